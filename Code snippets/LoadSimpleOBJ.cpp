@@ -21,6 +21,16 @@
  *  glBindVertexArray(objVAO);
  *  glDrawArrays(GL_TRIANGLES, 0, nVertices);
  *
+ *  Versão indexada (`loadSimpleOBJIndexed`): vértices repetidos são enviados
+ *  uma única vez e as faces viram um buffer de índices (EBO)
+ *  -----------------
+ *  int nIndices;
+ *  GLenum indexType;
+ *  GLuint objVAO = loadSimpleOBJIndexed("../Modelos3D/Cube.obj", nIndices, indexType);
+ *  ...
+ *  glBindVertexArray(objVAO);
+ *  glDrawElements(GL_TRIANGLES, nIndices, indexType, 0);
+ *
  */
 
  // Cabeçalhos necessários (para esta função), acrescentar ao seu código 
@@ -29,6 +39,8 @@
 #include <sstream>
 #include <string>
 #include <vector>
+#include <unordered_map>
+#include <cstdint>
  
  
 using namespace std;
@@ -135,4 +147,147 @@ int loadSimpleOBJ(string filePATH, int &nVertices)
 	nVertices = vBuffer.size() / 6;  // x, y, z, r, g, b (valores atualmente armazenados por vértice)
 
     return VAO;
-}
\ No newline at end of file
+}
+
+// Trio (v, vt, vn) de um canto de face, com os índices inteiros;
+// -1 quando o componente não aparece (f 1//3 não tem vt)
+struct ChaveCanto {
+    int v, vt, vn;
+    bool operator==(const ChaveCanto& o) const { return v == o.v && vt == o.vt && vn == o.vn; }
+};
+
+struct HashChaveCanto {
+    size_t operator()(const ChaveCanto& c) const {
+        uint64_t h = (uint64_t)(uint32_t)c.v;
+        h = h * 0x9E3779B97F4A7C15ull ^ (uint32_t)c.vt;
+        h = h * 0x9E3779B97F4A7C15ull ^ (uint32_t)c.vn;
+        return (size_t)(h ^ (h >> 32));
+    }
+};
+
+// Versão indexada: cada trio (v, vt, vn) distinto vira um único vértice no VBO
+// e as faces são gravadas como índices num EBO (desenho com glDrawElements).
+int loadSimpleOBJIndexed(string filePATH, int &nIndices, GLenum &indexType)
+ {
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec2> texCoords;
+    std::vector<glm::vec3> normals;
+    std::vector<GLfloat> vBuffer;
+    std::vector<GLuint> indices;
+    std::unordered_map<ChaveCanto, GLuint, HashChaveCanto> uniqueVertices;
+    glm::vec3 color = glm::vec3(1.0, 0.0, 0.0);
+
+    std::ifstream arqEntrada(filePATH.c_str());
+    if (!arqEntrada.is_open()) 
+	{
+        std::cerr << "Erro ao tentar ler o arquivo " << filePATH << std::endl;
+        return -1;
+    }
+
+    std::string line;
+    while (std::getline(arqEntrada, line)) 
+	{
+        std::istringstream ssline(line);
+        std::string word;
+        ssline >> word;
+
+        if (word == "v") 
+		{
+            glm::vec3 vertice;
+            ssline >> vertice.x >> vertice.y >> vertice.z;
+            vertices.push_back(vertice);
+        } 
+        else if (word == "vt") 
+		{
+            glm::vec2 vt;
+            ssline >> vt.s >> vt.t;
+            texCoords.push_back(vt);
+        } 
+        else if (word == "vn") 
+		{
+            glm::vec3 normal;
+            ssline >> normal.x >> normal.y >> normal.z;
+            normals.push_back(normal);
+        } 
+        else if (word == "f")
+		 {
+            while (ssline >> word) 
+			{
+                int vi = -1, ti = -1, ni = -1;
+                std::istringstream ss(word);
+                std::string index;
+
+                if (std::getline(ss, index, '/')) vi = !index.empty() ? std::stoi(index) - 1 : -1;
+                if (std::getline(ss, index, '/')) ti = !index.empty() ? std::stoi(index) - 1 : -1;
+                if (std::getline(ss, index)) ni = !index.empty() ? std::stoi(index) - 1 : -1;
+                if (vi < 0 || vi >= (int)vertices.size() || ti < -1 || ti >= (int)texCoords.size() ||
+                    ni < -1 || ni >= (int)normals.size())
+				{
+                    std::cerr << "Indice fora do intervalo na face \"" << word << "\" de " << filePATH << std::endl;
+                    return -1;
+                }
+
+                ChaveCanto key = { vi, ti, ni };
+                auto it = uniqueVertices.find(key);
+                if (it != uniqueVertices.end())
+				{
+                    indices.push_back(it->second);
+                    continue;
+                }
+
+                GLuint newIndex = vBuffer.size() / 6;
+                uniqueVertices[key] = newIndex;
+                indices.push_back(newIndex);
+
+                vBuffer.push_back(vertices[vi].x);
+                vBuffer.push_back(vertices[vi].y);
+                vBuffer.push_back(vertices[vi].z);
+                vBuffer.push_back(color.r);
+                vBuffer.push_back(color.g);
+                vBuffer.push_back(color.b);
+            }
+        }
+    }
+
+    arqEntrada.close();
+
+    std::cout << "Gerando o buffer de geometria (indexado)..." << std::endl;
+    GLuint VBO, EBO, VAO;
+    glGenBuffers(1, &VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, vBuffer.size() * sizeof(GLfloat), vBuffer.data(), GL_STATIC_DRAW);
+    
+    glGenVertexArrays(1, &VAO);
+    glBindVertexArray(VAO);
+
+    // O EBO fica registrado no VAO, por isso é vinculado com o VAO ativo
+    glGenBuffers(1, &EBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    if (vBuffer.size() / 6 <= 65536)
+	{
+        std::vector<GLushort> indices16(indices.begin(), indices.end());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices16.size() * sizeof(GLushort), indices16.data(), GL_STATIC_DRAW);
+        indexType = GL_UNSIGNED_SHORT;
+    }
+    else
+	{
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+        indexType = GL_UNSIGNED_INT;
+    }
+    
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)0);
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(1);
+    
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    std::cout << "Vertices unicos: " << vBuffer.size() / 6 << " de " << indices.size()
+              << " (VBO " << vBuffer.size() * sizeof(GLfloat) << " bytes)" << std::endl;
+
+	nIndices = indices.size();
+
+    return VAO;
+}
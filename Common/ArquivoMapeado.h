@@ -0,0 +1,155 @@
+/*
+ *  ArquivoMapeado.h
+ *
+ *  Mapeia um arquivo inteiro em memória, somente leitura, para que os
+ *  carregadores possam percorrer o conteúdo direto da página do SO, sem
+ *  copiar para std::string nem passar por ifstream.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  ArquivoMapeado arq("../assets/Modelos3D/Suzanne.obj");
+ *  if (arq.aberto()) {
+ *      const char* p = arq.dados();
+ *      const char* fim = p + arq.tamanho();
+ *      ...
+ *  }
+ *
+ *  gravarAtomico(caminho, dados); // temporário + rename, para os formatos binários
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class ArquivoMapeado {
+public:
+    ArquivoMapeado() = default;
+    explicit ArquivoMapeado(const std::string& caminho) { abrir(caminho); }
+    ~ArquivoMapeado() { fechar(); }
+
+    ArquivoMapeado(const ArquivoMapeado&) = delete;
+    ArquivoMapeado& operator=(const ArquivoMapeado&) = delete;
+
+    bool abrir(const std::string& caminho) {
+        fechar();
+#ifdef _WIN32
+        arquivo = CreateFileA(caminho.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (arquivo == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER tam;
+        if (!GetFileSizeEx(arquivo, &tam)) { fechar(); return false; }
+        tamanhoBytes = (size_t)tam.QuadPart;
+        mapeamentoAberto = true;
+        if (tamanhoBytes == 0) return true; // arquivo vazio: nada a mapear
+        mapeamento = CreateFileMappingA(arquivo, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapeamento) { fechar(); return false; }
+        ptr = (const char*)MapViewOfFile(mapeamento, FILE_MAP_READ, 0, 0, 0);
+        if (!ptr) { fechar(); return false; }
+#else
+        fd = open(caminho.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) { fechar(); return false; }
+        tamanhoBytes = (size_t)st.st_size;
+        mapeamentoAberto = true;
+        if (tamanhoBytes == 0) return true; // mmap não aceita tamanho zero
+        void* m = mmap(nullptr, tamanhoBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m == MAP_FAILED) { fechar(); return false; }
+        madvise(m, tamanhoBytes, MADV_SEQUENTIAL);
+        ptr = (const char*)m;
+#endif
+        return true;
+    }
+
+    void fechar() {
+#ifdef _WIN32
+        if (ptr) UnmapViewOfFile(ptr);
+        if (mapeamento) CloseHandle(mapeamento);
+        if (arquivo != INVALID_HANDLE_VALUE) CloseHandle(arquivo);
+        mapeamento = nullptr;
+        arquivo = INVALID_HANDLE_VALUE;
+#else
+        if (ptr) munmap((void*)ptr, tamanhoBytes);
+        if (fd >= 0) close(fd);
+        fd = -1;
+#endif
+        ptr = nullptr;
+        tamanhoBytes = 0;
+        mapeamentoAberto = false;
+    }
+
+    bool aberto() const { return mapeamentoAberto; }
+    const char* dados() const { return ptr; }
+    size_t tamanho() const { return tamanhoBytes; }
+
+private:
+    const char* ptr = nullptr;
+    size_t tamanhoBytes = 0;
+    bool mapeamentoAberto = false;
+#ifdef _WIN32
+    HANDLE arquivo = INVALID_HANDLE_VALUE;
+    HANDLE mapeamento = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+// Temporário ao lado de caminho, com o pid e um contador no nome: gravações
+// simultâneas do mesmo arquivo (threads do carregador, outro processo) não
+// truncam nem renomeiam o temporário umas das outras
+inline std::string caminhoTemporario(const std::string& caminho) {
+    static std::atomic<unsigned> contador{0};
+#ifdef _WIN32
+    unsigned long pid = GetCurrentProcessId();
+#else
+    unsigned long pid = (unsigned long)getpid();
+#endif
+    return caminho + "." + std::to_string(pid) + "." + std::to_string(contador.fetch_add(1)) + ".tmp";
+}
+
+// Grava num temporário próprio e renomeia: quem abrir caminho vê o arquivo
+// antigo ou o novo inteiro, nunca um pela metade nem misturado com o de
+// outra gravação simultânea (caches .malha, trajetórias .trj)
+inline bool gravarAtomico(const std::string& caminho, const std::vector<char>& dados) {
+    std::string tmp = caminhoTemporario(caminho);
+    std::error_code ec;
+    {
+        std::ofstream arq(tmp, std::ios::binary | std::ios::trunc);
+        if (!arq.is_open()) return false;
+        arq.write(dados.data(), (std::streamsize)dados.size());
+        if (!arq) {
+            arq.close();
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(tmp, caminho, ec);
+    if (!ec) return true;
+    std::filesystem::remove(tmp, ec); // o ec do remove não muda o resultado: a gravação já falhou
+    return false;
+}
+
+// Os blocos dos formatos binários começam em offsets múltiplos de 16
+inline uint64_t alinhar16(uint64_t x) { return (x + 15) & ~(uint64_t)15; }
@@ -0,0 +1,211 @@
+/*
+ *  ArquivoTrajetoria.h
+ *
+ *  Formato binário de trajetórias (.trj). Na leitura o arquivo é mapeado
+ *  em memória e os pontos são usados de lá mesmo, sem ler texto nenhum;
+ *  gravado em float32 não perde precisão como o texto "x y z".
+ *
+ *  Layout do arquivo (little-endian, blocos alinhados em 16 bytes):
+ *    CabecalhoTrajetoria   - mágica, versão, número de pontos, modo da
+ *                            curva (ModoTrajetoria), codificação dos pontos,
+ *                            caixa envolvente e offsets dos blocos
+ *    pontos                - nPontos * 3 floats (PONTOS_FLOAT32) ou
+ *                            nPontos * 3 int16 (PONTOS_INT16), quantizados
+ *                            na caixa envolvente: -32768 é o mínimo do
+ *                            eixo e 32767 o máximo
+ *    tempos (opcional)     - nPontos floats, em segundos, de quando cada
+ *                            ponto foi gravado
+ *
+ *  O texto antigo (um "x y z" por linha, com um tempo opcional como quarta
+ *  coluna) continua entrando por importarTrajetoriaTexto().
+ *
+ *  Forma de uso
+ *  -----------------
+ *  gravarTrajetoria("caminho.trj", pontos, TRAJETORIA_CENTRIPETA);
+ *  gravarTrajetoria("gravado.trj", pontos, modo, &tempos, true);  // int16, com tempos
+ *  ...
+ *  TrajetoriaMapeada t;
+ *  if (abrirTrajetoria("caminho.trj", t)) {
+ *      std::vector<glm::vec3> pontos;
+ *      t.copiarPontos(pontos);
+ *      ModoTrajetoria modo = t.modo();
+ *  }
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ArquivoMapeado.h"
+#include "Trajetoria.h"
+
+const char MAGICA_TRAJETORIA[4] = { 'T', 'R', 'J', 'B' };
+const uint32_t VERSAO_TRAJETORIA = 1;
+
+enum CodificacaoPontos : uint32_t {
+    PONTOS_FLOAT32 = 0,
+    PONTOS_INT16 = 1
+};
+
+struct CabecalhoTrajetoria {
+    char magica[4];
+    uint32_t versao;
+    uint32_t nPontos;
+    uint32_t modo;                 // ModoTrajetoria
+    uint32_t codificacao;          // CodificacaoPontos
+    uint32_t temTempos;            // 1 se há o bloco de tempos
+    float minimo[3];               // caixa envolvente dos pontos
+    float maximo[3];
+    uint64_t offsetPontos, offsetTempos; // offsetTempos é 0 sem o bloco de tempos
+};
+
+struct TrajetoriaMapeada {
+    ArquivoMapeado arquivo;        // .trj mapeado
+    const CabecalhoTrajetoria* cabecalho = nullptr;
+    const void* pontos = nullptr;
+    const float* tempos = nullptr; // nulo sem o bloco de tempos
+
+    size_t nPontos() const { return cabecalho->nPontos; }
+    ModoTrajetoria modo() const { return (ModoTrajetoria)cabecalho->modo; }
+    bool quantizada() const { return cabecalho->codificacao == PONTOS_INT16; }
+    // Os pontos como estão no arquivo, quando não quantizados (x, y, z por ponto)
+    const float* pontosFloat() const { return quantizada() ? nullptr : (const float*)pontos; }
+
+    glm::vec3 ponto(size_t i) const {
+        if (!quantizada()) {
+            const float* p = (const float*)pontos + i * 3;
+            return glm::vec3(p[0], p[1], p[2]);
+        }
+        const int16_t* q = (const int16_t*)pontos + i * 3;
+        glm::vec3 p;
+        for (int e = 0; e < 3; ++e)
+            p[e] = cabecalho->minimo[e] + ((float)q[e] + 32768.0f) * ((cabecalho->maximo[e] - cabecalho->minimo[e]) / 65535.0f);
+        return p;
+    }
+
+    void copiarPontos(std::vector<glm::vec3>& saida) const {
+        saida.resize(nPontos());
+        if (!quantizada()) {
+            if (!saida.empty()) memcpy(saida.data(), pontos, saida.size() * sizeof(glm::vec3));
+            return;
+        }
+        for (size_t i = 0; i < saida.size(); ++i) saida[i] = ponto(i);
+    }
+
+    void copiarTempos(std::vector<float>& saida) const {
+        if (tempos) saida.assign(tempos, tempos + nPontos());
+        else saida.clear();
+    }
+};
+
+namespace arquivoTrajetoria {
+
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "os pontos float32 são copiados como glm::vec3");
+
+// Confere mágica, versão, modo, codificação e se os blocos cabem no arquivo
+inline bool apontar(TrajetoriaMapeada& saida, const char* base, size_t tamanho) {
+    if (tamanho < sizeof(CabecalhoTrajetoria)) return false;
+    const CabecalhoTrajetoria* c = (const CabecalhoTrajetoria*)base;
+    if (memcmp(c->magica, MAGICA_TRAJETORIA, 4) != 0 || c->versao != VERSAO_TRAJETORIA) return false;
+    if (c->modo >= N_MODOS_TRAJETORIA || (c->codificacao != PONTOS_FLOAT32 && c->codificacao != PONTOS_INT16)) return false;
+    uint64_t bytesPontos = (uint64_t)c->nPontos * 3 * (c->codificacao == PONTOS_INT16 ? sizeof(int16_t) : sizeof(float));
+    uint64_t bytesTempos = c->temTempos ? (uint64_t)c->nPontos * sizeof(float) : 0;
+    if (c->offsetPontos + bytesPontos > tamanho || c->offsetTempos + bytesTempos > tamanho) return false;
+    if (c->offsetPontos % 16 != 0 || c->offsetTempos % 16 != 0) return false;
+    saida.cabecalho = c;
+    saida.pontos = base + c->offsetPontos;
+    saida.tempos = c->temTempos ? (const float*)(base + c->offsetTempos) : nullptr;
+    return true;
+}
+
+inline void serializar(const std::vector<glm::vec3>& pontos, ModoTrajetoria modo, const std::vector<float>* tempos,
+                       bool quantizar, std::vector<char>& saida) {
+    CabecalhoTrajetoria c;
+    memset(&c, 0, sizeof(c));
+    memcpy(c.magica, MAGICA_TRAJETORIA, 4);
+    c.versao = VERSAO_TRAJETORIA;
+    c.nPontos = (uint32_t)pontos.size();
+    c.modo = (uint32_t)modo;
+    c.codificacao = quantizar ? PONTOS_INT16 : PONTOS_FLOAT32;
+    c.temTempos = tempos && tempos->size() == pontos.size() ? 1 : 0;
+    for (size_t i = 0; i < pontos.size(); ++i)
+        for (int e = 0; e < 3; ++e) {
+            c.minimo[e] = i == 0 ? pontos[i][e] : std::min(c.minimo[e], pontos[i][e]);
+            c.maximo[e] = i == 0 ? pontos[i][e] : std::max(c.maximo[e], pontos[i][e]);
+        }
+
+    uint64_t bytesPontos = (uint64_t)c.nPontos * 3 * (quantizar ? sizeof(int16_t) : sizeof(float));
+    c.offsetPontos = alinhar16(sizeof(CabecalhoTrajetoria));
+    c.offsetTempos = c.temTempos ? alinhar16(c.offsetPontos + bytesPontos) : 0;
+    uint64_t fim = c.temTempos ? c.offsetTempos + (uint64_t)c.nPontos * sizeof(float) : c.offsetPontos + bytesPontos;
+
+    saida.assign((size_t)fim, 0);
+    memcpy(saida.data(), &c, sizeof(c));
+    if (!quantizar) {
+        if (!pontos.empty()) memcpy(&saida[c.offsetPontos], pontos.data(), bytesPontos);
+    } else {
+        int16_t* q = (int16_t*)&saida[c.offsetPontos];
+        for (size_t i = 0; i < pontos.size(); ++i)
+            for (int e = 0; e < 3; ++e) {
+                float extensao = c.maximo[e] - c.minimo[e];
+                float t = extensao > 0.0f ? (pontos[i][e] - c.minimo[e]) / extensao : 0.0f;
+                q[i * 3 + e] = (int16_t)(std::lround(t * 65535.0f) - 32768);
+            }
+    }
+    if (c.temTempos) memcpy(&saida[c.offsetTempos], tempos->data(), (size_t)c.nPontos * sizeof(float));
+}
+
+} // namespace arquivoTrajetoria
+
+// Grava os pontos (e, se vierem, os tempos, um por ponto) em caminho.
+// quantizar troca os floats por int16 na caixa envolvente: metade do
+// tamanho, erro de até (maior - menor) / 131070 por eixo.
+inline bool gravarTrajetoria(const std::string& caminho, const std::vector<glm::vec3>& pontos, ModoTrajetoria modo,
+                             const std::vector<float>* tempos = nullptr, bool quantizar = false) {
+    std::vector<char> dados;
+    arquivoTrajetoria::serializar(pontos, modo, tempos, quantizar, dados);
+    return gravarAtomico(caminho, dados);
+}
+
+// Mapeia caminho; falha se não existir ou não for um .trj desta versão
+inline bool abrirTrajetoria(const std::string& caminho, TrajetoriaMapeada& saida) {
+    saida.cabecalho = nullptr;
+    if (saida.arquivo.abrir(caminho) &&
+        arquivoTrajetoria::apontar(saida, saida.arquivo.dados(), saida.arquivo.tamanho())) return true;
+    saida.arquivo.fechar();
+    return false;
+}
+
+// Lê o formato texto: um "x y z" por linha, com o tempo opcional depois.
+// tempos só é preenchido se todas as linhas tiverem a quarta coluna.
+inline bool importarTrajetoriaTexto(const std::string& caminho, std::vector<glm::vec3>& pontos,
+                                    std::vector<float>* tempos = nullptr) {
+    std::ifstream arquivo(caminho);
+    if (!arquivo.is_open()) return false;
+    pontos.clear();
+    if (tempos) tempos->clear();
+    bool todosComTempo = true;
+    std::string linha;
+    while (std::getline(arquivo, linha)) {
+        std::istringstream campos(linha);
+        glm::vec3 p;
+        if (!(campos >> p.x >> p.y >> p.z)) continue;
+        pontos.push_back(p);
+        float t;
+        if (campos >> t) {
+            if (tempos) tempos->push_back(t);
+        } else {
+            todosComTempo = false;
+        }
+    }
+    if (tempos && !todosComTempo) tempos->clear();
+    return true;
+}
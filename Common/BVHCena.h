@@ -0,0 +1,472 @@
+/*
+ *  BVHCena.h
+ *
+ *  Hierarquia de volumes envolventes (BVH) sobre as AABBs no espaço do
+ *  mundo dos objetos da cena, para culling, picking e consultas de
+ *  vizinhança sem percorrer a cena inteira.
+ *
+ *  - Construção top-down com SAH em NBINS baldes por eixo. Os níveis de
+ *    cima dividem o trabalho entre threads: a subárvore direita vai para
+ *    uma thread nova e a esquerda segue na atual.
+ *  - Os nós ficam em profundidade (o filho esquerdo vem logo depois do pai),
+ *    e os objetos de qualquer subárvore são contíguos em ordem[].
+ *  - atualizar() troca a caixa de um objeto e marca o caminho até a raiz;
+ *    reajustar() recalcula só os nós marcados e devolve true quando o custo
+ *    SAH passou de LIMITE_DEGRADACAO vezes o da construção, sinal de que é
+ *    hora de construir de novo.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  BVHCena bvh;
+ *  bvh.construir(caixas);                 // caixas[i] = caixaMundo(model_i, limites_i)
+ *  ...
+ *  bvh.atualizar(i, novaCaixa);
+ *  if (bvh.reajustar()) bvh.construir(caixas);
+ *  bvh.consultarFrustum(Frustum::extrair(projection * view), visiveis);
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "Frustum.h"
+
+struct CaixaAlinhada {
+    glm::vec3 minimo{ FLT_MAX };
+    glm::vec3 maximo{ -FLT_MAX };
+
+    void expandir(const CaixaAlinhada& c) {
+        minimo = glm::min(minimo, c.minimo);
+        maximo = glm::max(maximo, c.maximo);
+    }
+    void expandir(const glm::vec3& p) {
+        minimo = glm::min(minimo, p);
+        maximo = glm::max(maximo, p);
+    }
+    glm::vec3 centro() const { return (minimo + maximo) * 0.5f; }
+    float area() const {
+        glm::vec3 d = maximo - minimo;
+        if (d.x < 0.0f || d.y < 0.0f || d.z < 0.0f) return 0.0f;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+};
+
+// AABB no mundo da caixa da malha transformada por model (Arvo)
+inline CaixaAlinhada caixaMundo(const glm::mat4& model, const LimitesMalha& l) {
+    glm::vec3 centro(model * glm::vec4(l.centro[0], l.centro[1], l.centro[2], 1.0f));
+    glm::vec3 meia(0.5f * (l.maximo[0] - l.minimo[0]), 0.5f * (l.maximo[1] - l.minimo[1]), 0.5f * (l.maximo[2] - l.minimo[2]));
+    glm::vec3 extensao;
+    for (int e = 0; e < 3; ++e)
+        extensao[e] = std::fabs(model[0][e]) * meia.x + std::fabs(model[1][e]) * meia.y + std::fabs(model[2][e]) * meia.z;
+    CaixaAlinhada c;
+    c.minimo = centro - extensao;
+    c.maximo = centro + extensao;
+    return c;
+}
+
+// Testes de uma caixa isolada, usados pela BVH e pelas buscas por força bruta
+
+// Bit p de 'mascara' ligado = plano p ainda precisa ser testado. Retorna -1
+// se a caixa está fora, 1 se está inteira dentro e 0 se cruza algum plano;
+// os planos que a caixa já tem inteiros do lado de dentro saem da máscara.
+inline int classificarCaixa(const Frustum& f, const CaixaAlinhada& c, unsigned& mascara) {
+    glm::vec3 centro = c.centro();
+    glm::vec3 meia = (c.maximo - c.minimo) * 0.5f;
+    for (int p = 0; p < 6; ++p) {
+        if (!(mascara & (1u << p))) continue;
+        const glm::vec4& pl = f.planos[p];
+        float d = pl.x * centro.x + pl.y * centro.y + pl.z * centro.z + pl.w;
+        float r = std::fabs(pl.x) * meia.x + std::fabs(pl.y) * meia.y + std::fabs(pl.z) * meia.z;
+        if (d < -r) return -1;
+        if (d >= r) mascara &= ~(1u << p);
+    }
+    return mascara == 0 ? 1 : 0;
+}
+
+inline bool caixaNoFrustum(const Frustum& f, const CaixaAlinhada& c) {
+    unsigned mascara = 0x3F;
+    return classificarCaixa(f, c, mascara) >= 0;
+}
+
+// Slab test; tEntrada recebe a distância em que o raio entra na caixa (0 se a origem está dentro)
+inline bool raioNaCaixa(const CaixaAlinhada& c, const glm::vec3& origem, const glm::vec3& inverso, float tMax, float& tEntrada) {
+    float t0 = 0.0f, t1 = tMax;
+    for (int e = 0; e < 3; ++e) {
+        float a = (c.minimo[e] - origem[e]) * inverso[e];
+        float b = (c.maximo[e] - origem[e]) * inverso[e];
+        if (a > b) std::swap(a, b);
+        t0 = a > t0 ? a : t0; // assim um NaN (0 * inf) não estraga o intervalo
+        t1 = b < t1 ? b : t1;
+        if (t0 > t1) return false;
+    }
+    tEntrada = t0;
+    return true;
+}
+
+inline bool esferaNaCaixa(const CaixaAlinhada& c, const glm::vec3& centro, float raio) {
+    glm::vec3 maisPerto = glm::min(glm::max(centro, c.minimo), c.maximo);
+    glm::vec3 d = centro - maisPerto;
+    return glm::dot(d, d) <= raio * raio;
+}
+
+class BVHCena {
+public:
+    static constexpr uint32_t NENHUM = 0xFFFFFFFFu;
+    static constexpr int NBINS = 16;
+    static constexpr uint32_t MAX_FOLHA = 4;              // folhas com até isso de objetos
+    static constexpr uint32_t MIN_PARALELO = 4096;        // subárvores menores não ganham thread
+    static constexpr float CUSTO_TRAVESSIA = 1.0f;    // custo de visitar um nó, relativo a testar um objeto
+    static constexpr float LIMITE_DEGRADACAO = 1.5f;
+
+    // nThreads = 0 usa todos os núcleos
+    void construir(const std::vector<CaixaAlinhada>& caixas, unsigned nThreads = 0) {
+        objetos = caixas;
+        uint32_t n = (uint32_t)objetos.size();
+        nos.clear();
+        ordem.resize(n);
+        centros.resize(n);
+        for (uint32_t i = 0; i < n; ++i) {
+            ordem[i] = i;
+            centros[i] = objetos[i].centro();
+        }
+        if (n > 0) {
+            if (nThreads == 0) nThreads = std::max(1u, std::thread::hardware_concurrency());
+            int niveis = 0;
+            while ((1u << niveis) < nThreads) ++niveis;
+            nos.reserve(2 * n / MAX_FOLHA + 1);
+            construirNo(nos, 0, n, niveis);
+        }
+        indexar();
+    }
+
+    // Troca a caixa de um objeto; vale a partir do próximo reajustar()
+    void atualizar(uint32_t objeto, const CaixaAlinhada& caixa) {
+        objetos[objeto] = caixa;
+        for (uint32_t no = folha[objeto]; !sujo[no]; no = pai[no]) {
+            sujo[no] = 1;
+            sujos.push_back(no);
+            if (no == 0) break;
+        }
+    }
+
+    // Recalcula os nós marcados, de baixo para cima (filhos têm índice maior
+    // que o pai). Retorna true se a árvore degradou e vale reconstruir.
+    bool reajustar() {
+        std::sort(sujos.begin(), sujos.end(), std::greater<uint32_t>());
+        for (uint32_t no : sujos) {
+            recalcular(no);
+            sujo[no] = 0;
+        }
+        sujos.clear();
+        return degradacao() > LIMITE_DEGRADACAO;
+    }
+
+    // Troca todas as caixas de uma vez e reajusta a árvore inteira
+    bool reajustar(const std::vector<CaixaAlinhada>& caixas) {
+        objetos = caixas;
+        for (uint32_t no = (uint32_t)nos.size(); no-- > 0;) recalcular(no);
+        return degradacao() > LIMITE_DEGRADACAO;
+    }
+
+    // Objetos cuja AABB está ao menos em parte dentro do frustum
+    void consultarFrustum(const Frustum& f, std::vector<uint32_t>& saida) const {
+        saida.clear();
+        if (nos.empty()) return;
+        std::vector<std::pair<uint32_t, unsigned>> pilha;
+        pilha.reserve(64);
+        pilha.push_back({ 0u, 0x3Fu });
+        while (!pilha.empty()) {
+            uint32_t indice = pilha.back().first;
+            unsigned mascara = pilha.back().second;
+            pilha.pop_back();
+            const No& no = nos[indice];
+            int lado = classificarCaixa(f, no.caixa, mascara);
+            if (lado < 0) continue;
+            if (lado > 0) { // inteiro dentro: a subárvore toda entra sem mais testes
+                saida.insert(saida.end(), ordem.begin() + no.primeiro, ordem.begin() + no.primeiro + no.total);
+                continue;
+            }
+            if (no.folha()) {
+                for (uint32_t k = no.primeiro; k < no.primeiro + no.total; ++k) {
+                    unsigned m = mascara;
+                    if (classificarCaixa(f, objetos[ordem[k]], m) >= 0) saida.push_back(ordem[k]);
+                }
+                continue;
+            }
+            pilha.push_back({ no.direito, mascara });
+            pilha.push_back({ indice + 1, mascara });
+        }
+    }
+
+    // Objetos cuja AABB o raio atravessa em [0, tMax]
+    void consultarRaio(const glm::vec3& origem, const glm::vec3& direcao, float tMax, std::vector<uint32_t>& saida) const {
+        saida.clear();
+        percorrerRaio(origem, direcao, tMax, [&](uint32_t objeto, float) {
+            saida.push_back(objeto);
+            return FLT_MAX;
+        });
+    }
+
+    // Objeto mais próximo atingido pelo raio. teste(objeto, tCaixa) devolve a
+    // distância do acerto de verdade (FLT_MAX se errou); os nós são visitados
+    // do mais perto para o mais longe e os que começam depois do melhor acerto
+    // são podados. Sem teste, vale a entrada na AABB. t recebe a distância.
+    template <typename Teste>
+    uint32_t raioMaisProximo(const glm::vec3& origem, const glm::vec3& direcao, float tMax, float& t, Teste teste) const {
+        uint32_t melhor = NENHUM;
+        t = tMax;
+        percorrerRaio(origem, direcao, tMax, [&](uint32_t objeto, float tCaixa) {
+            float tObjeto = teste(objeto, tCaixa);
+            if (tObjeto < t) {
+                t = tObjeto;
+                melhor = objeto;
+            }
+            return t;
+        });
+        return melhor;
+    }
+
+    uint32_t raioMaisProximo(const glm::vec3& origem, const glm::vec3& direcao, float tMax, float& t) const {
+        return raioMaisProximo(origem, direcao, tMax, t, [](uint32_t, float tCaixa) { return tCaixa; });
+    }
+
+    // Objetos cuja AABB toca a esfera
+    void consultarEsfera(const glm::vec3& centro, float raio, std::vector<uint32_t>& saida) const {
+        saida.clear();
+        if (nos.empty()) return;
+        std::vector<uint32_t> pilha;
+        pilha.reserve(64);
+        pilha.push_back(0);
+        while (!pilha.empty()) {
+            uint32_t indice = pilha.back();
+            pilha.pop_back();
+            const No& no = nos[indice];
+            if (!esferaNaCaixa(no.caixa, centro, raio)) continue;
+            if (no.folha()) {
+                for (uint32_t k = no.primeiro; k < no.primeiro + no.total; ++k)
+                    if (esferaNaCaixa(objetos[ordem[k]], centro, raio)) saida.push_back(ordem[k]);
+                continue;
+            }
+            pilha.push_back(no.direito);
+            pilha.push_back(indice + 1);
+        }
+    }
+
+    // Custo SAH atual dividido pelo da última construção (1 logo depois de construir)
+    float degradacao() const {
+        if (nos.empty() || custoConstrucao <= 0.0) return 1.0f;
+        return (float)(custoAtual() / custoConstrucao);
+    }
+    float custoSAH() const { return nos.empty() ? 0.0f : (float)custoAtual(); }
+
+    size_t tamanho() const { return objetos.size(); }
+    size_t nNos() const { return nos.size(); }
+    const CaixaAlinhada& caixa(uint32_t objeto) const { return objetos[objeto]; }
+
+private:
+    struct No {
+        CaixaAlinhada caixa;
+        uint32_t primeiro;   // objetos da subárvore: ordem[primeiro .. primeiro + total)
+        uint32_t total;
+        uint32_t direito;    // 0 numa folha (a raiz nunca é filho direito)
+
+        bool folha() const { return direito == 0; }
+    };
+
+    struct Balde {
+        CaixaAlinhada caixa;
+        uint32_t n = 0;
+    };
+
+    uint32_t construirNo(std::vector<No>& destino, uint32_t primeiro, uint32_t total, int niveisParalelos) {
+        uint32_t indice = (uint32_t)destino.size();
+        CaixaAlinhada caixa, caixaCentros;
+        for (uint32_t k = primeiro; k < primeiro + total; ++k) {
+            caixa.expandir(objetos[ordem[k]]);
+            caixaCentros.expandir(centros[ordem[k]]);
+        }
+        destino.push_back({ caixa, primeiro, total, 0 });
+        if (total <= MAX_FOLHA) return indice;
+
+        // SAH: procura o melhor corte entre baldes nos três eixos
+        int melhorEixo = -1, melhorCorte = 0;
+        float melhorCusto = FLT_MAX;
+        float area = caixa.area();
+        for (int e = 0; e < 3; ++e) {
+            float extensao = caixaCentros.maximo[e] - caixaCentros.minimo[e];
+            if (extensao <= 0.0f) continue;
+            float escala = NBINS / extensao;
+            Balde baldes[NBINS];
+            for (uint32_t k = primeiro; k < primeiro + total; ++k) {
+                int b = std::min(NBINS - 1, (int)((centros[ordem[k]][e] - caixaCentros.minimo[e]) * escala));
+                baldes[b].caixa.expandir(objetos[ordem[k]]);
+                ++baldes[b].n;
+            }
+            float areaDireita[NBINS];
+            uint32_t nDireita[NBINS];
+            CaixaAlinhada acumulada;
+            uint32_t n = 0;
+            for (int b = NBINS - 1; b > 0; --b) {
+                acumulada.expandir(baldes[b].caixa);
+                n += baldes[b].n;
+                areaDireita[b] = acumulada.area();
+                nDireita[b] = n;
+            }
+            acumulada = CaixaAlinhada();
+            n = 0;
+            for (int corte = 1; corte < NBINS; ++corte) {
+                acumulada.expandir(baldes[corte - 1].caixa);
+                n += baldes[corte - 1].n;
+                if (n == 0 || nDireita[corte] == 0) continue;
+                float custo = CUSTO_TRAVESSIA + (acumulada.area() * n + areaDireita[corte] * nDireita[corte]) / area;
+                if (custo < melhorCusto) {
+                    melhorCusto = custo;
+                    melhorEixo = e;
+                    melhorCorte = corte;
+                }
+            }
+        }
+
+        uint32_t meio;
+        if (melhorEixo < 0) {
+            // Todos os centros no mesmo ponto: divide ao meio para não virar uma folha enorme
+            meio = primeiro + total / 2;
+        } else {
+            if (melhorCusto >= (float)total && total <= 4 * MAX_FOLHA) return indice; // dividir não compensa
+            int e = melhorEixo;
+            float minimo = caixaCentros.minimo[e];
+            float escala = NBINS / (caixaCentros.maximo[e] - minimo);
+            uint32_t* p = std::partition(ordem.data() + primeiro, ordem.data() + primeiro + total, [&](uint32_t o) {
+                return std::min(NBINS - 1, (int)((centros[o][e] - minimo) * escala)) < melhorCorte;
+            });
+            meio = (uint32_t)(p - ordem.data());
+        }
+
+        uint32_t fim = primeiro + total;
+        if (niveisParalelos > 0 && total >= MIN_PARALELO) {
+            std::vector<No> nosDireita;
+            nosDireita.reserve(2 * (fim - meio) / MAX_FOLHA + 1);
+            std::thread direita([&] { construirNo(nosDireita, meio, fim - meio, niveisParalelos - 1); });
+            construirNo(destino, primeiro, meio - primeiro, niveisParalelos - 1);
+            direita.join();
+            uint32_t deslocamento = (uint32_t)destino.size();
+            for (No no : nosDireita) {
+                if (!no.folha()) no.direito += deslocamento;
+                destino.push_back(no);
+            }
+            destino[indice].direito = deslocamento;
+        } else {
+            construirNo(destino, primeiro, meio - primeiro, niveisParalelos - 1);
+            uint32_t direito = construirNo(destino, meio, fim - meio, niveisParalelos - 1);
+            destino[indice].direito = direito;
+        }
+        return indice;
+    }
+
+    // pai[] e folha[] para o reajuste, e o custo SAH de referência
+    void indexar() {
+        pai.assign(nos.size(), NENHUM);
+        sujo.assign(nos.size(), 0);
+        sujos.clear();
+        folha.assign(objetos.size(), NENHUM);
+        for (uint32_t i = 0; i < nos.size(); ++i) {
+            const No& no = nos[i];
+            if (no.folha()) {
+                for (uint32_t k = no.primeiro; k < no.primeiro + no.total; ++k) folha[ordem[k]] = i;
+            } else {
+                pai[i + 1] = i;
+                pai[no.direito] = i;
+            }
+        }
+        somaCusto = 0.0;
+        for (const No& no : nos) somaCusto += custoNo(no);
+        custoConstrucao = nos.empty() ? 0.0 : custoAtual();
+    }
+
+    void recalcular(uint32_t indice) {
+        No& no = nos[indice];
+        somaCusto -= custoNo(no);
+        no.caixa = CaixaAlinhada();
+        if (no.folha()) {
+            for (uint32_t k = no.primeiro; k < no.primeiro + no.total; ++k) no.caixa.expandir(objetos[ordem[k]]);
+        } else {
+            no.caixa.expandir(nos[indice + 1].caixa);
+            no.caixa.expandir(nos[no.direito].caixa);
+        }
+        somaCusto += custoNo(no);
+    }
+
+    // Área ponderada: custo de travessia nos nós internos, de objetos nas folhas
+    static double custoNo(const No& no) {
+        return (double)no.caixa.area() * (no.folha() ? (double)no.total : (double)CUSTO_TRAVESSIA);
+    }
+
+    // Soma dos custos dos nós (mantida pelo reajuste) sobre a área da raiz
+    double custoAtual() const {
+        double raiz = nos[0].caixa.area();
+        return raiz > 0.0 ? somaCusto / raiz : 0.0;
+    }
+
+    // Visita as folhas atravessadas pelo raio, do nó mais perto para o mais
+    // longe. visitar(objeto, tCaixa) devolve o novo limite de distância.
+    template <typename Visitar>
+    void percorrerRaio(const glm::vec3& origem, const glm::vec3& direcao, float tMax, Visitar visitar) const {
+        if (nos.empty()) return;
+        glm::vec3 inverso(1.0f / direcao.x, 1.0f / direcao.y, 1.0f / direcao.z);
+        float limite = tMax;
+        float tEntrada;
+        if (!raioNaCaixa(nos[0].caixa, origem, inverso, limite, tEntrada)) return;
+        std::vector<std::pair<uint32_t, float>> pilha;
+        pilha.reserve(64);
+        pilha.push_back({ 0u, tEntrada });
+        while (!pilha.empty()) {
+            uint32_t indice = pilha.back().first;
+            float tNo = pilha.back().second;
+            pilha.pop_back();
+            if (tNo > limite) continue;
+            const No& no = nos[indice];
+            if (no.folha()) {
+                for (uint32_t k = no.primeiro; k < no.primeiro + no.total; ++k) {
+                    float tCaixa;
+                    if (raioNaCaixa(objetos[ordem[k]], origem, inverso, limite, tCaixa))
+                        limite = std::min(limite, visitar(ordem[k], tCaixa));
+                }
+                continue;
+            }
+            uint32_t a = indice + 1, b = no.direito;
+            float ta = 0.0f, tb = 0.0f;
+            bool acertaA = raioNaCaixa(nos[a].caixa, origem, inverso, limite, ta);
+            bool acertaB = raioNaCaixa(nos[b].caixa, origem, inverso, limite, tb);
+            if (acertaA && acertaB) {
+                if (ta > tb) { // o mais perto sai primeiro da pilha
+                    std::swap(a, b);
+                    std::swap(ta, tb);
+                }
+                pilha.push_back({ b, tb });
+                pilha.push_back({ a, ta });
+            } else if (acertaA) {
+                pilha.push_back({ a, ta });
+            } else if (acertaB) {
+                pilha.push_back({ b, tb });
+            }
+        }
+    }
+
+    std::vector<No> nos;
+    std::vector<CaixaAlinhada> objetos;   // caixa de cada objeto, no índice da cena
+    std::vector<glm::vec3> centros;       // centros na construção
+    std::vector<uint32_t> ordem;          // índices dos objetos, agrupados por folha
+    std::vector<uint32_t> folha;          // objeto -> folha que o contém
+    std::vector<uint32_t> pai;            // nó -> pai (NENHUM na raiz)
+    std::vector<uint8_t> sujo;
+    std::vector<uint32_t> sujos;
+    double somaCusto = 0.0;
+    double custoConstrucao = 0.0;
+};
@@ -0,0 +1,378 @@
+/*
+ *  BVHTriangulos.h
+ *
+ *  BVH dos triângulos de uma malha, no espaço do objeto, usada no picking
+ *  exato. É construída uma única vez, quando o .malha é gerado, e gravada
+ *  nele logo depois dos índices (ver CacheMalha.h); carregar a malha só
+ *  copia os dois blocos. Todas as instâncias de uma malha compartilham a
+ *  mesma árvore: o raio é que vai para o espaço do objeto.
+ *
+ *  Cada folha tem até 4 triângulos num PacoteTriangulos (SoA, vértice 0 e
+ *  arestas já subtraídas), testados de uma vez por um Möller-Trumbore em
+ *  SSE. Vagas sem triângulo têm arestas nulas e nunca acertam.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  BVHTriangulos bvh;
+ *  malha.copiarBVH(bvh);
+ *  AcertoTriangulo acerto;
+ *  if (bvh.intersectar(origemObjeto, direcaoObjeto, tMax, acerto)) ... acerto.triangulo, acerto.u, acerto.v ...
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BVH_TRIANGULOS_SSE 1
+#endif
+
+const uint32_t TRIANGULO_NENHUM = 0xFFFFFFFFu;
+
+struct NoBVHTriangulos {
+    float minimo[3];
+    uint32_t indice;        // folha: pacote; interno: filho direito (o esquerdo vem logo depois)
+    float maximo[3];
+    uint32_t folha;         // 1 numa folha
+};
+static_assert(sizeof(NoBVHTriangulos) == 32, "NoBVHTriangulos vai direto para o arquivo");
+
+struct alignas(16) PacoteTriangulos {
+    float v0[3][4];         // [eixo][vaga]
+    float e1[3][4];         // v1 - v0
+    float e2[3][4];         // v2 - v0
+    uint32_t triangulo[4];  // índice do triângulo na malha, TRIANGULO_NENHUM se a vaga está vazia
+};
+static_assert(sizeof(PacoteTriangulos) == 160, "PacoteTriangulos vai direto para o arquivo");
+
+// Ponto atingido: (1 - u - v) * v0 + u * v1 + v * v2 do triângulo
+struct AcertoTriangulo {
+    float t = FLT_MAX;
+    float u = 0.0f, v = 0.0f;
+    uint32_t triangulo = TRIANGULO_NENHUM;
+};
+
+namespace bvhTriangulos {
+
+const int NBINS = 16;
+const int PROFUNDIDADE_SAH = 64;   // abaixo disso divide pela mediana, para a pilha da busca bastar
+const int TAMANHO_PILHA = 128;
+
+struct Construcao {
+    const float* vertices;
+    size_t floatsPorVertice;
+    const uint32_t* indices;
+    std::vector<uint32_t> ordem;
+    std::vector<glm::vec3> minimos, maximos, centros;
+    std::vector<NoBVHTriangulos>* nos;
+    std::vector<PacoteTriangulos>* pacotes;
+
+    glm::vec3 vertice(uint32_t tri, int canto) const {
+        const float* p = vertices + (size_t)indices[tri * 3 + canto] * floatsPorVertice;
+        return glm::vec3(p[0], p[1], p[2]);
+    }
+};
+
+inline float area(const glm::vec3& minimo, const glm::vec3& maximo) {
+    glm::vec3 d = maximo - minimo;
+    if (d.x < 0.0f) return 0.0f;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+inline void emitirFolha(Construcao& c, uint32_t primeiro, uint32_t total, uint32_t indiceNo) {
+    PacoteTriangulos p;
+    for (int k = 0; k < 4; ++k) {
+        uint32_t tri = k < (int)total ? c.ordem[primeiro + k] : TRIANGULO_NENHUM;
+        glm::vec3 a(0.0f), e1(0.0f), e2(0.0f);
+        if (tri != TRIANGULO_NENHUM) {
+            a = c.vertice(tri, 0);
+            e1 = c.vertice(tri, 1) - a;
+            e2 = c.vertice(tri, 2) - a;
+        }
+        for (int e = 0; e < 3; ++e) {
+            p.v0[e][k] = a[e];
+            p.e1[e][k] = e1[e];
+            p.e2[e][k] = e2[e];
+        }
+        p.triangulo[k] = tri;
+    }
+    (*c.nos)[indiceNo].indice = (uint32_t)c.pacotes->size();
+    (*c.nos)[indiceNo].folha = 1;
+    c.pacotes->push_back(p);
+}
+
+inline uint32_t construirNo(Construcao& c, uint32_t primeiro, uint32_t total, int profundidade) {
+    uint32_t indice = (uint32_t)c.nos->size();
+    glm::vec3 minimo(FLT_MAX), maximo(-FLT_MAX), minCentro(FLT_MAX), maxCentro(-FLT_MAX);
+    for (uint32_t k = primeiro; k < primeiro + total; ++k) {
+        uint32_t t = c.ordem[k];
+        minimo = glm::min(minimo, c.minimos[t]);
+        maximo = glm::max(maximo, c.maximos[t]);
+        minCentro = glm::min(minCentro, c.centros[t]);
+        maxCentro = glm::max(maxCentro, c.centros[t]);
+    }
+    NoBVHTriangulos no;
+    for (int e = 0; e < 3; ++e) {
+        no.minimo[e] = minimo[e];
+        no.maximo[e] = maximo[e];
+    }
+    no.indice = 0;
+    no.folha = 0;
+    c.nos->push_back(no);
+    if (total <= 4) {
+        emitirFolha(c, primeiro, total, indice);
+        return indice;
+    }
+
+    // SAH em baldes; sem corte útil (ou fundo demais) cai para a mediana no maior eixo
+    int melhorEixo = -1, melhorCorte = 0;
+    float melhorCusto = FLT_MAX;
+    if (profundidade < PROFUNDIDADE_SAH) {
+        for (int e = 0; e < 3; ++e) {
+            float extensao = maxCentro[e] - minCentro[e];
+            if (extensao <= 0.0f) continue;
+            float escala = NBINS / extensao;
+            glm::vec3 bMin[NBINS], bMax[NBINS];
+            uint32_t bN[NBINS] = {};
+            for (int b = 0; b < NBINS; ++b) { bMin[b] = glm::vec3(FLT_MAX); bMax[b] = glm::vec3(-FLT_MAX); }
+            for (uint32_t k = primeiro; k < primeiro + total; ++k) {
+                uint32_t t = c.ordem[k];
+                int b = std::min(NBINS - 1, (int)((c.centros[t][e] - minCentro[e]) * escala));
+                bMin[b] = glm::min(bMin[b], c.minimos[t]);
+                bMax[b] = glm::max(bMax[b], c.maximos[t]);
+                ++bN[b];
+            }
+            float areaDireita[NBINS];
+            uint32_t nDireita[NBINS];
+            glm::vec3 aMin(FLT_MAX), aMax(-FLT_MAX);
+            uint32_t n = 0;
+            for (int b = NBINS - 1; b > 0; --b) {
+                aMin = glm::min(aMin, bMin[b]);
+                aMax = glm::max(aMax, bMax[b]);
+                n += bN[b];
+                areaDireita[b] = area(aMin, aMax);
+                nDireita[b] = n;
+            }
+            aMin = glm::vec3(FLT_MAX);
+            aMax = glm::vec3(-FLT_MAX);
+            n = 0;
+            for (int corte = 1; corte < NBINS; ++corte) {
+                aMin = glm::min(aMin, bMin[corte - 1]);
+                aMax = glm::max(aMax, bMax[corte - 1]);
+                n += bN[corte - 1];
+                if (n == 0 || nDireita[corte] == 0) continue;
+                float custo = area(aMin, aMax) * n + areaDireita[corte] * nDireita[corte];
+                if (custo < melhorCusto) {
+                    melhorCusto = custo;
+                    melhorEixo = e;
+                    melhorCorte = corte;
+                }
+            }
+        }
+    }
+
+    uint32_t* inicio = c.ordem.data() + primeiro;
+    uint32_t* fim = inicio + total;
+    uint32_t meio;
+    if (melhorEixo >= 0) {
+        int e = melhorEixo;
+        float escala = NBINS / (maxCentro[e] - minCentro[e]);
+        meio = (uint32_t)(std::partition(inicio, fim, [&](uint32_t t) {
+            return std::min(NBINS - 1, (int)((c.centros[t][e] - minCentro[e]) * escala)) < melhorCorte;
+        }) - c.ordem.data());
+    } else {
+        glm::vec3 d = maxCentro - minCentro;
+        int e = d.x > d.y ? (d.x > d.z ? 0 : 2) : (d.y > d.z ? 1 : 2);
+        uint32_t* m = inicio + total / 2;
+        std::nth_element(inicio, m, fim, [&](uint32_t a, uint32_t b) { return c.centros[a][e] < c.centros[b][e]; });
+        meio = (uint32_t)(m - c.ordem.data());
+    }
+    construirNo(c, primeiro, meio - primeiro, profundidade + 1);
+    uint32_t direito = construirNo(c, meio, primeiro + total - meio, profundidade + 1);
+    (*c.nos)[indice].indice = direito;
+    return indice;
+}
+
+// Möller-Trumbore nos 4 triângulos do pacote; atualiza 'melhor' se algum acerta mais perto
+inline void testarPacote(const PacoteTriangulos& p, const glm::vec3& o, const glm::vec3& d, AcertoTriangulo& melhor) {
+#ifdef BVH_TRIANGULOS_SSE
+    __m128 e1x = _mm_load_ps(p.e1[0]), e1y = _mm_load_ps(p.e1[1]), e1z = _mm_load_ps(p.e1[2]);
+    __m128 e2x = _mm_load_ps(p.e2[0]), e2y = _mm_load_ps(p.e2[1]), e2z = _mm_load_ps(p.e2[2]);
+    __m128 dx = _mm_set1_ps(d.x), dy = _mm_set1_ps(d.y), dz = _mm_set1_ps(d.z);
+    // P = d x e2
+    __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+    __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+    __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+    __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+    __m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), det);
+    // T = o - v0
+    __m128 tx = _mm_sub_ps(_mm_set1_ps(o.x), _mm_load_ps(p.v0[0]));
+    __m128 ty = _mm_sub_ps(_mm_set1_ps(o.y), _mm_load_ps(p.v0[1]));
+    __m128 tz = _mm_sub_ps(_mm_set1_ps(o.z), _mm_load_ps(p.v0[2]));
+    __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), inv);
+    // Q = T x e1
+    __m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+    __m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+    __m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+    __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inv);
+    __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inv);
+
+    __m128 zero = _mm_setzero_ps();
+    __m128 absDet = _mm_andnot_ps(_mm_set1_ps(-0.0f), det);
+    __m128 acerta = _mm_cmpgt_ps(absDet, _mm_set1_ps(1e-12f));
+    acerta = _mm_and_ps(acerta, _mm_cmpge_ps(u, zero));
+    acerta = _mm_and_ps(acerta, _mm_cmpge_ps(v, zero));
+    acerta = _mm_and_ps(acerta, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+    acerta = _mm_and_ps(acerta, _mm_cmpgt_ps(t, zero));
+    acerta = _mm_and_ps(acerta, _mm_cmplt_ps(t, _mm_set1_ps(melhor.t)));
+    int mascara = _mm_movemask_ps(acerta);
+    if (!mascara) return;
+    alignas(16) float ts[4], us[4], vs[4];
+    _mm_store_ps(ts, t);
+    _mm_store_ps(us, u);
+    _mm_store_ps(vs, v);
+    for (int k = 0; k < 4; ++k) {
+        if ((mascara & (1 << k)) && ts[k] < melhor.t) {
+            melhor.t = ts[k];
+            melhor.u = us[k];
+            melhor.v = vs[k];
+            melhor.triangulo = p.triangulo[k];
+        }
+    }
+#else
+    for (int k = 0; k < 4; ++k) {
+        if (p.triangulo[k] == TRIANGULO_NENHUM) continue;
+        glm::vec3 e1(p.e1[0][k], p.e1[1][k], p.e1[2][k]);
+        glm::vec3 e2(p.e2[0][k], p.e2[1][k], p.e2[2][k]);
+        glm::vec3 pv = glm::cross(d, e2);
+        float det = glm::dot(e1, pv);
+        if (std::fabs(det) <= 1e-12f) continue;
+        float inv = 1.0f / det;
+        glm::vec3 tv = o - glm::vec3(p.v0[0][k], p.v0[1][k], p.v0[2][k]);
+        float u = glm::dot(tv, pv) * inv;
+        glm::vec3 qv = glm::cross(tv, e1);
+        float v = glm::dot(d, qv) * inv;
+        float t = glm::dot(e2, qv) * inv;
+        if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t > 0.0f && t < melhor.t) {
+            melhor.t = t;
+            melhor.u = u;
+            melhor.v = v;
+            melhor.triangulo = p.triangulo[k];
+        }
+    }
+#endif
+}
+
+inline bool raioNoNo(const NoBVHTriangulos& no, const glm::vec3& o, const glm::vec3& inverso, float tMax, float& tEntrada) {
+    float t0 = 0.0f, t1 = tMax;
+    for (int e = 0; e < 3; ++e) {
+        float a = (no.minimo[e] - o[e]) * inverso[e];
+        float b = (no.maximo[e] - o[e]) * inverso[e];
+        if (a > b) std::swap(a, b);
+        t0 = a > t0 ? a : t0;
+        t1 = b < t1 ? b : t1;
+        if (t0 > t1) return false;
+    }
+    tEntrada = t0;
+    return true;
+}
+
+// Funciona direto sobre os blocos do .malha mapeado ou sobre os vetores de BVHTriangulos
+inline bool intersectar(const NoBVHTriangulos* nos, const PacoteTriangulos* pacotes, size_t nNos,
+                        const glm::vec3& origem, const glm::vec3& direcao, float tMax, AcertoTriangulo& acerto) {
+    acerto = AcertoTriangulo();
+    acerto.t = tMax;
+    if (nNos == 0) return false;
+    glm::vec3 inverso(1.0f / direcao.x, 1.0f / direcao.y, 1.0f / direcao.z);
+    float tNo;
+    if (!raioNoNo(nos[0], origem, inverso, tMax, tNo)) return false;
+    uint32_t pilha[TAMANHO_PILHA];
+    float tPilha[TAMANHO_PILHA];
+    int topo = 0;
+    pilha[topo] = 0;
+    tPilha[topo++] = tNo;
+    while (topo > 0) {
+        --topo;
+        if (tPilha[topo] > acerto.t) continue;
+        uint32_t indice = pilha[topo];
+        const NoBVHTriangulos& no = nos[indice];
+        if (no.folha) {
+            testarPacote(pacotes[no.indice], origem, direcao, acerto);
+            continue;
+        }
+        uint32_t a = indice + 1, b = no.indice;
+        float ta = 0.0f, tb = 0.0f;
+        bool acertaA = raioNoNo(nos[a], origem, inverso, acerto.t, ta);
+        bool acertaB = raioNoNo(nos[b], origem, inverso, acerto.t, tb);
+        if (acertaA && acertaB) {
+            if (ta > tb) { // o mais perto fica no topo
+                std::swap(a, b);
+                std::swap(ta, tb);
+            }
+            pilha[topo] = b; tPilha[topo++] = tb;
+            pilha[topo] = a; tPilha[topo++] = ta;
+        } else if (acertaA) {
+            pilha[topo] = a; tPilha[topo++] = ta;
+        } else if (acertaB) {
+            pilha[topo] = b; tPilha[topo++] = tb;
+        }
+    }
+    return acerto.triangulo != TRIANGULO_NENHUM;
+}
+
+} // namespace bvhTriangulos
+
+class BVHTriangulos {
+public:
+    // indices: 3 por triângulo; as posições são os 3 primeiros floats de cada vértice
+    void construir(const float* vertices, size_t floatsPorVertice, const uint32_t* indices, size_t nTriangulos) {
+        using namespace bvhTriangulos;
+        nos.clear();
+        pacotes.clear();
+        if (nTriangulos == 0) return;
+        Construcao c;
+        c.vertices = vertices;
+        c.floatsPorVertice = floatsPorVertice;
+        c.indices = indices;
+        c.nos = &nos;
+        c.pacotes = &pacotes;
+        c.ordem.resize(nTriangulos);
+        c.minimos.resize(nTriangulos);
+        c.maximos.resize(nTriangulos);
+        c.centros.resize(nTriangulos);
+        for (uint32_t t = 0; t < nTriangulos; ++t) {
+            glm::vec3 a = c.vertice(t, 0), b = c.vertice(t, 1), d = c.vertice(t, 2);
+            c.ordem[t] = t;
+            c.minimos[t] = glm::min(a, glm::min(b, d));
+            c.maximos[t] = glm::max(a, glm::max(b, d));
+            c.centros[t] = (c.minimos[t] + c.maximos[t]) * 0.5f;
+        }
+        nos.reserve(nTriangulos / 2 + 1);
+        pacotes.reserve(nTriangulos / 3 + 1);
+        construirNo(c, 0, (uint32_t)nTriangulos, 0);
+    }
+
+    void atribuir(const NoBVHTriangulos* n, size_t nNos, const PacoteTriangulos* p, size_t nPacotes) {
+        nos.assign(n, n + nNos);
+        pacotes.assign(p, p + nPacotes);
+    }
+
+    // Raio no espaço do objeto; a direção não precisa estar normalizada e t é medido nela
+    bool intersectar(const glm::vec3& origem, const glm::vec3& direcao, float tMax, AcertoTriangulo& acerto) const {
+        return bvhTriangulos::intersectar(nos.data(), pacotes.data(), nos.size(), origem, direcao, tMax, acerto);
+    }
+
+    bool vazia() const { return nos.empty(); }
+    const std::vector<NoBVHTriangulos>& nosArvore() const { return nos; }
+    const std::vector<PacoteTriangulos>& pacotesArvore() const { return pacotes; }
+
+private:
+    std::vector<NoBVHTriangulos> nos;
+    std::vector<PacoteTriangulos> pacotes;
+};
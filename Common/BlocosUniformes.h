@@ -0,0 +1,145 @@
+/*
+ *  BlocosUniformes.h
+ *
+ *  Uniform buffer objects (layout std140) compartilhados pelos programas:
+ *
+ *  - Quadro (ponto de ligação 0): câmera e luz. Escrito uma vez por quadro
+ *    com um único glBufferSubData; todo programa que declara o bloco vê o
+ *    valor novo, sem reenviar uniform por programa.
+ *  - Material (ponto de ligação 1): ka/kd/ks/ns. Todos os materiais ficam
+ *    num único buffer, um por fatia alinhada a
+ *    GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT; cada objeto guarda o índice da sua
+ *    fatia e o desenho só troca o glBindBufferRange.
+ *
+ *  Declaração correspondente em GLSL:
+ *
+ *  layout(std140) uniform Quadro {
+ *      mat4 view;
+ *      mat4 projection;
+ *      vec4 lightPos;   // xyz
+ *      vec4 camPos;     // xyz
+ *  };
+ *  layout(std140) uniform Material {
+ *      float ka;
+ *      float kd;
+ *      float ks;
+ *      float ns;
+ *  };
+ *
+ *  GLSL 3.30 não aceita layout(binding = N), então cada programa precisa de
+ *  ligarBlocosUniformes(programa) depois de linkado.
+ */
+
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstring>
+#include <vector>
+
+const GLuint PONTO_BLOCO_QUADRO = 0;
+const GLuint PONTO_BLOCO_MATERIAL = 1;
+
+// Espelho em C++ dos blocos: em std140, mat4 ocupa 64 bytes e vec4 16
+struct BlocoQuadro {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 lightPos;
+    glm::vec4 camPos;
+};
+static_assert(sizeof(BlocoQuadro) == 160, "BlocoQuadro fora do layout std140");
+
+struct BlocoMaterial {
+    float ka = 0.1f;
+    float kd = 0.7f;
+    float ks = 0.5f;
+    float ns = 32.0f;
+};
+static_assert(sizeof(BlocoMaterial) == 16, "BlocoMaterial fora do layout std140");
+
+// Associa os blocos "Quadro" e "Material" do programa aos pontos de ligação
+inline void ligarBlocosUniformes(GLuint programa) {
+    GLuint quadro = glGetUniformBlockIndex(programa, "Quadro");
+    if (quadro != GL_INVALID_INDEX) glUniformBlockBinding(programa, quadro, PONTO_BLOCO_QUADRO);
+    GLuint material = glGetUniformBlockIndex(programa, "Material");
+    if (material != GL_INVALID_INDEX) glUniformBlockBinding(programa, material, PONTO_BLOCO_MATERIAL);
+}
+
+// UBO com um único bloco T, ligado por inteiro ao ponto de ligação
+template <typename T>
+class BufferUniforme {
+public:
+    void criar(GLuint ponto) {
+        glGenBuffers(1, &ubo);
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(T), nullptr, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, ponto, ubo);
+    }
+
+    void atualizar(const T& valor) {
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &valor);
+    }
+
+    GLuint id() const { return ubo; }
+
+private:
+    GLuint ubo = 0;
+};
+
+// Todos os materiais da cena num só UBO, selecionados por índice
+class TabelaMateriais {
+public:
+    void criar(GLuint ponto) {
+        pontoLigacao = ponto;
+        GLint alinhamento = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alinhamento);
+        passo = ((sizeof(BlocoMaterial) + alinhamento - 1) / alinhamento) * alinhamento;
+        glGenBuffers(1, &ubo);
+    }
+
+    // Retorna o índice do material; o envio acontece no próximo enviar()
+    int adicionar(const BlocoMaterial& m) {
+        int indice = (int)tamanho();
+        dados.resize(dados.size() + passo);
+        atualizar(indice, m);
+        return indice;
+    }
+
+    void atualizar(int indice, const BlocoMaterial& m) {
+        memcpy(&dados[indice * passo], &m, sizeof(m));
+        sujo = true;
+    }
+
+    // Sobe o buffer inteiro se algo mudou desde o último envio
+    void enviar() {
+        if (!sujo) return;
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        if (dados.size() > capacidade) {
+            glBufferData(GL_UNIFORM_BUFFER, dados.size(), dados.data(), GL_DYNAMIC_DRAW);
+            capacidade = dados.size();
+        } else {
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, dados.size(), dados.data());
+        }
+        sujo = false;
+        ligado = -1;
+    }
+
+    // Seleciona o material para os próximos desenhos (não religa o mesmo)
+    void ligar(int indice) {
+        if (indice == ligado) return;
+        glBindBufferRange(GL_UNIFORM_BUFFER, pontoLigacao, ubo, indice * passo, sizeof(BlocoMaterial));
+        ligado = indice;
+    }
+
+    size_t tamanho() const { return passo ? dados.size() / passo : 0; }
+
+private:
+    GLuint ubo = 0;
+    GLuint pontoLigacao = 0;
+    size_t passo = 0;
+    size_t capacidade = 0;
+    std::vector<unsigned char> dados;
+    bool sujo = false;
+    int ligado = -1;
+};
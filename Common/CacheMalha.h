@@ -0,0 +1,343 @@
+/*
+ *  CacheMalha.h
+ *
+ *  Cache binário de malhas (.malha) gravado ao lado do .obj na primeira
+ *  carga. Nas execuções seguintes o arquivo é mapeado em memória e os
+ *  blocos de vértices e índices vão direto para o glBufferData, sem ler
+ *  texto nenhum.
+ *
+ *  Layout do arquivo (little-endian, blocos alinhados em 16 bytes):
+ *    CabecalhoMalha        - mágica, versão, descritor de layout, contagens,
+ *                            limites (AABB e esfera), material e dados da
+ *                            fonte (.obj/.mtl)
+ *    vértices              - nVertices * floatsPorVertice floats intercalados
+ *    índices               - nIndices * bytesPorIndice (uint16 ou uint32)
+ *    nós da BVH            - nNosBVH * NoBVHTriangulos (ver BVHTriangulos.h)
+ *    pacotes da BVH        - nPacotesBVH * PacoteTriangulos
+ *    nome do map_Kd        - tamanhoMapKd bytes
+ *    nome do mtllib        - tamanhoMtllib bytes
+ *
+ *  O cache é considerado válido quando tamanho e data de modificação do .obj
+ *  e do .mtl batem com o cabeçalho. Se só a data mudou, o hash FNV-1a do
+ *  conteúdo decide; qualquer diferença real reconstrói o arquivo.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  MalhaCacheada malha;
+ *  if (carregarMalhaCacheada("../assets/Modelos3D/Suzanne.obj", malha)) {
+ *      glBufferData(GL_ARRAY_BUFFER, malha.bytesVertices(), malha.vertices, GL_STATIC_DRAW);
+ *      glBufferData(GL_ELEMENT_ARRAY_BUFFER, malha.bytesIndices(), malha.indices, GL_STATIC_DRAW);
+ *      ...
+ *  }
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "ArquivoMapeado.h"
+#include "BVHTriangulos.h"
+#include "CarregadorOBJ.h"
+
+const char MAGICA_MALHA[4] = { 'M', 'L', 'H', 'B' };
+const uint32_t VERSAO_MALHA = 3;
+
+enum SemanticaAtributo : uint32_t {
+    ATRIBUTO_POSICAO = 0,
+    ATRIBUTO_COR = 1,
+    ATRIBUTO_NORMAL = 2,
+    ATRIBUTO_TEXCOORD = 3
+};
+
+// Um atributo do vértice intercalado (deslocamento em floats)
+struct AtributoMalha {
+    uint32_t semantica;
+    uint32_t componentes;
+    uint32_t deslocamento;
+};
+
+// Volumes envolventes da malha no espaço do objeto, usados no culling
+struct LimitesMalha {
+    float minimo[3];
+    float maximo[3];
+    float centro[3];               // centro da AABB
+    float raio;                    // maior distância de um vértice ao centro
+};
+
+inline LimitesMalha calcularLimites(const float* vertices, size_t nVertices, size_t floatsPorVertice) {
+    LimitesMalha l;
+    if (nVertices == 0) {
+        memset(&l, 0, sizeof(l));
+        return l;
+    }
+    for (int e = 0; e < 3; ++e) l.minimo[e] = l.maximo[e] = vertices[e];
+    for (size_t i = 1; i < nVertices; ++i) {
+        const float* p = vertices + i * floatsPorVertice;
+        for (int e = 0; e < 3; ++e) {
+            l.minimo[e] = std::min(l.minimo[e], p[e]);
+            l.maximo[e] = std::max(l.maximo[e], p[e]);
+        }
+    }
+    for (int e = 0; e < 3; ++e) l.centro[e] = 0.5f * (l.minimo[e] + l.maximo[e]);
+    float raio2 = 0.0f;
+    for (size_t i = 0; i < nVertices; ++i) {
+        const float* p = vertices + i * floatsPorVertice;
+        float dx = p[0] - l.centro[0], dy = p[1] - l.centro[1], dz = p[2] - l.centro[2];
+        raio2 = std::max(raio2, dx * dx + dy * dy + dz * dz);
+    }
+    l.raio = std::sqrt(raio2);
+    return l;
+}
+
+struct CabecalhoMalha {
+    char magica[4];
+    uint32_t versao;
+
+    // Descritor de layout
+    uint32_t floatsPorVertice;
+    uint32_t nAtributos;
+    AtributoMalha atributos[4];
+
+    uint32_t nVertices;
+    uint32_t nIndices;
+    uint32_t bytesPorIndice;       // 2 ou 4
+
+    LimitesMalha limites;
+    uint32_t nNosBVH;              // BVH dos triângulos, para o picking
+    uint32_t nPacotesBVH;
+
+    // Material
+    float ka, kd, ks, ns;
+    uint32_t tamanhoMapKd;
+    uint32_t tamanhoMtllib;
+
+    // Fonte
+    uint64_t hashFonte;            // FNV-1a de .obj seguido do .mtl
+    uint64_t tamanhoObj, tamanhoMtl;
+    int64_t mtimeObj, mtimeMtl;
+
+    uint64_t offsetVertices, offsetIndices, offsetMapKd, offsetMtllib;
+    uint64_t offsetNosBVH, offsetPacotesBVH;
+};
+
+struct MalhaCacheada {
+    ArquivoMapeado arquivo;        // .malha mapeado
+    std::vector<char> memoria;     // usado só se o cache não pôde ser gravado
+    const CabecalhoMalha* cabecalho = nullptr;
+    const float* vertices = nullptr;
+    const void* indices = nullptr;
+    const NoBVHTriangulos* nosBVH = nullptr;
+    const PacoteTriangulos* pacotesBVH = nullptr;
+    MaterialOBJ material;
+    std::string diretorio;
+    bool doCache = false;          // true quando o .obj não precisou ser lido
+    bool cacheGravado = false;     // o .malha no disco está em dia; false: a malha ficou só na memória
+
+    size_t nVertices() const { return cabecalho->nVertices; }
+    size_t nIndices() const { return cabecalho->nIndices; }
+    size_t bytesVertices() const { return (size_t)cabecalho->nVertices * cabecalho->floatsPorVertice * sizeof(float); }
+    size_t bytesIndices() const { return (size_t)cabecalho->nIndices * cabecalho->bytesPorIndice; }
+    bool indices16Bits() const { return cabecalho->bytesPorIndice == 2; }
+    const LimitesMalha& limites() const { return cabecalho->limites; }
+    void copiarBVH(BVHTriangulos& bvh) const { bvh.atribuir(nosBVH, cabecalho->nNosBVH, pacotesBVH, cabecalho->nPacotesBVH); }
+};
+
+namespace cacheMalha {
+
+inline std::string caminhoCache(const std::string& objPath, bool comNormais) {
+    return objPath + (comNormais ? ".11f.malha" : ".8f.malha");
+}
+
+inline bool infoArquivo(const std::string& caminho, uint64_t& tamanho, int64_t& mtime) {
+    std::error_code ec;
+    tamanho = std::filesystem::file_size(caminho, ec);
+    if (ec) { tamanho = 0; mtime = 0; return false; }
+    mtime = (int64_t)std::filesystem::last_write_time(caminho, ec).time_since_epoch().count();
+    if (ec) mtime = 0;
+    return true;
+}
+
+inline uint64_t fnv1a(const char* p, size_t n, uint64_t h = 14695981039346656037ull) {
+    for (size_t i = 0; i < n; ++i) {
+        h ^= (unsigned char)p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+inline uint64_t hashFonte(const std::string& objPath, const std::string& mtlPath) {
+    uint64_t h = 14695981039346656037ull;
+    ArquivoMapeado obj(objPath);
+    if (obj.aberto()) h = fnv1a(obj.dados(), obj.tamanho(), h);
+    if (!mtlPath.empty()) {
+        ArquivoMapeado mtl(mtlPath);
+        if (mtl.aberto()) h = fnv1a(mtl.dados(), mtl.tamanho(), h);
+    }
+    return h;
+}
+
+// Confere mágica, versão, layout e se todos os blocos cabem no arquivo
+inline bool apontar(MalhaCacheada& saida, const char* base, size_t tamanho, bool comNormais) {
+    if (tamanho < sizeof(CabecalhoMalha)) return false;
+    const CabecalhoMalha* c = (const CabecalhoMalha*)base;
+    uint32_t floatsEsperados = comNormais ? FLOATS_POR_VERTICE : FLOATS_POR_VERTICE - 3;
+    if (memcmp(c->magica, MAGICA_MALHA, 4) != 0 || c->versao != VERSAO_MALHA) return false;
+    if (c->floatsPorVertice != floatsEsperados || (c->bytesPorIndice != 2 && c->bytesPorIndice != 4)) return false;
+    uint64_t bytesV = (uint64_t)c->nVertices * c->floatsPorVertice * sizeof(float);
+    uint64_t bytesI = (uint64_t)c->nIndices * c->bytesPorIndice;
+    uint64_t bytesNos = (uint64_t)c->nNosBVH * sizeof(NoBVHTriangulos);
+    uint64_t bytesPacotes = (uint64_t)c->nPacotesBVH * sizeof(PacoteTriangulos);
+    if (c->offsetVertices + bytesV > tamanho || c->offsetIndices + bytesI > tamanho ||
+        c->offsetNosBVH + bytesNos > tamanho || c->offsetPacotesBVH + bytesPacotes > tamanho ||
+        c->offsetMapKd + c->tamanhoMapKd > tamanho || c->offsetMtllib + c->tamanhoMtllib > tamanho) return false;
+    saida.cabecalho = c;
+    saida.vertices = (const float*)(base + c->offsetVertices);
+    saida.indices = base + c->offsetIndices;
+    saida.nosBVH = (const NoBVHTriangulos*)(base + c->offsetNosBVH);
+    saida.pacotesBVH = (const PacoteTriangulos*)(base + c->offsetPacotesBVH);
+    saida.material.ka = c->ka; saida.material.kd = c->kd;
+    saida.material.ks = c->ks; saida.material.ns = c->ns;
+    saida.material.mapKd.assign(base + c->offsetMapKd, c->tamanhoMapKd);
+    return true;
+}
+
+inline std::string mtllibDoCache(const MalhaCacheada& m) {
+    const char* base = (const char*)m.cabecalho;
+    return std::string(base + m.cabecalho->offsetMtllib, m.cabecalho->tamanhoMtllib);
+}
+
+inline void serializar(const MalhaOBJ& malha, const MalhaIndexada& indexada, std::vector<char>& saida) {
+    CabecalhoMalha c;
+    memset(&c, 0, sizeof(c));
+    memcpy(c.magica, MAGICA_MALHA, 4);
+    c.versao = VERSAO_MALHA;
+    c.floatsPorVertice = (uint32_t)indexada.floatsPorVertice;
+    bool comNormais = indexada.floatsPorVertice == FLOATS_POR_VERTICE;
+    uint32_t d = 0;
+    c.atributos[c.nAtributos++] = { ATRIBUTO_POSICAO, 3, d }; d += 3;
+    c.atributos[c.nAtributos++] = { ATRIBUTO_COR, 3, d }; d += 3;
+    if (comNormais) { c.atributos[c.nAtributos++] = { ATRIBUTO_NORMAL, 3, d }; d += 3; }
+    c.atributos[c.nAtributos++] = { ATRIBUTO_TEXCOORD, 2, d };
+    c.nVertices = (uint32_t)indexada.nVertices();
+    c.nIndices = (uint32_t)indexada.indices.size();
+    c.bytesPorIndice = indexada.indices16Bits() ? 2 : 4;
+    c.limites = calcularLimites(indexada.vertices.data(), indexada.nVertices(), indexada.floatsPorVertice);
+    c.ka = malha.material.ka; c.kd = malha.material.kd;
+    c.ks = malha.material.ks; c.ns = malha.material.ns;
+    c.tamanhoMapKd = (uint32_t)malha.material.mapKd.size();
+    c.tamanhoMtllib = (uint32_t)malha.mtllib.size();
+    BVHTriangulos bvh;
+    bvh.construir(indexada.vertices.data(), indexada.floatsPorVertice, indexada.indices.data(), indexada.indices.size() / 3);
+    c.nNosBVH = (uint32_t)bvh.nosArvore().size();
+    c.nPacotesBVH = (uint32_t)bvh.pacotesArvore().size();
+
+    uint64_t bytesV = indexada.vertices.size() * sizeof(float);
+    uint64_t bytesI = (uint64_t)c.nIndices * c.bytesPorIndice;
+    uint64_t bytesNos = (uint64_t)c.nNosBVH * sizeof(NoBVHTriangulos);
+    uint64_t bytesPacotes = (uint64_t)c.nPacotesBVH * sizeof(PacoteTriangulos);
+    c.offsetVertices = alinhar16(sizeof(CabecalhoMalha));
+    c.offsetIndices = alinhar16(c.offsetVertices + bytesV);
+    c.offsetNosBVH = alinhar16(c.offsetIndices + bytesI);
+    c.offsetPacotesBVH = alinhar16(c.offsetNosBVH + bytesNos);
+    c.offsetMapKd = c.offsetPacotesBVH + bytesPacotes;
+    c.offsetMtllib = c.offsetMapKd + c.tamanhoMapKd;
+
+    saida.assign((size_t)(c.offsetMtllib + c.tamanhoMtllib), 0);
+    memcpy(saida.data(), &c, sizeof(c));
+    memcpy(&saida[c.offsetVertices], indexada.vertices.data(), bytesV);
+    if (c.bytesPorIndice == 2) {
+        uint16_t* dst = (uint16_t*)&saida[c.offsetIndices];
+        for (uint32_t i = 0; i < c.nIndices; ++i) dst[i] = (uint16_t)indexada.indices[i];
+    } else {
+        memcpy(&saida[c.offsetIndices], indexada.indices.data(), bytesI);
+    }
+    memcpy(&saida[c.offsetNosBVH], bvh.nosArvore().data(), bytesNos);
+    memcpy(&saida[c.offsetPacotesBVH], bvh.pacotesArvore().data(), bytesPacotes);
+    memcpy(&saida[c.offsetMapKd], malha.material.mapKd.data(), c.tamanhoMapKd);
+    memcpy(&saida[c.offsetMtllib], malha.mtllib.data(), c.tamanhoMtllib);
+}
+
+// Preenche os campos da fonte no cabeçalho já serializado
+inline void carimbarFonte(std::vector<char>& dados, const std::string& objPath, const std::string& mtlPath, uint64_t hash) {
+    CabecalhoMalha* c = (CabecalhoMalha*)dados.data();
+    infoArquivo(objPath, c->tamanhoObj, c->mtimeObj);
+    if (mtlPath.empty() || !infoArquivo(mtlPath, c->tamanhoMtl, c->mtimeMtl)) {
+        c->tamanhoMtl = 0;
+        c->mtimeMtl = 0;
+    }
+    c->hashFonte = hash;
+}
+
+inline bool usarMemoria(MalhaCacheada& saida, std::vector<char>& dados, bool comNormais) {
+    saida.arquivo.fechar();
+    saida.memoria.swap(dados);
+    return apontar(saida, saida.memoria.data(), saida.memoria.size(), comNormais);
+}
+
+} // namespace cacheMalha
+
+// Carrega a malha indexada de objPath usando o cache .malha sempre que ele
+// estiver em dia com o .obj/.mtl; caso contrário lê o texto e regrava o cache.
+inline bool carregarMalhaCacheada(const std::string& objPath, MalhaCacheada& saida, bool comNormais = true) {
+    using namespace cacheMalha;
+    std::string caminho = caminhoCache(objPath, comNormais);
+    saida.diretorio = leitorOBJ::diretorioDe(objPath);
+    saida.doCache = false;
+    saida.cacheGravado = false;
+
+    uint64_t tamObj = 0, tamMtl = 0;
+    int64_t mtimeObj = 0, mtimeMtl = 0;
+    bool temFonte = infoArquivo(objPath, tamObj, mtimeObj);
+
+    if (saida.arquivo.abrir(caminho) && apontar(saida, saida.arquivo.dados(), saida.arquivo.tamanho(), comNormais)) {
+        const CabecalhoMalha& c = *saida.cabecalho;
+        std::string mtllib = mtllibDoCache(saida);
+        std::string mtlPath = mtllib.empty() ? std::string() : saida.diretorio + mtllib;
+        if (!mtlPath.empty()) infoArquivo(mtlPath, tamMtl, mtimeMtl);
+
+        // Sem o .obj por perto, o cache é a única fonte disponível
+        if (!temFonte) { saida.doCache = saida.cacheGravado = true; return true; }
+        if (c.tamanhoObj == tamObj && c.mtimeObj == mtimeObj &&
+            c.tamanhoMtl == tamMtl && c.mtimeMtl == mtimeMtl) {
+            saida.doCache = saida.cacheGravado = true;
+            return true;
+        }
+        // Data mudou (cópia, checkout...): confere o conteúdo antes de reconstruir
+        if (c.tamanhoObj == tamObj && c.tamanhoMtl == tamMtl && c.hashFonte == hashFonte(objPath, mtlPath)) {
+            std::vector<char> dados(saida.arquivo.dados(), saida.arquivo.dados() + saida.arquivo.tamanho());
+            carimbarFonte(dados, objPath, mtlPath, c.hashFonte);
+            saida.arquivo.fechar();
+            saida.cacheGravado = gravarAtomico(caminho, dados);
+            if (saida.cacheGravado && saida.arquivo.abrir(caminho) &&
+                apontar(saida, saida.arquivo.dados(), saida.arquivo.tamanho(), comNormais)) {
+                saida.doCache = true;
+                return true;
+            }
+            saida.doCache = usarMemoria(saida, dados, comNormais);
+            return saida.doCache;
+        }
+    }
+    saida.arquivo.fechar();
+
+    // Cache ausente ou desatualizado: lê o .obj e reconstrói
+    MalhaOBJ malha;
+    if (!lerOBJParalelo(objPath, malha)) return false;
+    MalhaIndexada indexada;
+    indexarMalha(malha, indexada, comNormais);
+    std::vector<char> dados;
+    serializar(malha, indexada, dados);
+    std::string mtlPath = malha.mtllib.empty() ? std::string() : malha.diretorio + malha.mtllib;
+    carimbarFonte(dados, objPath, mtlPath, hashFonte(objPath, mtlPath));
+
+    saida.cacheGravado = gravarAtomico(caminho, dados);
+    if (saida.cacheGravado && saida.arquivo.abrir(caminho) &&
+        apontar(saida, saida.arquivo.dados(), saida.arquivo.tamanho(), comNormais)) return true;
+    return usarMemoria(saida, dados, comNormais);
+}
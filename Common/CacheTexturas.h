@@ -0,0 +1,277 @@
+/*
+ *  CacheTexturas.h
+ *
+ *  Texturas compartilhadas entre objetos. Cada imagem é identificada pelo
+ *  caminho canônico do arquivo mais o hash FNV-1a do conteúdo (o hash é
+ *  refeito só quando o tamanho ou a data do arquivo mudam), e cada chave
+ *  é decodificada e enviada à GPU uma única vez enquanto houver alguém
+ *  usando a textura: carregar a mesma Suzanne mil vezes custa um
+ *  stbi_load e um glTexImage2D.
+ *
+ *  As texturas são entregues como RefTextura (shared_ptr): quando o último
+ *  Objeto3D que a referencia some, a textura é apagada da GPU e sai da
+ *  contagem de bytes. A decodificação pode rodar em qualquer thread (é o
+ *  que o CarregadorAssincrono faz); se duas threads pedirem a mesma chave
+ *  ao mesmo tempo, a segunda espera a primeira em vez de decodificar de
+ *  novo. O envio fica com a thread dona do contexto, pela função passada
+ *  no construtor, e a liberação também (então os objetos precisam sumir
+ *  antes do glfwTerminate).
+ *
+ *  Forma de uso
+ *  -----------------
+ *  CacheTexturas texturas(criarTextura, [](unsigned id) { glDeleteTextures(1, &id); });
+ *  obj.textura = texturas.textura("../assets/tex/pixelWall.png"); // síncrono
+ *  obj.textura = texturas.branca();                               // 1x1 branca
+ *  glBindTexture(GL_TEXTURE_2D, obj.textura->id);
+ *
+ *  // com o CarregadorAssincrono(texturas), para cada ASSET_TEXTURA:
+ *  if (RefTextura t = texturas.textura(asset->chave, asset->imagem.get())) obj.textura = t;
+ *
+ *  stb_image.h precisa estar incluído (com STB_IMAGE_IMPLEMENTATION em
+ *  algum ponto do programa), como já é feito nos trabalhos.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+#ifndef STBI_INCLUDE_STB_IMAGE_H
+#include "stb_image.h"
+#endif
+
+#include "ArquivoMapeado.h"
+#include "CacheMalha.h"
+
+struct ChaveTextura {
+    std::string caminho; // canônico
+    uint64_t hash = 0;   // FNV-1a do conteúdo
+
+    bool valida() const { return !caminho.empty(); }
+    bool operator<(const ChaveTextura& o) const { return std::tie(caminho, hash) < std::tie(o.caminho, o.hash); }
+};
+
+// Pixels decodificados, à espera do envio para a GPU
+struct ImagemTextura {
+    unsigned char* pixels = nullptr;
+    int largura = 0, altura = 0, canais = 0;
+
+    ImagemTextura() = default;
+    ImagemTextura(const ImagemTextura&) = delete;
+    ImagemTextura& operator=(const ImagemTextura&) = delete;
+    ~ImagemTextura() { if (pixels) stbi_image_free(pixels); }
+};
+
+struct TexturaGPU {
+    unsigned id = 0;       // nome da textura no OpenGL
+    int largura = 0, altura = 0, canais = 0;
+    size_t bytesGPU = 0;   // nível 0 mais os mipmaps, com os canais enviados
+    ChaveTextura chave;
+};
+
+typedef std::shared_ptr<const TexturaGPU> RefTextura;
+
+struct EstatisticasTexturas {
+    size_t decodificacoes = 0; // stbi_load feitos
+    size_t envios = 0;         // texturas criadas na GPU
+    size_t reusos = 0;         // pedidos atendidos por uma textura já residente
+    size_t liberadas = 0;      // texturas apagadas porque ninguém mais as usava
+    size_t residentes = 0;
+    size_t bytesGPU = 0;
+};
+
+class CacheTexturas {
+public:
+    typedef std::function<unsigned(const unsigned char* pixels, int largura, int altura, int canais)> FuncaoEnvio;
+    typedef std::function<void(unsigned id)> FuncaoLiberacao;
+
+    CacheTexturas(FuncaoEnvio enviar, FuncaoLiberacao liberar) : estado(std::make_shared<Estado>()) {
+        estado->enviar = std::move(enviar);
+        estado->liberar = std::move(liberar);
+    }
+
+    CacheTexturas(const CacheTexturas&) = delete;
+    CacheTexturas& operator=(const CacheTexturas&) = delete;
+
+    // Qualquer thread. Falha se o arquivo não abrir
+    bool chave(const std::string& caminho, ChaveTextura& saida) {
+        uint64_t tamanho;
+        int64_t mtime;
+        if (caminho.empty() || !cacheMalha::infoArquivo(caminho, tamanho, mtime)) return false;
+        {
+            std::lock_guard<std::mutex> trava(estado->mutex);
+            auto it = estado->chaves.find(caminho);
+            if (it != estado->chaves.end() && it->second.tamanho == tamanho && it->second.mtime == mtime) {
+                saida = it->second.chave;
+                return true;
+            }
+        }
+        ArquivoMapeado arq(caminho);
+        if (!arq.aberto()) return false;
+        std::error_code ec;
+        std::filesystem::path canonico = std::filesystem::weakly_canonical(caminho, ec);
+        saida.caminho = ec ? caminho : canonico.string();
+        saida.hash = cacheMalha::fnv1a(arq.dados(), arq.tamanho());
+        std::lock_guard<std::mutex> trava(estado->mutex);
+        estado->chaves[caminho] = { tamanho, mtime, saida };
+        return true;
+    }
+
+    // Qualquer thread. Devolve os pixels da chave, decodificando só se
+    // ninguém mais os tiver; imagem fica nula (e o retorno é true) quando
+    // a textura já está na GPU e não precisa deles. false: não decodificou
+    bool decodificar(const ChaveTextura& chave, std::shared_ptr<const ImagemTextura>& imagem) {
+        imagem.reset();
+        std::unique_lock<std::mutex> trava(estado->mutex);
+        for (;;) {
+            Entrada& e = estado->entradas[chave];
+            if (!e.gpu.expired()) return true;
+            if ((imagem = e.imagem.lock())) return true;
+            if (!e.decodificando) {
+                e.decodificando = true;
+                break;
+            }
+            estado->decodificado.wait(trava);
+        }
+        trava.unlock();
+
+        std::shared_ptr<ImagemTextura> nova = std::make_shared<ImagemTextura>();
+        ArquivoMapeado arq(chave.caminho);
+        if (arq.aberto() && arq.tamanho() > 0)
+            nova->pixels = stbi_load_from_memory((const unsigned char*)arq.dados(), (int)arq.tamanho(), &nova->largura,
+                                                 &nova->altura, &nova->canais, 0);
+
+        trava.lock();
+        Entrada& e = estado->entradas[chave];
+        e.decodificando = false;
+        if (nova->pixels) {
+            e.imagem = nova;
+            imagem = nova;
+            ++estado->estatisticas.decodificacoes;
+        } else if (e.gpu.expired()) {
+            estado->entradas.erase(chave);
+        }
+        trava.unlock();
+        estado->decodificado.notify_all();
+        return imagem != nullptr;
+    }
+
+    // Thread do contexto. A textura residente da chave, ou uma nova feita
+    // com imagem (decodificada aqui mesmo se vier nula); nullptr se falhar
+    RefTextura textura(const ChaveTextura& chave, const ImagemTextura* imagem = nullptr) {
+        if (RefTextura t = residente(chave)) return t;
+        // Só esta thread cria texturas, então ninguém mais pode ter enviado a chave desde a consulta
+        std::shared_ptr<const ImagemTextura> decodificada;
+        if (!imagem) {
+            if (!decodificar(chave, decodificada) || !decodificada) return nullptr;
+            imagem = decodificada.get();
+        }
+        return criar(chave, imagem->pixels, imagem->largura, imagem->altura, imagem->canais);
+    }
+
+    // Thread do contexto. Chave, decodificação e envio de uma vez
+    RefTextura textura(const std::string& caminho) {
+        ChaveTextura c;
+        return chave(caminho, c) ? textura(c) : nullptr;
+    }
+
+    // Textura branca 1x1 compartilhada, para placeholders e materiais sem map_Kd
+    RefTextura branca() {
+        static const unsigned char pixels[4] = { 255, 255, 255, 255 };
+        ChaveTextura c;
+        c.caminho = "<branca>";
+        if (RefTextura t = residente(c)) return t;
+        return criar(c, pixels, 1, 1, 4);
+    }
+
+    EstatisticasTexturas estatisticas() const {
+        std::lock_guard<std::mutex> trava(estado->mutex);
+        return estado->estatisticas;
+    }
+
+    // Bytes do nível 0 e de todos os mipmaps até 1x1
+    static size_t bytesComMipmaps(int largura, int altura, int canais) {
+        size_t total = 0;
+        for (;;) {
+            total += (size_t)largura * altura * canais;
+            if (largura == 1 && altura == 1) return total;
+            largura = largura > 1 ? largura / 2 : 1;
+            altura = altura > 1 ? altura / 2 : 1;
+        }
+    }
+
+private:
+    struct Entrada {
+        std::weak_ptr<const ImagemTextura> imagem;
+        std::weak_ptr<const TexturaGPU> gpu;
+        bool decodificando = false;
+    };
+
+    struct ChaveMemorizada {
+        uint64_t tamanho;
+        int64_t mtime;
+        ChaveTextura chave;
+    };
+
+    // Fica vivo enquanto houver RefTextura, mesmo que o cache já tenha sido destruído
+    struct Estado {
+        FuncaoEnvio enviar;
+        FuncaoLiberacao liberar;
+        mutable std::mutex mutex;
+        std::condition_variable decodificado;
+        std::map<ChaveTextura, Entrada> entradas;
+        std::unordered_map<std::string, ChaveMemorizada> chaves; // pelo caminho como foi pedido
+        EstatisticasTexturas estatisticas;
+    };
+
+    RefTextura residente(const ChaveTextura& chave) {
+        std::lock_guard<std::mutex> trava(estado->mutex);
+        auto it = estado->entradas.find(chave);
+        if (it == estado->entradas.end()) return nullptr;
+        RefTextura t = it->second.gpu.lock();
+        if (t) ++estado->estatisticas.reusos;
+        return t;
+    }
+
+    RefTextura criar(const ChaveTextura& chave, const unsigned char* pixels, int largura, int altura, int canais) {
+        TexturaGPU* t = new TexturaGPU();
+        t->id = estado->enviar(pixels, largura, altura, canais);
+        t->largura = largura;
+        t->altura = altura;
+        t->canais = canais;
+        t->bytesGPU = bytesComMipmaps(largura, altura, canais);
+        t->chave = chave;
+        std::shared_ptr<Estado> dono = estado;
+        RefTextura ref(t, [dono](const TexturaGPU* t) {
+            {
+                std::lock_guard<std::mutex> trava(dono->mutex);
+                auto it = dono->entradas.find(t->chave);
+                if (it != dono->entradas.end() && it->second.gpu.expired() && it->second.imagem.expired() &&
+                    !it->second.decodificando)
+                    dono->entradas.erase(it);
+                ++dono->estatisticas.liberadas;
+                --dono->estatisticas.residentes;
+                dono->estatisticas.bytesGPU -= t->bytesGPU;
+            }
+            dono->liberar(t->id);
+            delete t;
+        });
+        std::lock_guard<std::mutex> trava(estado->mutex);
+        estado->entradas[chave].gpu = ref;
+        ++estado->estatisticas.envios;
+        ++estado->estatisticas.residentes;
+        estado->estatisticas.bytesGPU += t->bytesGPU;
+        return ref;
+    }
+
+    std::shared_ptr<Estado> estado;
+};
@@ -0,0 +1,296 @@
+/*
+ *  CarregadorAssincrono.h
+ *
+ *  Carregamento de assets em segundo plano. Threads de trabalho fazem a
+ *  parte de CPU (leitura do .obj/.malha, parse, stbi_load) e empurram os
+ *  buffers prontos numa fila sem trava (FilaSemTrava). A thread de
+ *  renderização, que é a dona do contexto OpenGL, retira os itens a cada
+ *  quadro e faz os glBufferData/glTexImage2D dentro de um orçamento de
+ *  tempo, para que a janela apareça e continue respondendo enquanto os
+ *  modelos chegam.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  CarregadorAssincrono carregador;
+ *  carregador.pedirModelo(0, "../assets/Modelos3D/Suzanne.obj", "../assets/tex/pixelWall.png");
+ *  ...
+ *  // no loop, antes de desenhar:
+ *  double limite = glfwGetTime() + 0.004;
+ *  while (glfwGetTime() < limite) {
+ *      unique_ptr<AssetPronto> asset = carregador.proximo();
+ *      if (!asset) break;
+ *      ... envia asset->malha / asset->pixels para a GPU ...
+ *  }
+ *
+ *  Com um CacheTexturas no construtor, as texturas vêm em asset->chave e
+ *  asset->imagem em vez de asset->pixels: a mesma imagem pedida por vários
+ *  modelos é decodificada uma vez só, e nem isso se ela já estiver na GPU
+ *  (imagem nula; o cache devolve a textura residente).
+ *
+ *  stb_image.h precisa estar incluído (com STB_IMAGE_IMPLEMENTATION em
+ *  algum ponto do programa), como já é feito nos trabalhos.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef STBI_INCLUDE_STB_IMAGE_H
+#include "stb_image.h"
+#endif
+
+#include "CacheMalha.h"
+#include "CacheTexturas.h"
+
+// Fila limitada com vários produtores e consumidores, sem mutex
+// (algoritmo de D. Vyukov: cada célula tem um número de sequência que diz
+// se ela está livre para escrita ou pronta para leitura).
+template <typename T>
+class FilaSemTrava {
+public:
+    explicit FilaSemTrava(size_t capacidade) {
+        size_t n = 2;
+        while (n < capacidade) n <<= 1;
+        mascara = n - 1;
+        celulas.reset(new Celula[n]);
+        for (size_t i = 0; i < n; ++i) celulas[i].sequencia.store(i, std::memory_order_relaxed);
+    }
+
+    FilaSemTrava(const FilaSemTrava&) = delete;
+    FilaSemTrava& operator=(const FilaSemTrava&) = delete;
+
+    // Retorna false se a fila estiver cheia
+    bool empurrar(const T& valor) {
+        size_t pos = entrada.load(std::memory_order_relaxed);
+        for (;;) {
+            Celula& c = celulas[pos & mascara];
+            size_t seq = c.sequencia.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if (dif == 0) {
+                if (entrada.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.dado = valor;
+                    c.sequencia.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = entrada.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Retorna false se a fila estiver vazia
+    bool retirar(T& valor) {
+        size_t pos = saida.load(std::memory_order_relaxed);
+        for (;;) {
+            Celula& c = celulas[pos & mascara];
+            size_t seq = c.sequencia.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (dif == 0) {
+                if (saida.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    valor = c.dado;
+                    c.sequencia.store(pos + mascara + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = saida.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Celula {
+        std::atomic<size_t> sequencia;
+        T dado;
+    };
+    std::unique_ptr<Celula[]> celulas;
+    size_t mascara;
+    alignas(64) std::atomic<size_t> entrada{0};
+    alignas(64) std::atomic<size_t> saida{0};
+};
+
+enum TipoAsset {
+    ASSET_MALHA,
+    ASSET_TEXTURA
+};
+
+// Resultado de CPU pronto para ser enviado à GPU pela thread de renderização
+struct AssetPronto {
+    TipoAsset tipo;
+    int id;                        // identificador passado no pedido
+    std::string caminho;
+    bool ok = false;
+
+    // ASSET_MALHA
+    MalhaCacheada malha;
+    bool comNormais = true;
+
+    // ASSET_TEXTURA
+    unsigned char* pixels = nullptr;
+    int largura = 0, altura = 0, canais = 0;
+    // ASSET_TEXTURA com CacheTexturas (pixels fica nulo)
+    ChaveTextura chave;
+    std::shared_ptr<const ImagemTextura> imagem;
+
+    ~AssetPronto() { if (pixels) stbi_image_free(pixels); }
+};
+
+class CarregadorAssincrono {
+public:
+    // nThreads == 0: um a menos que o número de núcleos (mínimo 1)
+    explicit CarregadorAssincrono(unsigned nThreads = 0, size_t capacidadeFila = 256)
+        : CarregadorAssincrono(nullptr, nThreads, capacidadeFila) {}
+
+    // Texturas decodificadas pelo cache, compartilhadas entre pedidos
+    explicit CarregadorAssincrono(CacheTexturas& texturas, unsigned nThreads = 0, size_t capacidadeFila = 256)
+        : CarregadorAssincrono(&texturas, nThreads, capacidadeFila) {}
+
+    ~CarregadorAssincrono() {
+        {
+            std::lock_guard<std::mutex> trava(mutexPedidos);
+            encerrando = true;
+        }
+        temPedido.notify_all();
+        for (auto& t : threads) t.join();
+        // O que não chegou a ser entregue também sai da contagem
+        for (const Pedido& p : pedidos) pendentes.fetch_sub(itensPorPedido(p), std::memory_order_relaxed);
+        pedidos.clear();
+        AssetPronto* a;
+        while (prontos.retirar(a)) {
+            delete a;
+            pendentes.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    CarregadorAssincrono(const CarregadorAssincrono&) = delete;
+    CarregadorAssincrono& operator=(const CarregadorAssincrono&) = delete;
+
+    // Malha (via cache .malha) seguida da textura do map_Kd, ou de
+    // texturaPadrao quando o material não tiver uma
+    void pedirModelo(int id, const std::string& caminho, const std::string& texturaPadrao, bool comNormais = true) {
+        enfileirar({ ASSET_MALHA, id, caminho, texturaPadrao, comNormais });
+    }
+
+    void pedirTextura(int id, const std::string& caminho) {
+        enfileirar({ ASSET_TEXTURA, id, caminho, std::string(), false });
+    }
+
+    // Próximo asset pronto, ou nullptr se nada chegou ainda
+    std::unique_ptr<AssetPronto> proximo() {
+        AssetPronto* a = nullptr;
+        if (!prontos.retirar(a)) return nullptr;
+        pendentes.fetch_sub(1, std::memory_order_relaxed);
+        return std::unique_ptr<AssetPronto>(a);
+    }
+
+    // Pedidos ainda não entregues por proximo()
+    int emAndamento() const { return pendentes.load(std::memory_order_relaxed); }
+
+private:
+    CarregadorAssincrono(CacheTexturas* texturas, unsigned nThreads, size_t capacidadeFila)
+        : prontos(capacidadeFila), texturas(texturas) {
+        if (nThreads == 0) nThreads = std::max(2u, std::thread::hardware_concurrency()) - 1;
+        for (unsigned i = 0; i < nThreads; ++i) threads.emplace_back([this] { trabalhar(); });
+    }
+
+    struct Pedido {
+        TipoAsset tipo;
+        int id;
+        std::string caminho;
+        std::string texturaPadrao;
+        bool comNormais;
+    };
+
+    // Um modelo entrega dois itens: a malha e a textura
+    static int itensPorPedido(const Pedido& p) { return p.tipo == ASSET_MALHA ? 2 : 1; }
+
+    void enfileirar(Pedido p) {
+        pendentes.fetch_add(itensPorPedido(p), std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> trava(mutexPedidos);
+            pedidos.push_back(std::move(p));
+        }
+        temPedido.notify_one();
+    }
+
+    // Fila cheia: espera o render consumir, a menos que o carregador esteja
+    // sendo destruído (janela fechada no meio da carga), e aí descarta o item
+    // (que deixa de contar em emAndamento)
+    bool entregar(AssetPronto* a) {
+        while (!prontos.empurrar(a)) {
+            if (encerrando.load(std::memory_order_relaxed)) {
+                delete a;
+                pendentes.fetch_sub(1, std::memory_order_relaxed);
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    AssetPronto* decodificarTextura(int id, const std::string& caminho) {
+        AssetPronto* t = new AssetPronto();
+        t->tipo = ASSET_TEXTURA;
+        t->id = id;
+        t->caminho = caminho;
+        if (texturas) {
+            t->ok = texturas->chave(caminho, t->chave) && texturas->decodificar(t->chave, t->imagem);
+            if (t->imagem) t->largura = t->imagem->largura, t->altura = t->imagem->altura, t->canais = t->imagem->canais;
+        } else {
+            t->pixels = stbi_load(caminho.c_str(), &t->largura, &t->altura, &t->canais, 0);
+            t->ok = t->pixels != nullptr;
+        }
+        return t;
+    }
+
+    void trabalhar() {
+        for (;;) {
+            Pedido p;
+            {
+                std::unique_lock<std::mutex> trava(mutexPedidos);
+                temPedido.wait(trava, [this] { return encerrando || !pedidos.empty(); });
+                if (encerrando) return;
+                p = std::move(pedidos.front());
+                pedidos.pop_front();
+            }
+            if (p.tipo == ASSET_MALHA) {
+                AssetPronto* m = new AssetPronto();
+                m->tipo = ASSET_MALHA;
+                m->id = p.id;
+                m->caminho = p.caminho;
+                m->comNormais = p.comNormais;
+                m->ok = carregarMalhaCacheada(p.caminho, m->malha, p.comNormais);
+                std::string textura = (m->ok && !m->malha.material.mapKd.empty())
+                    ? m->malha.diretorio + m->malha.material.mapKd : p.texturaPadrao;
+                // A geometria aparece antes da textura terminar de decodificar;
+                // com a malha descartada, a textura nem é decodificada
+                if (entregar(m)) entregar(decodificarTextura(p.id, textura));
+                else pendentes.fetch_sub(1, std::memory_order_relaxed);
+            } else {
+                entregar(decodificarTextura(p.id, p.caminho));
+            }
+        }
+    }
+
+    FilaSemTrava<AssetPronto*> prontos;
+    CacheTexturas* texturas;
+    std::atomic<int> pendentes{0};
+    std::mutex mutexPedidos;
+    std::condition_variable temPedido;
+    std::deque<Pedido> pedidos;
+    std::atomic<bool> encerrando{false}; // escrito sob mutexPedidos; lido sem ele em entregar()
+    std::vector<std::thread> threads;
+};
@@ -0,0 +1,451 @@
+/*
+ *  CarregadorOBJ.h
+ *
+ *  Leitor de arquivos Wavefront .OBJ/.MTL compartilhado pelos trabalhos.
+ *  O arquivo é mapeado em memória (ArquivoMapeado) e os tokens são lidos
+ *  no próprio buffer mapeado, com um leitor de float/int escrito à mão:
+ *  não há getline, istringstream nem sscanf, e nenhuma alocação por linha.
+ *
+ *  Suporta faces nos formatos v, v/vt, v//vn e v/vt/vn, índices negativos
+ *  (relativos) e polígonos com mais de 3 vértices (triangulados em leque).
+ *  Para modelos grandes, lerOBJParalelo divide o arquivo entre várias threads
+ *  e produz exatamente a mesma MalhaOBJ que lerOBJ.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  MalhaOBJ malha;
+ *  if (lerOBJ("../assets/Modelos3D/Suzanne.obj", malha)) {
+ *      vector<GLfloat> buffer;
+ *      expandirMalha(malha, buffer); // x y z  r g b  nx ny nz  s t
+ *      ...
+ *  }
+ *
+ *  Para desenhar com glDrawElements, indexarMalha deduplica os cantos
+ *  (v, vt, vn) iguais e gera um buffer de índices:
+ *
+ *  MalhaIndexada indexada;
+ *  indexarMalha(malha, indexada);
+ *  // indexada.vertices -> GL_ARRAY_BUFFER, indexada.indices -> GL_ELEMENT_ARRAY_BUFFER
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "ArquivoMapeado.h"
+
+// Número de floats por vértice no layout intercalado usado pelos trabalhos:
+// posição (3), cor (3), normal (3), coordenada de textura (2)
+const int FLOATS_POR_VERTICE = 11;
+
+struct MaterialOBJ {
+    float ka = 0.1f, kd = 0.7f, ks = 0.5f, ns = 32.0f;
+    std::string mapKd;
+};
+
+// Um canto de face: índices já convertidos para base 0 (-1 quando ausente)
+struct CantoOBJ {
+    int v, vt, vn;
+};
+
+struct MalhaOBJ {
+    std::vector<glm::vec3> posicoes;
+    std::vector<glm::vec2> texCoords;
+    std::vector<glm::vec3> normais;
+    std::vector<CantoOBJ> cantos; // 3 cantos por triângulo
+    MaterialOBJ material;
+    std::string mtllib;           // nome do .mtl referenciado (relativo a diretorio)
+    std::string diretorio;        // pasta do .obj, usada para achar .mtl e texturas
+};
+
+namespace leitorOBJ {
+
+inline bool ehEspaco(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+inline bool ehDigito(char c) { return c >= '0' && c <= '9'; }
+
+inline const char* pularEspacos(const char* p, const char* fim) {
+    while (p < fim && ehEspaco(*p)) ++p;
+    return p;
+}
+
+inline const char* fimDaLinha(const char* p, const char* fim) {
+    const void* nl = memchr(p, '\n', (size_t)(fim - p));
+    return nl ? (const char*)nl : fim;
+}
+
+// Compara a palavra-chave no início da linha e exige separador logo depois
+inline bool ehPalavra(const char* p, const char* fim, const char* palavra, size_t n) {
+    return (size_t)(fim - p) > n && memcmp(p, palavra, n) == 0 && ehEspaco(p[n]);
+}
+
+inline bool lerInt(const char*& p, const char* fim, int& out) {
+    bool neg = false;
+    if (p < fim && (*p == '-' || *p == '+')) { neg = (*p == '-'); ++p; }
+    if (p >= fim || !ehDigito(*p)) return false;
+    int v = 0;
+    while (p < fim && ehDigito(*p)) v = v * 10 + (*p++ - '0');
+    out = neg ? -v : v;
+    return true;
+}
+
+inline bool lerFloat(const char*& p, const char* fim, float& out) {
+    static const double pot10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    p = pularEspacos(p, fim);
+    bool neg = false;
+    if (p < fim && (*p == '-' || *p == '+')) { neg = (*p == '-'); ++p; }
+
+    uint64_t mantissa = 0;
+    int expoente = 0, digitos = 0;
+    bool algum = false;
+    while (p < fim && ehDigito(*p)) {
+        if (digitos < 19) { mantissa = mantissa * 10 + (uint64_t)(*p - '0'); if (mantissa) ++digitos; }
+        else ++expoente;
+        ++p; algum = true;
+    }
+    if (p < fim && *p == '.') {
+        ++p;
+        while (p < fim && ehDigito(*p)) {
+            if (digitos < 19) { mantissa = mantissa * 10 + (uint64_t)(*p - '0'); if (mantissa) ++digitos; --expoente; }
+            ++p; algum = true;
+        }
+    }
+    if (!algum) return false;
+    if (p < fim && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        int e;
+        if (lerInt(q, fim, e)) { expoente += e; p = q; }
+    }
+
+    double v = (double)mantissa;
+    if (expoente < 0) {
+        while (expoente < -22) { v /= 1e22; expoente += 22; }
+        v /= pot10[-expoente];
+    } else {
+        while (expoente > 22) { v *= 1e22; expoente -= 22; }
+        v *= pot10[expoente];
+    }
+    out = (float)(neg ? -v : v);
+    return true;
+}
+
+// Converte índice OBJ (base 1, ou negativo relativo ao fim da lista) para
+// base 0; -1 quando ausente ou quando o relativo aponta antes do primeiro
+// elemento. Com limitar == false o relativo sai sem essa checagem: num bloco
+// do lerOBJParalelo ela só pode ser feita depois de somar a base global
+inline int resolverIndice(int idx, size_t contagem, bool limitar = true) {
+    if (idx > 0) return idx - 1;
+    if (idx < 0) {
+        int i = (int)contagem + idx;
+        return (i >= 0 || !limitar) ? i : -1;
+    }
+    return -1;
+}
+
+// Relativo de um bloco mais o início do bloco na lista global, com a
+// mesma checagem que resolverIndice faz na leitura serial
+inline int rebasearIndice(int local, size_t base) {
+    int i = local + (int)base;
+    return i >= 0 ? i : -1;
+}
+
+// Lê um canto "v", "v/vt", "v//vn" ou "v/vt/vn" sem resolver os índices
+inline bool lerCanto(const char*& p, const char* fim, int& v, int& vt, int& vn) {
+    v = vt = vn = 0;
+    if (!lerInt(p, fim, v)) return false;
+    if (p < fim && *p == '/') {
+        ++p;
+        if (p < fim && *p != '/') lerInt(p, fim, vt);
+        if (p < fim && *p == '/') { ++p; lerInt(p, fim, vn); }
+    }
+    return true;
+}
+
+inline std::string restoDaLinha(const char* p, const char* fim) {
+    p = pularEspacos(p, fim);
+    while (fim > p && ehEspaco(fim[-1])) --fim;
+    return std::string(p, fim);
+}
+
+inline std::string diretorioDe(const std::string& caminho) {
+    size_t barra = caminho.find_last_of("/\\");
+    return barra == std::string::npos ? std::string() : caminho.substr(0, barra + 1);
+}
+
+} // namespace leitorOBJ
+
+inline bool lerMTL(const std::string& caminho, MaterialOBJ& material) {
+    using namespace leitorOBJ;
+    ArquivoMapeado arq(caminho);
+    if (!arq.aberto()) return false;
+    const char* p = arq.dados();
+    const char* fim = p + arq.tamanho();
+    while (p < fim) {
+        const char* eol = fimDaLinha(p, fim);
+        p = pularEspacos(p, eol);
+        // Apenas a primeira componente de Ka/Kd/Ks é usada (coeficiente escalar)
+        if (ehPalavra(p, eol, "map_Kd", 6)) material.mapKd = restoDaLinha(p + 6, eol);
+        else if (ehPalavra(p, eol, "Ka", 2)) { p += 2; lerFloat(p, eol, material.ka); }
+        else if (ehPalavra(p, eol, "Kd", 2)) { p += 2; lerFloat(p, eol, material.kd); }
+        else if (ehPalavra(p, eol, "Ks", 2)) { p += 2; lerFloat(p, eol, material.ks); }
+        else if (ehPalavra(p, eol, "Ns", 2)) { p += 2; lerFloat(p, eol, material.ns); }
+        p = (eol < fim) ? eol + 1 : fim;
+    }
+    return true;
+}
+
+// Canto gravado com índice relativo (negativo) dentro de um bloco lido em
+// paralelo: os bits de mascara (1 = v, 2 = vt, 4 = vn) indicam quais
+// componentes ainda precisam somar a contagem global anterior ao bloco.
+struct CantoRelativoOBJ {
+    size_t canto;
+    int mascara;
+};
+
+// Interpreta as linhas de [p, fim) acrescentando em malha. Índices relativos
+// são resolvidos contra o que já está em malha; se relativos != nullptr, os
+// cantos que usaram índice relativo são anotados para correção posterior.
+inline void lerLinhasOBJ(const char* p, const char* fim, MalhaOBJ& malha, std::string* mtllib,
+                         std::vector<CantoRelativoOBJ>* relativos = nullptr) {
+    using namespace leitorOBJ;
+    while (p < fim) {
+        const char* eol = fimDaLinha(p, fim);
+        p = pularEspacos(p, eol);
+        if (p + 1 < eol) {
+            if (p[0] == 'v' && ehEspaco(p[1])) {
+                glm::vec3 v(0.0f);
+                p += 2;
+                lerFloat(p, eol, v.x); lerFloat(p, eol, v.y); lerFloat(p, eol, v.z);
+                malha.posicoes.push_back(v);
+            } else if (p[0] == 'v' && p[1] == 't' && p + 2 < eol && ehEspaco(p[2])) {
+                glm::vec2 vt(0.0f);
+                p += 3;
+                lerFloat(p, eol, vt.x); lerFloat(p, eol, vt.y);
+                malha.texCoords.push_back(vt);
+            } else if (p[0] == 'v' && p[1] == 'n' && p + 2 < eol && ehEspaco(p[2])) {
+                glm::vec3 n(0.0f);
+                p += 3;
+                lerFloat(p, eol, n.x); lerFloat(p, eol, n.y); lerFloat(p, eol, n.z);
+                malha.normais.push_back(n);
+            } else if (p[0] == 'f' && ehEspaco(p[1])) {
+                // Triangulação em leque: (c0, c[i-1], c[i])
+                CantoOBJ primeiro{}, anterior{}, atual;
+                int mPrimeiro = 0, mAnterior = 0, mAtual;
+                int n = 0, v, vt, vn;
+                p += 2;
+                for (p = pularEspacos(p, eol); p < eol && lerCanto(p, eol, v, vt, vn); p = pularEspacos(p, eol)) {
+                    bool limitar = relativos == nullptr;
+                    atual.v = resolverIndice(v, malha.posicoes.size(), limitar);
+                    atual.vt = resolverIndice(vt, malha.texCoords.size(), limitar);
+                    atual.vn = resolverIndice(vn, malha.normais.size(), limitar);
+                    mAtual = (v < 0 ? 1 : 0) | (vt < 0 ? 2 : 0) | (vn < 0 ? 4 : 0);
+                    if (n == 0) { primeiro = atual; mPrimeiro = mAtual; }
+                    else if (n >= 2) {
+                        if (relativos && (mPrimeiro | mAnterior | mAtual)) {
+                            size_t base = malha.cantos.size();
+                            if (mPrimeiro) relativos->push_back({ base, mPrimeiro });
+                            if (mAnterior) relativos->push_back({ base + 1, mAnterior });
+                            if (mAtual) relativos->push_back({ base + 2, mAtual });
+                        }
+                        malha.cantos.push_back(primeiro);
+                        malha.cantos.push_back(anterior);
+                        malha.cantos.push_back(atual);
+                    }
+                    anterior = atual;
+                    mAnterior = mAtual;
+                    ++n;
+                }
+            } else if (mtllib && ehPalavra(p, eol, "mtllib", 6)) {
+                *mtllib = restoDaLinha(p + 6, eol);
+            }
+        }
+        p = (eol < fim) ? eol + 1 : fim;
+    }
+}
+
+inline bool lerOBJ(const std::string& caminho, MalhaOBJ& malha) {
+    ArquivoMapeado arq(caminho);
+    if (!arq.aberto()) return false;
+    malha = MalhaOBJ();
+    malha.diretorio = leitorOBJ::diretorioDe(caminho);
+    lerLinhasOBJ(arq.dados(), arq.dados() + arq.tamanho(), malha, &malha.mtllib);
+    if (!malha.mtllib.empty()) lerMTL(malha.diretorio + malha.mtllib, malha.material);
+    return true;
+}
+
+// Abaixo disso a leitura em paralelo não compensa o custo das threads
+const size_t TAMANHO_MINIMO_OBJ_PARALELO = 4u << 20;
+
+// Leitura em paralelo: o arquivo mapeado é dividido em nThreads blocos nas
+// quebras de linha, cada thread lê o seu bloco em uma MalhaOBJ local e, por
+// soma de prefixos das contagens de v/vt/vn, os blocos são copiados para a
+// malha final corrigindo os índices relativos. O resultado é idêntico ao de
+// lerOBJ. Com nThreads == 0 usa todos os núcleos e lê em série os arquivos
+// menores que TAMANHO_MINIMO_OBJ_PARALELO.
+inline bool lerOBJParalelo(const std::string& caminho, MalhaOBJ& malha, unsigned nThreads = 0) {
+    ArquivoMapeado arq(caminho);
+    if (!arq.aberto()) return false;
+    const char* inicio = arq.dados();
+    const char* fim = inicio + arq.tamanho();
+    if (nThreads == 0) {
+        nThreads = std::max(1u, std::thread::hardware_concurrency());
+        if (arq.tamanho() < TAMANHO_MINIMO_OBJ_PARALELO) nThreads = 1;
+    }
+    nThreads = (unsigned)std::max<size_t>(1, std::min<size_t>(nThreads, arq.tamanho() / 64 + 1));
+
+    malha = MalhaOBJ();
+    malha.diretorio = leitorOBJ::diretorioDe(caminho);
+    if (nThreads == 1) {
+        lerLinhasOBJ(inicio, fim, malha, &malha.mtllib);
+    } else {
+        // Limites dos blocos, sempre logo após um '\n'
+        std::vector<const char*> limites(nThreads + 1);
+        limites[0] = inicio;
+        limites[nThreads] = fim;
+        for (unsigned i = 1; i < nThreads; ++i) {
+            const char* p = inicio + arq.tamanho() / nThreads * i;
+            p = std::max(p, limites[i - 1]);
+            p = leitorOBJ::fimDaLinha(p, fim);
+            limites[i] = (p < fim) ? p + 1 : fim;
+        }
+
+        std::vector<MalhaOBJ> blocos(nThreads);
+        std::vector<std::vector<CantoRelativoOBJ>> relativos(nThreads);
+        std::vector<std::string> mtllibs(nThreads);
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < nThreads; ++i)
+            threads.emplace_back([&, i] { lerLinhasOBJ(limites[i], limites[i + 1], blocos[i], &mtllibs[i], &relativos[i]); });
+        for (auto& t : threads) t.join();
+        threads.clear();
+
+        // Soma de prefixos: onde cada bloco começa nas listas globais
+        std::vector<size_t> baseV(nThreads + 1, 0), baseVT(nThreads + 1, 0), baseVN(nThreads + 1, 0), baseC(nThreads + 1, 0);
+        for (unsigned i = 0; i < nThreads; ++i) {
+            baseV[i + 1] = baseV[i] + blocos[i].posicoes.size();
+            baseVT[i + 1] = baseVT[i] + blocos[i].texCoords.size();
+            baseVN[i + 1] = baseVN[i] + blocos[i].normais.size();
+            baseC[i + 1] = baseC[i] + blocos[i].cantos.size();
+        }
+        malha.posicoes.resize(baseV[nThreads]);
+        malha.texCoords.resize(baseVT[nThreads]);
+        malha.normais.resize(baseVN[nThreads]);
+        malha.cantos.resize(baseC[nThreads]);
+
+        for (unsigned i = 0; i < nThreads; ++i) {
+            threads.emplace_back([&, i] {
+                MalhaOBJ& b = blocos[i];
+                std::copy(b.posicoes.begin(), b.posicoes.end(), malha.posicoes.begin() + baseV[i]);
+                std::copy(b.texCoords.begin(), b.texCoords.end(), malha.texCoords.begin() + baseVT[i]);
+                std::copy(b.normais.begin(), b.normais.end(), malha.normais.begin() + baseVN[i]);
+                CantoOBJ* cantos = malha.cantos.data() + baseC[i];
+                std::copy(b.cantos.begin(), b.cantos.end(), cantos);
+                for (const CantoRelativoOBJ& r : relativos[i]) {
+                    if (r.mascara & 1) cantos[r.canto].v = leitorOBJ::rebasearIndice(cantos[r.canto].v, baseV[i]);
+                    if (r.mascara & 2) cantos[r.canto].vt = leitorOBJ::rebasearIndice(cantos[r.canto].vt, baseVT[i]);
+                    if (r.mascara & 4) cantos[r.canto].vn = leitorOBJ::rebasearIndice(cantos[r.canto].vn, baseVN[i]);
+                }
+                b = MalhaOBJ(); // libera o bloco assim que copiado
+            });
+        }
+        for (auto& t : threads) t.join();
+
+        for (const std::string& m : mtllibs) {
+            if (!m.empty()) malha.mtllib = m; // como na leitura serial, vale o último mtllib
+        }
+    }
+    if (!malha.mtllib.empty()) lerMTL(malha.diretorio + malha.mtllib, malha.material);
+    return true;
+}
+
+// Escreve um vértice intercalado: x y z  r g b  [nx ny nz]  s t.
+// A coordenada t é invertida, como nos carregadores originais.
+inline float* escreverVertice(const MalhaOBJ& malha, const CantoOBJ& c, float* out, bool comNormais) {
+    glm::vec3 v = (c.v >= 0 && c.v < (int)malha.posicoes.size()) ? malha.posicoes[c.v] : glm::vec3(0.0f);
+    glm::vec2 t(0.0f);
+    if (c.vt >= 0 && c.vt < (int)malha.texCoords.size()) {
+        t = malha.texCoords[c.vt];
+        t.y = 1.0f - t.y;
+    }
+    *out++ = v.x; *out++ = v.y; *out++ = v.z;
+    *out++ = 1.0f; *out++ = 1.0f; *out++ = 1.0f;
+    if (comNormais) {
+        glm::vec3 n = (c.vn >= 0 && c.vn < (int)malha.normais.size()) ? malha.normais[c.vn] : glm::vec3(0.0f);
+        *out++ = n.x; *out++ = n.y; *out++ = n.z;
+    }
+    *out++ = t.x; *out++ = t.y;
+    return out;
+}
+
+// Gera o buffer intercalado de 11 floats por canto (um vértice por canto),
+// no mesmo layout que os trabalhos enviam ao VBO.
+inline void expandirMalha(const MalhaOBJ& malha, std::vector<float>& buffer) {
+    buffer.resize(malha.cantos.size() * FLOATS_POR_VERTICE);
+    float* out = buffer.data();
+    for (const CantoOBJ& c : malha.cantos) out = escreverVertice(malha, c, out, true);
+}
+
+struct MalhaIndexada {
+    std::vector<float> vertices;    // floatsPorVertice floats por vértice único
+    std::vector<uint32_t> indices;  // 3 por triângulo
+    int floatsPorVertice = FLOATS_POR_VERTICE;
+
+    size_t nVertices() const { return vertices.size() / floatsPorVertice; }
+    // GL_UNSIGNED_SHORT basta enquanto todo índice couber em 16 bits
+    bool indices16Bits() const { return nVertices() <= 65536; }
+    void indicesComo16Bits(std::vector<uint16_t>& saida) const {
+        saida.assign(indices.begin(), indices.end());
+    }
+};
+
+// Deduplica os cantos iguais com uma tabela hash de endereçamento aberto e
+// gera vértices únicos + índices. Sem normais o layout tem 8 floats
+// (x y z r g b s t) e vn é ignorado na comparação.
+inline void indexarMalha(const MalhaOBJ& malha, MalhaIndexada& saida, bool comNormais = true) {
+    saida.floatsPorVertice = comNormais ? FLOATS_POR_VERTICE : FLOATS_POR_VERTICE - 3;
+    saida.vertices.clear();
+    saida.indices.resize(malha.cantos.size());
+
+    size_t capacidade = 16;
+    while (capacidade < malha.cantos.size() * 2) capacidade <<= 1;
+    std::vector<int32_t> tabela(capacidade, -1); // índice do vértice único, -1 = vazio
+    std::vector<CantoOBJ> unicos;
+    unicos.reserve(malha.cantos.size() / 2);
+    saida.vertices.reserve(malha.cantos.size() / 2 * saida.floatsPorVertice);
+
+    for (size_t i = 0; i < malha.cantos.size(); ++i) {
+        CantoOBJ c = malha.cantos[i];
+        if (!comNormais) c.vn = -1;
+        uint64_t h = (uint64_t)(uint32_t)c.v * 0x9E3779B97F4A7C15ull
+                   ^ (uint64_t)(uint32_t)c.vt * 0xC2B2AE3D27D4EB4Full
+                   ^ (uint64_t)(uint32_t)c.vn * 0x165667B19E3779F9ull;
+        size_t slot = (size_t)(h ^ (h >> 29)) & (capacidade - 1);
+        for (;;) {
+            int32_t id = tabela[slot];
+            if (id < 0) {
+                id = (int32_t)unicos.size();
+                tabela[slot] = id;
+                unicos.push_back(c);
+                size_t base = saida.vertices.size();
+                saida.vertices.resize(base + saida.floatsPorVertice);
+                escreverVertice(malha, c, &saida.vertices[base], comNormais);
+                saida.indices[i] = (uint32_t)id;
+                break;
+            }
+            const CantoOBJ& u = unicos[id];
+            if (u.v == c.v && u.vt == c.vt && u.vn == c.vn) {
+                saida.indices[i] = (uint32_t)id;
+                break;
+            }
+            slot = (slot + 1) & (capacidade - 1);
+        }
+    }
+}
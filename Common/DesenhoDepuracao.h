@@ -0,0 +1,228 @@
+/*
+ *  DesenhoDepuracao.h
+ *
+ *  Desenho de depuração (linhas, pontos e caixas) em core profile. Durante
+ *  o quadro as primitivas só são acumuladas em dois arrays de vértices na
+ *  CPU; desenhar() envia tudo num único buffer (órfão + glBufferSubData,
+ *  sem esperar a GPU) e faz no máximo duas chamadas: um glDrawArrays de
+ *  GL_LINES e um de GL_POINTS, com um shader próprio que lê view e
+ *  projection do bloco Quadro (BlocosUniformes.h).
+ *
+ *  PoligonalTrajetoria guarda os vértices prontos da curva de uma
+ *  trajetória (amostrada pelos segmentos da Trajetoria) e dos seus pontos
+ *  de controle. Só é refeita depois de invalidar(), quando os pontos ou o
+ *  modo mudam; nos outros quadros adicionar() só copia os vértices.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  DesenhoDepuracao depuracao;
+ *  depuracao.criar();                        // depois do gladLoadGLLoader
+ *  ...
+ *  depuracao.linha(a, b, COR_VERDE);
+ *  depuracao.caixa(minimo, maximo, COR_AMARELO);
+ *  poligonal.atualizar(pontos, modo);        // não faz nada se não foi invalidada
+ *  depuracao.adicionar(poligonal);
+ *  depuracao.desenhar();                     // envia, desenha e esvazia
+ */
+
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "BlocosUniformes.h"
+#include "Trajetoria.h"
+
+// Cores em RGBA8 (r no byte menos significativo), normalizadas no atributo
+const uint32_t COR_BRANCO = 0xFFFFFFFFu;
+const uint32_t COR_VERMELHO = 0xFF0000FFu;
+const uint32_t COR_VERDE = 0xFF00FF00u;
+const uint32_t COR_AZUL = 0xFFFF0000u;
+const uint32_t COR_AMARELO = 0xFF00FFFFu;
+const uint32_t COR_CINZA = 0xFF808080u;
+
+struct VerticeDepuracao {
+    glm::vec3 pos;
+    uint32_t cor;
+};
+static_assert(sizeof(VerticeDepuracao) == 16, "VerticeDepuracao deve ter 16 bytes");
+
+// Curva e pontos de controle de uma trajetória, já como vértices
+class PoligonalTrajetoria {
+public:
+    static const int AMOSTRAS_SEGMENTO = 16; // cordas por segmento da curva
+
+    void invalidar() { valida = false; }
+
+    // Refaz os vértices se a poligonal foi invalidada; retorna se refez
+    bool atualizar(const std::vector<glm::vec3>& pontos, ModoTrajetoria modo,
+                   uint32_t corCurva = COR_VERDE, uint32_t corPontos = COR_VERMELHO) {
+        if (valida) return false;
+        valida = true;
+        linhas.clear();
+        pontosControle.clear();
+        for (const glm::vec3& p : pontos) pontosControle.push_back({ p, corPontos });
+        Trajetoria curva;
+        curva.definir(pontos, modo);
+        linhas.reserve(curva.segmentosCurva().size() * AMOSTRAS_SEGMENTO * 2);
+        for (const SegmentoCubico& seg : curva.segmentosCurva()) {
+            glm::vec3 anterior = seg.a;
+            for (int k = 1; k <= AMOSTRAS_SEGMENTO; ++k) {
+                glm::vec3 p = seg.avaliar((float)k / AMOSTRAS_SEGMENTO);
+                linhas.push_back({ anterior, corCurva });
+                linhas.push_back({ p, corCurva });
+                anterior = p;
+            }
+        }
+        return true;
+    }
+
+    const std::vector<VerticeDepuracao>& verticesLinhas() const { return linhas; }
+    const std::vector<VerticeDepuracao>& verticesPontos() const { return pontosControle; }
+
+private:
+    std::vector<VerticeDepuracao> linhas;         // pares de vértices (GL_LINES)
+    std::vector<VerticeDepuracao> pontosControle; // GL_POINTS
+    bool valida = false;
+};
+
+class DesenhoDepuracao {
+public:
+    float tamanhoPonto = 8.0f; // em pixels
+
+    void criar() {
+        programa = compilar();
+        ligarBlocosUniformes(programa);
+        glUseProgram(programa);
+        uTamanhoPonto = glGetUniformLocation(programa, "tamanhoPonto");
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VerticeDepuracao), (void*)offsetof(VerticeDepuracao, pos));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(VerticeDepuracao), (void*)offsetof(VerticeDepuracao, cor));
+        glEnableVertexAttribArray(1);
+        glBindVertexArray(0);
+    }
+
+    void destruir() {
+        if (vbo) glDeleteBuffers(1, &vbo);
+        if (vao) glDeleteVertexArrays(1, &vao);
+        if (programa) glDeleteProgram(programa);
+        vbo = vao = programa = 0;
+    }
+
+    void linha(const glm::vec3& a, const glm::vec3& b, uint32_t cor) {
+        linhas.push_back({ a, cor });
+        linhas.push_back({ b, cor });
+    }
+
+    void ponto(const glm::vec3& p, uint32_t cor) { pontos.push_back({ p, cor }); }
+
+    // As 12 arestas da caixa alinhada aos eixos
+    void caixa(const glm::vec3& minimo, const glm::vec3& maximo, uint32_t cor) {
+        glm::vec3 v[8];
+        for (int i = 0; i < 8; ++i)
+            v[i] = glm::vec3(i & 1 ? maximo.x : minimo.x, i & 2 ? maximo.y : minimo.y, i & 4 ? maximo.z : minimo.z);
+        static const int arestas[12][2] = { { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 }, { 0, 2 }, { 1, 3 },
+                                            { 4, 6 }, { 5, 7 }, { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 } };
+        for (const auto& a : arestas) linha(v[a[0]], v[a[1]], cor);
+    }
+
+    // Pontos consecutivos ligados por linhas; fechada liga o último ao primeiro
+    void poligonal(const std::vector<glm::vec3>& p, bool fechada, uint32_t cor) {
+        for (size_t i = 1; i < p.size(); ++i) linha(p[i - 1], p[i], cor);
+        if (fechada && p.size() > 2) linha(p.back(), p.front(), cor);
+    }
+
+    void adicionar(const PoligonalTrajetoria& t) {
+        linhas.insert(linhas.end(), t.verticesLinhas().begin(), t.verticesLinhas().end());
+        pontos.insert(pontos.end(), t.verticesPontos().begin(), t.verticesPontos().end());
+    }
+
+    // Envia o quadro, desenha e esvazia os arrays (mantendo a memória)
+    void desenhar() {
+        size_t nLinhas = linhas.size(), nPontos = pontos.size();
+        verticesEnviados = nLinhas + nPontos;
+        if (verticesEnviados == 0) return;
+        size_t bytesLinhas = nLinhas * sizeof(VerticeDepuracao), bytes = verticesEnviados * sizeof(VerticeDepuracao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        if (bytes > capacidade) capacidade = std::max(bytes, capacidade * 2);
+        glBufferData(GL_ARRAY_BUFFER, capacidade, nullptr, GL_STREAM_DRAW); // órfão: não espera a GPU
+        if (nLinhas) glBufferSubData(GL_ARRAY_BUFFER, 0, bytesLinhas, linhas.data());
+        if (nPontos) glBufferSubData(GL_ARRAY_BUFFER, bytesLinhas, nPontos * sizeof(VerticeDepuracao), pontos.data());
+
+        glUseProgram(programa);
+        glUniform1f(uTamanhoPonto, tamanhoPonto);
+        glBindVertexArray(vao);
+        if (nLinhas) glDrawArrays(GL_LINES, 0, (GLsizei)nLinhas);
+        if (nPontos) {
+            glEnable(GL_PROGRAM_POINT_SIZE);
+            glDrawArrays(GL_POINTS, (GLint)nLinhas, (GLsizei)nPontos);
+            glDisable(GL_PROGRAM_POINT_SIZE);
+        }
+        glBindVertexArray(0);
+        linhas.clear();
+        pontos.clear();
+    }
+
+    size_t verticesEnviados = 0; // no último desenhar()
+
+private:
+    static GLuint compilar() {
+        const char* fonteVertice = R"(
+#version 330 core
+layout(location = 0) in vec3 pos;
+layout(location = 1) in vec4 cor;
+
+layout(std140) uniform Quadro {
+    mat4 view;
+    mat4 projection;
+    vec4 lightPos;
+    vec4 camPos;
+};
+uniform float tamanhoPonto;
+
+out vec4 vCor;
+
+void main() {
+    gl_Position = projection * view * vec4(pos, 1.0);
+    gl_PointSize = tamanhoPonto;
+    vCor = cor;
+}
+)";
+        const char* fonteFragmento = R"(
+#version 330 core
+in vec4 vCor;
+out vec4 FragColor;
+
+void main() {
+    FragColor = vCor;
+}
+)";
+        GLuint v = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(v, 1, &fonteVertice, nullptr);
+        glCompileShader(v);
+        GLuint f = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(f, 1, &fonteFragmento, nullptr);
+        glCompileShader(f);
+        GLuint p = glCreateProgram();
+        glAttachShader(p, v);
+        glAttachShader(p, f);
+        glLinkProgram(p);
+        glDeleteShader(v);
+        glDeleteShader(f);
+        return p;
+    }
+
+    GLuint programa = 0, vao = 0, vbo = 0;
+    GLint uTamanhoPonto = -1;
+    size_t capacidade = 0; // bytes alocados no VBO
+    std::vector<VerticeDepuracao> linhas;
+    std::vector<VerticeDepuracao> pontos;
+};
@@ -0,0 +1,103 @@
+/*
+ *  FilaRenderizacao.h
+ *
+ *  Fila de desenho ordenada por estado. Cada objeto vira um item com uma
+ *  chave de 64 bits; a fila é ordenada por radix sort a cada quadro, de
+ *  modo que objetos com o mesmo programa, textura, material e VAO fiquem
+ *  juntos (e, dentro disso, da frente para trás, aproveitando o early-z).
+ *
+ *  Layout da chave, do bit mais significativo para o menos:
+ *
+ *    programa (6) | textura (14) | material (10) | VAO (14) | profundidade (20)
+ *
+ *  Nomes de objetos do OpenGL maiores que o campo são truncados; isso só
+ *  piora o agrupamento, nunca a correção, porque quem desenha compara os
+ *  nomes verdadeiros antes de evitar um bind.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct ItemFila {
+    uint64_t chave;
+    uint32_t indice; // escolhido por quem adiciona (em geral, a posição do objeto na cena)
+};
+
+// Trocas de estado feitas e evitadas (bind igual ao anterior) num quadro
+struct EstatisticasRenderizacao {
+    size_t desenhos = 0;
+    size_t trocasPrograma = 0, evitadasPrograma = 0;
+    size_t trocasTextura = 0, evitadasTextura = 0;
+    size_t trocasMaterial = 0, evitadasMaterial = 0;
+    size_t trocasVAO = 0, evitadasVAO = 0;
+    size_t instanciasEnviadas = 0, faixasEnviadas = 0; // glBufferSubData no VBO de instâncias
+
+    size_t trocas() const { return trocasPrograma + trocasTextura + trocasMaterial + trocasVAO; }
+    size_t evitadas() const { return evitadasPrograma + evitadasTextura + evitadasMaterial + evitadasVAO; }
+};
+
+class FilaRenderizacao {
+public:
+    static const int BITS_PROGRAMA = 6;
+    static const int BITS_TEXTURA = 14;
+    static const int BITS_MATERIAL = 10;
+    static const int BITS_VAO = 14;
+    static const int BITS_PROFUNDIDADE = 20;
+
+    void limpar() { itens.clear(); }
+
+    // profundidade: distância até a câmera normalizada em [0, 1] (0 = perto)
+    void adicionar(uint32_t programa, uint32_t textura, uint32_t material, uint32_t vao, float profundidade, uint32_t indice) {
+        itens.push_back({ montarChave(programa, textura, material, vao, profundidade), indice });
+    }
+
+    static uint64_t montarChave(uint32_t programa, uint32_t textura, uint32_t material, uint32_t vao, float profundidade) {
+        const uint32_t maxProf = (1u << BITS_PROFUNDIDADE) - 1;
+        profundidade = std::min(std::max(profundidade, 0.0f), 1.0f);
+        uint64_t chave = programa & ((1u << BITS_PROGRAMA) - 1);
+        chave = (chave << BITS_TEXTURA) | (textura & ((1u << BITS_TEXTURA) - 1));
+        chave = (chave << BITS_MATERIAL) | (material & ((1u << BITS_MATERIAL) - 1));
+        chave = (chave << BITS_VAO) | (vao & ((1u << BITS_VAO) - 1));
+        chave = (chave << BITS_PROFUNDIDADE) | (uint32_t)(profundidade * maxProf);
+        return chave;
+    }
+
+    // Radix sort LSD com dígitos de 8 bits. Os histogramas dos 8 dígitos
+    // saem de uma única passada, e dígitos iguais em todas as chaves (campos
+    // que não variam na cena) não geram passada nenhuma.
+    void ordenar() {
+        size_t n = itens.size();
+        if (n < 2) return;
+        size_t contagem[8][256] = {};
+        for (const ItemFila& item : itens)
+            for (int d = 0; d < 8; ++d) ++contagem[d][(item.chave >> (d * 8)) & 0xFF];
+
+        auxiliar.resize(n);
+        ItemFila* origem = itens.data();
+        ItemFila* destino = auxiliar.data();
+        for (int d = 0; d < 8; ++d) {
+            size_t* c = contagem[d];
+            if (c[(origem[0].chave >> (d * 8)) & 0xFF] == n) continue; // dígito constante
+            size_t soma = 0;
+            for (int b = 0; b < 256; ++b) {
+                size_t t = c[b];
+                c[b] = soma;
+                soma += t;
+            }
+            for (size_t i = 0; i < n; ++i) destino[c[(origem[i].chave >> (d * 8)) & 0xFF]++] = origem[i];
+            std::swap(origem, destino);
+        }
+        if (origem != itens.data()) itens.swap(auxiliar);
+    }
+
+    const std::vector<ItemFila>& ordenados() const { return itens; }
+    size_t tamanho() const { return itens.size(); }
+
+private:
+    std::vector<ItemFila> itens;
+    std::vector<ItemFila> auxiliar;
+};
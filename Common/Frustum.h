@@ -0,0 +1,123 @@
+/*
+ *  Frustum.h
+ *
+ *  Frustum culling na CPU. Os seis planos saem direto de
+ *  projection * view (método de Gribb/Hartmann). Cada objeto entra com a
+ *  sua matriz model e os LimitesMalha da malha (gravados no .malha); os
+ *  volumes vão para o espaço do mundo e ficam em arrays separados por
+ *  componente (SoA), testados de 4 em 4 com SSE: esfera e AABB precisam
+ *  estar ao menos em parte do lado de dentro de todos os planos.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  CullingFrustum culling;
+ *  culling.limpar();
+ *  for (obj : cena) culling.adicionar(model, obj.limites);
+ *  culling.testar(Frustum::extrair(projection * view));
+ *  for (uint32_t i : culling.visiveis()) ... desenha cena[i] ...
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRUSTUM_SSE 1
+#endif
+
+#include "CacheMalha.h"
+
+struct Frustum {
+    glm::vec4 planos[6]; // (n, d) com n apontando para dentro e |n| = 1
+
+    static Frustum extrair(const glm::mat4& m) {
+        // Linhas da matriz (glm guarda por coluna)
+        glm::vec4 l0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        glm::vec4 l1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        glm::vec4 l2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        glm::vec4 l3(m[0][3], m[1][3], m[2][3], m[3][3]);
+        Frustum f;
+        f.planos[0] = l3 + l0; // esquerda
+        f.planos[1] = l3 - l0; // direita
+        f.planos[2] = l3 + l1; // baixo
+        f.planos[3] = l3 - l1; // cima
+        f.planos[4] = l3 + l2; // perto
+        f.planos[5] = l3 - l2; // longe
+        for (glm::vec4& p : f.planos) p = p / glm::length(glm::vec3(p));
+        return f;
+    }
+};
+
+class CullingFrustum {
+public:
+    void limpar() {
+        cx.clear(); cy.clear(); cz.clear(); raio.clear();
+        ex.clear(); ey.clear(); ez.clear();
+        lista.clear();
+    }
+
+    // Leva esfera e AABB da malha para o espaço do mundo
+    void adicionar(const glm::mat4& model, const LimitesMalha& l) {
+        glm::vec3 centro(model * glm::vec4(l.centro[0], l.centro[1], l.centro[2], 1.0f));
+        glm::vec3 meia(0.5f * (l.maximo[0] - l.minimo[0]), 0.5f * (l.maximo[1] - l.minimo[1]), 0.5f * (l.maximo[2] - l.minimo[2]));
+        float escala = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+        cx.push_back(centro.x); cy.push_back(centro.y); cz.push_back(centro.z);
+        raio.push_back(l.raio * escala);
+        // Meias-extensões da AABB que envolve a caixa girada (Arvo)
+        ex.push_back(std::fabs(model[0][0]) * meia.x + std::fabs(model[1][0]) * meia.y + std::fabs(model[2][0]) * meia.z);
+        ey.push_back(std::fabs(model[0][1]) * meia.x + std::fabs(model[1][1]) * meia.y + std::fabs(model[2][1]) * meia.z);
+        ez.push_back(std::fabs(model[0][2]) * meia.x + std::fabs(model[1][2]) * meia.y + std::fabs(model[2][2]) * meia.z);
+    }
+
+    // Preenche visiveis() com os índices (ordem de adicionar) que passaram
+    void testar(const Frustum& f) {
+        lista.clear();
+        size_t n = cx.size();
+        size_t i = 0;
+#ifdef FRUSTUM_SSE
+        for (; i + 4 <= n; i += 4) {
+            __m128 x = _mm_loadu_ps(&cx[i]), y = _mm_loadu_ps(&cy[i]), z = _mm_loadu_ps(&cz[i]);
+            __m128 r = _mm_loadu_ps(&raio[i]);
+            __m128 hx = _mm_loadu_ps(&ex[i]), hy = _mm_loadu_ps(&ey[i]), hz = _mm_loadu_ps(&ez[i]);
+            __m128 dentro = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (const glm::vec4& p : f.planos) {
+                __m128 nx = _mm_set1_ps(p.x), ny = _mm_set1_ps(p.y), nz = _mm_set1_ps(p.z);
+                __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, x), _mm_mul_ps(ny, y)),
+                                      _mm_add_ps(_mm_mul_ps(nz, z), _mm_set1_ps(p.w)));
+                // Projeção da AABB na normal: |nx|*hx + |ny|*hy + |nz|*hz
+                __m128 projecao = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::fabs(p.x)), hx),
+                                                        _mm_mul_ps(_mm_set1_ps(std::fabs(p.y)), hy)),
+                                             _mm_mul_ps(_mm_set1_ps(std::fabs(p.z)), hz));
+                __m128 limite = _mm_sub_ps(_mm_setzero_ps(), _mm_min_ps(r, projecao));
+                dentro = _mm_and_ps(dentro, _mm_cmpge_ps(d, limite));
+            }
+            int mascara = _mm_movemask_ps(dentro);
+            for (int k = 0; k < 4; ++k)
+                if (mascara & (1 << k)) lista.push_back((uint32_t)(i + k));
+        }
+#endif
+        for (; i < n; ++i) {
+            bool dentro = true;
+            for (const glm::vec4& p : f.planos) {
+                float d = p.x * cx[i] + p.y * cy[i] + p.z * cz[i] + p.w;
+                float projecao = std::fabs(p.x) * ex[i] + std::fabs(p.y) * ey[i] + std::fabs(p.z) * ez[i];
+                if (d < -std::min(raio[i], projecao)) { dentro = false; break; }
+            }
+            if (dentro) lista.push_back((uint32_t)i);
+        }
+    }
+
+    const std::vector<uint32_t>& visiveis() const { return lista; }
+    size_t testados() const { return cx.size(); }
+    size_t descartados() const { return cx.size() - lista.size(); }
+
+private:
+    std::vector<float> cx, cy, cz, raio;  // esfera no mundo
+    std::vector<float> ex, ey, ez;        // meias-extensões da AABB no mundo (mesmo centro)
+    std::vector<uint32_t> lista;
+};
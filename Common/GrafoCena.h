@@ -0,0 +1,278 @@
+/*
+ *  GrafoCena.h
+ *
+ *  Hierarquia pai/filho de transformações. Cada nó tem uma transformação
+ *  local (posição, rotação, escala, guardadas numa TransformacoesSoA com a
+ *  model local em cache) e a matriz de mundo = mundo do pai * local.
+ *
+ *  Os nós ficam guardados em pré-ordem (pai antes dos filhos, e cada
+ *  subárvore ocupa uma faixa contígua [p, fim[p])). Assim:
+ *    - a atualização é uma passada linear por faixas: o pai de qualquer nó
+ *      já foi refeito (ou não mudou) quando o nó é visitado;
+ *    - só as subárvores sujas são visitadas: um nó cuja local mudou suja a
+ *      sua faixa inteira, e faixas contidas em outra são descartadas;
+ *    - raízes (e subárvores irmãs) diferentes não dependem umas das outras,
+ *      então faixas grandes são repartidas entre threads.
+ *
+ *  Os ids devolvidos por adicionar() são estáveis (índice na cena); a
+ *  posição em pré-ordem é interna e é refeita quando a hierarquia muda.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  GrafoCena grafo;
+ *  uint32_t carro = grafo.adicionar(GrafoCena::NENHUM, pos);
+ *  uint32_t roda = grafo.adicionar(carro, glm::vec3(1.0f, -0.5f, 0.0f));
+ *  ...
+ *  grafo.locais().definirPosicao(carro, novaPos);   // a roda vai junto
+ *  size_t refeitas = grafo.atualizar();              // uma vez por quadro
+ *  const glm::mat4& model = grafo.mundo(roda);
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "Transformacoes.h"
+#include "TransformacoesSoA.h"
+
+class GrafoCena {
+public:
+    static constexpr uint32_t NENHUM = 0xFFFFFFFFu;
+    static constexpr size_t MIN_PARALELO = 16384; // menos nós sujos que isso não ganham threads
+
+    // pai = NENHUM cria uma raiz; o pai precisa existir
+    uint32_t adicionar(uint32_t pai, const glm::vec3& pos, const glm::vec3& rot = glm::vec3(0.0f),
+                       const glm::vec3& escala = glm::vec3(1.0f)) {
+        uint32_t id = transformacoes.adicionar(pos, rot, escala);
+        paiDe.push_back(pai);
+        posicaoDe.push_back((uint32_t)posicaoDe.size());
+        geracaoMundo.push_back(0);
+        // Raiz nova ou filho do último nó em pré-ordem: continua em pré-ordem
+        ordemValida = ordemValida && (pai == NENHUM || posicaoDe[pai] + 1 == (uint32_t)idNaPosicao.size());
+        idNaPosicao.push_back(id);
+        paiNaPosicao.push_back(pai == NENHUM ? NENHUM : posicaoDe[pai]);
+        fim.push_back((uint32_t)idNaPosicao.size());
+        if (ordemValida)
+            for (uint32_t p = paiNaPosicao.back(); p != NENHUM; p = paiNaPosicao[p]) fim[p] = fim.back();
+        mundos.emplace_back(1.0f);
+        normais.emplace_back(1.0f);
+        uniformes.push_back(1);
+        return id;
+    }
+
+    void reservar(size_t n) {
+        transformacoes.reservar(n);
+        paiDe.reserve(n);
+        posicaoDe.reserve(n);
+        geracaoMundo.reserve(n);
+        idNaPosicao.reserve(n);
+        paiNaPosicao.reserve(n);
+        fim.reserve(n);
+        mundos.reserve(n);
+        normais.reserve(n);
+        uniformes.reserve(n);
+    }
+
+    // Muda o pai de um nó (NENHUM solta o nó como raiz). A transformação
+    // local é mantida, então o nó passa a se mover junto com o novo pai.
+    // Retorna false se o novo pai estiver dentro da subárvore do nó.
+    bool definirPai(uint32_t id, uint32_t novoPai) {
+        if (novoPai != NENHUM) {
+            prepararOrdem();
+            uint32_t p = posicaoDe[id], q = posicaoDe[novoPai];
+            if (q >= p && q < fim[p]) return false;
+        }
+        paiDe[id] = novoPai;
+        ordemValida = false;
+        pendentes.push_back(id);
+        return true;
+    }
+
+    uint32_t pai(uint32_t id) const { return paiDe[id]; }
+    size_t tamanho() const { return paiDe.size(); }
+
+    // Posição, rotação e escala locais (relativas ao pai)
+    TransformacoesSoA& locais() { return transformacoes; }
+    const TransformacoesSoA& locais() const { return transformacoes; }
+
+    // Refaz as matrizes de mundo das subárvores sujas e retorna quantas foram.
+    // nThreads = 0 usa todos os núcleos.
+    size_t atualizar(unsigned nThreads = 0) {
+        prepararOrdem();
+        ++geracao;
+        transformacoes.atualizarCache();
+        raizes.clear();
+        for (uint32_t id : transformacoes.recalculados()) raizes.push_back(posicaoDe[id]);
+        for (uint32_t id : pendentes) raizes.push_back(posicaoDe[id]);
+        pendentes.clear();
+        std::sort(raizes.begin(), raizes.end());
+
+        // Faixas disjuntas: uma raiz dentro da faixa anterior já está coberta
+        faixas.clear();
+        size_t total = 0;
+        for (uint32_t p : raizes) {
+            if (!faixas.empty() && p < faixas.back().fim) continue;
+            faixas.push_back({ p, fim[p] });
+            total += fim[p] - p;
+        }
+
+        if (nThreads == 0) nThreads = std::max(1u, std::thread::hardware_concurrency());
+        if (nThreads > 1 && total >= MIN_PARALELO) {
+            repartir(total / (nThreads * 4) + 1);
+            std::atomic<size_t> proxima(0);
+            auto trabalhar = [&] {
+                for (size_t k; (k = proxima++) < trabalhos.size();) refazer(trabalhos[k].inicio, trabalhos[k].fim);
+            };
+            std::vector<std::thread> threads;
+            for (unsigned t = 1; t < nThreads; ++t) threads.emplace_back(trabalhar);
+            trabalhar();
+            for (std::thread& t : threads) t.join();
+        } else {
+            for (const Faixa& f : faixas) refazer(f.inicio, f.fim);
+        }
+
+        recalculadosUltimo.clear();
+        recalculadosUltimo.reserve(total);
+        for (const Faixa& f : faixas)
+            for (uint32_t p = f.inicio; p < f.fim; ++p) recalculadosUltimo.push_back(idNaPosicao[p]);
+        return total;
+    }
+
+    const glm::mat4& mundo(uint32_t id) const { return mundos[posicaoDe[id]]; }
+    const glm::mat3& normalMundo(uint32_t id) const { return normais[posicaoDe[id]]; }
+    // Nós cuja matriz de mundo mudou no último atualizar()
+    const std::vector<uint32_t>& recalculados() const { return recalculadosUltimo; }
+    bool recalculado(uint32_t id) const { return geracaoMundo[id] == geracao; }
+
+private:
+    struct Faixa {
+        uint32_t inicio, fim;
+    };
+
+    // mundo = mundo do pai * local, na ordem das posições
+    void refazer(uint32_t inicio, uint32_t fimFaixa) {
+        for (uint32_t p = inicio; p < fimFaixa; ++p) {
+            uint32_t id = idNaPosicao[p], pp = paiNaPosicao[p];
+            const glm::mat4& local = transformacoes.modeloCache(id);
+            bool uniforme = escalaUniforme(transformacoes.escala(id));
+            if (pp == NENHUM) {
+                mundos[p] = local;
+            } else {
+                mundos[p] = mundos[pp] * local;
+                uniforme = uniforme && uniformes[pp];
+            }
+            // Escala uniforme em toda a cadeia: a parte 3x3 é rotação vezes escalar
+            uniformes[p] = uniforme;
+            normais[p] = matrizNormal(mundos[p], uniforme);
+            geracaoMundo[id] = geracao;
+        }
+    }
+
+    // Quebra as faixas em trabalhos de até ~alvo nós. Uma faixa grande tem a
+    // raiz refeita aqui mesmo; as subárvores dos filhos, contíguas e
+    // independentes entre si, são agrupadas em trabalhos ou quebradas de novo.
+    void repartir(size_t alvo) {
+        trabalhos.clear();
+        std::vector<Faixa> pilha(faixas.rbegin(), faixas.rend());
+        while (!pilha.empty()) {
+            Faixa f = pilha.back();
+            pilha.pop_back();
+            if (f.fim - f.inicio <= alvo) {
+                trabalhos.push_back(f);
+                continue;
+            }
+            refazer(f.inicio, f.inicio + 1);
+            uint32_t grupo = f.inicio + 1;
+            std::vector<Faixa> filhos;
+            for (uint32_t c = f.inicio + 1; c < f.fim; c = fim[c]) {
+                if (fim[c] - c > alvo) {
+                    if (grupo < c) filhos.push_back({ grupo, c });
+                    filhos.push_back({ c, fim[c] });
+                    grupo = fim[c];
+                } else if (fim[c] - grupo > alvo) {
+                    filhos.push_back({ grupo, fim[c] });
+                    grupo = fim[c];
+                }
+            }
+            if (grupo < f.fim) filhos.push_back({ grupo, f.fim });
+            // Só a faixa que ainda é um nó com filhos grande volta para a pilha
+            for (auto it = filhos.rbegin(); it != filhos.rend(); ++it) {
+                bool subarvore = fim[it->inicio] == it->fim;
+                if (subarvore && it->fim - it->inicio > alvo) pilha.push_back(*it);
+                else trabalhos.push_back(*it);
+            }
+        }
+    }
+
+    // Reordena em pré-ordem (filhos na ordem dos ids) depois de mudanças na
+    // hierarquia. As matrizes já calculadas vão junto para as novas posições.
+    void prepararOrdem() {
+        if (ordemValida) return;
+        uint32_t n = (uint32_t)paiDe.size();
+        std::vector<uint32_t> inicioFilhos(n + 2, 0), filhos(n);
+        for (uint32_t id = 0; id < n; ++id) ++inicioFilhos[(paiDe[id] == NENHUM ? n : paiDe[id]) + 1];
+        for (uint32_t k = 0; k <= n; ++k) inicioFilhos[k + 1] += inicioFilhos[k];
+        std::vector<uint32_t> cursor(inicioFilhos.begin(), inicioFilhos.end() - 1);
+        for (uint32_t id = 0; id < n; ++id) filhos[cursor[paiDe[id] == NENHUM ? n : paiDe[id]]++] = id;
+
+        std::vector<uint32_t> novaOrdem;
+        novaOrdem.reserve(n);
+        std::vector<uint32_t> pilha;
+        for (uint32_t k = inicioFilhos[n + 1]; k-- > inicioFilhos[n];) pilha.push_back(filhos[k]);
+        while (!pilha.empty()) {
+            uint32_t id = pilha.back();
+            pilha.pop_back();
+            novaOrdem.push_back(id);
+            for (uint32_t k = inicioFilhos[id + 1]; k-- > inicioFilhos[id];) pilha.push_back(filhos[k]);
+        }
+
+        std::vector<glm::mat4> novosMundos(n);
+        std::vector<glm::mat3> novasNormais(n);
+        std::vector<uint8_t> novosUniformes(n);
+        for (uint32_t p = 0; p < n; ++p) {
+            uint32_t id = novaOrdem[p];
+            novosMundos[p] = mundos[posicaoDe[id]];
+            novasNormais[p] = normais[posicaoDe[id]];
+            novosUniformes[p] = uniformes[posicaoDe[id]];
+        }
+        for (uint32_t p = 0; p < n; ++p) posicaoDe[novaOrdem[p]] = p;
+        for (uint32_t p = 0; p < n; ++p) {
+            uint32_t pai = paiDe[novaOrdem[p]];
+            paiNaPosicao[p] = pai == NENHUM ? NENHUM : posicaoDe[pai];
+            fim[p] = p + 1;
+        }
+        for (uint32_t p = n; p-- > 0;)
+            if (paiNaPosicao[p] != NENHUM) fim[paiNaPosicao[p]] = std::max(fim[paiNaPosicao[p]], fim[p]);
+        idNaPosicao.swap(novaOrdem);
+        mundos.swap(novosMundos);
+        normais.swap(novasNormais);
+        uniformes.swap(novosUniformes);
+        ordemValida = true;
+    }
+
+    TransformacoesSoA transformacoes;
+    // Por id
+    std::vector<uint32_t> paiDe;
+    std::vector<uint32_t> posicaoDe;
+    std::vector<uint32_t> geracaoMundo;
+    // Por posição em pré-ordem
+    std::vector<uint32_t> idNaPosicao;
+    std::vector<uint32_t> paiNaPosicao;
+    std::vector<uint32_t> fim;          // uma posição depois do fim da subárvore
+    std::vector<glm::mat4> mundos;
+    std::vector<glm::mat3> normais;
+    std::vector<uint8_t> uniformes;     // escala uniforme do nó até a raiz
+
+    bool ordemValida = true;
+    std::vector<uint32_t> pendentes;    // ids com o pai trocado
+    std::vector<uint32_t> raizes;
+    std::vector<Faixa> faixas, trabalhos;
+    std::vector<uint32_t> recalculadosUltimo;
+    uint32_t geracao = 0;
+};
@@ -0,0 +1,63 @@
+/*
+ *  PassoFixo.h
+ *
+ *  Relógio de simulação com passo fixo, separado do desenho. Cada quadro
+ *  soma o tempo real decorrido e avancar() diz quantos passos de dt()
+ *  segundos simular agora (zero se o quadro foi mais curto que o passo,
+ *  vários se foi mais longo). A simulação anda sempre em passos iguais,
+ *  então o resultado não depende da taxa de quadros nem da repetição de
+ *  teclas; o resto que sobra no acumulador vira alfa(), a fração do passo
+ *  seguinte já decorrida, para o desenho interpolar entre os dois últimos
+ *  estados simulados.
+ *
+ *  Se o quadro demorar tanto que seriam mais de maxPassos passos, o
+ *  excesso é descartado (a simulação fica mais lenta que o relógio) em vez
+ *  de cada quadro ficar mais caro que o anterior.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  PassoFixo relogio(120.0);                  // 120 passos por segundo
+ *  ...
+ *  int passos = relogio.avancar(deltaTime);   // a cada quadro
+ *  for (int p = 0; p < passos; ++p) {
+ *      anterior = atual;
+ *      simular(atual, relogio.dt());
+ *  }
+ *  desenhar(mix(anterior, atual, relogio.alfa()));
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+class PassoFixo {
+public:
+    explicit PassoFixo(double frequencia = 120.0, int maxPassos = 10)
+        : passo(1.0 / frequencia), maximo(maxPassos) {}
+
+    // Soma o tempo real do quadro e retorna quantos passos simular
+    int avancar(double tempoReal) {
+        acumulado += std::max(tempoReal, 0.0);
+        double inteiros = std::floor(acumulado / passo);
+        acumulado -= inteiros * passo;
+        int n = (int)std::min(inteiros, (double)maximo);
+        descartados += (uint64_t)(inteiros - n);
+        simulados += (uint64_t)n;
+        return n;
+    }
+
+    float dt() const { return (float)passo; }
+    // Fração do próximo passo já decorrida, de 0 a 1
+    float alfa() const { return (float)std::min(acumulado / passo, 1.0); }
+
+    uint64_t passosSimulados() const { return simulados; }
+    uint64_t passosDescartados() const { return descartados; }
+
+private:
+    double passo;
+    int maximo;
+    double acumulado = 0.0;
+    uint64_t simulados = 0, descartados = 0;
+};
@@ -0,0 +1,153 @@
+/*
+ *  ProgramaShader.h
+ *
+ *  Envolve um programa de shader já linkado (o GLuint de criarShader()) e
+ *  resolve as localizações de todos os uniforms ativos uma única vez, com
+ *  glGetActiveUniform. Os setters são tipados (em debug, um assert confere o
+ *  tipo declarado no GLSL). O laço de desenho passa a usar handles
+ *  (UniformShader) em vez de procurar "model"/"view" por string a cada
+ *  objeto, e cada uniform guarda o último valor enviado: se o valor não
+ *  mudou, o glUniform* não é chamado.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  ProgramaShader shader(criarShader());
+ *  UniformShader uModel = shader.uniform("model");
+ *  ...
+ *  shader.usar();
+ *  shader.definir(uModel, model);
+ *
+ *  Como no glUniform*, os setters valem para o programa em uso: chame
+ *  usar() antes. Um handle inválido (uniform inexistente ou eliminado pelo
+ *  compilador de GLSL) é ignorado, igual a uma localização -1.
+ */
+
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Índice de um uniform dentro de um ProgramaShader
+struct UniformShader {
+    int indice = -1;
+    bool valido() const { return indice >= 0; }
+};
+
+class ProgramaShader {
+public:
+    ProgramaShader() = default;
+    explicit ProgramaShader(GLuint programa) { adotar(programa); }
+
+    // Lê a lista de uniforms ativos do programa (uma vez, fora do laço)
+    void adotar(GLuint programa) {
+        id = programa;
+        uniforms.clear();
+        porNome.clear();
+        GLint nAtivos = 0, maiorNome = 0;
+        glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &nAtivos);
+        glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maiorNome);
+        std::vector<GLchar> nome(std::max(maiorNome, 1));
+        for (GLint i = 0; i < nAtivos; ++i) {
+            GLsizei comprimento = 0;
+            Uniform u;
+            glGetActiveUniform(id, (GLuint)i, (GLsizei)nome.size(), &comprimento, &u.tamanho, &u.tipo, nome.data());
+            u.nome.assign(nome.data(), comprimento);
+            u.local = glGetUniformLocation(id, u.nome.c_str());
+            if (u.local < 0) continue; // membros de uniform blocks não têm localização
+            // Arrays aparecem como "nome[0]"; aceita também "nome"
+            if (u.nome.size() > 3 && u.nome.compare(u.nome.size() - 3, 3, "[0]") == 0)
+                porNome[u.nome.substr(0, u.nome.size() - 3)] = (int)uniforms.size();
+            porNome[u.nome] = (int)uniforms.size();
+            uniforms.push_back(u);
+        }
+    }
+
+    GLuint programa() const { return id; }
+    void usar() const { glUseProgram(id); }
+
+    UniformShader uniform(const std::string& nome) const {
+        auto it = porNome.find(nome);
+        UniformShader u;
+        if (it != porNome.end()) u.indice = it->second;
+        return u;
+    }
+
+    // Esquece os valores guardados (p.ex. depois de alterar o programa por fora)
+    void invalidar() { for (Uniform& u : uniforms) u.definido = false; }
+
+    // Envios feitos e evitados por serem iguais ao último valor
+    size_t envios() const { return nEnvios; }
+    size_t enviosEvitados() const { return nEvitados; }
+
+    void definir(UniformShader u, int v) {
+        if (mudou(u, GL_INT, &v, sizeof(v))) glUniform1i(uniforms[u.indice].local, v);
+    }
+    void definir(UniformShader u, float v) {
+        if (mudou(u, GL_FLOAT, &v, sizeof(v))) glUniform1f(uniforms[u.indice].local, v);
+    }
+    void definir(UniformShader u, const glm::vec2& v) {
+        if (mudou(u, GL_FLOAT_VEC2, &v, sizeof(v))) glUniform2fv(uniforms[u.indice].local, 1, &v[0]);
+    }
+    void definir(UniformShader u, const glm::vec3& v) {
+        if (mudou(u, GL_FLOAT_VEC3, &v, sizeof(v))) glUniform3fv(uniforms[u.indice].local, 1, &v[0]);
+    }
+    void definir(UniformShader u, const glm::vec4& v) {
+        if (mudou(u, GL_FLOAT_VEC4, &v, sizeof(v))) glUniform4fv(uniforms[u.indice].local, 1, &v[0]);
+    }
+    void definir(UniformShader u, const glm::mat3& v) {
+        if (mudou(u, GL_FLOAT_MAT3, &v, sizeof(v))) glUniformMatrix3fv(uniforms[u.indice].local, 1, GL_FALSE, &v[0][0]);
+    }
+    void definir(UniformShader u, const glm::mat4& v) {
+        if (mudou(u, GL_FLOAT_MAT4, &v, sizeof(v))) glUniformMatrix4fv(uniforms[u.indice].local, 1, GL_FALSE, &v[0][0]);
+    }
+
+    // Atalho para configuração inicial; no laço de desenho prefira os handles
+    template <typename T>
+    void definir(const std::string& nome, const T& v) { definir(uniform(nome), v); }
+
+private:
+    struct Uniform {
+        std::string nome;
+        GLint local = -1;
+        GLint tamanho = 0;
+        GLenum tipo = 0;
+        bool definido = false;
+        unsigned char valor[sizeof(glm::mat4)]; // último valor enviado
+    };
+
+    // Inteiros servem para int, bool e samplers; os demais tipos precisam bater
+    static bool compativel(GLenum declarado, GLenum pedido) {
+        if (declarado == pedido) return true;
+        if (pedido != GL_INT) return false;
+        return declarado != GL_FLOAT && declarado != GL_FLOAT_VEC2 && declarado != GL_FLOAT_VEC3 &&
+               declarado != GL_FLOAT_VEC4 && declarado != GL_FLOAT_MAT3 && declarado != GL_FLOAT_MAT4;
+    }
+
+    bool mudou(UniformShader h, GLenum tipo, const void* v, size_t bytes) {
+        if (!h.valido()) return false;
+        assert(h.indice < (int)uniforms.size());
+        Uniform& u = uniforms[h.indice];
+        assert(compativel(u.tipo, tipo));
+        (void)tipo;
+        assert(bytes <= sizeof(u.valor));
+        if (u.definido && memcmp(u.valor, v, bytes) == 0) {
+            ++nEvitados;
+            return false;
+        }
+        memcpy(u.valor, v, bytes);
+        u.definido = true;
+        ++nEnvios;
+        return true;
+    }
+
+    GLuint id = 0;
+    std::vector<Uniform> uniforms;
+    std::unordered_map<std::string, int> porNome;
+    size_t nEnvios = 0, nEvitados = 0;
+};
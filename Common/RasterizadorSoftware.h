@@ -0,0 +1,878 @@
+/*
+ *  RasterizadorSoftware.h
+ *
+ *  Rasterizador em CPU que reproduz o fragment shader Phong do M5/M6:
+ *  (ka + kd * difusa + ks * especular) * cor da textura, com a luz branca.
+ *  Serve de referência para imagens de comparação e para máquinas sem GPU.
+ *  Consome o mesmo vértice intercalado de 11 floats (posição, cor, normal,
+ *  uv) e os mesmos índices de 16 ou 32 bits que vão para o glDrawElements.
+ *
+ *  executar() roda as chamadas acumuladas por desenhar() em três fases,
+ *  todas divididas entre threads:
+ *    1) vértices: clip space, posição no mundo, normal (matriz das normais
+ *       da CPU) e uv de cada vértice;
+ *    2) triângulos: recorte no plano near, divisão perspectiva, descarte
+ *       fora da tela e montagem das funções de aresta (half-space) e dos
+ *       planos de z, 1/w e atributo/w; cada triângulo vai para a lista dos
+ *       tiles de 64x64 que a sua caixa toca. Cada thread tem as suas
+ *       listas e pega um trecho contíguo dos triângulos, então a ordem de
+ *       envio se mantém ao ler as listas na ordem das threads;
+ *    3) tiles: cada thread pega o próximo tile livre e desenha os seus
+ *       triângulos em blocos de 8x8. Cada bloco guarda a maior
+ *       profundidade (Z hierárquico): um triângulo cujo menor z no bloco
+ *       (ou no tile inteiro) já é maior é descartado sem olhar pixels.
+ *       Os pixels são sombreados 8 por vez (uma linha do bloco) com AVX2,
+ *       ou um a um sem AVX2.
+ *
+ *  A uv é interpolada com correção de perspectiva e a textura é amostrada
+ *  como GL_LINEAR_MIPMAP_LINEAR com GL_REPEAT, com o nível de detalhe tirado
+ *  das derivadas analíticas da uv no pixel. O resultado é o mesmo para
+ *  qualquer número de threads; entre o caminho escalar e o AVX2 difere no
+ *  arredondamento (pow e log2 por polinômio), no máximo uma ou duas unidades
+ *  por canal.
+ *
+ *  A imagem fica em RGBA8 com a linha 0 embaixo, como o glReadPixels lê.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  TexturaSoftware textura;
+ *  textura.criar(pixels, largura, altura, canais);     // os mesmos de criarTextura()
+ *  RasterizadorSoftware raster;
+ *  raster.redimensionar(1920, 1080);
+ *  raster.definirQuadro(view, projection, lightPos, camPos);
+ *  raster.limpar(glm::vec3(0.1f));
+ *  raster.desenhar(malha.vertices, malha.nVertices(), malha.indices, malha.nIndices(),
+ *                  malha.indices16Bits(), model, &textura, malha.material);
+ *  raster.executar();                                   // os vértices precisam existir até aqui
+ *  raster.gravarPPM("quadro.ppm");
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CarregadorOBJ.h"
+#include "Transformacoes.h"
+#include "TransformacoesSoA.h"
+
+namespace rasterizadorSoftware {
+
+#ifdef TRANSFORMACOES_AVX2
+
+// log2 de 8 valores positivos: expoente do float mais o polinômio do logf
+// da Cephes para a mantissa em [sqrt(1/2), sqrt(2)); erro ~1e-7
+ALVO_AVX2 inline __m256 log2_8(__m256 x) {
+    __m256i bits = _mm256_castps_si256(x);
+    __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+    __m256 m = _mm256_castsi256_ps(
+        _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F800000)));
+    __m256 grande = _mm256_cmp_ps(m, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+    m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), grande);
+    e = _mm256_add_ps(e, _mm256_and_ps(grande, _mm256_set1_ps(1.0f)));
+    __m256 f = _mm256_sub_ps(m, _mm256_set1_ps(1.0f));
+    const float coeficientes[9] = { 7.0376836292e-2f, -1.1514610310e-1f, 1.1676998740e-1f, -1.2420140846e-1f,
+                                    1.4249322787e-1f, -1.6668057665e-1f, 2.0000714765e-1f, -2.4999993993e-1f,
+                                    3.3333331174e-1f };
+    __m256 p = _mm256_set1_ps(coeficientes[0]);
+    for (int i = 1; i < 9; ++i) p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(coeficientes[i]));
+    __m256 f2 = _mm256_mul_ps(f, f);
+    // ln(1 + f) = f - f²/2 + f³ p(f)
+    __m256 ln = _mm256_add_ps(f, _mm256_fmadd_ps(_mm256_mul_ps(f2, f), p, _mm256_mul_ps(_mm256_set1_ps(-0.5f), f2)));
+    return _mm256_fmadd_ps(ln, _mm256_set1_ps(1.4426950409f), e); // 1 / ln 2
+}
+
+// 2^x: parte inteira no expoente, fracionária pela série de e^(f ln 2); erro ~1e-6
+ALVO_AVX2 inline __m256 exp2_8(__m256 x) {
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-126.0f)), _mm256_set1_ps(126.0f));
+    __m256 n = _mm256_floor_ps(x);
+    __m256 f = _mm256_sub_ps(x, n);
+    __m256 p = _mm256_fmadd_ps(f, _mm256_set1_ps(1.5252734e-5f), _mm256_set1_ps(1.5403530e-4f));
+    p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(1.3333558e-3f));
+    p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(9.6181291e-3f));
+    p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(5.5504109e-2f));
+    p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(2.4022651e-1f));
+    p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(6.9314718e-1f));
+    p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(1.0f));
+    __m256i escala = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(p, _mm256_castsi256_ps(escala));
+}
+
+ALVO_AVX2 inline __m256 canal8(__m256i texels, int deslocamento) {
+    return _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(texels, deslocamento), _mm256_set1_epi32(0xFF)));
+}
+
+ALVO_AVX2 inline __m256 plano8(float c, float dx, float dy, __m256 x, __m256 y) {
+    return _mm256_fmadd_ps(_mm256_set1_ps(dx), x, _mm256_fmadd_ps(_mm256_set1_ps(dy), y, _mm256_set1_ps(c)));
+}
+
+ALVO_AVX2 inline __m256 produtoEscalar8(__m256 ax, __m256 ay, __m256 az, __m256 bx, __m256 by, __m256 bz) {
+    return _mm256_fmadd_ps(ax, bx, _mm256_fmadd_ps(ay, by, _mm256_mul_ps(az, bz)));
+}
+
+// 1/x e 1/sqrt(x) pelas aproximações de 12 bits com um passo de Newton (~22 bits)
+ALVO_AVX2 inline __m256 inverso8(__m256 x) {
+    __m256 r = _mm256_rcp_ps(x);
+    return _mm256_mul_ps(r, _mm256_fnmadd_ps(x, r, _mm256_set1_ps(2.0f)));
+}
+
+ALVO_AVX2 inline __m256 inversoRaiz8(__m256 x) {
+    __m256 r = _mm256_rsqrt_ps(x);
+    __m256 meioXR2 = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), x), _mm256_mul_ps(r, r));
+    return _mm256_mul_ps(r, _mm256_sub_ps(_mm256_set1_ps(1.5f), meioXR2));
+}
+
+ALVO_AVX2 inline void normalizar8(__m256& x, __m256& y, __m256& z) {
+    __m256 inverso = inversoRaiz8(produtoEscalar8(x, y, z, x, y, z));
+    x = _mm256_mul_ps(x, inverso);
+    y = _mm256_mul_ps(y, inverso);
+    z = _mm256_mul_ps(z, inverso);
+}
+
+// luz * cor em [0, 1] para um byte, arredondado como na conversão do GL
+ALVO_AVX2 inline __m256i byte8(__m256 luz, __m256 cor) {
+    cor = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(luz, cor), _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    return _mm256_cvttps_epi32(_mm256_fmadd_ps(cor, _mm256_set1_ps(255.0f), _mm256_set1_ps(0.5f)));
+}
+
+// Maior profundidade de um bloco 8x8 (linhas a passo floats uma da outra)
+ALVO_AVX2 inline float maximoBloco8(const float* p, size_t passo) {
+    __m256 m = _mm256_loadu_ps(p);
+    for (int k = 1; k < 8; ++k) m = _mm256_max_ps(m, _mm256_loadu_ps(p + k * passo));
+    __m128 q = _mm_max_ps(_mm256_castps256_ps128(m), _mm256_extractf128_ps(m, 1));
+    q = _mm_max_ps(q, _mm_movehl_ps(q, q));
+    q = _mm_max_ss(q, _mm_shuffle_ps(q, q, 1));
+    return _mm_cvtss_f32(q);
+}
+
+#endif // TRANSFORMACOES_AVX2
+
+} // namespace rasterizadorSoftware
+
+// Textura com a cadeia de mipmaps em RGBA8, amostrada como a do M5/M6
+class TexturaSoftware {
+public:
+    // Os mesmos parâmetros de criarTextura(): a primeira linha de pixels fica
+    // em v = 0; 1 ou 2 canais viram cinza. Os níveis saem da média de 2x2.
+    void criar(const unsigned char* pixels, int largura, int altura, int canais) {
+        texels.clear();
+        offsets.clear();
+        larguras.clear();
+        alturas.clear();
+        texels.resize((size_t)largura * altura);
+        for (size_t i = 0; i < texels.size(); ++i) {
+            const unsigned char* p = pixels + i * canais;
+            uint32_t r = p[0], g = canais >= 3 ? p[1] : p[0], b = canais >= 3 ? p[2] : p[0];
+            texels[i] = r | (g << 8) | (b << 16) | 0xFF000000u;
+        }
+        offsets.push_back(0);
+        larguras.push_back(largura);
+        alturas.push_back(altura);
+        while (larguras.back() > 1 || alturas.back() > 1) {
+            int w = larguras.back(), h = alturas.back();
+            int w2 = std::max(1, w / 2), h2 = std::max(1, h / 2);
+            size_t origem = offsets.back(), destino = texels.size();
+            texels.resize(destino + (size_t)w2 * h2);
+            for (int y = 0; y < h2; ++y)
+                for (int x = 0; x < w2; ++x) {
+                    int x0 = std::min(2 * x, w - 1), x1 = std::min(2 * x + 1, w - 1);
+                    int y0 = std::min(2 * y, h - 1), y1 = std::min(2 * y + 1, h - 1);
+                    uint32_t t[4] = { texels[origem + (size_t)y0 * w + x0], texels[origem + (size_t)y0 * w + x1],
+                                      texels[origem + (size_t)y1 * w + x0], texels[origem + (size_t)y1 * w + x1] };
+                    uint32_t media = 0xFF000000u;
+                    for (int c = 0; c < 3; ++c) {
+                        uint32_t soma = 2;
+                        for (uint32_t v : t) soma += (v >> (8 * c)) & 0xFF;
+                        media |= (soma / 4) << (8 * c);
+                    }
+                    texels[destino + (size_t)y * w2 + x] = media;
+                }
+            offsets.push_back((int32_t)destino);
+            larguras.push_back(w2);
+            alturas.push_back(h2);
+        }
+    }
+
+    int niveis() const { return (int)offsets.size(); }
+    int largura() const { return larguras[0]; }
+    int altura() const { return alturas[0]; }
+
+    // Trilinear com repetição; lod em níveis (log2 dos texels por pixel). Cor em [0, 1]
+    glm::vec3 amostrar(float u, float v, float lod) const {
+        lod = std::min(std::max(lod, 0.0f), (float)(niveis() - 1));
+        int n0 = (int)lod, n1 = std::min(n0 + 1, niveis() - 1);
+        float f = lod - (float)n0;
+        glm::vec3 c = bilinear(n0, u, v);
+        if (f > 0.0f) c += (bilinear(n1, u, v) - c) * f;
+        return c * (1.0f / 255.0f);
+    }
+
+#ifdef TRANSFORMACOES_AVX2
+    ALVO_AVX2 void amostrar8(__m256 u, __m256 v, __m256 lod, __m256& r, __m256& g, __m256& b) const {
+        lod = _mm256_min_ps(_mm256_max_ps(lod, _mm256_setzero_ps()), _mm256_set1_ps((float)(niveis() - 1)));
+        __m256i n0 = _mm256_cvttps_epi32(lod);
+        __m256i n1 = _mm256_min_epi32(_mm256_add_epi32(n0, _mm256_set1_epi32(1)), _mm256_set1_epi32(niveis() - 1));
+        __m256 f = _mm256_sub_ps(lod, _mm256_cvtepi32_ps(n0));
+        bilinear8(n0, u, v, r, g, b);
+        if (_mm256_movemask_ps(_mm256_cmp_ps(f, _mm256_setzero_ps(), _CMP_GT_OQ))) {
+            __m256 r1, g1, b1;
+            bilinear8(n1, u, v, r1, g1, b1);
+            r = _mm256_fmadd_ps(_mm256_sub_ps(r1, r), f, r);
+            g = _mm256_fmadd_ps(_mm256_sub_ps(g1, g), f, g);
+            b = _mm256_fmadd_ps(_mm256_sub_ps(b1, b), f, b);
+        }
+        __m256 escala = _mm256_set1_ps(1.0f / 255.0f);
+        r = _mm256_mul_ps(r, escala);
+        g = _mm256_mul_ps(g, escala);
+        b = _mm256_mul_ps(b, escala);
+    }
+#endif
+
+private:
+    static glm::vec3 cor(uint32_t t) { return glm::vec3((float)(t & 0xFF), (float)((t >> 8) & 0xFF), (float)((t >> 16) & 0xFF)); }
+
+    // Centros dos texels em (i + 0.5) / largura, como no GL; u e v dão a volta em [0, 1)
+    glm::vec3 bilinear(int nivel, float u, float v) const {
+        int w = larguras[nivel], h = alturas[nivel];
+        float x = (u - std::floor(u)) * w - 0.5f, y = (v - std::floor(v)) * h - 0.5f;
+        float xf = std::floor(x), yf = std::floor(y);
+        float fx = x - xf, fy = y - yf;
+        int x0 = (int)xf, y0 = (int)yf;
+        if (x0 < 0) x0 += w;
+        if (y0 < 0) y0 += h;
+        int x1 = x0 + 1 == w ? 0 : x0 + 1, y1 = y0 + 1 == h ? 0 : y0 + 1;
+        const uint32_t* base = texels.data() + offsets[nivel];
+        glm::vec3 c00 = cor(base[(size_t)y0 * w + x0]), c10 = cor(base[(size_t)y0 * w + x1]);
+        glm::vec3 c01 = cor(base[(size_t)y1 * w + x0]), c11 = cor(base[(size_t)y1 * w + x1]);
+        glm::vec3 baixo = c00 + (c10 - c00) * fx, cima = c01 + (c11 - c01) * fx;
+        return baixo + (cima - baixo) * fy;
+    }
+
+#ifdef TRANSFORMACOES_AVX2
+    ALVO_AVX2 void bilinear8(__m256i nivel, __m256 u, __m256 v, __m256& r, __m256& g, __m256& b) const {
+        using namespace rasterizadorSoftware;
+        __m256i offset = _mm256_i32gather_epi32(offsets.data(), nivel, 4);
+        __m256i w = _mm256_i32gather_epi32(larguras.data(), nivel, 4);
+        __m256i h = _mm256_i32gather_epi32(alturas.data(), nivel, 4);
+        __m256 meio = _mm256_set1_ps(0.5f);
+        __m256 x = _mm256_fmsub_ps(_mm256_sub_ps(u, _mm256_floor_ps(u)), _mm256_cvtepi32_ps(w), meio);
+        __m256 y = _mm256_fmsub_ps(_mm256_sub_ps(v, _mm256_floor_ps(v)), _mm256_cvtepi32_ps(h), meio);
+        __m256 xf = _mm256_floor_ps(x), yf = _mm256_floor_ps(y);
+        __m256 fx = _mm256_sub_ps(x, xf), fy = _mm256_sub_ps(y, yf);
+        __m256i zero = _mm256_setzero_si256(), um = _mm256_set1_epi32(1);
+        __m256i x0 = _mm256_cvtps_epi32(xf), y0 = _mm256_cvtps_epi32(yf);
+        x0 = _mm256_add_epi32(x0, _mm256_and_si256(_mm256_cmpgt_epi32(zero, x0), w));
+        y0 = _mm256_add_epi32(y0, _mm256_and_si256(_mm256_cmpgt_epi32(zero, y0), h));
+        __m256i x1 = _mm256_add_epi32(x0, um), y1 = _mm256_add_epi32(y0, um);
+        x1 = _mm256_andnot_si256(_mm256_cmpeq_epi32(x1, w), x1);
+        y1 = _mm256_andnot_si256(_mm256_cmpeq_epi32(y1, h), y1);
+        __m256i linha0 = _mm256_add_epi32(offset, _mm256_mullo_epi32(y0, w));
+        __m256i linha1 = _mm256_add_epi32(offset, _mm256_mullo_epi32(y1, w));
+        const int* t = (const int*)texels.data();
+        __m256i t00 = _mm256_i32gather_epi32(t, _mm256_add_epi32(linha0, x0), 4);
+        __m256i t10 = _mm256_i32gather_epi32(t, _mm256_add_epi32(linha0, x1), 4);
+        __m256i t01 = _mm256_i32gather_epi32(t, _mm256_add_epi32(linha1, x0), 4);
+        __m256i t11 = _mm256_i32gather_epi32(t, _mm256_add_epi32(linha1, x1), 4);
+        __m256* saida[3] = { &r, &g, &b };
+        for (int c = 0; c < 3; ++c) {
+            __m256 c00 = canal8(t00, 8 * c), c10 = canal8(t10, 8 * c);
+            __m256 c01 = canal8(t01, 8 * c), c11 = canal8(t11, 8 * c);
+            __m256 baixo = _mm256_fmadd_ps(_mm256_sub_ps(c10, c00), fx, c00);
+            __m256 cima = _mm256_fmadd_ps(_mm256_sub_ps(c11, c01), fx, c01);
+            *saida[c] = _mm256_fmadd_ps(_mm256_sub_ps(cima, baixo), fy, baixo);
+        }
+    }
+#endif
+
+    std::vector<uint32_t> texels;  // todos os níveis, um depois do outro
+    std::vector<int32_t> offsets, larguras, alturas; // por nível (int32 para os gathers)
+};
+
+struct EstatisticasRaster {
+    size_t triangulos = 0;          // enviados por desenhar()
+    size_t descartados = 0;         // fora da tela, de costas ou sem área
+    size_t recortados = 0;          // cortados pelo plano near
+    size_t rejeitadosHiZ = 0;       // blocos 8x8 (ou tiles inteiros, contados como os seus blocos) pulados pelo Z hierárquico
+    size_t pixelsSombreados = 0;    // que passaram no teste de profundidade
+
+    void somar(const EstatisticasRaster& o) {
+        triangulos += o.triangulos;
+        descartados += o.descartados;
+        recortados += o.recortados;
+        rejeitadosHiZ += o.rejeitadosHiZ;
+        pixelsSombreados += o.pixelsSombreados;
+    }
+};
+
+class RasterizadorSoftware {
+public:
+    static const int TAMANHO_TILE = 64;
+    static const int TAMANHO_BLOCO = 8;      // Z hierárquico e sombreamento: 8 pixels por vez
+    static const size_t BLOCO_VERTICES = 4096;
+
+    bool usarAVX2 = true;
+    bool descartarCostas = false;            // GL_CULL_FACE (M5/M6 não ligam)
+    EstatisticasRaster estatisticas;         // da última executar()
+
+    void redimensionar(int largura, int altura) {
+        this->largura = largura;
+        this->altura = altura;
+        passo = (largura + TAMANHO_BLOCO - 1) / TAMANHO_BLOCO * TAMANHO_BLOCO;
+        int linhas = (altura + TAMANHO_BLOCO - 1) / TAMANHO_BLOCO * TAMANHO_BLOCO;
+        cores.assign((size_t)passo * linhas, 0);
+        profundidades.assign((size_t)passo * linhas, 1.0f);
+        blocosX = passo / TAMANHO_BLOCO;
+        zMaxBlocos.assign((size_t)blocosX * (linhas / TAMANHO_BLOCO), 1.0f);
+        tilesX = (largura + TAMANHO_TILE - 1) / TAMANHO_TILE;
+        tilesY = (altura + TAMANHO_TILE - 1) / TAMANHO_TILE;
+    }
+
+    // Cor de fundo e profundidade 1, como glClear
+    void limpar(const glm::vec3& cor) {
+        std::fill(cores.begin(), cores.end(), empacotar(cor));
+        std::fill(profundidades.begin(), profundidades.end(), 1.0f);
+        std::fill(zMaxBlocos.begin(), zMaxBlocos.end(), 1.0f);
+    }
+
+    // O que o bloco Quadro leva para o fragment shader
+    void definirQuadro(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& lightPos,
+                       const glm::vec3& camPos) {
+        viewProjection = projection * view;
+        this->lightPos = lightPos;
+        this->camPos = camPos;
+    }
+
+    // Acumula uma chamada; vertices e indices são lidos só em executar()
+    void desenhar(const float* vertices, size_t nVertices, const void* indices, size_t nIndices, bool indices16Bits,
+                  const glm::mat4& model, const TexturaSoftware* textura, const MaterialOBJ& material) {
+        Chamada c;
+        c.vertices = vertices;
+        c.nVertices = nVertices;
+        c.indices = indices;
+        c.nTriangulos = nIndices / 3;
+        c.indices16Bits = indices16Bits;
+        c.model = model;
+        c.normal = matrizNormal(model, false);
+        c.mvp = viewProjection * model;
+        c.textura = textura ? textura : &branca();
+        c.material = material;
+        c.primeiroVertice = chamadas.empty() ? 0 : chamadas.back().primeiroVertice + chamadas.back().nVertices;
+        c.primeiroTriangulo = chamadas.empty() ? 0 : chamadas.back().primeiroTriangulo + chamadas.back().nTriangulos;
+        chamadas.push_back(c);
+    }
+
+    // Desenha as chamadas acumuladas e as esquece; nThreads = 0 usa todos os núcleos
+    void executar(unsigned nThreads = 0) {
+        estatisticas = EstatisticasRaster();
+        if (nThreads == 0) nThreads = std::max(1u, std::thread::hardware_concurrency());
+        if (chamadas.empty() || largura <= 0 || altura <= 0) {
+            chamadas.clear();
+            return;
+        }
+        size_t nVertices = chamadas.back().primeiroVertice + chamadas.back().nVertices;
+        size_t nTriangulos = chamadas.back().primeiroTriangulo + chamadas.back().nTriangulos;
+        verticesClip.resize(nVertices);
+        porThread.resize(nThreads);
+        size_t nTiles = (size_t)tilesX * tilesY;
+        for (PorThread& p : porThread) {
+            p.triangulos.clear();
+            p.tiles.resize(nTiles);
+            for (std::vector<uint32_t>& lista : p.tiles) lista.clear();
+            p.estatisticas = EstatisticasRaster();
+        }
+
+        // 1) vértices, em blocos
+        std::atomic<size_t> proximoVertice(0);
+        rodar(nThreads, [&](unsigned) {
+            for (size_t inicio; (inicio = proximoVertice.fetch_add(BLOCO_VERTICES)) < nVertices;)
+                transformarVertices(inicio, std::min(nVertices, inicio + BLOCO_VERTICES));
+        });
+
+        // 2) triângulos: trechos contíguos, na ordem das threads
+        rodar(nThreads, [&](unsigned t) {
+            montarTriangulos(nTriangulos * t / nThreads, nTriangulos * (t + 1) / nThreads, porThread[t]);
+        });
+
+        // 3) tiles
+        std::atomic<size_t> proximoTile(0);
+        rodar(std::min<size_t>(nThreads, nTiles), [&](unsigned t) {
+            for (size_t tile; (tile = proximoTile.fetch_add(1)) < nTiles;) desenharTile(tile, porThread[t].estatisticas);
+        });
+
+        for (const PorThread& p : porThread) estatisticas.somar(p.estatisticas);
+        estatisticas.triangulos = nTriangulos;
+        chamadas.clear();
+    }
+
+    int larguraImagem() const { return largura; }
+    int alturaImagem() const { return altura; }
+    // RGBA8 (r no byte menos significativo), linha 0 embaixo; a linha y começa em cor() + y * passoLinha()
+    const uint32_t* cor() const { return cores.data(); }
+    const float* profundidade() const { return profundidades.data(); }
+    int passoLinha() const { return passo; }
+    uint32_t pixel(int x, int y) const { return cores[(size_t)y * passo + x]; }
+
+    // P6 em RGB, linhas de cima para baixo
+    bool gravarPPM(const std::string& nome) const {
+        FILE* arquivo = fopen(nome.c_str(), "wb");
+        if (!arquivo) return false;
+        fprintf(arquivo, "P6\n%d %d\n255\n", largura, altura);
+        std::vector<unsigned char> linha((size_t)largura * 3);
+        for (int y = altura - 1; y >= 0; --y) {
+            for (int x = 0; x < largura; ++x) {
+                uint32_t c = pixel(x, y);
+                linha[(size_t)x * 3] = (unsigned char)(c & 0xFF);
+                linha[(size_t)x * 3 + 1] = (unsigned char)((c >> 8) & 0xFF);
+                linha[(size_t)x * 3 + 2] = (unsigned char)((c >> 16) & 0xFF);
+            }
+            fwrite(linha.data(), 1, linha.size(), arquivo);
+        }
+        return fclose(arquivo) == 0;
+    }
+
+private:
+    static const int N_ATRIBUTOS = 8;        // posição no mundo, normal, uv
+
+    struct Chamada {
+        const float* vertices;
+        size_t nVertices;
+        const void* indices;
+        size_t nTriangulos;
+        bool indices16Bits;
+        glm::mat4 model, mvp;
+        glm::mat3 normal;
+        const TexturaSoftware* textura;
+        MaterialOBJ material;
+        size_t primeiroVertice, primeiroTriangulo;
+    };
+
+    struct VerticeClip {
+        glm::vec4 clip;
+        float atributos[N_ATRIBUTOS];
+    };
+
+    // Planos em coordenadas relativas ao primeiro vértice (ox, oy), para não
+    // perder precisão longe da origem: p(x, y) = c + dx * (x - ox) + dy * (y - oy)
+    struct Plano {
+        float c, dx, dy;
+        float em(float x, float y) const { return c + dx * x + dy * y; }
+    };
+
+    struct Triangulo {
+        Plano arestas[3];                    // > 0 dentro (>= 0 nas arestas de cima/esquerda)
+        bool cimaEsquerda[3];
+        Plano z, q;                          // profundidade e 1/w
+        Plano atributos[N_ATRIBUTOS];        // atributo/w
+        float ox, oy;
+        float zMin;
+        int xMin, yMin, xMax, yMax;          // pixels, inclusive, já dentro da tela
+        uint32_t chamada;
+    };
+
+    struct PorThread {
+        std::vector<Triangulo> triangulos;
+        std::vector<std::vector<uint32_t>> tiles; // índices em triangulos, por tile
+        EstatisticasRaster estatisticas;
+    };
+
+    static const TexturaSoftware& branca() {
+        static const TexturaSoftware textura = [] {
+            TexturaSoftware t;
+            const unsigned char pixel[4] = { 255, 255, 255, 255 };
+            t.criar(pixel, 1, 1, 4);
+            return t;
+        }();
+        return textura;
+    }
+
+    static uint32_t empacotar(const glm::vec3& c) {
+        uint32_t r = (uint32_t)(std::min(std::max(c.r, 0.0f), 1.0f) * 255.0f + 0.5f);
+        uint32_t g = (uint32_t)(std::min(std::max(c.g, 0.0f), 1.0f) * 255.0f + 0.5f);
+        uint32_t b = (uint32_t)(std::min(std::max(c.b, 0.0f), 1.0f) * 255.0f + 0.5f);
+        return r | (g << 8) | (b << 16) | 0xFF000000u;
+    }
+
+    template <typename F>
+    static void rodar(size_t nThreads, F&& tarefa) {
+        std::vector<std::thread> threads;
+        for (unsigned t = 1; t < nThreads; ++t) threads.emplace_back(tarefa, t);
+        tarefa(0u);
+        for (std::thread& t : threads) t.join();
+    }
+
+    // Chamada que contém o vértice (ou triângulo) global g
+    template <typename Campo>
+    size_t chamadaDe(size_t g, Campo campo) const {
+        size_t c = std::upper_bound(chamadas.begin(), chamadas.end(), g,
+                                    [&](size_t v, const Chamada& ch) { return v < ch.*campo; }) - chamadas.begin();
+        return c - 1;
+    }
+
+    void transformarVertices(size_t inicio, size_t fim) {
+        for (size_t c = chamadaDe(inicio, &Chamada::primeiroVertice); inicio < fim; ++c) {
+            const Chamada& ch = chamadas[c];
+            size_t ate = std::min(fim, ch.primeiroVertice + ch.nVertices);
+            for (size_t g = inicio; g < ate; ++g) {
+                const float* v = ch.vertices + (g - ch.primeiroVertice) * FLOATS_POR_VERTICE;
+                glm::vec4 pos(v[0], v[1], v[2], 1.0f);
+                glm::vec3 mundo = glm::vec3(ch.model * pos);
+                glm::vec3 normal = ch.normal * glm::vec3(v[6], v[7], v[8]);
+                VerticeClip& s = verticesClip[g];
+                s.clip = ch.mvp * pos;
+                float a[N_ATRIBUTOS] = { mundo.x, mundo.y, mundo.z, normal.x, normal.y, normal.z, v[9], v[10] };
+                std::copy(a, a + N_ATRIBUTOS, s.atributos);
+            }
+            inicio = ate;
+        }
+    }
+
+    void montarTriangulos(size_t inicio, size_t fim, PorThread& saida) {
+        if (inicio >= fim) return;
+        for (size_t c = chamadaDe(inicio, &Chamada::primeiroTriangulo); inicio < fim; ++c) {
+            const Chamada& ch = chamadas[c];
+            size_t ate = std::min(fim, ch.primeiroTriangulo + ch.nTriangulos);
+            for (size_t g = inicio; g < ate; ++g) {
+                size_t k = (g - ch.primeiroTriangulo) * 3;
+                VerticeClip v[3];
+                for (int i = 0; i < 3; ++i) {
+                    uint32_t indice = ch.indices16Bits ? ((const uint16_t*)ch.indices)[k + i]
+                                                       : ((const uint32_t*)ch.indices)[k + i];
+                    v[i] = verticesClip[ch.primeiroVertice + indice];
+                }
+                recortarEMontar(v, (uint32_t)c, saida);
+            }
+            inicio = ate;
+        }
+    }
+
+    // Descarta o que está todo fora de um plano do frustum e recorta no near (z >= -w)
+    void recortarEMontar(const VerticeClip v[3], uint32_t chamada, PorThread& saida) {
+        for (int eixo = 0; eixo < 3; ++eixo) {
+            bool foraMenor = true, foraMaior = true;
+            for (int i = 0; i < 3; ++i) {
+                foraMenor &= v[i].clip[eixo] < -v[i].clip.w;
+                foraMaior &= v[i].clip[eixo] > v[i].clip.w;
+            }
+            if (foraMenor || foraMaior) {
+                ++saida.estatisticas.descartados;
+                return;
+            }
+        }
+        float d[3];
+        bool recortar = false;
+        for (int i = 0; i < 3; ++i) {
+            d[i] = v[i].clip.z + v[i].clip.w;
+            recortar |= d[i] < 0.0f;
+        }
+        if (!recortar) {
+            if (!montar(v[0], v[1], v[2], chamada, saida)) ++saida.estatisticas.descartados;
+            return;
+        }
+        ++saida.estatisticas.recortados;
+        VerticeClip poligono[4];
+        int n = 0;
+        for (int i = 0; i < 3; ++i) {
+            int j = (i + 1) % 3;
+            if (d[i] >= 0.0f) poligono[n++] = v[i];
+            if ((d[i] >= 0.0f) != (d[j] >= 0.0f)) {
+                float t = d[i] / (d[i] - d[j]);
+                VerticeClip& p = poligono[n++];
+                p.clip = v[i].clip + (v[j].clip - v[i].clip) * t;
+                for (int a = 0; a < N_ATRIBUTOS; ++a)
+                    p.atributos[a] = v[i].atributos[a] + (v[j].atributos[a] - v[i].atributos[a]) * t;
+            }
+        }
+        for (int i = 2; i < n; ++i) montar(poligono[0], poligono[i - 1], poligono[i], chamada, saida);
+    }
+
+    // Divisão perspectiva, viewport, arestas e planos; põe o triângulo nos tiles
+    bool montar(const VerticeClip& a, const VerticeClip& b, const VerticeClip& c, uint32_t chamada, PorThread& saida) {
+        const VerticeClip* v[3] = { &a, &b, &c };
+        float x[3], y[3], z[3], q[3];
+        for (int i = 0; i < 3; ++i) {
+            q[i] = 1.0f / v[i]->clip.w;
+            x[i] = (v[i]->clip.x * q[i] * 0.5f + 0.5f) * largura;
+            y[i] = (v[i]->clip.y * q[i] * 0.5f + 0.5f) * altura;
+            z[i] = v[i]->clip.z * q[i] * 0.5f + 0.5f;
+        }
+        float minX = std::min({ x[0], x[1], x[2] }), maxX = std::max({ x[0], x[1], x[2] });
+        float minY = std::min({ y[0], y[1], y[2] }), maxY = std::max({ y[0], y[1], y[2] });
+        Triangulo t;
+        // Pixels cujo centro (i + 0.5) pode estar dentro
+        t.xMin = std::max(0, (int)std::ceil(minX - 0.5f));
+        t.yMin = std::max(0, (int)std::ceil(minY - 0.5f));
+        t.xMax = std::min(largura - 1, (int)std::floor(maxX - 0.5f));
+        t.yMax = std::min(altura - 1, (int)std::floor(maxY - 0.5f));
+        if (t.xMin > t.xMax || t.yMin > t.yMax) return false;
+
+        t.ox = x[0];
+        t.oy = y[0];
+        float rx[3] = { 0.0f, x[1] - x[0], x[2] - x[0] }, ry[3] = { 0.0f, y[1] - y[0], y[2] - y[0] };
+        float area = rx[1] * ry[2] - rx[2] * ry[1];
+        if (area == 0.0f || (descartarCostas && area < 0.0f)) return false;
+        float sinal = area > 0.0f ? 1.0f : -1.0f; // de costas: inverte para o interior ficar positivo
+        float inversoArea = 1.0f / std::fabs(area);
+        for (int i = 0; i < 3; ++i) {
+            int j = (i + 1) % 3, k = (i + 2) % 3;
+            Plano& e = t.arestas[i];
+            e.dx = sinal * (ry[j] - ry[k]);
+            e.dy = sinal * (rx[k] - rx[j]);
+            e.c = -(e.dx * rx[j] + e.dy * ry[j]);
+            t.cimaEsquerda[i] = e.dx > 0.0f || (e.dx == 0.0f && e.dy < 0.0f);
+        }
+        // Baricêntricas λi = arestai / área: um plano por valor interpolado
+        auto plano = [&](float v0, float v1, float v2) {
+            const float val[3] = { v0, v1, v2 };
+            Plano p = { 0.0f, 0.0f, 0.0f };
+            for (int i = 0; i < 3; ++i) {
+                p.dx += t.arestas[i].dx * val[i];
+                p.dy += t.arestas[i].dy * val[i];
+            }
+            p.dx *= inversoArea;
+            p.dy *= inversoArea;
+            p.c = v0;
+            return p;
+        };
+        t.z = plano(z[0], z[1], z[2]);
+        t.q = plano(q[0], q[1], q[2]);
+        for (int i = 0; i < N_ATRIBUTOS; ++i)
+            t.atributos[i] = plano(a.atributos[i] * q[0], b.atributos[i] * q[1], c.atributos[i] * q[2]);
+        t.zMin = std::min({ z[0], z[1], z[2] });
+        t.chamada = chamada;
+
+        uint32_t indice = (uint32_t)saida.triangulos.size();
+        saida.triangulos.push_back(t);
+        for (int ty = t.yMin / TAMANHO_TILE; ty <= t.yMax / TAMANHO_TILE; ++ty)
+            for (int tx = t.xMin / TAMANHO_TILE; tx <= t.xMax / TAMANHO_TILE; ++tx)
+                saida.tiles[(size_t)ty * tilesX + tx].push_back(indice);
+        return true;
+    }
+
+    float zMaxTile(int x0, int y0, int x1, int y1) const {
+        float m = 0.0f;
+        for (int by = y0 / TAMANHO_BLOCO; by <= y1 / TAMANHO_BLOCO; ++by)
+            for (int bx = x0 / TAMANHO_BLOCO; bx <= x1 / TAMANHO_BLOCO; ++bx)
+                m = std::max(m, zMaxBlocos[(size_t)by * blocosX + bx]);
+        return m;
+    }
+
+    void desenharTile(size_t tile, EstatisticasRaster& stats) {
+        int tx0 = (int)(tile % tilesX) * TAMANHO_TILE, ty0 = (int)(tile / tilesX) * TAMANHO_TILE;
+        int tx1 = std::min(largura, tx0 + TAMANHO_TILE) - 1, ty1 = std::min(altura, ty0 + TAMANHO_TILE) - 1;
+        float zMaxDoTile = zMaxTile(tx0, ty0, tx1, ty1);
+        bool zMaxMudou = false;
+        for (const PorThread& p : porThread)
+            for (uint32_t indice : p.tiles[tile]) {
+                const Triangulo& t = p.triangulos[indice];
+                int x0 = std::max(tx0, t.xMin) & ~(TAMANHO_BLOCO - 1), x1 = std::min(tx1, t.xMax);
+                int y0 = std::max(ty0, t.yMin) & ~(TAMANHO_BLOCO - 1), y1 = std::min(ty1, t.yMax);
+                if (zMaxMudou) {
+                    zMaxDoTile = zMaxTile(tx0, ty0, tx1, ty1);
+                    zMaxMudou = false;
+                }
+                if (t.zMin >= zMaxDoTile) {
+                    stats.rejeitadosHiZ += (size_t)((x1 - x0) / TAMANHO_BLOCO + 1) * ((y1 - y0) / TAMANHO_BLOCO + 1);
+                    continue;
+                }
+                const Chamada& ch = chamadas[t.chamada];
+                for (int by = y0; by <= y1; by += TAMANHO_BLOCO)
+                    for (int bx = x0; bx <= x1; bx += TAMANHO_BLOCO)
+                        zMaxMudou |= desenharBloco(t, ch, bx, by, stats);
+            }
+    }
+
+    // Um bloco 8x8: rejeição pelas arestas e pelo Z hierárquico, depois linha a linha
+    bool desenharBloco(const Triangulo& t, const Chamada& ch, int bx, int by, EstatisticasRaster& stats) {
+        float x = (float)bx + 0.5f - t.ox, y = (float)by + 0.5f - t.oy;
+        const float lado = (float)(TAMANHO_BLOCO - 1);
+        for (const Plano& e : t.arestas)
+            if (e.em(x, y) + std::max(e.dx, 0.0f) * lado + std::max(e.dy, 0.0f) * lado < 0.0f) return false;
+        float& zMax = zMaxBlocos[(size_t)(by / TAMANHO_BLOCO) * blocosX + bx / TAMANHO_BLOCO];
+        float zBloco = t.z.em(x, y) + std::min(t.z.dx, 0.0f) * lado + std::min(t.z.dy, 0.0f) * lado;
+        if (std::max(zBloco, t.zMin) >= zMax) {
+            ++stats.rejeitadosHiZ;
+            return false;
+        }
+
+        int xMin = std::max(bx, t.xMin), xMax = std::min(bx + TAMANHO_BLOCO - 1, t.xMax);
+        int yMin = std::max(by, t.yMin), yMax = std::min(by + TAMANHO_BLOCO - 1, t.yMax);
+        size_t escritos = 0;
+        bool avx2 = false;
+#ifdef TRANSFORMACOES_AVX2
+        avx2 = usarAVX2 && transformacoesSoA::temAVX2();
+        if (avx2) escritos = blocoAVX2(t, ch, bx, xMin, xMax, yMin, yMax);
+#endif
+        if (!avx2)
+            for (int py = yMin; py <= yMax; ++py)
+                escritos += linha(t, ch, bx, py, xMin, xMax, &cores[(size_t)py * passo + bx],
+                                  &profundidades[(size_t)py * passo + bx]);
+        if (!escritos) return false;
+        stats.pixelsSombreados += escritos;
+
+        const float* bloco = &profundidades[(size_t)by * passo + bx];
+        float m = 0.0f;
+#ifdef TRANSFORMACOES_AVX2
+        if (avx2) m = rasterizadorSoftware::maximoBloco8(bloco, passo);
+#endif
+        if (!avx2)
+            for (int py = 0; py < TAMANHO_BLOCO; ++py)
+                for (int px = 0; px < TAMANHO_BLOCO; ++px) m = std::max(m, bloco[(size_t)py * passo + px]);
+        bool mudou = m != zMax;
+        zMax = m;
+        return mudou;
+    }
+
+    // Os pixels de bx a bx + 7 da linha py; retorna quantos passaram no teste de profundidade
+    size_t linha(const Triangulo& t, const Chamada& ch, int bx, int py, int xMin, int xMax, uint32_t* cor, float* prof) const {
+        size_t escritos = 0;
+        float y = (float)py + 0.5f - t.oy;
+        for (int i = 0; i < TAMANHO_BLOCO; ++i) {
+            int px = bx + i;
+            if (px < xMin || px > xMax) continue;
+            float x = (float)px + 0.5f - t.ox;
+            bool dentro = true;
+            for (int e = 0; e < 3; ++e) {
+                float v = t.arestas[e].em(x, y);
+                dentro &= v > 0.0f || (v == 0.0f && t.cimaEsquerda[e]);
+            }
+            if (!dentro) continue;
+            float z = t.z.em(x, y);
+            if (!(z < prof[i])) continue;
+
+            float q = t.q.em(x, y), w = 1.0f / q;
+            float a[N_ATRIBUTOS];
+            for (int k = 0; k < N_ATRIBUTOS; ++k) a[k] = t.atributos[k].em(x, y) * w;
+            glm::vec3 mundo(a[0], a[1], a[2]);
+            glm::vec3 n = glm::normalize(glm::vec3(a[3], a[4], a[5]));
+            float u = a[6], v = a[7];
+            // Derivadas da uv no pixel: d(U/Q) = (dU - u dQ) / Q, com U = u/w e Q = 1/w
+            const TexturaSoftware& tex = *ch.textura;
+            float dudx = (t.atributos[6].dx - u * t.q.dx) * w * tex.largura();
+            float dvdx = (t.atributos[7].dx - v * t.q.dx) * w * tex.altura();
+            float dudy = (t.atributos[6].dy - u * t.q.dy) * w * tex.largura();
+            float dvdy = (t.atributos[7].dy - v * t.q.dy) * w * tex.altura();
+            float rho2 = std::max({ dudx * dudx + dvdx * dvdx, dudy * dudy + dvdy * dvdy, 1e-20f });
+            glm::vec3 texColor = tex.amostrar(u, v, 0.5f * std::log2(rho2));
+
+            const MaterialOBJ& m = ch.material;
+            glm::vec3 lightDir = glm::normalize(lightPos - mundo);
+            float diff = std::max(glm::dot(n, lightDir), 0.0f);
+            glm::vec3 viewDir = glm::normalize(camPos - mundo);
+            glm::vec3 reflectDir = 2.0f * glm::dot(n, lightDir) * n - lightDir;
+            float base = std::max(glm::dot(viewDir, reflectDir), 0.0f);
+            float spec = base > 0.0f ? std::pow(base, m.ns) : 0.0f;
+            cor[i] = empacotar((m.ka + m.kd * diff + m.ks * spec) * texColor);
+            prof[i] = z;
+            ++escritos;
+        }
+        return escritos;
+    }
+
+#ifdef TRANSFORMACOES_AVX2
+    // As linhas yMin a yMax do bloco em bx: cobertura e profundidade de 8 pixels por vez
+    ALVO_AVX2 size_t blocoAVX2(const Triangulo& t, const Chamada& ch, int bx, int xMin, int xMax, int yMin, int yMax) {
+        using namespace rasterizadorSoftware;
+        const __m256 zero = _mm256_setzero_ps();
+        __m256i px = _mm256_add_epi32(_mm256_set1_epi32(bx), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        __m256i foraDaCaixa = _mm256_or_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(xMin), px),
+                                              _mm256_cmpgt_epi32(px, _mm256_set1_epi32(xMax)));
+        __m256 naCaixa = _mm256_castsi256_ps(_mm256_xor_si256(foraDaCaixa, _mm256_set1_epi32(-1)));
+        __m256 x = _mm256_sub_ps(_mm256_add_ps(_mm256_cvtepi32_ps(px), _mm256_set1_ps(0.5f)), _mm256_set1_ps(t.ox));
+        size_t escritos = 0;
+        for (int py = yMin; py <= yMax; ++py) {
+            __m256 y = _mm256_set1_ps((float)py + 0.5f - t.oy);
+            __m256 mascara = naCaixa;
+            for (int e = 0; e < 3; ++e) {
+                __m256 v = plano8(t.arestas[e].c, t.arestas[e].dx, t.arestas[e].dy, x, y);
+                __m256 dentro = t.cimaEsquerda[e] ? _mm256_cmp_ps(v, zero, _CMP_GE_OQ) : _mm256_cmp_ps(v, zero, _CMP_GT_OQ);
+                mascara = _mm256_and_ps(mascara, dentro);
+            }
+            if (!_mm256_movemask_ps(mascara)) continue;
+            float* prof = &profundidades[(size_t)py * passo + bx];
+            __m256 z = plano8(t.z.c, t.z.dx, t.z.dy, x, y);
+            __m256 profAntiga = _mm256_loadu_ps(prof);
+            mascara = _mm256_and_ps(mascara, _mm256_cmp_ps(z, profAntiga, _CMP_LT_OQ));
+            int bits = _mm256_movemask_ps(mascara);
+            if (!bits) continue;
+            _mm256_storeu_ps(prof, _mm256_blendv_ps(profAntiga, z, mascara));
+            sombrearAVX2(t, ch, x, y, mascara, &cores[(size_t)py * passo + bx]);
+            escritos += (size_t)transformacoesSoA::contarBits((unsigned)bits);
+        }
+        return escritos;
+    }
+
+    // Phong e textura nos pixels da máscara
+    ALVO_AVX2 void sombrearAVX2(const Triangulo& t, const Chamada& ch, __m256 x, __m256 y, __m256 mascara, uint32_t* cor) const {
+        using namespace rasterizadorSoftware;
+        const __m256 zero = _mm256_setzero_ps();
+        __m256 w = inverso8(plano8(t.q.c, t.q.dx, t.q.dy, x, y));
+        __m256 a[N_ATRIBUTOS];
+        for (int k = 0; k < N_ATRIBUTOS; ++k)
+            a[k] = _mm256_mul_ps(plano8(t.atributos[k].c, t.atributos[k].dx, t.atributos[k].dy, x, y), w);
+        __m256 nx = a[3], ny = a[4], nz = a[5];
+        normalizar8(nx, ny, nz);
+
+        const TexturaSoftware& tex = *ch.textura;
+        __m256 u = a[6], v = a[7];
+        __m256 tw = _mm256_mul_ps(w, _mm256_set1_ps((float)tex.largura()));
+        __m256 th = _mm256_mul_ps(w, _mm256_set1_ps((float)tex.altura()));
+        __m256 dudx = _mm256_mul_ps(_mm256_fnmadd_ps(u, _mm256_set1_ps(t.q.dx), _mm256_set1_ps(t.atributos[6].dx)), tw);
+        __m256 dvdx = _mm256_mul_ps(_mm256_fnmadd_ps(v, _mm256_set1_ps(t.q.dx), _mm256_set1_ps(t.atributos[7].dx)), th);
+        __m256 dudy = _mm256_mul_ps(_mm256_fnmadd_ps(u, _mm256_set1_ps(t.q.dy), _mm256_set1_ps(t.atributos[6].dy)), tw);
+        __m256 dvdy = _mm256_mul_ps(_mm256_fnmadd_ps(v, _mm256_set1_ps(t.q.dy), _mm256_set1_ps(t.atributos[7].dy)), th);
+        __m256 rho2 = _mm256_max_ps(_mm256_fmadd_ps(dudx, dudx, _mm256_mul_ps(dvdx, dvdx)),
+                                    _mm256_fmadd_ps(dudy, dudy, _mm256_mul_ps(dvdy, dvdy)));
+        rho2 = _mm256_max_ps(rho2, _mm256_set1_ps(1e-20f));
+        // Fora da máscara o LOD vira 0, para que essas pistas não obriguem a
+        // amostrar o segundo nível
+        __m256 lod = _mm256_and_ps(mascara, _mm256_mul_ps(_mm256_set1_ps(0.5f), log2_8(rho2)));
+        __m256 tr, tg, tb;
+        tex.amostrar8(u, v, lod, tr, tg, tb);
+
+        const MaterialOBJ& m = ch.material;
+        __m256 lx = _mm256_sub_ps(_mm256_set1_ps(lightPos.x), a[0]);
+        __m256 ly = _mm256_sub_ps(_mm256_set1_ps(lightPos.y), a[1]);
+        __m256 lz = _mm256_sub_ps(_mm256_set1_ps(lightPos.z), a[2]);
+        normalizar8(lx, ly, lz);
+        __m256 nl = produtoEscalar8(nx, ny, nz, lx, ly, lz);
+        __m256 diff = _mm256_max_ps(nl, zero);
+        __m256 vx = _mm256_sub_ps(_mm256_set1_ps(camPos.x), a[0]);
+        __m256 vy = _mm256_sub_ps(_mm256_set1_ps(camPos.y), a[1]);
+        __m256 vz = _mm256_sub_ps(_mm256_set1_ps(camPos.z), a[2]);
+        normalizar8(vx, vy, vz);
+        __m256 dois = _mm256_add_ps(nl, nl);
+        __m256 rx = _mm256_fmsub_ps(dois, nx, lx), ry = _mm256_fmsub_ps(dois, ny, ly), rz = _mm256_fmsub_ps(dois, nz, lz);
+        __m256 base = _mm256_max_ps(produtoEscalar8(vx, vy, vz, rx, ry, rz), zero);
+        __m256 positiva = _mm256_cmp_ps(base, zero, _CMP_GT_OQ);
+        __m256 spec = _mm256_and_ps(positiva, exp2_8(_mm256_mul_ps(_mm256_set1_ps(m.ns),
+                                                                     log2_8(_mm256_max_ps(base, _mm256_set1_ps(1e-30f))))));
+        __m256 luz = _mm256_fmadd_ps(_mm256_set1_ps(m.ks), spec,
+                                     _mm256_fmadd_ps(_mm256_set1_ps(m.kd), diff, _mm256_set1_ps(m.ka)));
+
+        __m256i rgba = _mm256_or_si256(
+            _mm256_or_si256(byte8(luz, tr), _mm256_slli_epi32(byte8(luz, tg), 8)),
+            _mm256_or_si256(_mm256_slli_epi32(byte8(luz, tb), 16), _mm256_set1_epi32((int)0xFF000000u)));
+        __m256i corAntiga = _mm256_loadu_si256((const __m256i*)cor);
+        _mm256_storeu_si256((__m256i*)cor, _mm256_blendv_epi8(corAntiga, rgba, _mm256_castps_si256(mascara)));
+    }
+#endif
+
+    int largura = 0, altura = 0, passo = 0;  // passo: largura arredondada para blocos
+    int blocosX = 0, tilesX = 0, tilesY = 0;
+    std::vector<uint32_t> cores;
+    std::vector<float> profundidades;
+    std::vector<float> zMaxBlocos;           // maior profundidade de cada bloco 8x8
+
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    glm::vec3 lightPos = glm::vec3(0.0f), camPos = glm::vec3(0.0f);
+    std::vector<Chamada> chamadas;
+    std::vector<VerticeClip> verticesClip;
+    std::vector<PorThread> porThread;
+};
@@ -0,0 +1,285 @@
+/*
+ *  RenderizacaoOffscreen.h
+ *
+ *  Peças para renderizar sem janela visível e gravar os quadros em disco:
+ *
+ *  - FramebufferOffscreen: FBO com cor RGBA8 e profundidade de 24 bits em
+ *    renderbuffers, de qualquer tamanho (não depende da janela).
+ *  - LeituraQuadros: lê os quadros de volta por um anel de pixel buffer
+ *    objects. ler() só agenda o glReadPixels para o PBO da vez e põe um
+ *    fence; o quadro é copiado para a CPU quando o fence já passou, ou,
+ *    com o anel cheio, quando o PBO precisa ser reusado (aí já faz
+ *    nPBOs quadros que a GPU recebeu o pedido). A cópia vai para uma fila
+ *    e threads escritoras gravam PNG (stb_image_write) ou PPM binário,
+ *    sem segurar o laço de desenho; a fila é limitada, então um disco
+ *    lento acaba freando o desenho em vez de acumular memória.
+ *
+ *  stb_image_write.h precisa estar incluído (com STB_IMAGE_WRITE_IMPLEMENTATION
+ *  em um .cpp) antes deste cabeçalho.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  FramebufferOffscreen fbo;
+ *  fbo.criar(1920, 1080);
+ *  LeituraQuadros leitura;
+ *  leitura.criar(1920, 1080, 3, FORMATO_PNG, "quadros/q");
+ *  for (quadro...) {
+ *      fbo.usar();
+ *      ... desenha ...
+ *      leitura.ler(quadro);             // quadros/q_00012.png, mais tarde
+ *  }
+ *  leitura.terminar();                  // antes de destruir o contexto: espera tudo estar no disco
+ */
+
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef INCLUDE_STB_IMAGE_WRITE_H
+#error "inclua stb_image_write.h antes de RenderizacaoOffscreen.h"
+#endif
+
+enum FormatoImagem {
+    FORMATO_PNG = 0,
+    FORMATO_PPM
+};
+
+class FramebufferOffscreen {
+public:
+    bool criar(int largura, int altura) {
+        this->largura = largura;
+        this->altura = altura;
+        glGenFramebuffers(1, &fbo);
+        glGenRenderbuffers(1, &cor);
+        glGenRenderbuffers(1, &profundidade);
+        glBindRenderbuffer(GL_RENDERBUFFER, cor);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, largura, altura);
+        glBindRenderbuffer(GL_RENDERBUFFER, profundidade);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, largura, altura);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, cor);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, profundidade);
+        bool completo = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return completo;
+    }
+
+    // Passa a desenhar (e ler) no FBO, com o viewport do tamanho dele
+    void usar() const {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, largura, altura);
+    }
+
+    void destruir() {
+        if (fbo) glDeleteFramebuffers(1, &fbo);
+        if (cor) glDeleteRenderbuffers(1, &cor);
+        if (profundidade) glDeleteRenderbuffers(1, &profundidade);
+        fbo = cor = profundidade = 0;
+    }
+
+    int largura = 0, altura = 0;
+
+private:
+    GLuint fbo = 0, cor = 0, profundidade = 0;
+};
+
+struct EstatisticasLeitura {
+    size_t quadrosLidos = 0;   // cópias de PBO para a CPU
+    size_t esperasFence = 0;   // vezes em que o anel estava cheio e o fence ainda não tinha passado
+    size_t esperasFila = 0;    // vezes em que a fila de escrita estava cheia
+    size_t gravados = 0;       // arquivos escritos
+    size_t falhas = 0;         // quadros sem mapeamento do PBO ou que não puderam ser gravados
+};
+
+class LeituraQuadros {
+public:
+    static const size_t MAX_FILA = 8; // quadros copiados esperando escrita
+
+    // Sem contexto GL garantido aqui: só para as escritoras (chame terminar() antes)
+    ~LeituraQuadros() { pararEscritores(); }
+
+    void criar(int largura, int altura, int nPBOs, FormatoImagem formato, const std::string& prefixo,
+               unsigned nEscritores = 2) {
+        this->largura = largura;
+        this->altura = altura;
+        this->formato = formato;
+        this->prefixo = prefixo;
+        bytesQuadro = (size_t)largura * altura * 4;
+        anel.resize(std::max(nPBOs, 1));
+        for (Slot& s : anel) {
+            glGenBuffers(1, &s.pbo);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, bytesQuadro, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        stbi_flip_vertically_on_write(1); // o GL lê de baixo para cima
+        encerrar = false;
+        for (unsigned i = 0; i < std::max(nEscritores, 1u); ++i) escritores.emplace_back([this] { escrever(); });
+    }
+
+    // Agenda a leitura do framebuffer ligado para o quadro numero
+    void ler(int numero) {
+        Slot& s = anel[proximo];
+        if (s.fence) coletar(s, true); // o anel deu a volta: este PBO ainda tem um quadro
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, largura, altura, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        s.numero = numero;
+        proximo = (proximo + 1) % anel.size();
+
+        // Adianta os mais antigos que já estão prontos, na ordem do anel
+        for (size_t k = 0; k < anel.size(); ++k) {
+            Slot& antigo = anel[(proximo + k) % anel.size()];
+            if (!antigo.fence) continue;
+            if (!coletar(antigo, false)) break;
+        }
+    }
+
+    // Copia o que falta, espera as escritas e libera os PBOs
+    void terminar() {
+        for (size_t k = 0; k < anel.size(); ++k) {
+            Slot& s = anel[(proximo + k) % anel.size()];
+            if (s.fence) coletar(s, true);
+        }
+        pararEscritores();
+        for (Slot& s : anel)
+            if (s.pbo) glDeleteBuffers(1, &s.pbo);
+        anel.clear();
+    }
+
+    std::string nomeArquivo(int numero) const {
+        char sufixo[32];
+        snprintf(sufixo, sizeof(sufixo), "_%05d.%s", numero, formato == FORMATO_PNG ? "png" : "ppm");
+        return prefixo + sufixo;
+    }
+
+    EstatisticasLeitura estatisticas() const {
+        std::lock_guard<std::mutex> trava(mutex);
+        return stats;
+    }
+
+private:
+    struct Slot {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        int numero = 0;
+    };
+
+    struct Pendente {
+        int numero;
+        std::vector<unsigned char> pixels;
+    };
+
+    // Terminam de gravar a fila e saem
+    void pararEscritores() {
+        {
+            std::lock_guard<std::mutex> trava(mutex);
+            encerrar = true;
+        }
+        temTrabalho.notify_all();
+        for (std::thread& t : escritores) t.join();
+        escritores.clear();
+    }
+
+    // Copia o PBO para a fila de escrita; sem esperar, falha se o fence não passou
+    bool coletar(Slot& s, bool esperar) {
+        GLenum estado = glClientWaitSync(s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (estado == GL_TIMEOUT_EXPIRED) {
+            if (!esperar) return false;
+            ++statsLocal.esperasFence;
+            while (estado == GL_TIMEOUT_EXPIRED) estado = glClientWaitSync(s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        }
+        glDeleteSync(s.fence);
+        s.fence = nullptr;
+
+        Pendente p;
+        p.numero = s.numero;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+        const void* dados = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytesQuadro, GL_MAP_READ_BIT);
+        if (dados) {
+            p.pixels.assign((const unsigned char*)dados, (const unsigned char*)dados + bytesQuadro);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        if (!dados) {
+            // Sem o mapeamento não há imagem: conta como falha em vez de gravar um quadro preto
+            std::lock_guard<std::mutex> trava(mutex);
+            ++stats.falhas;
+            return true;
+        }
+        ++statsLocal.quadrosLidos;
+
+        std::unique_lock<std::mutex> trava(mutex);
+        if (fila.size() >= MAX_FILA) ++statsLocal.esperasFila;
+        espacoNaFila.wait(trava, [this] { return fila.size() < MAX_FILA; });
+        fila.push_back(std::move(p));
+        stats.quadrosLidos = statsLocal.quadrosLidos;
+        stats.esperasFence = statsLocal.esperasFence;
+        stats.esperasFila = statsLocal.esperasFila;
+        trava.unlock();
+        temTrabalho.notify_one();
+        return true;
+    }
+
+    void escrever() {
+        for (;;) {
+            Pendente p;
+            {
+                std::unique_lock<std::mutex> trava(mutex);
+                temTrabalho.wait(trava, [this] { return encerrar || !fila.empty(); });
+                if (fila.empty()) return;
+                p = std::move(fila.front());
+                fila.pop_front();
+            }
+            espacoNaFila.notify_one();
+            bool ok = formato == FORMATO_PNG ? gravarPNG(nomeArquivo(p.numero), p.pixels) : gravarPPM(nomeArquivo(p.numero), p.pixels);
+            std::lock_guard<std::mutex> trava(mutex);
+            ++(ok ? stats.gravados : stats.falhas);
+        }
+    }
+
+    bool gravarPNG(const std::string& nome, const std::vector<unsigned char>& pixels) const {
+        return stbi_write_png(nome.c_str(), largura, altura, 4, pixels.data(), largura * 4) != 0;
+    }
+
+    // P6 em RGB, linhas de cima para baixo
+    bool gravarPPM(const std::string& nome, const std::vector<unsigned char>& pixels) const {
+        FILE* arquivo = fopen(nome.c_str(), "wb");
+        if (!arquivo) return false;
+        fprintf(arquivo, "P6\n%d %d\n255\n", largura, altura);
+        std::vector<unsigned char> linha((size_t)largura * 3);
+        for (int y = altura - 1; y >= 0; --y) {
+            const unsigned char* origem = pixels.data() + (size_t)y * largura * 4;
+            for (int x = 0; x < largura; ++x) memcpy(&linha[(size_t)x * 3], origem + (size_t)x * 4, 3);
+            fwrite(linha.data(), 1, linha.size(), arquivo);
+        }
+        return fclose(arquivo) == 0;
+    }
+
+    int largura = 0, altura = 0;
+    FormatoImagem formato = FORMATO_PNG;
+    std::string prefixo;
+    size_t bytesQuadro = 0;
+    std::vector<Slot> anel;
+    size_t proximo = 0;
+
+    mutable std::mutex mutex;
+    std::condition_variable temTrabalho, espacoNaFila;
+    std::deque<Pendente> fila;
+    std::vector<std::thread> escritores;
+    bool encerrar = false;
+    EstatisticasLeitura stats;      // protegido pelo mutex
+    EstatisticasLeitura statsLocal; // só a thread do GL
+};
@@ -0,0 +1,234 @@
+/*
+ *  RenderizadorInstanciado.h
+ *
+ *  Desenho por instâncias. A cada quadro os objetos são agrupados por
+ *  (programa, VAO, textura, material); as matrizes model e das normais de todos eles
+ *  vão para um único VBO de atributos por instância (divisor 1) e cada
+ *  grupo vira um glDrawElementsInstanced, em vez de um glUniform* mais um
+ *  glDrawElements por objeto. Os grupos são desenhados na ordem em que
+ *  aparecem no quadro (a da FilaRenderizacao, quando usada), e binds de
+ *  programa, textura, material e VAO iguais ao anterior não são refeitos.
+ *
+ *  Quando cada instância vem com o índice do seu objeto e as instâncias do
+ *  quadro são as mesmas, na mesma ordem, do quadro anterior, o VBO não é
+ *  reenviado inteiro: só as faixas contíguas de instâncias marcadas como
+ *  alteradas vão por glBufferSubData. Cena parada, zero bytes enviados.
+ *
+ *  Atributos por instância no vertex shader:
+ *
+ *  layout(location = 4) in mat4 model;         // ocupa 4..7
+ *  layout(location = 8) in mat3 normalMatrix;  // ocupa 8..10
+ *
+ *  Forma de uso
+ *  -----------------
+ *  RenderizadorInstanciado renderizador;
+ *  renderizador.criar();
+ *  ...
+ *  renderizador.comecar();
+ *  for (item : fila.ordenados()) renderizador.adicionar(programa, obj.vao, obj.textura, obj.material, obj.nIndices, obj.tipoIndice, model, normal);
+ *  // ou, com envio só do que mudou:
+ *  //   renderizador.adicionar(..., model, normal, item.indice, transformacoes.recalculado(item.indice));
+ *  renderizador.desenhar(materiais);
+ */
+
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include "BlocosUniformes.h"
+#include "FilaRenderizacao.h"
+
+const GLuint LOCAL_INSTANCIA_MODEL = 4;
+const GLuint LOCAL_INSTANCIA_NORMAL = 8;
+const uint32_t INSTANCIA_SEM_OBJETO = 0xFFFFFFFFu;
+
+struct DadosInstancia {
+    glm::mat4 model;
+    glm::mat3 normal;
+};
+
+class RenderizadorInstanciado {
+public:
+    void criar() { glGenBuffers(1, &vbo); }
+
+    // Esvazia os grupos, mantendo a memória reservada
+    void comecar() {
+        for (Grupo& g : grupos) {
+            g.instancias.clear();
+            g.objetos.clear();
+            g.alteradas.clear();
+        }
+        ordem.clear();
+        ultimoGrupo = -1;
+        anonimas = false;
+    }
+
+    void adicionar(GLuint programa, GLuint vao, GLuint textura, int material, GLsizei nIndices, GLenum tipoIndice,
+                   const glm::mat4& model, const glm::mat3& normal) {
+        adicionar(programa, vao, textura, material, nIndices, tipoIndice, model, normal, INSTANCIA_SEM_OBJETO, true);
+    }
+
+    // objeto identifica a instância entre quadros; alterada diz se model/normal
+    // mudaram desde o quadro anterior
+    void adicionar(GLuint programa, GLuint vao, GLuint textura, int material, GLsizei nIndices, GLenum tipoIndice,
+                   const glm::mat4& model, const glm::mat3& normal, uint32_t objeto, bool alterada) {
+        Grupo& g = grupos[encontrarGrupo(programa, vao, textura, material, nIndices, tipoIndice)];
+        if (g.instancias.empty()) ordem.push_back(ultimoGrupo);
+        g.instancias.push_back({ model, normal });
+        g.objetos.push_back(objeto);
+        g.alteradas.push_back(alterada);
+        anonimas |= objeto == INSTANCIA_SEM_OBJETO;
+    }
+
+    // Um envio de buffer (órfão + subdados por grupo, ou só as faixas
+    // alteradas) e uma chamada por grupo
+    void desenhar(TabelaMateriais& materiais) {
+        size_t total = 0;
+        for (const Grupo& g : grupos) total += g.instancias.size();
+        stats = EstatisticasRenderizacao();
+        nInstancias = total;
+        sequencia.clear();
+        for (int indice : ordem) sequencia.insert(sequencia.end(), grupos[indice].objetos.begin(), grupos[indice].objetos.end());
+        bool parcial = !anonimas && sequencia == sequenciaAnterior;
+        sequenciaAnterior.swap(sequencia);
+        if (total == 0) return;
+
+        size_t bytes = total * sizeof(DadosInstancia);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        if (!parcial) {
+            if (bytes > capacidade) capacidade = std::max(bytes, capacidade * 2);
+            glBufferData(GL_ARRAY_BUFFER, capacidade, nullptr, GL_STREAM_DRAW); // órfão: não espera a GPU
+        }
+
+        // Estado desconhecido no início do quadro: o primeiro bind de cada tipo sempre acontece
+        GLint programaAtual = -1, vaoAtual = -1, texturaAtual = -1, materialAtual = -1;
+        size_t deslocamento = 0;
+        glActiveTexture(GL_TEXTURE0);
+        for (int indice : ordem) {
+            const Grupo& g = grupos[indice];
+            size_t bytesGrupo = g.instancias.size() * sizeof(DadosInstancia);
+            if (parcial) {
+                enviarAlteradas(g, deslocamento);
+            } else {
+                glBufferSubData(GL_ARRAY_BUFFER, deslocamento, bytesGrupo, g.instancias.data());
+                stats.instanciasEnviadas += g.instancias.size();
+                ++stats.faixasEnviadas;
+            }
+            if (trocar(programaAtual, (GLint)g.programa, stats.trocasPrograma, stats.evitadasPrograma))
+                glUseProgram(g.programa);
+            if (trocar(vaoAtual, (GLint)g.vao, stats.trocasVAO, stats.evitadasVAO))
+                glBindVertexArray(g.vao);
+            apontarAtributos(deslocamento);
+            if (trocar(texturaAtual, (GLint)g.textura, stats.trocasTextura, stats.evitadasTextura))
+                glBindTexture(GL_TEXTURE_2D, g.textura);
+            if (trocar(materialAtual, g.material, stats.trocasMaterial, stats.evitadasMaterial))
+                materiais.ligar(g.material);
+            glDrawElementsInstanced(GL_TRIANGLES, g.nIndices, g.tipoIndice, 0, (GLsizei)g.instancias.size());
+            deslocamento += bytesGrupo;
+            ++stats.desenhos;
+        }
+        glBindVertexArray(0);
+    }
+
+    // Estatísticas do último desenhar()
+    size_t chamadas() const { return stats.desenhos; }
+    size_t instancias() const { return nInstancias; }
+    const EstatisticasRenderizacao& estatisticas() const { return stats; }
+
+private:
+    struct Grupo {
+        GLuint programa;
+        GLuint vao;
+        GLuint textura;
+        int material;
+        GLsizei nIndices;
+        GLenum tipoIndice;
+        std::vector<DadosInstancia> instancias;
+        std::vector<uint32_t> objetos; // um por instância
+        std::vector<uint8_t> alteradas;
+    };
+
+    // Cada trecho contíguo de instâncias alteradas vira um glBufferSubData
+    void enviarAlteradas(const Grupo& g, size_t deslocamento) {
+        size_t n = g.instancias.size();
+        for (size_t k = 0; k < n;) {
+            if (!g.alteradas[k]) {
+                ++k;
+                continue;
+            }
+            size_t fim = k + 1;
+            while (fim < n && g.alteradas[fim]) ++fim;
+            glBufferSubData(GL_ARRAY_BUFFER, deslocamento + k * sizeof(DadosInstancia), (fim - k) * sizeof(DadosInstancia),
+                            &g.instancias[k]);
+            stats.instanciasEnviadas += fim - k;
+            ++stats.faixasEnviadas;
+            k = fim;
+        }
+    }
+
+    static bool trocar(GLint& atual, GLint novo, size_t& trocas, size_t& evitadas) {
+        if (atual == novo) {
+            ++evitadas;
+            return false;
+        }
+        atual = novo;
+        ++trocas;
+        return true;
+    }
+
+    int encontrarGrupo(GLuint programa, GLuint vao, GLuint textura, int material, GLsizei nIndices, GLenum tipoIndice) {
+        // Objetos iguais vêm em sequência depois da ordenação: evita a busca no mapa
+        if (ultimoGrupo >= 0) {
+            const Grupo& g = grupos[ultimoGrupo];
+            if (g.programa == programa && g.vao == vao && g.textura == textura && g.material == material) return ultimoGrupo;
+        }
+        auto chave = std::make_tuple(programa, vao, textura, material);
+        auto it = indices.find(chave);
+        if (it == indices.end()) {
+            it = indices.emplace(chave, (int)grupos.size()).first;
+            grupos.push_back({ programa, vao, textura, material, nIndices, tipoIndice, {} });
+        }
+        Grupo& g = grupos[it->second];
+        g.nIndices = nIndices;
+        g.tipoIndice = tipoIndice;
+        ultimoGrupo = it->second;
+        return ultimoGrupo;
+    }
+
+    // O VAO é da malha e pode ser compartilhado por vários grupos, então os
+    // ponteiros de instância são refeitos a cada grupo com o seu deslocamento
+    static void apontarAtributos(size_t deslocamento) {
+        for (GLuint i = 0; i < 4; ++i) {
+            GLuint local = LOCAL_INSTANCIA_MODEL + i;
+            glEnableVertexAttribArray(local);
+            glVertexAttribPointer(local, 4, GL_FLOAT, GL_FALSE, sizeof(DadosInstancia),
+                                  (void*)(deslocamento + offsetof(DadosInstancia, model) + i * sizeof(glm::vec4)));
+            glVertexAttribDivisor(local, 1);
+        }
+        for (GLuint i = 0; i < 3; ++i) {
+            GLuint local = LOCAL_INSTANCIA_NORMAL + i;
+            glEnableVertexAttribArray(local);
+            glVertexAttribPointer(local, 3, GL_FLOAT, GL_FALSE, sizeof(DadosInstancia),
+                                  (void*)(deslocamento + offsetof(DadosInstancia, normal) + i * sizeof(glm::vec3)));
+            glVertexAttribDivisor(local, 1);
+        }
+    }
+
+    GLuint vbo = 0;
+    size_t capacidade = 0;
+    std::vector<Grupo> grupos;
+    std::map<std::tuple<GLuint, GLuint, GLuint, int>, int> indices;
+    std::vector<int> ordem; // grupos com instâncias neste quadro, na ordem de chegada
+    int ultimoGrupo = -1;
+    bool anonimas = false; // alguma instância sem objeto neste quadro: envio completo
+    std::vector<uint32_t> sequencia, sequenciaAnterior; // objeto de cada posição do VBO
+    size_t nInstancias = 0;
+    EstatisticasRenderizacao stats;
+};
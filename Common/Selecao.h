@@ -0,0 +1,87 @@
+/*
+ *  Selecao.h
+ *
+ *  Seleção de objetos com o mouse. O pixel é desprojetado por
+ *  inverse(projection * view) num raio no mundo; a BVHCena devolve os
+ *  objetos cuja AABB o raio cruza, do mais perto para o mais longe, e em
+ *  cada um o raio vai para o espaço do objeto e desce pela BVHTriangulos
+ *  da malha. O resultado é o triângulo exato e as baricêntricas do ponto.
+ *  Objetos sem BVH de triângulos (placeholders) valem pela própria AABB.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  RaioSelecao raio = raioDaTela(x, y, largura, altura, projection, view);
+ *  Selecao s = selecionar(bvh, raio,
+ *                         [&](uint32_t i) { return modelDe(i); },
+ *                         [&](uint32_t i) { return cena[i].bvhMalha.get(); });
+ *  if (s.acertou()) objetoAtual = s.objeto;
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cfloat>
+#include <cstdint>
+
+#include "BVHCena.h"
+#include "BVHTriangulos.h"
+
+struct RaioSelecao {
+    glm::vec3 origem;
+    glm::vec3 direcao;  // normalizada
+};
+
+struct Selecao {
+    uint32_t objeto = BVHCena::NENHUM;
+    uint32_t triangulo = TRIANGULO_NENHUM; // NENHUM quando valeu a AABB
+    float t = FLT_MAX;                     // distância no mundo ao longo do raio
+    float u = 0.0f, v = 0.0f;              // baricêntricas no triângulo
+    glm::vec3 ponto{ 0.0f };
+
+    bool acertou() const { return objeto != BVHCena::NENHUM; }
+};
+
+// (x, y) em pixels com a origem no canto superior esquerdo, como o GLFW entrega
+inline RaioSelecao raioDaTela(double x, double y, int largura, int altura, const glm::mat4& projection, const glm::mat4& view) {
+    float ndcX = (float)(2.0 * x / largura - 1.0);
+    float ndcY = (float)(1.0 - 2.0 * y / altura);
+    glm::mat4 inversa = glm::inverse(projection * view);
+    glm::vec4 perto = inversa * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+    glm::vec4 longe = inversa * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+    RaioSelecao raio;
+    raio.origem = glm::vec3(perto) / perto.w;
+    raio.direcao = glm::normalize(glm::vec3(longe) / longe.w - raio.origem);
+    return raio;
+}
+
+// modelDe(i) devolve a matriz model do objeto i; malhaDe(i) a BVHTriangulos
+// da sua malha (ou nullptr). Como a transformação é afim e a direção no
+// objeto não é normalizada, o t medido lá é o mesmo do mundo.
+template <typename ModelDe, typename MalhaDe>
+Selecao selecionar(const BVHCena& bvh, const RaioSelecao& raio, ModelDe modelDe, MalhaDe malhaDe, float tMax = FLT_MAX) {
+    Selecao s;
+    s.t = tMax;
+    float t;
+    s.objeto = bvh.raioMaisProximo(raio.origem, raio.direcao, tMax, t, [&](uint32_t i, float tCaixa) {
+        const BVHTriangulos* malha = malhaDe(i);
+        if (!malha || malha->vazia()) {
+            if (tCaixa < s.t) {
+                s.t = tCaixa;
+                s.triangulo = TRIANGULO_NENHUM;
+            }
+            return tCaixa;
+        }
+        glm::mat4 inversa = glm::inverse(modelDe(i));
+        glm::vec3 origem(inversa * glm::vec4(raio.origem, 1.0f));
+        glm::vec3 direcao(inversa * glm::vec4(raio.direcao, 0.0f));
+        AcertoTriangulo acerto;
+        if (!malha->intersectar(origem, direcao, s.t, acerto)) return FLT_MAX;
+        s.t = acerto.t;
+        s.triangulo = acerto.triangulo;
+        s.u = acerto.u;
+        s.v = acerto.v;
+        return acerto.t;
+    });
+    if (s.acertou()) s.ponto = raio.origem + raio.direcao * t;
+    return s;
+}
@@ -0,0 +1,403 @@
+/*
+ *  SistemaTrajetorias.h
+ *
+ *  Muitos objetos andando por trajetórias (Trajetoria.h) num passo só.
+ *  As curvas ficam em dois pools contíguos: os segmentos cúbicos de todas
+ *  elas e as tabelas de comprimento de arco de todas elas. Cada trajetória
+ *  guarda, em arrays por campo (SoA), o objeto que move, onde a sua curva
+ *  começa nos pools, quantas amostras tem, o comprimento, a distância
+ *  percorrida e a velocidade. Várias trajetórias podem usar a mesma curva.
+ *
+ *  atualizar(dt, transformacoes) avança todas as ativas e grava a posição
+ *  direto nos arrays da TransformacoesSoA: com AVX2, 8 trajetórias por
+ *  iteração (com gathers nos pools); sem AVX2, o mesmo cálculo escalar.
+ *  Cada trajetória lembra a amostra da tabela onde parou e, como a
+ *  distância só cresce, a procura anda para frente a partir dela (uma ou
+ *  duas leituras por quadro); na volta da curva ou num salto longo cai na
+ *  busca binária. Acima de MIN_PARALELO trajetórias o trabalho é dividido
+ *  em blocos entre threads.
+ *
+ *  Com simulação em passo fixo (PassoFixo.h) as duas metades se separam:
+ *  avancar(dt) só anda as distâncias, a cada passo; gravarPosicoes(t,
+ *  recuo) avalia a curva recuo segundos antes da distância atual, a cada
+ *  quadro, o que interpola entre os dois últimos passos ao longo da
+ *  própria curva. O recuo não passa de onde a trajetória começou (ao ser
+ *  ativada ou ter a distância redefinida): antes do primeiro passo o
+ *  objeto fica no ponto de partida em vez de aparecer no fim da curva.
+ *
+ *  Curvas trocadas com trocarCurva() continuam ocupando o pool até limpar().
+ *
+ *  Forma de uso
+ *  -----------------
+ *  SistemaTrajetorias trajetorias;
+ *  CurvaTrajetoria curva = trajetorias.adicionarCurva(pontos, TRAJETORIA_CENTRIPETA);
+ *  uint32_t t = trajetorias.adicionar(objeto, curva, 2.0f);  // 2 unidades/s
+ *  trajetorias.definirAtiva(t, true);
+ *  ...
+ *  trajetorias.atualizar(deltaTime, grafo.locais());        // a cada quadro
+ *  // ou, em passo fixo:
+ *  //   for (passos) trajetorias.avancar(relogio.dt());
+ *  //   trajetorias.gravarPosicoes(grafo.locais(), (1.0f - relogio.alfa()) * relogio.dt());
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "Trajetoria.h"
+#include "TransformacoesSoA.h"
+
+// Onde a curva está nos pools do sistema
+struct CurvaTrajetoria {
+    uint32_t segmentos = 0; // índice do primeiro segmento
+    uint32_t tabela = 0;    // índice da primeira amostra
+    uint32_t amostras = 0;  // a tabela tem amostras + 1 entradas
+    float comprimento = 0.0f;
+};
+
+class SistemaTrajetorias {
+public:
+    static const int AMOSTRAS = Trajetoria::AMOSTRAS_SEGMENTO;
+    static const int DESLOCAMENTO_AMOSTRAS = 5; // log2(AMOSTRAS): o caminho AVX2 divide com deslocamento
+    static_assert(AMOSTRAS == 1 << DESLOCAMENTO_AMOSTRAS, "AMOSTRAS precisa ser 2^DESLOCAMENTO_AMOSTRAS");
+    static_assert(sizeof(SegmentoCubico) == 12 * sizeof(float), "o caminho AVX2 lê os segmentos como floats");
+    static constexpr size_t MIN_PARALELO = 8192; // menos trajetórias que isso não ganham threads
+    static const int PASSOS_AVANCO = 4; // amostras andadas antes de desistir e fazer a busca binária
+
+    // Menos de 2 pontos vira uma curva de comprimento zero: a trajetória
+    // fica ativa mas não mexe no objeto
+    CurvaTrajetoria adicionarCurva(const std::vector<glm::vec3>& pontos, ModoTrajetoria modo) {
+        Trajetoria t;
+        t.definir(pontos, modo);
+        CurvaTrajetoria c;
+        c.segmentos = (uint32_t)segmentos.size();
+        c.tabela = (uint32_t)tabelas.size();
+        if (t.vazia()) {
+            // Um segmento constante e uma tabela toda em zero: a busca não precisa de caso especial
+            glm::vec3 p = pontos.empty() ? glm::vec3(0.0f) : pontos[0];
+            segmentos.push_back({ p, glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f) });
+            tabelas.insert(tabelas.end(), AMOSTRAS + 1, 0.0f);
+        } else {
+            segmentos.insert(segmentos.end(), t.segmentosCurva().begin(), t.segmentosCurva().end());
+            tabelas.insert(tabelas.end(), t.tabelaComprimentos().begin(), t.tabelaComprimentos().end());
+        }
+        c.amostras = (uint32_t)(tabelas.size() - c.tabela - 1);
+        c.comprimento = tabelas.back();
+        maiorTabela = std::max(maiorTabela, (int32_t)c.amostras);
+        return c;
+    }
+
+    // Nova trajetória (inativa) movendo o objeto de índice objeto
+    uint32_t adicionar(uint32_t objeto, const CurvaTrajetoria& curva, float velocidade, float distancia = 0.0f) {
+        objetos.push_back(objeto);
+        inicioSegmentos.push_back((int32_t)curva.segmentos);
+        inicioTabela.push_back((int32_t)curva.tabela);
+        amostras.push_back((int32_t)curva.amostras);
+        comprimentos.push_back(curva.comprimento);
+        distancias.push_back(distancia);
+        velocidades.push_back(velocidade);
+        ativas.push_back(0);
+        amostraAtual.push_back(0);
+        percorridas.push_back(0.0f);
+        return (uint32_t)(objetos.size() - 1);
+    }
+
+    void reservar(size_t nTrajetorias) {
+        objetos.reserve(nTrajetorias);
+        inicioSegmentos.reserve(nTrajetorias);
+        inicioTabela.reserve(nTrajetorias);
+        amostras.reserve(nTrajetorias);
+        comprimentos.reserve(nTrajetorias);
+        distancias.reserve(nTrajetorias);
+        velocidades.reserve(nTrajetorias);
+        ativas.reserve(nTrajetorias);
+        amostraAtual.reserve(nTrajetorias);
+        percorridas.reserve(nTrajetorias);
+    }
+
+    // Troca a curva mantendo a distância percorrida (que dá a volta se passar do fim)
+    void trocarCurva(uint32_t i, const CurvaTrajetoria& curva) {
+        inicioSegmentos[i] = (int32_t)curva.segmentos;
+        inicioTabela[i] = (int32_t)curva.tabela;
+        amostras[i] = (int32_t)curva.amostras;
+        comprimentos[i] = curva.comprimento;
+        amostraAtual[i] = 0;
+    }
+
+    void definirDistancia(uint32_t i, float distancia) {
+        distancias[i] = distancia;
+        amostraAtual[i] = 0;
+        percorridas[i] = 0.0f;
+    }
+
+    void definirAtiva(uint32_t i, bool ativa) {
+        if (ativa && !ativas[i]) percorridas[i] = 0.0f;
+        ativas[i] = ativa;
+    }
+    void definirVelocidade(uint32_t i, float velocidade) { velocidades[i] = velocidade; }
+    bool ativa(uint32_t i) const { return ativas[i] != 0; }
+    float distancia(uint32_t i) const { return distancias[i]; }
+    float velocidade(uint32_t i) const { return velocidades[i]; }
+    float comprimento(uint32_t i) const { return comprimentos[i]; }
+    size_t tamanho() const { return objetos.size(); }
+
+    // Esvazia trajetórias e pools
+    void limpar() {
+        segmentos.clear();
+        tabelas.clear();
+        for (std::vector<int32_t>* v : { &inicioSegmentos, &inicioTabela, &amostras, &amostraAtual }) v->clear();
+        for (std::vector<float>* v : { &comprimentos, &distancias, &velocidades, &percorridas }) v->clear();
+        objetos.clear();
+        ativas.clear();
+        maiorTabela = 1;
+    }
+
+    // Posição da trajetória i na distância atual
+    glm::vec3 posicao(uint32_t i) const {
+        int32_t k = buscar(i, distancias[i]);
+        return segmentos[inicioSegmentos[i] + k / AMOSTRAS].avaliar(parametro(i, k, distancias[i]));
+    }
+
+    // Avança as trajetórias ativas dt segundos e grava as posições em
+    // transformacoes (marcando os objetos). Retorna quantas andaram.
+    size_t atualizar(float dt, TransformacoesSoA& transformacoes, unsigned nThreads = 0) {
+        return executar(dt, 0.0f, &transformacoes, nThreads);
+    }
+
+    // Só anda as distâncias (um passo de simulação), sem avaliar as curvas
+    void avancar(float dt, unsigned nThreads = 0) { executar(dt, 0.0f, nullptr, nThreads); }
+
+    // Grava as posições de recuo segundos atrás na curva (0: a distância
+    // atual), sem recuar para antes de onde a trajetória começou
+    size_t gravarPosicoes(TransformacoesSoA& transformacoes, float recuo = 0.0f, unsigned nThreads = 0) {
+        return executar(0.0f, recuo, &transformacoes, nThreads);
+    }
+
+    bool usarAVX2 = true; // false força o caminho escalar (comparações e benchmark)
+
+private:
+    size_t executar(float dt, float recuo, TransformacoesSoA* transformacoes, unsigned nThreads) {
+        size_t n = objetos.size();
+        float* posicoes[3] = { nullptr, nullptr, nullptr };
+        if (transformacoes)
+            for (int e = 0; e < 3; ++e) posicoes[e] = transformacoes->posicoes(e);
+        float* const* destino = transformacoes ? posicoes : nullptr;
+        const size_t BLOCO = 1024; // múltiplo de 8
+        if (nThreads == 0) nThreads = std::max(1u, std::thread::hardware_concurrency());
+        if (nThreads > 1 && n >= MIN_PARALELO) {
+            std::atomic<size_t> proximo(0);
+            auto trabalhar = [&] {
+                for (size_t inicio; (inicio = proximo.fetch_add(BLOCO)) < n;)
+                    processar(inicio, std::min(n, inicio + BLOCO), dt, recuo, destino);
+            };
+            std::vector<std::thread> threads;
+            for (unsigned t = 1; t < nThreads; ++t) threads.emplace_back(trabalhar);
+            trabalhar();
+            for (std::thread& t : threads) t.join();
+        } else {
+            processar(0, n, dt, recuo, destino);
+        }
+        if (!transformacoes) return 0;
+        size_t andaram = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (!ativas[i] || comprimentos[i] <= 0.0f) continue;
+            transformacoes->marcarAlterado(objetos[i]);
+            ++andaram;
+        }
+        return andaram;
+    }
+
+    // Maior amostra k em [0, amostras) com tabela[k] <= s
+    int32_t buscar(uint32_t i, float s) const {
+        const float* t = tabelas.data() + inicioTabela[i];
+        int32_t base = 0, tamanho = amostras[i];
+        while (tamanho > 1) {
+            int32_t metade = tamanho / 2;
+            if (t[base + metade] <= s) base += metade;
+            tamanho -= metade;
+        }
+        return base;
+    }
+
+    // Igual a buscar(), andando a partir da amostra k onde a trajetória estava
+    int32_t avancarAmostra(uint32_t i, int32_t k, float s) const {
+        const float* t = tabelas.data() + inicioTabela[i];
+        int32_t ultima = amostras[i] - 1;
+        if (t[k] > s) k = 0; // deu a volta (ou andou para trás)
+        for (int p = 0; p < PASSOS_AVANCO; ++p) {
+            if (k >= ultima || t[k + 1] > s) return k;
+            ++k;
+        }
+        return buscar(i, s);
+    }
+
+    float parametro(uint32_t i, int32_t k, float s) const {
+        const float* t = tabelas.data() + inicioTabela[i];
+        float s0 = t[k], s1 = t[k + 1];
+        float f = s1 > s0 ? (s - s0) / (s1 - s0) : 0.0f;
+        return ((float)(k % AMOSTRAS) + f) * (1.0f / AMOSTRAS);
+    }
+
+    // s mod c, em [0, c)
+    static float darVolta(float s, float c) {
+        s -= std::floor(s / c) * c;
+        return s >= c || s < 0.0f ? 0.0f : s;
+    }
+
+    // Anda dt segundos e, com destino, grava a posição recuo segundos antes
+    void processar(size_t inicio, size_t fim, float dt, float recuo, float* const* destino) {
+        size_t i = inicio;
+#ifdef TRANSFORMACOES_AVX2
+        if (usarAVX2 && transformacoesSoA::temAVX2()) i = processarAVX2(inicio, fim, dt, recuo, destino);
+#endif
+        for (; i < fim; ++i) {
+            float c = comprimentos[i];
+            if (!ativas[i] || c <= 0.0f) continue;
+            float s = darVolta(distancias[i] + velocidades[i] * dt, c);
+            distancias[i] = s;
+            percorridas[i] = std::min(percorridas[i] + std::fabs(velocidades[i] * dt), c);
+            if (!destino) continue;
+            if (recuo != 0.0f) {
+                float r = std::min(std::max(velocidades[i] * recuo, -percorridas[i]), percorridas[i]);
+                s = darVolta(s - r, c);
+            }
+            int32_t k = avancarAmostra((uint32_t)i, amostraAtual[i], s);
+            amostraAtual[i] = k;
+            glm::vec3 p = segmentos[inicioSegmentos[i] + k / AMOSTRAS].avaliar(parametro((uint32_t)i, k, s));
+            uint32_t o = objetos[i];
+            destino[0][o] = p.x;
+            destino[1][o] = p.y;
+            destino[2][o] = p.z;
+        }
+    }
+
+#ifdef TRANSFORMACOES_AVX2
+    ALVO_AVX2 static __m256 darVolta8(__m256 s, __m256 c) {
+        s = _mm256_fnmadd_ps(_mm256_floor_ps(_mm256_div_ps(s, c)), c, s);
+        __m256 valida = _mm256_and_ps(_mm256_cmp_ps(s, _mm256_setzero_ps(), _CMP_GE_OQ), _mm256_cmp_ps(s, c, _CMP_LT_OQ));
+        return _mm256_and_ps(s, valida);
+    }
+
+    // Mesmo cálculo de processar() para 8 trajetórias por vez; retorna onde parou
+    ALVO_AVX2 size_t processarAVX2(size_t inicio, size_t fim, float dt, float recuo, float* const* destino) {
+        const float* tabela = tabelas.data();
+        const float* coeficientes = reinterpret_cast<const float*>(segmentos.data()); // a, b, c, d
+        int passos = 0;
+        while ((1 << passos) < maiorTabela) ++passos;
+
+        const __m256 zero = _mm256_setzero_ps(), vdt = _mm256_set1_ps(dt);
+        const __m256i um = _mm256_set1_epi32(1);
+        size_t i = inicio;
+        for (; i + 8 <= fim; i += 8) {
+            // Só andam as ativas com curva de comprimento positivo
+            __m256 c = _mm256_loadu_ps(comprimentos.data() + i);
+            __m128i bytes = _mm_loadl_epi64((const __m128i*)(ativas.data() + i));
+            __m256i ativa = _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_cvtepu8_epi32(bytes), _mm256_setzero_si256()),
+                                             _mm256_castps_si256(_mm256_cmp_ps(c, zero, _CMP_GT_OQ)));
+            int mascara = _mm256_movemask_ps(_mm256_castsi256_ps(ativa));
+            if (mascara == 0) continue;
+
+            // s = (s + v * dt) mod comprimento
+            __m256 v = _mm256_loadu_ps(velocidades.data() + i);
+            __m256 antiga = _mm256_loadu_ps(distancias.data() + i);
+            __m256 s = darVolta8(_mm256_fmadd_ps(v, vdt, antiga), c);
+            _mm256_storeu_ps(distancias.data() + i, _mm256_blendv_ps(antiga, s, _mm256_castsi256_ps(ativa)));
+            __m256 percorridaAntiga = _mm256_loadu_ps(percorridas.data() + i);
+            __m256 andou = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), _mm256_mul_ps(v, vdt)); // |v * dt|
+            __m256 percorrida = _mm256_min_ps(_mm256_add_ps(percorridaAntiga, andou), c);
+            _mm256_storeu_ps(percorridas.data() + i,
+                             _mm256_blendv_ps(percorridaAntiga, percorrida, _mm256_castsi256_ps(ativa)));
+            if (!destino) continue;
+            if (recuo != 0.0f) {
+                __m256 r = _mm256_mul_ps(v, _mm256_set1_ps(recuo));
+                r = _mm256_min_ps(_mm256_max_ps(r, _mm256_sub_ps(zero, percorrida)), percorrida);
+                s = darVolta8(_mm256_sub_ps(s, r), c);
+            }
+
+            // Anda da amostra anterior (ou do começo, se deu a volta) enquanto a próxima ainda está em s ou antes
+            __m256i inicioT = _mm256_loadu_si256((const __m256i*)(inicioTabela.data() + i));
+            __m256i nAmostras = _mm256_max_epi32(_mm256_loadu_si256((const __m256i*)(amostras.data() + i)), um);
+            __m256i ultima = _mm256_sub_epi32(nAmostras, um);
+            __m256i base = _mm256_loadu_si256((const __m256i*)(amostraAtual.data() + i));
+            __m256 atual = _mm256_i32gather_ps(tabela, _mm256_add_epi32(inicioT, base), 4);
+            base = _mm256_andnot_si256(_mm256_castps_si256(_mm256_cmp_ps(atual, s, _CMP_GT_OQ)), base);
+            __m256i anda = _mm256_setzero_si256();
+            for (int p = 0; p <= PASSOS_AVANCO; ++p) {
+                __m256 proximo = _mm256_i32gather_ps(tabela, _mm256_add_epi32(_mm256_add_epi32(inicioT, base), um), 4);
+                anda = _mm256_and_si256(_mm256_castps_si256(_mm256_cmp_ps(proximo, s, _CMP_LE_OQ)),
+                                        _mm256_cmpgt_epi32(ultima, base));
+                if (_mm256_testz_si256(anda, anda) || p == PASSOS_AVANCO) break;
+                base = _mm256_sub_epi32(base, anda); // anda é -1 onde avança
+            }
+            if (!_mm256_testz_si256(anda, anda)) {
+                // Alguma ainda não chegou: busca binária nas 8 ao mesmo tempo; quem chega a 1 fica parado
+                __m256i tamanho = nAmostras;
+                base = _mm256_setzero_si256();
+                for (int p = 0; p < passos; ++p) {
+                    __m256i metade = _mm256_srli_epi32(tamanho, 1);
+                    __m256i meio = _mm256_add_epi32(base, metade);
+                    __m256 valor = _mm256_i32gather_ps(tabela, _mm256_add_epi32(inicioT, meio), 4);
+                    __m256i vai = _mm256_castps_si256(_mm256_cmp_ps(valor, s, _CMP_LE_OQ));
+                    base = _mm256_blendv_epi8(base, meio, vai);
+                    tamanho = _mm256_sub_epi32(tamanho, metade);
+                }
+            }
+            __m256i anterior = _mm256_loadu_si256((const __m256i*)(amostraAtual.data() + i));
+            _mm256_storeu_si256((__m256i*)(amostraAtual.data() + i), _mm256_blendv_epi8(anterior, base, ativa));
+            __m256i indice = _mm256_add_epi32(inicioT, base);
+            __m256 s0 = _mm256_i32gather_ps(tabela, indice, 4);
+            __m256 s1 = _mm256_i32gather_ps(tabela, _mm256_add_epi32(indice, um), 4);
+            __m256 largura = _mm256_sub_ps(s1, s0);
+            __m256 f = _mm256_and_ps(_mm256_div_ps(_mm256_sub_ps(s, s0), largura), _mm256_cmp_ps(largura, zero, _CMP_GT_OQ));
+            __m256 amostra = _mm256_cvtepi32_ps(_mm256_and_si256(base, _mm256_set1_epi32(AMOSTRAS - 1)));
+            __m256 u = _mm256_mul_ps(_mm256_add_ps(amostra, f), _mm256_set1_ps(1.0f / AMOSTRAS));
+
+            // Polinômio do segmento, por Horner, eixo por eixo
+            __m256i segmento = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(inicioSegmentos.data() + i)),
+                                                _mm256_srli_epi32(base, DESLOCAMENTO_AMOSTRAS));
+            __m256i coef = _mm256_mullo_epi32(segmento, _mm256_set1_epi32(12));
+            alignas(32) float saida[3][8];
+            for (int eixo = 0; eixo < 3; ++eixo) {
+                __m256i e = _mm256_add_epi32(coef, _mm256_set1_epi32(eixo));
+                __m256 a = _mm256_i32gather_ps(coeficientes, e, 4);
+                __m256 b = _mm256_i32gather_ps(coeficientes, _mm256_add_epi32(e, _mm256_set1_epi32(3)), 4);
+                __m256 cc = _mm256_i32gather_ps(coeficientes, _mm256_add_epi32(e, _mm256_set1_epi32(6)), 4);
+                __m256 d = _mm256_i32gather_ps(coeficientes, _mm256_add_epi32(e, _mm256_set1_epi32(9)), 4);
+                __m256 v = _mm256_fmadd_ps(_mm256_fmadd_ps(_mm256_fmadd_ps(d, u, cc), u, b), u, a);
+                _mm256_store_ps(saida[eixo], v);
+            }
+            for (int l = 0; l < 8; ++l) {
+                if (!(mascara & (1 << l))) continue;
+                uint32_t o = objetos[i + l];
+                destino[0][o] = saida[0][l];
+                destino[1][o] = saida[1][l];
+                destino[2][o] = saida[2][l];
+            }
+        }
+        return i;
+    }
+#endif
+
+    // Pools
+    std::vector<SegmentoCubico> segmentos;
+    std::vector<float> tabelas;
+    int32_t maiorTabela = 1; // amostras da maior curva: passos da busca binária
+    // Por trajetória
+    std::vector<uint32_t> objetos;
+    std::vector<int32_t> inicioSegmentos;
+    std::vector<int32_t> inicioTabela;
+    std::vector<int32_t> amostras;
+    std::vector<float> comprimentos;
+    std::vector<float> distancias;
+    std::vector<float> velocidades;
+    std::vector<uint8_t> ativas;
+    std::vector<int32_t> amostraAtual; // amostra da tabela na distância atual
+    std::vector<float> percorridas;    // andado desde a ativação ou a última definirDistancia, até uma volta
+};
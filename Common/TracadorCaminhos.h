@@ -0,0 +1,610 @@
+/*
+ *  TracadorCaminhos.h
+ *
+ *  Traçador de caminhos em CPU, progressivo, para gerar imagens de
+ *  referência da iluminação do M5/M6. A cena são as mesmas malhas
+ *  (vértice intercalado de 11 floats), texturas do map_Kd e materiais
+ *  Ka/Kd/Ks/Ns que vão para a GPU, com a luz pontual branca do shader.
+ *
+ *  O modelo de luz é o Phong do fragment shader com o que a GPU não faz:
+ *    - difusa e especular (kd * difusa + ks * especular) * textura só
+ *      contam se a luz é visível do ponto (raio de sombra);
+ *    - o termo ambiente vira luz de verdade: ka * textura é o albedo de um
+ *      rebote difuso (amostrado pelo cosseno) que traz a luz de outras
+ *      superfícies ou, se escapa da cena, a do céu branco. Um ponto sem
+ *      nada em volta recebe exatamente ka * textura, como no shader; em
+ *      cantos e cavidades, menos (oclusão), e superfícies vizinhas se
+ *      tingem umas às outras.
+ *  Raio primário que não acerta nada vê a cor de fundo.
+ *
+ *  construir() junta os triângulos de todas as instâncias no espaço do
+ *  mundo numa BVHTriangulos (SAH, folhas de 4 triângulos). Os caminhos
+ *  andam em pacotes de 8 pixels vizinhos (uma linha de 8 de um tile): a
+ *  cada rebote os 8 raios do pacote, e depois os 8 raios de sombra, são
+ *  traçados juntos pela BVH com AVX2 (8 raios contra cada caixa e contra
+ *  cada triângulo); sem AVX2, um raio por vez com o teste de 4 triângulos
+ *  em SSE da BVHTriangulos.
+ *
+ *  Cada amostra percorre a imagem em tiles de 16x16. As threads recebem
+ *  faixas contíguas de tiles e, quando a sua acaba, roubam metade da maior
+ *  faixa restante (RouboTiles). Os números aleatórios dependem só do pixel
+ *  e do índice da amostra, então a imagem é a mesma com qualquer número de
+ *  threads.
+ *
+ *  A imagem fica em RGBA8 com a linha 0 embaixo, como no RasterizadorSoftware.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  TracadorCaminhos tracador;
+ *  tracador.adicionar(malha.vertices, malha.nVertices(), malha.indices, malha.nIndices(),
+ *                     malha.indices16Bits(), model, &textura, malha.material);
+ *  tracador.construir();
+ *  tracador.redimensionar(800, 800);
+ *  tracador.definirCamera(view, projection, lightPos);
+ *  while (tracador.amostras() < 256) tracador.amostrar();   // uma amostra por pixel a cada chamada
+ *  tracador.gravarPPM("referencia.ppm");
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BVHTriangulos.h"
+#include "RasterizadorSoftware.h"
+
+// Estatísticas de uma ou mais chamadas de amostrar()
+struct EstatisticasTracado {
+    size_t primarios = 0;
+    size_t sombra = 0;
+    size_t indiretos = 0;
+    size_t roubos = 0;        // faixas de tiles roubadas por threads sem trabalho
+
+    size_t raios() const { return primarios + sombra + indiretos; }
+    void somar(const EstatisticasTracado& e) {
+        primarios += e.primarios;
+        sombra += e.sombra;
+        indiretos += e.indiretos;
+        roubos += e.roubos;
+    }
+};
+
+namespace tracadorCaminhos {
+
+// Faixas [inicio, fim) de tiles por thread, cada uma num atomic de 64 bits.
+// O dono tira do começo; quem ficou sem trabalho rouba a metade final da
+// maior faixa restante e passa a tirar dela.
+class RouboTiles {
+public:
+    void iniciar(uint32_t nTiles, unsigned nThreads) {
+        faixas.reset(new Faixa[nThreads]);
+        this->nThreads = nThreads;
+        for (unsigned t = 0; t < nThreads; ++t)
+            faixas[t].intervalo.store(juntar((uint32_t)((uint64_t)nTiles * t / nThreads),
+                                             (uint32_t)((uint64_t)nTiles * (t + 1) / nThreads)));
+    }
+
+    // Próximo tile da thread; false quando não sobrou nenhum em lugar algum
+    bool proximo(unsigned thread, uint32_t& tile, size_t& roubos) {
+        std::atomic<uint64_t>& propria = faixas[thread].intervalo;
+        for (;;) {
+            uint64_t atual = propria.load();
+            while (inicio(atual) < fim(atual))
+                if (propria.compare_exchange_weak(atual, juntar(inicio(atual) + 1, fim(atual)))) {
+                    tile = inicio(atual);
+                    return true;
+                }
+
+            unsigned vitima = thread;
+            uint32_t maior = 0;
+            for (unsigned t = 0; t < nThreads; ++t) {
+                uint64_t f = faixas[t].intervalo.load();
+                if (inicio(f) < fim(f) && fim(f) - inicio(f) > maior) {
+                    maior = fim(f) - inicio(f);
+                    vitima = t;
+                }
+            }
+            if (maior == 0) return false;
+            uint64_t alvo = faixas[vitima].intervalo.load();
+            uint32_t i = inicio(alvo), f = fim(alvo);
+            if (i >= f) continue;
+            uint32_t metade = (f - i + 1) / 2;
+            if (!faixas[vitima].intervalo.compare_exchange_strong(alvo, juntar(i, f - metade))) continue;
+            tile = f - metade;
+            propria.store(juntar(f - metade + 1, f));
+            ++roubos;
+            return true;
+        }
+    }
+
+private:
+    struct alignas(64) Faixa {
+        std::atomic<uint64_t> intervalo;
+    };
+
+    static uint64_t juntar(uint32_t inicio, uint32_t fim) { return ((uint64_t)fim << 32) | inicio; }
+    static uint32_t inicio(uint64_t f) { return (uint32_t)f; }
+    static uint32_t fim(uint64_t f) { return (uint32_t)(f >> 32); }
+
+    std::unique_ptr<Faixa[]> faixas;
+    unsigned nThreads = 0;
+};
+
+// 8 raios em SoA. Entra: origem, direção, tMax e as pistas ativas; sai:
+// o acerto mais próximo (ou, em sombra, qualquer acerto) de cada pista
+struct PacoteRaios {
+    alignas(32) float ox[8], oy[8], oz[8];
+    alignas(32) float dx[8], dy[8], dz[8];
+    alignas(32) float t[8], u[8], v[8];
+    uint32_t triangulo[8];
+    int ativos = 0;           // bit k: pista k
+};
+
+// Hash de inteiro (lowbias32); semente de um pixel numa amostra
+inline uint32_t misturar(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+// PCG32 reduzido (xorshift do estado de 32 bits); float em [0, 1)
+struct Aleatorio {
+    uint32_t estado;
+    float proximo() {
+        estado = estado * 747796405u + 2891336453u;
+        uint32_t w = ((estado >> ((estado >> 28u) + 4u)) ^ estado) * 277803737u;
+        return (float)(((w >> 22u) ^ w) >> 8) * (1.0f / 16777216.0f);
+    }
+};
+
+// Direção com densidade cos / pi em torno de n (base de Duff et al.)
+inline glm::vec3 amostrarCosseno(const glm::vec3& n, float a, float b) {
+    float sinal = std::copysign(1.0f, n.z);
+    float p = -1.0f / (sinal + n.z);
+    float q = n.x * n.y * p;
+    glm::vec3 t(1.0f + sinal * n.x * n.x * p, sinal * q, -sinal * n.x);
+    glm::vec3 s(q, sinal + n.y * n.y * p, -n.y);
+    float r = std::sqrt(a), fi = 6.28318531f * b;
+    return t * (r * std::cos(fi)) + s * (r * std::sin(fi)) + n * std::sqrt(std::max(0.0f, 1.0f - a));
+}
+
+#ifdef TRANSFORMACOES_AVX2
+
+// Möller-Trumbore dos 4 triângulos do pacote contra os 8 raios da máscara,
+// com as mesmas contas do testarPacote em SSE
+ALVO_AVX2 inline __m256 testarPacote8(const PacoteTriangulos& p, const __m256 o[3], const __m256 d[3], __m256 mascara,
+                                      __m256& tMelhor, __m256& uMelhor, __m256& vMelhor, __m256i& triMelhor) {
+    const __m256 zero = _mm256_setzero_ps(), um = _mm256_set1_ps(1.0f);
+    __m256 acertos = zero;
+    for (int k = 0; k < 4 && p.triangulo[k] != TRIANGULO_NENHUM; ++k) {
+        __m256 e1x = _mm256_set1_ps(p.e1[0][k]), e1y = _mm256_set1_ps(p.e1[1][k]), e1z = _mm256_set1_ps(p.e1[2][k]);
+        __m256 e2x = _mm256_set1_ps(p.e2[0][k]), e2y = _mm256_set1_ps(p.e2[1][k]), e2z = _mm256_set1_ps(p.e2[2][k]);
+        __m256 px = _mm256_sub_ps(_mm256_mul_ps(d[1], e2z), _mm256_mul_ps(d[2], e2y));
+        __m256 py = _mm256_sub_ps(_mm256_mul_ps(d[2], e2x), _mm256_mul_ps(d[0], e2z));
+        __m256 pz = _mm256_sub_ps(_mm256_mul_ps(d[0], e2y), _mm256_mul_ps(d[1], e2x));
+        __m256 det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, px), _mm256_mul_ps(e1y, py)), _mm256_mul_ps(e1z, pz));
+        __m256 inv = _mm256_div_ps(um, det);
+        __m256 tx = _mm256_sub_ps(o[0], _mm256_set1_ps(p.v0[0][k]));
+        __m256 ty = _mm256_sub_ps(o[1], _mm256_set1_ps(p.v0[1][k]));
+        __m256 tz = _mm256_sub_ps(o[2], _mm256_set1_ps(p.v0[2][k]));
+        __m256 u = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(tx, px), _mm256_mul_ps(ty, py)), _mm256_mul_ps(tz, pz)), inv);
+        __m256 qx = _mm256_sub_ps(_mm256_mul_ps(ty, e1z), _mm256_mul_ps(tz, e1y));
+        __m256 qy = _mm256_sub_ps(_mm256_mul_ps(tz, e1x), _mm256_mul_ps(tx, e1z));
+        __m256 qz = _mm256_sub_ps(_mm256_mul_ps(tx, e1y), _mm256_mul_ps(ty, e1x));
+        __m256 v = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(d[0], qx), _mm256_mul_ps(d[1], qy)), _mm256_mul_ps(d[2], qz)), inv);
+        __m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, qx), _mm256_mul_ps(e2y, qy)), _mm256_mul_ps(e2z, qz)), inv);
+
+        __m256 absDet = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), det);
+        __m256 acerta = _mm256_and_ps(mascara, _mm256_cmp_ps(absDet, _mm256_set1_ps(1e-12f), _CMP_GT_OQ));
+        acerta = _mm256_and_ps(acerta, _mm256_cmp_ps(u, zero, _CMP_GE_OQ));
+        acerta = _mm256_and_ps(acerta, _mm256_cmp_ps(v, zero, _CMP_GE_OQ));
+        acerta = _mm256_and_ps(acerta, _mm256_cmp_ps(_mm256_add_ps(u, v), um, _CMP_LE_OQ));
+        acerta = _mm256_and_ps(acerta, _mm256_cmp_ps(t, zero, _CMP_GT_OQ));
+        acerta = _mm256_and_ps(acerta, _mm256_cmp_ps(t, tMelhor, _CMP_LT_OQ));
+        tMelhor = _mm256_blendv_ps(tMelhor, t, acerta);
+        uMelhor = _mm256_blendv_ps(uMelhor, u, acerta);
+        vMelhor = _mm256_blendv_ps(vMelhor, v, acerta);
+        triMelhor = _mm256_castps_si256(
+            _mm256_blendv_ps(_mm256_castsi256_ps(triMelhor), _mm256_castsi256_ps(_mm256_set1_epi32((int)p.triangulo[k])), acerta));
+        acertos = _mm256_or_ps(acertos, acerta);
+    }
+    return acertos;
+}
+
+// Os 8 raios juntos pela BVH: cada nó é testado contra todas as pistas
+// ativas e só é pulado se nenhuma o atravessa antes do seu melhor t. Os
+// filhos são empilhados na ordem que serve à primeira pista ativa.
+// qualquer = true (sombra) tira a pista no primeiro acerto.
+ALVO_AVX2 inline void intersectar8(const NoBVHTriangulos* nos, const PacoteTriangulos* pacotes, size_t nNos,
+                                   PacoteRaios& r, bool qualquer) {
+    for (int k = 0; k < 8; ++k) r.triangulo[k] = TRIANGULO_NENHUM;
+    if (nNos == 0 || !r.ativos) return;
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 o[3] = { _mm256_load_ps(r.ox), _mm256_load_ps(r.oy), _mm256_load_ps(r.oz) };
+    __m256 d[3] = { _mm256_load_ps(r.dx), _mm256_load_ps(r.dy), _mm256_load_ps(r.dz) };
+    __m256 inverso[3], oi[3];
+    for (int e = 0; e < 3; ++e) {
+        inverso[e] = _mm256_div_ps(_mm256_set1_ps(1.0f), d[e]);
+        oi[e] = _mm256_mul_ps(o[e], inverso[e]);
+    }
+    __m256i bits = _mm256_and_si256(_mm256_set1_epi32(r.ativos), _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128));
+    __m256 ativo = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_cmpeq_epi32(bits, _mm256_setzero_si256()), _mm256_setzero_si256()));
+    __m256 tMelhor = _mm256_load_ps(r.t), uMelhor = zero, vMelhor = zero;
+    __m256i triMelhor = _mm256_set1_epi32((int)TRIANGULO_NENHUM);
+
+    uint32_t pilha[bvhTriangulos::TAMANHO_PILHA];
+    int topo = 0;
+    pilha[topo++] = 0;
+    while (topo > 0) {
+        uint32_t indice = pilha[--topo];
+        const NoBVHTriangulos& no = nos[indice];
+        __m256 tPerto = zero, tLonge = tMelhor;
+        for (int e = 0; e < 3; ++e) {
+            __m256 a = _mm256_fmsub_ps(_mm256_set1_ps(no.minimo[e]), inverso[e], oi[e]);
+            __m256 b = _mm256_fmsub_ps(_mm256_set1_ps(no.maximo[e]), inverso[e], oi[e]);
+            tPerto = _mm256_max_ps(tPerto, _mm256_min_ps(a, b));
+            tLonge = _mm256_min_ps(tLonge, _mm256_max_ps(a, b));
+        }
+        __m256 mascara = _mm256_and_ps(ativo, _mm256_cmp_ps(tPerto, tLonge, _CMP_LE_OQ));
+        int bitsMascara = _mm256_movemask_ps(mascara);
+        if (!bitsMascara) continue;
+        if (no.folha) {
+            __m256 acertos = testarPacote8(pacotes[no.indice], o, d, mascara, tMelhor, uMelhor, vMelhor, triMelhor);
+            if (qualquer) {
+                ativo = _mm256_andnot_ps(acertos, ativo);
+                if (!_mm256_movemask_ps(ativo)) break;
+            }
+            continue;
+        }
+        uint32_t a = indice + 1, b = no.indice;
+        const NoBVHTriangulos &na = nos[a], &nb = nos[b];
+        int eixo = 0;
+        float separacao = 0.0f;
+        for (int e = 0; e < 3; ++e) {
+            float s = (nb.minimo[e] + nb.maximo[e]) - (na.minimo[e] + na.maximo[e]);
+            if (std::fabs(s) > std::fabs(separacao)) {
+                separacao = s;
+                eixo = e;
+            }
+        }
+        int lider = transformacoesSoA::primeiroBit((unsigned)bitsMascara);
+        const float* direcao = eixo == 0 ? r.dx : eixo == 1 ? r.dy : r.dz;
+        if (direcao[lider] * separacao < 0.0f) std::swap(a, b); // o mais perto fica no topo
+        pilha[topo++] = b;
+        pilha[topo++] = a;
+    }
+    _mm256_store_ps(r.t, tMelhor);
+    _mm256_store_ps(r.u, uMelhor);
+    _mm256_store_ps(r.v, vMelhor);
+    _mm256_storeu_si256((__m256i*)r.triangulo, triMelhor);
+}
+
+#endif // TRANSFORMACOES_AVX2
+
+} // namespace tracadorCaminhos
+
+class TracadorCaminhos {
+public:
+    static const int TAMANHO_TILE = 16;
+
+    bool usarAVX2 = true;
+    int saltos = 4;                            // rebotes do termo ambiente depois do raio primário
+    glm::vec3 fundo = glm::vec3(0.1f);         // raio primário sem acerto (o glClearColor)
+    glm::vec3 ceu = glm::vec3(1.0f);           // rebote que escapa: a luz ambiente branca
+    EstatisticasTracado estatisticas;          // da última chamada de amostrar()
+
+    // Junta uma malha à cena, no mundo; vértices e índices são copiados
+    void adicionar(const float* vertices, size_t nVertices, const void* indices, size_t nIndices, bool indices16Bits,
+                   const glm::mat4& model, const TexturaSoftware* textura, const MaterialOBJ& material) {
+        uint32_t base = (uint32_t)(posicoes.size() / 3);
+        glm::mat3 normal = matrizNormal(model, false);
+        for (size_t i = 0; i < nVertices; ++i) {
+            const float* v = vertices + i * FLOATS_POR_VERTICE;
+            glm::vec3 p = glm::vec3(model * glm::vec4(v[0], v[1], v[2], 1.0f));
+            glm::vec3 n = normal * glm::vec3(v[6], v[7], v[8]);
+            posicoes.insert(posicoes.end(), { p.x, p.y, p.z });
+            normais.insert(normais.end(), { n.x, n.y, n.z });
+            uvs.insert(uvs.end(), { v[9], v[10] });
+        }
+        for (size_t i = 0; i < nIndices; ++i)
+            indicesMundo.push_back(base + (indices16Bits ? ((const uint16_t*)indices)[i] : ((const uint32_t*)indices)[i]));
+        materialDoTriangulo.resize(indicesMundo.size() / 3, (uint32_t)materiais.size());
+        materiais.push_back({ material, textura });
+    }
+
+    // BVH dos triângulos de todas as malhas; depois de adicionar() e antes de amostrar()
+    void construir() {
+        bvh.construir(posicoes.data(), 3, indicesMundo.data(), indicesMundo.size() / 3);
+        glm::vec3 minimo(FLT_MAX), maximo(-FLT_MAX);
+        for (size_t i = 0; i < posicoes.size(); i += 3) {
+            glm::vec3 p(posicoes[i], posicoes[i + 1], posicoes[i + 2]);
+            minimo = glm::min(minimo, p);
+            maximo = glm::max(maximo, p);
+        }
+        // Afastamento das origens dos raios secundários, relativo ao tamanho da cena
+        epsilon = posicoes.empty() ? 1e-4f : 1e-4f * std::max(1.0f, glm::length(maximo - minimo));
+    }
+
+    void redimensionar(int largura, int altura) {
+        this->largura = largura;
+        this->altura = altura;
+        tilesX = (largura + TAMANHO_TILE - 1) / TAMANHO_TILE;
+        tilesY = (altura + TAMANHO_TILE - 1) / TAMANHO_TILE;
+        reiniciar();
+    }
+
+    // As mesmas view, projection e lightPos do bloco Quadro; recomeça a acumulação
+    void definirCamera(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& lightPos) {
+        inversa = glm::inverse(projection * view);
+        this->lightPos = lightPos;
+        reiniciar();
+    }
+
+    // Descarta as amostras acumuladas
+    void reiniciar() {
+        soma.assign((size_t)largura * altura, glm::vec3(0.0f));
+        nAmostras = 0;
+    }
+
+    // Soma mais uma amostra a cada pixel; nThreads = 0 usa todos os núcleos
+    void amostrar(unsigned nThreads = 0) {
+        estatisticas = EstatisticasTracado();
+        if (nThreads == 0) nThreads = std::max(1u, std::thread::hardware_concurrency());
+        uint32_t nTiles = (uint32_t)tilesX * tilesY;
+        if (nTiles == 0) return;
+        nThreads = std::min<unsigned>(nThreads, nTiles);
+        std::vector<EstatisticasTracado> porThread(nThreads);
+        distribuidor.iniciar(nTiles, nThreads);
+        std::vector<std::thread> threads;
+        auto tarefa = [&](unsigned t) {
+            for (uint32_t tile; distribuidor.proximo(t, tile, porThread[t].roubos);) desenharTile(tile, porThread[t]);
+        };
+        for (unsigned t = 1; t < nThreads; ++t) threads.emplace_back(tarefa, t);
+        tarefa(0u);
+        for (std::thread& t : threads) t.join();
+        for (const EstatisticasTracado& e : porThread) estatisticas.somar(e);
+        ++nAmostras;
+    }
+
+    uint32_t amostras() const { return nAmostras; }
+    size_t triangulos() const { return indicesMundo.size() / 3; }
+    int larguraImagem() const { return largura; }
+    int alturaImagem() const { return altura; }
+
+    // Média das amostras em [0, 1]
+    glm::vec3 media(int x, int y) const {
+        return nAmostras ? soma[(size_t)y * largura + x] * (1.0f / nAmostras) : glm::vec3(0.0f);
+    }
+
+    // RGBA8 (r no byte menos significativo), linha 0 embaixo
+    uint32_t pixel(int x, int y) const {
+        glm::vec3 c = media(x, y);
+        uint32_t r = (uint32_t)(std::min(std::max(c.r, 0.0f), 1.0f) * 255.0f + 0.5f);
+        uint32_t g = (uint32_t)(std::min(std::max(c.g, 0.0f), 1.0f) * 255.0f + 0.5f);
+        uint32_t b = (uint32_t)(std::min(std::max(c.b, 0.0f), 1.0f) * 255.0f + 0.5f);
+        return r | (g << 8) | (b << 16) | 0xFF000000u;
+    }
+
+    // RGB8 de cima para baixo, como o stbi_write_png espera
+    void copiarRGB(std::vector<unsigned char>& rgb) const {
+        rgb.resize((size_t)largura * altura * 3);
+        for (int y = 0; y < altura; ++y)
+            for (int x = 0; x < largura; ++x) {
+                uint32_t c = pixel(x, altura - 1 - y);
+                unsigned char* p = &rgb[((size_t)y * largura + x) * 3];
+                p[0] = (unsigned char)(c & 0xFF);
+                p[1] = (unsigned char)((c >> 8) & 0xFF);
+                p[2] = (unsigned char)((c >> 16) & 0xFF);
+            }
+    }
+
+    // P6 em RGB, linhas de cima para baixo
+    bool gravarPPM(const std::string& nome) const {
+        std::vector<unsigned char> rgb;
+        copiarRGB(rgb);
+        FILE* arquivo = fopen(nome.c_str(), "wb");
+        if (!arquivo) return false;
+        fprintf(arquivo, "P6\n%d %d\n255\n", largura, altura);
+        fwrite(rgb.data(), 1, rgb.size(), arquivo);
+        return fclose(arquivo) == 0;
+    }
+
+private:
+    struct Material {
+        MaterialOBJ obj;
+        const TexturaSoftware* textura;
+    };
+
+    // Um caminho por pista do pacote
+    struct Caminho {
+        tracadorCaminhos::Aleatorio aleatorio;
+        glm::vec3 peso, radiancia, direta;
+        bool vivo;
+    };
+
+    void desenharTile(uint32_t tile, EstatisticasTracado& stats) {
+        int x0 = (int)(tile % tilesX) * TAMANHO_TILE, y0 = (int)(tile / tilesX) * TAMANHO_TILE;
+        int x1 = std::min(largura, x0 + TAMANHO_TILE), y1 = std::min(altura, y0 + TAMANHO_TILE);
+        for (int y = y0; y < y1; ++y)
+            for (int x = x0; x < x1; x += 8) tracarPacote(x, y, std::min(8, x1 - x), stats);
+    }
+
+    // Os caminhos dos pixels x a x + n - 1 da linha y, rebote a rebote juntos
+    void tracarPacote(int x, int y, int n, EstatisticasTracado& stats) {
+        using namespace tracadorCaminhos;
+        Caminho caminhos[8];
+        PacoteRaios raios, sombras;
+        for (int k = 0; k < n; ++k) {
+            Caminho& c = caminhos[k];
+            c.aleatorio.estado = misturar((uint32_t)((size_t)y * largura + x + k) ^ misturar(nAmostras * 0x9E3779B9u + 1u));
+            c.peso = glm::vec3(1.0f);
+            c.radiancia = glm::vec3(0.0f);
+            c.vivo = true;
+            // Ponto aleatório no pixel, do plano near ao far como o rasterizador
+            float ndcX = 2.0f * ((float)(x + k) + c.aleatorio.proximo()) / largura - 1.0f;
+            float ndcY = 2.0f * ((float)y + c.aleatorio.proximo()) / altura - 1.0f;
+            glm::vec4 perto = inversa * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+            glm::vec4 longe = inversa * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+            glm::vec3 origem = glm::vec3(perto) / perto.w;
+            glm::vec3 direcao = glm::vec3(longe) / longe.w - origem;
+            float comprimento = glm::length(direcao);
+            definirRaio(raios, k, origem, direcao / comprimento, comprimento);
+        }
+        raios.ativos = (1 << n) - 1;
+
+        for (int profundidade = 0; raios.ativos; ++profundidade) {
+            tracar(raios, false);
+            size_t nRaios = (size_t)transformacoesSoA::contarBits((unsigned)raios.ativos);
+            (profundidade == 0 ? stats.primarios : stats.indiretos) += nRaios;
+            int proximos = 0;
+            sombras.ativos = 0;
+            for (int k = 0; k < n; ++k) {
+                if (!(raios.ativos & (1 << k))) continue;
+                Caminho& c = caminhos[k];
+                glm::vec3 d(raios.dx[k], raios.dy[k], raios.dz[k]);
+                if (raios.triangulo[k] == TRIANGULO_NENHUM) {
+                    c.radiancia += c.peso * (profundidade == 0 ? fundo : ceu);
+                    continue;
+                }
+                glm::vec3 p = glm::vec3(raios.ox[k], raios.oy[k], raios.oz[k]) + d * raios.t[k];
+                sombrear(c, raios.triangulo[k], raios.u[k], raios.v[k], p, d, profundidade, sombras, raios, k);
+                if (c.vivo) proximos |= 1 << k;
+            }
+            if (sombras.ativos) {
+                tracar(sombras, true);
+                stats.sombra += (size_t)transformacoesSoA::contarBits((unsigned)sombras.ativos);
+                for (int k = 0; k < n; ++k)
+                    if ((sombras.ativos & (1 << k)) && sombras.triangulo[k] == TRIANGULO_NENHUM)
+                        caminhos[k].radiancia += caminhos[k].direta;
+            }
+            raios.ativos = proximos;
+        }
+        glm::vec3* linha = &soma[(size_t)y * largura + x];
+        for (int k = 0; k < n; ++k) linha[k] += caminhos[k].radiancia;
+    }
+
+    // Phong no ponto: prepara o raio de sombra (com a contribuição direta que
+    // ele libera) e, se o caminho continua, o rebote na pista k de raios
+    void sombrear(Caminho& c, uint32_t triangulo, float u, float v, const glm::vec3& p, const glm::vec3& d,
+                  int profundidade, tracadorCaminhos::PacoteRaios& sombras, tracadorCaminhos::PacoteRaios& raios, int k) {
+        const uint32_t* tri = &indicesMundo[(size_t)triangulo * 3];
+        float w = 1.0f - u - v;
+        glm::vec3 a = vec3De(posicoes, tri[0]), b = vec3De(posicoes, tri[1]), e = vec3De(posicoes, tri[2]);
+        glm::vec3 geometrica = glm::normalize(glm::cross(b - a, e - a));
+        glm::vec3 n = vec3De(normais, tri[0]) * w + vec3De(normais, tri[1]) * u + vec3De(normais, tri[2]) * v;
+        float comprimentoN = glm::length(n);
+        n = comprimentoN > 0.0f ? n / comprimentoN : geometrica;
+        // Faces dos dois lados, como sem GL_CULL_FACE
+        if (glm::dot(geometrica, d) > 0.0f) geometrica = -geometrica;
+        if (glm::dot(n, geometrica) < 0.0f) n = -n;
+
+        const Material& m = materiais[materialDoTriangulo[triangulo]];
+        glm::vec3 texColor(1.0f);
+        if (m.textura) {
+            float s = uvs[tri[0] * 2] * w + uvs[tri[1] * 2] * u + uvs[tri[2] * 2] * v;
+            float t = uvs[tri[0] * 2 + 1] * w + uvs[tri[1] * 2 + 1] * u + uvs[tri[2] * 2 + 1] * v;
+            texColor = m.textura->amostrar(s, t, 0.0f);
+        }
+
+        glm::vec3 paraLuz = lightPos - p;
+        float distancia = glm::length(paraLuz);
+        glm::vec3 lightDir = paraLuz / distancia;
+        float diff = std::max(glm::dot(n, lightDir), 0.0f);
+        glm::vec3 reflectDir = 2.0f * glm::dot(n, lightDir) * n - lightDir;
+        float base = std::max(glm::dot(-d, reflectDir), 0.0f);
+        float spec = base > 0.0f ? std::pow(base, m.obj.ns) : 0.0f;
+        if (diff > 0.0f || spec > 0.0f) {
+            c.direta = c.peso * (m.obj.kd * diff + m.obj.ks * spec) * texColor;
+            definirRaio(sombras, k, afastar(p, geometrica, lightDir), lightDir, distancia);
+            sombras.ativos |= 1 << k;
+        }
+
+        c.peso *= m.obj.ka * texColor;
+        if (profundidade >= saltos) {
+            c.vivo = false;
+            return;
+        }
+        // Roleta russa a partir do terceiro rebote, pelo maior canal do peso
+        if (profundidade >= 2) {
+            float continuar = std::min(1.0f, std::max({ c.peso.r, c.peso.g, c.peso.b }));
+            if (c.aleatorio.proximo() >= continuar) {
+                c.vivo = false;
+                return;
+            }
+            c.peso /= continuar;
+        }
+        float a1 = c.aleatorio.proximo(), a2 = c.aleatorio.proximo();
+        glm::vec3 direcao = tracadorCaminhos::amostrarCosseno(n, a1, a2);
+        definirRaio(raios, k, afastar(p, geometrica, direcao), direcao, FLT_MAX);
+    }
+
+    glm::vec3 afastar(const glm::vec3& p, const glm::vec3& geometrica, const glm::vec3& direcao) const {
+        return p + geometrica * (glm::dot(geometrica, direcao) >= 0.0f ? epsilon : -epsilon);
+    }
+
+    static glm::vec3 vec3De(const std::vector<float>& v, uint32_t i) {
+        return glm::vec3(v[(size_t)i * 3], v[(size_t)i * 3 + 1], v[(size_t)i * 3 + 2]);
+    }
+
+    static void definirRaio(tracadorCaminhos::PacoteRaios& r, int k, const glm::vec3& origem, const glm::vec3& direcao,
+                            float tMax) {
+        r.ox[k] = origem.x;
+        r.oy[k] = origem.y;
+        r.oz[k] = origem.z;
+        r.dx[k] = direcao.x;
+        r.dy[k] = direcao.y;
+        r.dz[k] = direcao.z;
+        r.t[k] = tMax;
+    }
+
+    // Pacote inteiro com AVX2 ou um raio por vez; as pistas inativas não mudam
+    void tracar(tracadorCaminhos::PacoteRaios& r, bool qualquer) const {
+        const std::vector<NoBVHTriangulos>& nos = bvh.nosArvore();
+        const std::vector<PacoteTriangulos>& pacotes = bvh.pacotesArvore();
+#ifdef TRANSFORMACOES_AVX2
+        if (usarAVX2 && transformacoesSoA::temAVX2()) {
+            for (int k = 0; k < 8; ++k)
+                if (!(r.ativos & (1 << k))) definirRaio(r, k, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), 0.0f);
+            tracadorCaminhos::intersectar8(nos.data(), pacotes.data(), nos.size(), r, qualquer);
+            return;
+        }
+#endif
+        for (int k = 0; k < 8; ++k) {
+            r.triangulo[k] = TRIANGULO_NENHUM;
+            if (!(r.ativos & (1 << k))) continue;
+            AcertoTriangulo acerto;
+            bvhTriangulos::intersectar(nos.data(), pacotes.data(), nos.size(), glm::vec3(r.ox[k], r.oy[k], r.oz[k]),
+                                       glm::vec3(r.dx[k], r.dy[k], r.dz[k]), r.t[k], acerto);
+            r.t[k] = acerto.t;
+            r.u[k] = acerto.u;
+            r.v[k] = acerto.v;
+            r.triangulo[k] = acerto.triangulo;
+        }
+    }
+
+    // Cena, no espaço do mundo
+    std::vector<float> posicoes, normais, uvs;
+    std::vector<uint32_t> indicesMundo, materialDoTriangulo;
+    std::vector<Material> materiais;
+    BVHTriangulos bvh;
+    float epsilon = 1e-4f;
+
+    int largura = 0, altura = 0, tilesX = 0, tilesY = 0;
+    glm::mat4 inversa{ 1.0f };
+    glm::vec3 lightPos{ 0.0f };
+    std::vector<glm::vec3> soma;
+    uint32_t nAmostras = 0;
+    tracadorCaminhos::RouboTiles distribuidor;
+};
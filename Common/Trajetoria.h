@@ -0,0 +1,182 @@
+/*
+ *  Trajetoria.h
+ *
+ *  Curva fechada pelos pontos de controle de uma trajetória, percorrida a
+ *  velocidade constante. Modos:
+ *    LINEAR        segmentos retos entre os pontos (o comportamento antigo)
+ *    CATMULL_ROM   passa pelos pontos, tangente (P[i+1] - P[i-1]) / 2
+ *    CENTRIPETA    Catmull-Rom centrípeta (alfa = 0.5): sem laços nem
+ *                  cúspides quando os pontos são irregulares
+ *    BEZIER        cúbicas de Bézier: P[3k] e P[3k+3] são os extremos e os
+ *                  dois do meio as alças (faltando alças no último segmento,
+ *                  ele vira reta)
+ *
+ *  Todo segmento vira um polinômio cúbico a + b*u + c*u^2 + d*u^3, u em
+ *  [0, 1]. Na montagem cada segmento é amostrado em AMOSTRAS_SEGMENTO
+ *  cordas e a tabela guarda o comprimento acumulado em cada amostra; a
+ *  posição na distância s é uma busca binária na tabela, uma interpolação
+ *  de u entre as duas amostras vizinhas e uma avaliação do polinômio.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  Trajetoria curva;
+ *  curva.definir(pontosControle, TRAJETORIA_CENTRIPETA);  // quando os pontos mudam
+ *  ...
+ *  distancia += velocidade * deltaTime;                    // unidades por segundo
+ *  glm::vec3 pos = curva.posicao(distancia);               // dá a volta sozinho
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum ModoTrajetoria {
+    TRAJETORIA_LINEAR = 0,
+    TRAJETORIA_CATMULL_ROM,
+    TRAJETORIA_CENTRIPETA,
+    TRAJETORIA_BEZIER,
+    N_MODOS_TRAJETORIA
+};
+
+inline const char* nomeModoTrajetoria(ModoTrajetoria modo) {
+    switch (modo) {
+        case TRAJETORIA_LINEAR: return "linear";
+        case TRAJETORIA_CATMULL_ROM: return "Catmull-Rom";
+        case TRAJETORIA_CENTRIPETA: return "Catmull-Rom centrípeta";
+        case TRAJETORIA_BEZIER: return "Bézier cúbica";
+        default: return "?";
+    }
+}
+
+// a + b*u + c*u^2 + d*u^3
+struct SegmentoCubico {
+    glm::vec3 a, b, c, d;
+
+    glm::vec3 avaliar(float u) const { return a + (b + (c + d * u) * u) * u; }
+    glm::vec3 derivada(float u) const { return b + (c * 2.0f + d * (3.0f * u)) * u; }
+};
+
+class Trajetoria {
+public:
+    static const int AMOSTRAS_SEGMENTO = 32;
+
+    // Menos de 2 pontos deixa a curva vazia (posicao() devolve o ponto, se houver)
+    void definir(const std::vector<glm::vec3>& pontos, ModoTrajetoria modo) {
+        modoAtual = modo;
+        segmentos.clear();
+        comprimentos.clear();
+        pontoUnico = pontos.empty() ? glm::vec3(0.0f) : pontos[0];
+        size_t n = pontos.size();
+        if (n < 2) return;
+
+        auto P = [&](long i) { return pontos[(size_t)(((i % (long)n) + (long)n) % (long)n)]; };
+        if (modo == TRAJETORIA_BEZIER) {
+            for (size_t k = 0; k < n; k += 3) {
+                glm::vec3 p0 = pontos[k];
+                glm::vec3 p3 = k + 3 < n ? pontos[k + 3] : pontos[0];
+                glm::vec3 p1 = k + 1 < n ? pontos[k + 1] : glm::mix(p0, p3, 1.0f / 3.0f);
+                glm::vec3 p2 = k + 2 < n ? pontos[k + 2] : glm::mix(p0, p3, 2.0f / 3.0f);
+                segmentos.push_back(bezier(p0, p1, p2, p3));
+            }
+        } else {
+            for (size_t i = 0; i < n; ++i) {
+                glm::vec3 p0 = P((long)i - 1), p1 = P((long)i), p2 = P((long)i + 1), p3 = P((long)i + 2);
+                if (modo == TRAJETORIA_LINEAR) segmentos.push_back({ p1, p2 - p1, glm::vec3(0.0f), glm::vec3(0.0f) });
+                else segmentos.push_back(catmullRom(p0, p1, p2, p3, modo == TRAJETORIA_CENTRIPETA ? 0.5f : 0.0f));
+            }
+        }
+
+        // Tabela: comprimentos[k] = distância até a amostra k (segmento k / AMOSTRAS, u = resto / AMOSTRAS)
+        comprimentos.reserve(segmentos.size() * AMOSTRAS_SEGMENTO + 1);
+        comprimentos.push_back(0.0f);
+        float total = 0.0f;
+        for (const SegmentoCubico& seg : segmentos) {
+            glm::vec3 anterior = seg.a;
+            for (int k = 1; k <= AMOSTRAS_SEGMENTO; ++k) {
+                glm::vec3 p = seg.avaliar((float)k / AMOSTRAS_SEGMENTO);
+                total += glm::length(p - anterior);
+                comprimentos.push_back(total);
+                anterior = p;
+            }
+        }
+    }
+
+    bool vazia() const { return segmentos.empty(); }
+    float comprimento() const { return comprimentos.empty() ? 0.0f : comprimentos.back(); }
+    ModoTrajetoria modo() const { return modoAtual; }
+    const std::vector<SegmentoCubico>& segmentosCurva() const { return segmentos; }
+    // comprimentos[k] = distância até a amostra k; AMOSTRAS_SEGMENTO por segmento, mais o 0 inicial
+    const std::vector<float>& tabelaComprimentos() const { return comprimentos; }
+
+    // s em unidades ao longo da curva; fora de [0, comprimento) dá a volta
+    glm::vec3 posicao(float s) const {
+        if (vazia()) return pontoUnico;
+        size_t segmento;
+        float u;
+        localizar(s, segmento, u);
+        return segmentos[segmento].avaliar(u);
+    }
+
+    // Direção do movimento (normalizada) na distância s
+    glm::vec3 direcao(float s) const {
+        if (vazia()) return glm::vec3(0.0f, 0.0f, -1.0f);
+        size_t segmento;
+        float u;
+        localizar(s, segmento, u);
+        glm::vec3 d = segmentos[segmento].derivada(u);
+        float tamanho = glm::length(d);
+        return tamanho > 0.0f ? d / tamanho : glm::vec3(0.0f, 0.0f, -1.0f);
+    }
+
+    // Segmento e parâmetro u da distância s
+    void localizar(float s, size_t& segmento, float& u) const {
+        float total = comprimento();
+        if (total <= 0.0f) {
+            segmento = 0;
+            u = 0.0f;
+            return;
+        }
+        s = std::fmod(s, total);
+        if (s < 0.0f) s += total;
+        // Primeira amostra além de s; a anterior fica em s ou antes
+        size_t k = std::upper_bound(comprimentos.begin() + 1, comprimentos.end(), s) - comprimentos.begin();
+        if (k >= comprimentos.size()) k = comprimentos.size() - 1;
+        float s0 = comprimentos[k - 1], s1 = comprimentos[k];
+        float f = s1 > s0 ? (s - s0) / (s1 - s0) : 0.0f;
+        size_t amostra = k - 1;
+        segmento = amostra / AMOSTRAS_SEGMENTO;
+        u = ((float)(amostra % AMOSTRAS_SEGMENTO) + f) / AMOSTRAS_SEGMENTO;
+    }
+
+private:
+    static SegmentoCubico hermite(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& m1, const glm::vec3& m2) {
+        return { p1, m1, p1 * -3.0f + p2 * 3.0f - m1 * 2.0f - m2, p1 * 2.0f - p2 * 2.0f + m1 + m2 };
+    }
+
+    static SegmentoCubico bezier(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3) {
+        return { p0, (p1 - p0) * 3.0f, (p0 - p1 * 2.0f + p2) * 3.0f, p3 - p0 + (p1 - p2) * 3.0f };
+    }
+
+    // Catmull-Rom com parametrização por corda^alfa (0 uniforme, 0.5
+    // centrípeta), escrita como Hermite no intervalo p1..p2
+    static SegmentoCubico catmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3,
+                                     float alfa) {
+        const float minimo = 1e-4f; // pontos repetidos não dividem por zero
+        float t01 = std::max(std::pow(glm::length(p1 - p0), alfa), minimo);
+        float t12 = std::max(std::pow(glm::length(p2 - p1), alfa), minimo);
+        float t23 = std::max(std::pow(glm::length(p3 - p2), alfa), minimo);
+        glm::vec3 m1 = (p2 - p1) + ((p1 - p0) / t01 - (p2 - p0) / (t01 + t12)) * t12;
+        glm::vec3 m2 = (p2 - p1) + ((p3 - p2) / t23 - (p3 - p1) / (t12 + t23)) * t12;
+        return hermite(p1, p2, m1, m2);
+    }
+
+    ModoTrajetoria modoAtual = TRAJETORIA_LINEAR;
+    std::vector<SegmentoCubico> segmentos;
+    std::vector<float> comprimentos;
+    glm::vec3 pontoUnico{ 0.0f };
+};
@@ -0,0 +1,35 @@
+/*
+ *  Transformacoes.h
+ *
+ *  Montagem da matriz model de um objeto (translação, rotações em X/Y/Z e
+ *  escala, na mesma ordem usada nos trabalhos) e da matriz das normais, que
+ *  passa a ser calculada uma vez por objeto na CPU em vez de
+ *  mat3(transpose(inverse(model))) a cada vértice no shader.
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+inline glm::mat4 matrizModelo(const glm::vec3& pos, const glm::vec3& rot, const glm::vec3& escala) {
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, pos);
+    model = glm::rotate(model, rot.x, glm::vec3(1, 0, 0));
+    model = glm::rotate(model, rot.y, glm::vec3(0, 1, 0));
+    model = glm::rotate(model, rot.z, glm::vec3(0, 0, 1));
+    model = glm::scale(model, escala);
+    return model;
+}
+
+inline bool escalaUniforme(const glm::vec3& escala) {
+    return escala.x == escala.y && escala.y == escala.z;
+}
+
+// Transposta da inversa da parte 3x3 do model. Com escala uniforme a parte
+// 3x3 é s * R, cuja inversa-transposta é R / s: mesma direção, e o shader
+// normaliza a normal de qualquer forma, então a inversa é dispensada.
+inline glm::mat3 matrizNormal(const glm::mat4& model, bool uniforme) {
+    glm::mat3 m(model);
+    return uniforme ? m : glm::transpose(glm::inverse(m));
+}
@@ -0,0 +1,351 @@
+/*
+ *  TransformacoesSoA.h
+ *
+ *  Posição, rotação (ângulos de Euler em X/Y/Z, em radianos) e escala dos
+ *  objetos guardadas em estrutura de arrays: um vetor de floats por
+ *  componente, no mesmo índice do objeto na cena.
+ *
+ *  As matrizes model saem direto da forma fechada de
+ *  T * Rx * Ry * Rz * S (a mesma ordem de matrizModelo), sem passar por
+ *  glm::translate/rotate/scale e seus produtos 4x4. Com AVX2 são 8 objetos
+ *  por iteração: seno e cosseno por polinômio, composição nos registradores
+ *  e uma transposição 8x8 que grava duas colunas de cada matriz por vez.
+ *  Sem AVX2 (compilador ou processador) o mesmo cálculo roda escalar.
+ *
+ *  Cada objeto guarda também a model e a matriz das normais já prontas. Os
+ *  definir* só marcam o objeto; atualizarCache() refaz de uma vez (em lote,
+ *  pelo mesmo caminho AVX2) apenas os marcados desde a última chamada, e
+ *  recalculados() diz quais foram, para quem precisa reenviar ou reajustar.
+ *  Num quadro em que nada se moveu nenhuma matriz é refeita.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  TransformacoesSoA transformacoes;
+ *  uint32_t i = transformacoes.adicionar(pos, rot, escala);
+ *  ...
+ *  transformacoes.definirPosicao(i, novaPos);        // só marca o objeto
+ *  size_t refeitas = transformacoes.atualizarCache(); // uma vez por quadro
+ *  const glm::mat4& model = transformacoes.modeloCache(i);
+ *  const glm::mat3& normal = transformacoes.normalCache(i);
+ *
+ *  // Sem cache, direto para um array:
+ *  transformacoes.calcularModelos(modelos.data());                       // todos
+ *  transformacoes.calcularModelos(visiveis.data(), visiveis.size(), m);  // só alguns
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Transformacoes.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+// Compila o caminho AVX2 mesmo sem -mavx2 e decide na execução
+#define TRANSFORMACOES_AVX2 1
+#define ALVO_AVX2 __attribute__((target("avx2,fma")))
+#elif defined(__AVX2__)
+#include <intrin.h>
+#define TRANSFORMACOES_AVX2 1
+#define ALVO_AVX2
+#endif
+#endif
+
+namespace transformacoesSoA {
+
+// Colunas da parte 3x3 de Rx(a) * Ry(b) * Rz(c) * S, para um objeto
+inline void compor(float px, float py, float pz, float rx, float ry, float rz,
+                   float sx, float sy, float sz, glm::mat4& m) {
+    float senX = std::sin(rx), cosX = std::cos(rx);
+    float senY = std::sin(ry), cosY = std::cos(ry);
+    float senZ = std::sin(rz), cosZ = std::cos(rz);
+    float* f = &m[0][0];
+    f[0] = cosY * cosZ * sx;
+    f[1] = (senX * senY * cosZ + cosX * senZ) * sx;
+    f[2] = (senX * senZ - cosX * senY * cosZ) * sx;
+    f[3] = 0.0f;
+    f[4] = -cosY * senZ * sy;
+    f[5] = (cosX * cosZ - senX * senY * senZ) * sy;
+    f[6] = (cosX * senY * senZ + senX * cosZ) * sy;
+    f[7] = 0.0f;
+    f[8] = senY * sz;
+    f[9] = -senX * cosY * sz;
+    f[10] = cosX * cosY * sz;
+    f[11] = 0.0f;
+    f[12] = px;
+    f[13] = py;
+    f[14] = pz;
+    f[15] = 1.0f;
+}
+
+#ifdef TRANSFORMACOES_AVX2
+
+inline bool temAVX2() {
+#if defined(__GNUC__) || defined(__clang__)
+    static const bool tem = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return tem;
+#else
+    return true;
+#endif
+}
+
+// Bits de uma máscara de movemask (8 pistas); primeiroBit pede máscara não nula
+inline int contarBits(unsigned mascara) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcount(mascara);
+#else
+    return (int)__popcnt(mascara); // todo processador com AVX2 tem POPCNT
+#endif
+}
+
+inline int primeiroBit(unsigned mascara) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(mascara);
+#else
+    unsigned long indice;
+    _BitScanForward(&indice, mascara);
+    return (int)indice;
+#endif
+}
+
+// Seno e cosseno de 8 ângulos: redução a [-pi/4, pi/4] em três partes
+// (Cody-Waite) e os polinômios do sinf/cosf da Cephes; erro ~1e-7 para
+// ângulos de até alguns milhares de radianos
+ALVO_AVX2 inline void senoCosseno(__m256 x, __m256& seno, __m256& cosseno) {
+    __m256 j = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(0.63661977236758134f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_fnmadd_ps(j, _mm256_set1_ps(1.5703125f), x);
+    r = _mm256_fnmadd_ps(j, _mm256_set1_ps(4.837512969970703125e-4f), r);
+    r = _mm256_fnmadd_ps(j, _mm256_set1_ps(7.54978995489188216e-8f), r);
+    __m256 r2 = _mm256_mul_ps(r, r);
+
+    __m256 ps = _mm256_fmadd_ps(r2, _mm256_set1_ps(-1.9515295891e-4f), _mm256_set1_ps(8.3321608736e-3f));
+    ps = _mm256_fmadd_ps(ps, r2, _mm256_set1_ps(-1.6666654611e-1f));
+    __m256 s = _mm256_fmadd_ps(_mm256_mul_ps(ps, r2), r, r);
+    __m256 pc = _mm256_fmadd_ps(r2, _mm256_set1_ps(2.443315711809948e-5f), _mm256_set1_ps(-1.388731625493765e-3f));
+    pc = _mm256_fmadd_ps(pc, r2, _mm256_set1_ps(4.166664568298827e-2f));
+    __m256 c = _mm256_fmadd_ps(_mm256_mul_ps(pc, r2), r2, _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), r2, _mm256_set1_ps(1.0f)));
+
+    // Quadrante q: 1 troca seno e cosseno; o sinal do seno vem do bit 1 de q
+    // e o do cosseno do bit 1 de q + 1
+    __m256i q = _mm256_cvtps_epi32(j);
+    __m256 troca = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+    __m256 sinalSeno = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, _mm256_set1_epi32(2)), 30));
+    __m256 sinalCosseno = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30));
+    seno = _mm256_xor_ps(_mm256_blendv_ps(s, c, troca), sinalSeno);
+    cosseno = _mm256_xor_ps(_mm256_blendv_ps(c, s, troca), sinalCosseno);
+}
+
+// r[k] vira o k-ésimo componente de cada um dos 8 objetos -> r[k] = 8 floats do objeto k
+ALVO_AVX2 inline void transpor8x8(__m256 r[8]) {
+    __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]), t1 = _mm256_unpackhi_ps(r[0], r[1]);
+    __m256 t2 = _mm256_unpacklo_ps(r[2], r[3]), t3 = _mm256_unpackhi_ps(r[2], r[3]);
+    __m256 t4 = _mm256_unpacklo_ps(r[4], r[5]), t5 = _mm256_unpackhi_ps(r[4], r[5]);
+    __m256 t6 = _mm256_unpacklo_ps(r[6], r[7]), t7 = _mm256_unpackhi_ps(r[6], r[7]);
+    __m256 u0 = _mm256_shuffle_ps(t0, t2, 0x44), u1 = _mm256_shuffle_ps(t0, t2, 0xEE);
+    __m256 u2 = _mm256_shuffle_ps(t1, t3, 0x44), u3 = _mm256_shuffle_ps(t1, t3, 0xEE);
+    __m256 u4 = _mm256_shuffle_ps(t4, t6, 0x44), u5 = _mm256_shuffle_ps(t4, t6, 0xEE);
+    __m256 u6 = _mm256_shuffle_ps(t5, t7, 0x44), u7 = _mm256_shuffle_ps(t5, t7, 0xEE);
+    r[0] = _mm256_permute2f128_ps(u0, u4, 0x20);
+    r[1] = _mm256_permute2f128_ps(u1, u5, 0x20);
+    r[2] = _mm256_permute2f128_ps(u2, u6, 0x20);
+    r[3] = _mm256_permute2f128_ps(u3, u7, 0x20);
+    r[4] = _mm256_permute2f128_ps(u0, u4, 0x31);
+    r[5] = _mm256_permute2f128_ps(u1, u5, 0x31);
+    r[6] = _mm256_permute2f128_ps(u2, u6, 0x31);
+    r[7] = _mm256_permute2f128_ps(u3, u7, 0x31);
+}
+
+// comp[0..8] = px py pz rx ry rz sx sy sz de 8 objetos; grava saida[0..7]
+ALVO_AVX2 inline void compor8(const __m256 comp[9], glm::mat4* saida) {
+    __m256 senX, cosX, senY, cosY, senZ, cosZ;
+    senoCosseno(comp[3], senX, cosX);
+    senoCosseno(comp[4], senY, cosY);
+    senoCosseno(comp[5], senZ, cosZ);
+    __m256 senXsenY = _mm256_mul_ps(senX, senY);
+    __m256 cosXsenY = _mm256_mul_ps(cosX, senY);
+    __m256 zero = _mm256_setzero_ps();
+
+    __m256 a[8], b[8];
+    a[0] = _mm256_mul_ps(_mm256_mul_ps(cosY, cosZ), comp[6]);
+    a[1] = _mm256_mul_ps(_mm256_fmadd_ps(senXsenY, cosZ, _mm256_mul_ps(cosX, senZ)), comp[6]);
+    a[2] = _mm256_mul_ps(_mm256_fnmadd_ps(cosXsenY, cosZ, _mm256_mul_ps(senX, senZ)), comp[6]);
+    a[3] = zero;
+    a[4] = _mm256_mul_ps(_mm256_mul_ps(cosY, senZ), _mm256_sub_ps(zero, comp[7]));
+    a[5] = _mm256_mul_ps(_mm256_fnmadd_ps(senXsenY, senZ, _mm256_mul_ps(cosX, cosZ)), comp[7]);
+    a[6] = _mm256_mul_ps(_mm256_fmadd_ps(cosXsenY, senZ, _mm256_mul_ps(senX, cosZ)), comp[7]);
+    a[7] = zero;
+    b[0] = _mm256_mul_ps(senY, comp[8]);
+    b[1] = _mm256_mul_ps(_mm256_mul_ps(senX, cosY), _mm256_sub_ps(zero, comp[8]));
+    b[2] = _mm256_mul_ps(_mm256_mul_ps(cosX, cosY), comp[8]);
+    b[3] = zero;
+    b[4] = comp[0];
+    b[5] = comp[1];
+    b[6] = comp[2];
+    b[7] = _mm256_set1_ps(1.0f);
+    transpor8x8(a);
+    transpor8x8(b);
+    for (int k = 0; k < 8; ++k) {
+        _mm256_storeu_ps(&saida[k][0][0], a[k]); // colunas 0 e 1
+        _mm256_storeu_ps(&saida[k][2][0], b[k]); // colunas 2 e 3
+    }
+}
+
+ALVO_AVX2 inline size_t comporAVX2(const float* const comp[9], size_t n, glm::mat4* saida) {
+    size_t i = 0;
+    __m256 v[9];
+    for (; i + 8 <= n; i += 8) {
+        for (int c = 0; c < 9; ++c) v[c] = _mm256_loadu_ps(comp[c] + i);
+        compor8(v, saida + i);
+    }
+    return i;
+}
+
+ALVO_AVX2 inline size_t comporAVX2(const float* const comp[9], const uint32_t* indices, size_t n, glm::mat4* saida) {
+    size_t i = 0;
+    __m256 v[9];
+    for (; i + 8 <= n; i += 8) {
+        __m256i idx = _mm256_loadu_si256((const __m256i*)(indices + i));
+        for (int c = 0; c < 9; ++c) v[c] = _mm256_i32gather_ps(comp[c], idx, 4);
+        compor8(v, saida + i);
+    }
+    return i;
+}
+
+#endif // TRANSFORMACOES_AVX2
+
+} // namespace transformacoesSoA
+
+class TransformacoesSoA {
+public:
+    uint32_t adicionar(const glm::vec3& pos, const glm::vec3& rot = glm::vec3(0.0f), const glm::vec3& escala = glm::vec3(1.0f)) {
+        float valores[9] = { pos.x, pos.y, pos.z, rot.x, rot.y, rot.z, escala.x, escala.y, escala.z };
+        for (int c = 0; c < 9; ++c) comp[c].push_back(valores[c]);
+        uint32_t i = (uint32_t)(comp[0].size() - 1);
+        modelos.emplace_back(1.0f);
+        normais.emplace_back(1.0f);
+        marcado.push_back(0);
+        geracaoObjeto.push_back(0);
+        marcarAlterado(i);
+        return i;
+    }
+
+    void reservar(size_t n) {
+        for (std::vector<float>& v : comp) v.reserve(n);
+        modelos.reserve(n);
+        normais.reserve(n);
+        marcado.reserve(n);
+        geracaoObjeto.reserve(n);
+    }
+    size_t tamanho() const { return comp[0].size(); }
+
+    glm::vec3 posicao(uint32_t i) const { return glm::vec3(comp[0][i], comp[1][i], comp[2][i]); }
+    glm::vec3 rotacao(uint32_t i) const { return glm::vec3(comp[3][i], comp[4][i], comp[5][i]); }
+    glm::vec3 escala(uint32_t i) const { return glm::vec3(comp[6][i], comp[7][i], comp[8][i]); }
+
+    void definirPosicao(uint32_t i, const glm::vec3& p) { definir3(0, i, p); }
+    void definirRotacao(uint32_t i, const glm::vec3& r) { definir3(3, i, r); }
+    void definirEscala(uint32_t i, const glm::vec3& e) { definir3(6, i, e); }
+    void definir(uint32_t i, const glm::vec3& pos, const glm::vec3& rot, const glm::vec3& esc) {
+        definirPosicao(i, pos);
+        definirRotacao(i, rot);
+        definirEscala(i, esc);
+    }
+
+    glm::mat4 modelo(uint32_t i) const {
+        glm::mat4 m;
+        transformacoesSoA::compor(comp[0][i], comp[1][i], comp[2][i], comp[3][i], comp[4][i], comp[5][i],
+                                  comp[6][i], comp[7][i], comp[8][i], m);
+        return m;
+    }
+
+    // Escrita direta das posições (eixo 0, 1, 2 = x, y, z), para quem move
+    // muitos objetos em lote; threads podem escrever objetos distintos ao
+    // mesmo tempo. Depois, numa thread só, marcarAlterado() em cada um.
+    float* posicoes(int eixo) { return comp[eixo].data(); }
+
+    // Agenda o objeto para o próximo atualizarCache(); os definir* já chamam
+    void marcarAlterado(uint32_t i) {
+        if (marcado[i]) return;
+        marcado[i] = 1;
+        pendentes.push_back(i);
+    }
+
+    // Refaz model e normal dos objetos marcados e retorna quantos foram
+    size_t atualizarCache() {
+        ++geracao;
+        recalculadosUltimo.swap(pendentes);
+        pendentes.clear();
+        std::sort(recalculadosUltimo.begin(), recalculadosUltimo.end());
+        size_t n = recalculadosUltimo.size();
+        if (n == 0) return 0;
+        temporario.resize(n);
+        calcularModelos(recalculadosUltimo.data(), n, temporario.data());
+        for (size_t k = 0; k < n; ++k) {
+            uint32_t i = recalculadosUltimo[k];
+            modelos[i] = temporario[k];
+            normais[i] = matrizNormal(temporario[k], escalaUniforme(escala(i)));
+            marcado[i] = 0;
+            geracaoObjeto[i] = geracao;
+        }
+        return n;
+    }
+
+    const glm::mat4& modeloCache(uint32_t i) const { return modelos[i]; }
+    const glm::mat3& normalCache(uint32_t i) const { return normais[i]; }
+    // Objetos refeitos no último atualizarCache(), em ordem crescente
+    const std::vector<uint32_t>& recalculados() const { return recalculadosUltimo; }
+    bool recalculado(uint32_t i) const { return geracaoObjeto[i] == geracao; }
+
+    // saida[i] = model do objeto i, para todos os objetos
+    void calcularModelos(glm::mat4* saida) const {
+        size_t n = tamanho();
+        size_t i = 0;
+#ifdef TRANSFORMACOES_AVX2
+        const float* p[9];
+        for (int c = 0; c < 9; ++c) p[c] = comp[c].data();
+        if (usarAVX2 && transformacoesSoA::temAVX2()) i = transformacoesSoA::comporAVX2(p, n, saida);
+#endif
+        for (; i < n; ++i) saida[i] = modelo((uint32_t)i);
+    }
+
+    // saida[k] = model do objeto indices[k]
+    void calcularModelos(const uint32_t* indices, size_t n, glm::mat4* saida) const {
+        size_t k = 0;
+#ifdef TRANSFORMACOES_AVX2
+        const float* p[9];
+        for (int c = 0; c < 9; ++c) p[c] = comp[c].data();
+        if (usarAVX2 && transformacoesSoA::temAVX2()) k = transformacoesSoA::comporAVX2(p, indices, n, saida);
+#endif
+        for (; k < n; ++k) saida[k] = modelo(indices[k]);
+    }
+
+    bool usarAVX2 = true; // false força o caminho escalar (comparações e benchmark)
+
+private:
+    // Valor igual ao guardado não marca o objeto
+    void definir3(int c, uint32_t i, const glm::vec3& v) {
+        if (comp[c][i] == v.x && comp[c + 1][i] == v.y && comp[c + 2][i] == v.z) return;
+        comp[c][i] = v.x;
+        comp[c + 1][i] = v.y;
+        comp[c + 2][i] = v.z;
+        marcarAlterado(i);
+    }
+
+    std::vector<float> comp[9]; // px py pz rx ry rz sx sy sz
+
+    // Cache por objeto
+    std::vector<glm::mat4> modelos;
+    std::vector<glm::mat3> normais;
+    std::vector<uint8_t> marcado;          // já está em pendentes
+    std::vector<uint32_t> geracaoObjeto;   // geracao do último recálculo do objeto
+    std::vector<uint32_t> pendentes;
+    std::vector<uint32_t> recalculadosUltimo;
+    std::vector<glm::mat4> temporario;
+    uint32_t geracao = 0;
+};
@@ -0,0 +1,201 @@
+/*	Benchmark da BVH de cena (BVHCena)
+    Espalha nObjetos cubos com rotação e escala variadas num volume que
+    cresce com a cena (densidade constante) e mede:
+      1) construção com 1 thread e com todas, e o custo SAH resultante;
+      2) reajuste incremental depois de mover 1% dos objetos, reajuste
+         completo e reconstrução quando a árvore degrada;
+      3) consultas de frustum, raio (mais próximo) e esfera na BVH contra a
+         busca por força bruta, conferindo que os resultados são iguais.
+
+    Uso: BenchBVH [nObjetos] [nConsultas]
+    Retorna 1 se alguma consulta da BVH divergir da força bruta.
+*/
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+#include "BVHCena.h"
+#include "Transformacoes.h"
+
+using namespace std;
+
+template <typename F>
+double medirSegundos(F&& f) {
+    auto inicio = chrono::steady_clock::now();
+    f();
+    chrono::duration<double> d = chrono::steady_clock::now() - inicio;
+    return d.count();
+}
+
+struct Objeto {
+    glm::vec3 pos, rot, escala;
+};
+
+int main(int argc, char** argv) {
+    size_t nObjetos = argc > 1 ? strtoull(argv[1], nullptr, 10) : 100000;
+    int nConsultas = argc > 2 ? atoi(argv[2]) : 200;
+    unsigned nucleos = max(1u, thread::hardware_concurrency());
+    bool falhou = false;
+
+    // Cubo unitário, como o placeholder dos trabalhos
+    LimitesMalha cubo;
+    for (int e = 0; e < 3; ++e) {
+        cubo.minimo[e] = -0.5f;
+        cubo.maximo[e] = 0.5f;
+        cubo.centro[e] = 0.0f;
+    }
+    cubo.raio = sqrt(0.75f);
+
+    mt19937 gerador(42);
+    uniform_real_distribution<float> unitario(0.0f, 1.0f);
+    float lado = 2.0f * cbrt((float)nObjetos);
+    auto pontoAleatorio = [&] { return glm::vec3(unitario(gerador), unitario(gerador), unitario(gerador)) * lado - lado * 0.5f; };
+
+    vector<Objeto> objetos(nObjetos);
+    vector<CaixaAlinhada> caixas(nObjetos);
+    for (size_t i = 0; i < nObjetos; ++i) {
+        objetos[i] = { pontoAleatorio(), glm::vec3(unitario(gerador), unitario(gerador), unitario(gerador)) * 6.28f,
+                       glm::vec3(0.5f + unitario(gerador) * 1.5f) };
+        caixas[i] = caixaMundo(matrizModelo(objetos[i].pos, objetos[i].rot, objetos[i].escala), cubo);
+    }
+    cout << nObjetos << " objetos num cubo de lado " << fixed << setprecision(1) << lado << ", "
+         << nConsultas << " consultas de cada tipo" << endl;
+
+    // 1) Construção
+    BVHCena bvh;
+    double tSerial = medirSegundos([&] { bvh.construir(caixas, 1); });
+    float custoSerial = bvh.custoSAH();
+    double tParalelo = medirSegundos([&] { bvh.construir(caixas, nucleos); });
+    cout << "construção  1 thread  " << setprecision(2) << setw(9) << tSerial * 1e3 << " ms  (SAH " << custoSerial << ")" << endl;
+    cout << "construção " << setw(2) << nucleos << " threads " << setw(9) << tParalelo * 1e3 << " ms  (SAH " << bvh.custoSAH()
+         << ", " << bvh.nNos() << " nós)  speedup " << tSerial / tParalelo << "x" << endl;
+
+    // 2) Reajuste: 1% dos objetos andam um pouco
+    vector<uint32_t> movidos;
+    for (size_t i = 0; i < nObjetos; i += 100) movidos.push_back((uint32_t)i);
+    for (uint32_t i : movidos) {
+        objetos[i].pos += (glm::vec3(unitario(gerador), unitario(gerador), unitario(gerador)) - 0.5f) * 2.0f;
+        caixas[i] = caixaMundo(matrizModelo(objetos[i].pos, objetos[i].rot, objetos[i].escala), cubo);
+    }
+    bool degradou = false;
+    double tIncremental = medirSegundos([&] {
+        for (uint32_t i : movidos) bvh.atualizar(i, caixas[i]);
+        degradou = bvh.reajustar();
+    });
+    double tCompleto = medirSegundos([&] { bvh.reajustar(caixas); });
+    cout << "reajuste incremental (" << movidos.size() << " objetos) " << setprecision(3) << setw(8) << tIncremental * 1e3
+         << " ms, degradação " << setprecision(2) << bvh.degradacao() << (degradou ? " (reconstruir)" : "") << endl;
+    cout << "reajuste completo                " << setprecision(3) << setw(8) << tCompleto * 1e3 << " ms" << endl;
+
+    // Todos andam bastante: a árvore velha piora e reajustar() pede reconstrução
+    for (size_t i = 0; i < nObjetos; ++i) {
+        objetos[i].pos = pontoAleatorio();
+        caixas[i] = caixaMundo(matrizModelo(objetos[i].pos, objetos[i].rot, objetos[i].escala), cubo);
+    }
+    degradou = bvh.reajustar(caixas);
+    cout << "cena embaralhada: degradação " << bvh.degradacao() << (degradou ? ", reconstruindo" : "");
+    if (degradou) {
+        double t = medirSegundos([&] { bvh.construir(caixas); });
+        cout << " em " << setprecision(2) << t * 1e3 << " ms, degradação " << bvh.degradacao();
+    }
+    cout << endl;
+
+    // 3) Consultas
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+    vector<Frustum> frustums;
+    vector<glm::vec3> origens, direcoes, centros;
+    for (int q = 0; q < nConsultas; ++q) {
+        glm::vec3 olho = pontoAleatorio();
+        glm::vec3 alvo = pontoAleatorio();
+        frustums.push_back(Frustum::extrair(projection * glm::lookAt(olho, alvo, glm::vec3(0, 1, 0))));
+        origens.push_back(olho);
+        direcoes.push_back(glm::normalize(alvo - olho));
+        centros.push_back(alvo);
+    }
+    float raioEsfera = 5.0f;
+
+    cout << left << setw(10) << "consulta" << right << setw(12) << "BVH us" << setw(16) << "força bruta us"
+         << setw(10) << "speedup" << setw(14) << "resultados" << endl;
+    auto linha = [&](const char* nome, double tBVH, double tBruta, double resultados, bool ok) {
+        cout << left << setw(10) << nome << right << setprecision(1)
+             << setw(12) << tBVH * 1e6 / nConsultas << setw(16) << tBruta * 1e6 / nConsultas
+             << setw(9) << tBruta / tBVH << "x" << setw(14) << resultados / nConsultas
+             << "  " << (ok ? "igual" : "DIFERENTE") << endl;
+        falhou |= !ok;
+    };
+
+    // Frustum
+    vector<vector<uint32_t>> viaBVH(nConsultas), viaBruta(nConsultas);
+    double tBVH = medirSegundos([&] {
+        for (int q = 0; q < nConsultas; ++q) bvh.consultarFrustum(frustums[q], viaBVH[q]);
+    });
+    double tBruta = medirSegundos([&] {
+        for (int q = 0; q < nConsultas; ++q) {
+            viaBruta[q].clear();
+            for (size_t i = 0; i < nObjetos; ++i)
+                if (caixaNoFrustum(frustums[q], caixas[i])) viaBruta[q].push_back((uint32_t)i);
+        }
+    });
+    bool ok = true;
+    double total = 0.0;
+    for (int q = 0; q < nConsultas; ++q) {
+        sort(viaBVH[q].begin(), viaBVH[q].end());
+        ok &= viaBVH[q] == viaBruta[q];
+        total += viaBVH[q].size();
+    }
+    linha("frustum", tBVH, tBruta, total, ok);
+
+    // Raio: objeto mais próximo pela entrada na AABB
+    vector<float> tViaBVH(nConsultas), tViaBruta(nConsultas, FLT_MAX);
+    tBVH = medirSegundos([&] {
+        for (int q = 0; q < nConsultas; ++q) bvh.raioMaisProximo(origens[q], direcoes[q], FLT_MAX, tViaBVH[q]);
+    });
+    tBruta = medirSegundos([&] {
+        for (int q = 0; q < nConsultas; ++q) {
+            glm::vec3 inverso(1.0f / direcoes[q].x, 1.0f / direcoes[q].y, 1.0f / direcoes[q].z);
+            for (size_t i = 0; i < nObjetos; ++i) {
+                float t;
+                if (raioNaCaixa(caixas[i], origens[q], inverso, tViaBruta[q], t)) tViaBruta[q] = min(tViaBruta[q], t);
+            }
+        }
+    });
+    ok = true;
+    total = 0.0;
+    for (int q = 0; q < nConsultas; ++q) {
+        ok &= tViaBVH[q] == tViaBruta[q];
+        total += tViaBVH[q] < FLT_MAX;
+    }
+    linha("raio", tBVH, tBruta, total, ok);
+
+    // Esfera
+    tBVH = medirSegundos([&] {
+        for (int q = 0; q < nConsultas; ++q) bvh.consultarEsfera(centros[q], raioEsfera, viaBVH[q]);
+    });
+    tBruta = medirSegundos([&] {
+        for (int q = 0; q < nConsultas; ++q) {
+            viaBruta[q].clear();
+            for (size_t i = 0; i < nObjetos; ++i)
+                if (esferaNaCaixa(caixas[i], centros[q], raioEsfera)) viaBruta[q].push_back((uint32_t)i);
+        }
+    });
+    ok = true;
+    total = 0.0;
+    for (int q = 0; q < nConsultas; ++q) {
+        sort(viaBVH[q].begin(), viaBVH[q].end());
+        ok &= viaBVH[q] == viaBruta[q];
+        total += viaBVH[q].size();
+    }
+    linha("esfera", tBVH, tBruta, total, ok);
+
+    cout << (falhou ? "FALHA: BVH divergiu da força bruta" : "OK: BVH igual à força bruta") << endl;
+    return falhou ? 1 : 0;
+}
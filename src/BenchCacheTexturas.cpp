@@ -0,0 +1,150 @@
+/*	Benchmark do CacheTexturas
+    Pede n Suzannes (1000 por padrão) ao CarregadorAssincrono e "envia" as
+    texturas como os trabalhos fazem, com funções de envio e liberação que
+    só contam (sem OpenGL), primeiro sem cache (um stbi_load e um envio
+    por modelo) e depois com ele.
+
+    Confere que com o cache houve exatamente uma decodificação e um envio,
+    que todos os objetos apontam para a mesma textura, com os bytes da GPU
+    contados uma vez, e que ela é liberada quando o último objeto some.
+
+    Uso: BenchCacheTexturas [modelo.obj] [n]
+    Retorna 1 se alguma contagem não bater.
+*/
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "CacheTexturas.h"
+#include "CarregadorAssincrono.h"
+
+using namespace std;
+
+struct Objeto3D {
+    size_t nIndices = 0;
+    unsigned id = 0;    // sem cache
+    RefTextura textura; // com cache
+};
+
+size_t enviadas = 0, liberadas = 0, bytesEnviados = 0;
+
+unsigned enviarTextura(const unsigned char* pixels, int w, int h, int c) {
+    (void)pixels;
+    bytesEnviados += CacheTexturas::bytesComMipmaps(w, h, c);
+    return (unsigned)++enviadas;
+}
+
+void liberarTextura(unsigned id) {
+    (void)id;
+    ++liberadas;
+}
+
+// Recebe tudo o que os n pedidos geram, como o enviarAssetsProntos dos trabalhos
+double carregar(CarregadorAssincrono& carregador, CacheTexturas* texturas, const string& modelo,
+                vector<Objeto3D>& cena) {
+    auto inicio = chrono::steady_clock::now();
+    for (size_t i = 0; i < cena.size(); ++i) carregador.pedirModelo((int)i, modelo, "../assets/tex/pixelWall.png");
+    while (carregador.emAndamento() > 0) {
+        unique_ptr<AssetPronto> asset = carregador.proximo();
+        if (!asset) {
+            this_thread::yield();
+            continue;
+        }
+        if (!asset->ok) continue;
+        Objeto3D& obj = cena[asset->id];
+        if (asset->tipo == ASSET_MALHA) {
+            obj.nIndices = asset->malha.nIndices();
+        } else if (texturas) {
+            if (RefTextura textura = texturas->textura(asset->chave, asset->imagem.get())) obj.textura = textura;
+        } else {
+            obj.id = enviarTextura(asset->pixels, asset->largura, asset->altura, asset->canais);
+        }
+    }
+    chrono::duration<double> d = chrono::steady_clock::now() - inicio;
+    return d.count();
+}
+
+int main(int argc, char** argv) {
+    string modelo = argc > 1 ? argv[1] : "../assets/Modelos3D/Suzanne.obj";
+    size_t n = argc > 2 ? (size_t)atoi(argv[2]) : 1000;
+    bool falhou = false;
+
+    vector<Objeto3D> cena(n);
+    double tSemCache;
+    {
+        CarregadorAssincrono carregador;
+        tSemCache = carregar(carregador, nullptr, modelo, cena);
+    }
+    cout << fixed << setprecision(1) << n << " x " << modelo << endl;
+    cout << "sem cache: " << tSemCache * 1e3 << " ms, " << enviadas << " texturas enviadas ("
+         << bytesEnviados / 1024 << " KB)" << endl;
+
+    enviadas = liberadas = bytesEnviados = 0;
+    cena.assign(n, Objeto3D());
+    CacheTexturas texturas(enviarTextura, liberarTextura);
+    double tComCache;
+    {
+        CarregadorAssincrono carregador(texturas);
+        tComCache = carregar(carregador, &texturas, modelo, cena);
+    }
+    EstatisticasTexturas stats = texturas.estatisticas();
+    cout << "com cache: " << tComCache * 1e3 << " ms, " << stats.decodificacoes << " decodificações, " << stats.envios
+         << " envios, " << stats.reusos << " reaproveitadas, " << stats.residentes << " residentes ("
+         << stats.bytesGPU / 1024 << " KB)" << endl;
+
+    if (stats.decodificacoes != 1 || stats.envios != 1 || enviadas != 1 || stats.residentes != 1) {
+        cout << "FALHA: esperava uma decodificação e um envio" << endl;
+        falhou = true;
+    }
+    for (const Objeto3D& obj : cena) {
+        if (!obj.textura || obj.textura != cena[0].textura || obj.nIndices == 0) {
+            cout << "FALHA: objeto sem malha ou com outra textura" << endl;
+            falhou = true;
+            break;
+        }
+    }
+    if (stats.bytesGPU != bytesEnviados) {
+        cout << "FALHA: " << stats.bytesGPU << " bytes contados, " << bytesEnviados << " enviados" << endl;
+        falhou = true;
+    }
+
+    // Metade dos objetos some: a textura continua; o resto some: ela é liberada
+    cena.resize(n / 2);
+    if (liberadas != 0 && !cena.empty()) {
+        cout << "FALHA: textura liberada com objetos ainda usando" << endl;
+        falhou = true;
+    }
+    cena.clear();
+    stats = texturas.estatisticas();
+    cout << "sem objetos: " << liberadas << " liberada, " << stats.residentes << " residentes (" << stats.bytesGPU
+         << " bytes)" << endl;
+    if (liberadas != 1 || stats.residentes != 0 || stats.bytesGPU != 0) {
+        cout << "FALHA: a textura não foi liberada com o último objeto" << endl;
+        falhou = true;
+    }
+
+    // Pedida de novo depois de liberada: decodifica outra vez, sem reaproveitar a antiga
+    cena.assign(2, Objeto3D());
+    {
+        CarregadorAssincrono carregador(texturas);
+        carregar(carregador, &texturas, modelo, cena);
+    }
+    stats = texturas.estatisticas();
+    if (stats.decodificacoes != 2 || stats.envios != 2 || stats.residentes != 1) {
+        cout << "FALHA: a textura liberada não foi recarregada" << endl;
+        falhou = true;
+    }
+    cena.clear();
+
+    cout << (falhou ? "FALHA" : "OK") << endl;
+    return falhou ? 1 : 0;
+}
@@ -0,0 +1,169 @@
+/*	Benchmark do GrafoCena
+    Três hierarquias:
+      profunda: uma corrente de nProfunda nós (cada um filho do anterior)
+      larga:    uma raiz com nLarga folhas
+      floresta: raízes independentes com 1000 folhas cada, nLarga nós no total
+    Em cada uma mede atualizar() depois de mexer na raiz (tudo sujo), numa
+    folha (só ela) e em nada (nenhum nó visitado), com 1 thread e com todos
+    os núcleos (ao menos 2), e confere as matrizes de mundo contra o produto ingênuo
+    mundo[pai] * matrizModelo(local) em ordem de id (aqui todo pai tem id
+    menor que os filhos). No fim troca o pai de uma subárvore e confere de novo.
+
+    Uso: BenchGrafoCena [nProfunda] [nLarga]
+    Retorna 1 se alguma matriz divergir da referência.
+*/
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <algorithm>
+#include <thread>
+
+#include "GrafoCena.h"
+#include "Transformacoes.h"
+
+using namespace std;
+
+template <typename F>
+double medirSegundos(F&& f) {
+    auto inicio = chrono::steady_clock::now();
+    f();
+    chrono::duration<double> d = chrono::steady_clock::now() - inicio;
+    return d.count();
+}
+
+// Maior erro relativo entre o grafo e a referência ingênua
+float conferir(const GrafoCena& grafo) {
+    const TransformacoesSoA& locais = grafo.locais();
+    vector<glm::mat4> referencia(grafo.tamanho());
+    float erro = 0.0f;
+    for (uint32_t id = 0; id < grafo.tamanho(); ++id) {
+        glm::mat4 local = matrizModelo(locais.posicao(id), locais.rotacao(id), locais.escala(id));
+        uint32_t pai = grafo.pai(id);
+        referencia[id] = pai == GrafoCena::NENHUM ? local : referencia[pai] * local;
+        const glm::mat4& m = grafo.mundo(id);
+        for (int c = 0; c < 4; ++c)
+            for (int l = 0; l < 4; ++l)
+                erro = max(erro, fabs(m[c][l] - referencia[id][c][l]) / max(1.0f, fabs(referencia[id][c][l])));
+    }
+    return erro;
+}
+
+struct Cenario {
+    string nome;
+    GrafoCena grafo;
+    uint32_t raiz, folha;
+    size_t nosRaiz; // tamanho da subárvore de raiz
+};
+
+int main(int argc, char** argv) {
+    uint32_t nProfunda = argc > 1 ? (uint32_t)atoi(argv[1]) : 10000;
+    uint32_t nLarga = argc > 2 ? (uint32_t)atoi(argv[2]) : 1000000;
+    unsigned nucleos = max(1u, thread::hardware_concurrency());
+    const float tolerancia = 1e-3f;
+    bool falhou = false;
+
+    mt19937 gerador(5);
+    uniform_real_distribution<float> unitario(-1.0f, 1.0f);
+    auto rotacaoAleatoria = [&] { return glm::vec3(unitario(gerador), unitario(gerador), unitario(gerador)) * 3.14f; };
+
+    vector<Cenario> cenarios(3);
+    {
+        Cenario& c = cenarios[0];
+        c.nome = "profunda (" + to_string(nProfunda) + ")";
+        c.grafo.reservar(nProfunda);
+        // Passos pequenos para a corrente não explodir em float
+        c.raiz = c.grafo.adicionar(GrafoCena::NENHUM, glm::vec3(0.0f));
+        uint32_t anterior = c.raiz;
+        for (uint32_t i = 1; i < nProfunda; ++i)
+            anterior = c.grafo.adicionar(anterior, glm::vec3(0.01f, 0.0f, 0.0f), rotacaoAleatoria() * 0.001f);
+        c.folha = anterior;
+        c.nosRaiz = nProfunda;
+    }
+    {
+        Cenario& c = cenarios[1];
+        c.nome = "larga (1 + " + to_string(nLarga) + ")";
+        c.grafo.reservar(nLarga + 1);
+        c.raiz = c.grafo.adicionar(GrafoCena::NENHUM, glm::vec3(0.0f));
+        for (uint32_t i = 0; i < nLarga; ++i)
+            c.folha = c.grafo.adicionar(c.raiz, glm::vec3(unitario(gerador), unitario(gerador), unitario(gerador)) * 100.0f,
+                                        rotacaoAleatoria(), glm::vec3(0.5f + 0.4f * unitario(gerador)));
+        c.nosRaiz = nLarga + 1;
+    }
+    {
+        Cenario& c = cenarios[2];
+        uint32_t porRaiz = 1000, nRaizes = max(1u, nLarga / porRaiz);
+        c.nome = "floresta (" + to_string(nRaizes) + " x " + to_string(porRaiz) + ")";
+        c.grafo.reservar((size_t)nRaizes * (porRaiz + 1));
+        c.nosRaiz = porRaiz + 1;
+        for (uint32_t r = 0; r < nRaizes; ++r) {
+            uint32_t raiz = c.grafo.adicionar(GrafoCena::NENHUM, glm::vec3(r % 100, 0.0f, r / 100) * 10.0f);
+            if (r == 0) c.raiz = raiz;
+            for (uint32_t i = 0; i < porRaiz; ++i)
+                c.folha = c.grafo.adicionar(raiz, glm::vec3(unitario(gerador), unitario(gerador), unitario(gerador)) * 4.0f,
+                                            rotacaoAleatoria());
+        }
+    }
+
+    cout << nucleos << " núcleos" << endl;
+    cout << left << setw(26) << "hierarquia" << setw(20) << "mudança" << right << setw(10) << "threads" << setw(12)
+         << "refeitos" << setw(12) << "ms" << setw(12) << "Mnós/s" << setw(12) << "erro" << endl;
+    for (Cenario& c : cenarios) {
+        auto linha = [&](const char* mudanca, unsigned threads, size_t refeitos, double t) {
+            cout << left << setw(26) << c.nome << setw(20) << mudanca << right << setw(10) << threads << setw(12)
+                 << refeitos << fixed << setprecision(3) << setw(12) << t * 1e3 << setprecision(1) << setw(12)
+                 << (t > 0.0 ? refeitos / t / 1e6 : 0.0);
+        };
+        size_t refeitos = 0;
+        double t = medirSegundos([&] { refeitos = c.grafo.atualizar(1); });
+        float erro = conferir(c.grafo);
+        linha("primeira", 1, refeitos, t);
+        cout << setw(12) << scientific << setprecision(1) << erro << fixed << endl;
+        falhou |= erro > tolerancia;
+
+        // Com um núcleo só, 2 threads ainda exercitam a divisão do trabalho
+        for (unsigned threads : { 1u, max(2u, nucleos) }) {
+            float angulo = unitario(gerador);
+            c.grafo.locais().definirRotacao(c.raiz, glm::vec3(0.0f, angulo, 0.0f));
+            t = medirSegundos([&] { refeitos = c.grafo.atualizar(threads); });
+            erro = conferir(c.grafo);
+            linha("raiz", threads, refeitos, t);
+            cout << setw(12) << scientific << setprecision(1) << erro << fixed << endl;
+            falhou |= erro > tolerancia || refeitos != c.nosRaiz;
+        }
+
+        c.grafo.locais().definirPosicao(c.folha, c.grafo.locais().posicao(c.folha) + glm::vec3(0.5f));
+        t = medirSegundos([&] { refeitos = c.grafo.atualizar(); });
+        linha("uma folha", nucleos, refeitos, t);
+        cout << endl;
+        falhou |= refeitos != 1 || !c.grafo.recalculado(c.folha) || c.grafo.recalculado(c.raiz);
+
+        t = medirSegundos([&] { refeitos = c.grafo.atualizar(); });
+        linha("nada", nucleos, refeitos, t);
+        cout << endl;
+        falhou |= refeitos != 0;
+    }
+
+    // Troca de pai: a segunda raiz da floresta (com suas folhas) vai para
+    // debaixo de uma folha da primeira
+    GrafoCena& floresta = cenarios[2].grafo;
+    uint32_t segundaRaiz = 1001;
+    if (segundaRaiz < floresta.tamanho()) {
+        bool ok = floresta.definirPai(segundaRaiz, 1);
+        bool ciclo = !floresta.definirPai(1, 1005); // 1005 é folha da segunda raiz, agora abaixo de 1
+        size_t refeitos = floresta.atualizar();
+        float erro = conferir(floresta);
+        cout << "troca de pai: " << refeitos << " refeitos, ciclo " << (ciclo ? "recusado" : "ACEITO") << ", erro "
+             << scientific << setprecision(1) << erro << fixed << endl;
+        falhou |= !ok || !ciclo || refeitos != 1001 || erro > tolerancia;
+    }
+
+    cout << (falhou ? "FALHA: matrizes ou contagens divergem" : "OK: matrizes iguais à referência") << endl;
+    return falhou ? 1 : 0;
+}
@@ -0,0 +1,219 @@
+/*	Benchmark de vértices: matriz das normais no shader x na CPU
+    Desenha um modelo denso (SuzanneSubdiv1 por padrão) várias vezes por
+    quadro numa janela oculta, com dois vertex shaders:
+      A) vNormal = mat3(transpose(inverse(model))) * normal   (como era em M4-M6)
+      B) vNormal = normalMatrix * normal, com a matriz calculada na CPU
+    O tempo de GPU vem de queries GL_TIME_ELAPSED; o viewport é pequeno
+    para que o custo fique no processamento de vértices e não nos
+    fragmentos. Também mede o custo de CPU de matrizNormal() com escala
+    qualquer (inversa 3x3) e com escala uniforme (sem inversa).
+
+    Uso: BenchNormais [modelo.obj] [objetos_por_quadro] [quadros]
+*/
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+
+#include "CacheMalha.h"
+#include "ProgramaShader.h"
+#include "Transformacoes.h"
+
+using namespace std;
+
+const char* vsInversa = R"(
+#version 330 core
+layout(location = 0) in vec3 pos;
+layout(location = 2) in vec3 normal;
+uniform mat4 model;
+uniform mat4 viewProjection;
+out vec3 vNormal;
+void main() {
+    vNormal = mat3(transpose(inverse(model))) * normal;
+    gl_Position = viewProjection * model * vec4(pos, 1.0);
+}
+)";
+
+const char* vsMatrizNormal = R"(
+#version 330 core
+layout(location = 0) in vec3 pos;
+layout(location = 2) in vec3 normal;
+uniform mat4 model;
+uniform mat3 normalMatrix;
+uniform mat4 viewProjection;
+out vec3 vNormal;
+void main() {
+    vNormal = normalMatrix * normal;
+    gl_Position = viewProjection * model * vec4(pos, 1.0);
+}
+)";
+
+const char* fsNormal = R"(
+#version 330 core
+in vec3 vNormal;
+out vec4 FragColor;
+void main() {
+    FragColor = vec4(normalize(vNormal) * 0.5 + 0.5, 1.0);
+}
+)";
+
+GLuint compilarPrograma(const char* vs, const char* fs) {
+    GLuint v = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(v, 1, &vs, nullptr);
+    glCompileShader(v);
+    GLuint f = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(f, 1, &fs, nullptr);
+    glCompileShader(f);
+    GLuint prog = glCreateProgram();
+    glAttachShader(prog, v);
+    glAttachShader(prog, f);
+    glLinkProgram(prog);
+    GLint ok;
+    glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[512];
+        glGetProgramInfoLog(prog, 512, nullptr, log);
+        cerr << "Erro ao linkar shader: " << log << endl;
+    }
+    glDeleteShader(v);
+    glDeleteShader(f);
+    return prog;
+}
+
+struct Instancia {
+    glm::vec3 pos, rot, escala;
+};
+
+struct Medida {
+    double msGPU = 0.0;       // por quadro
+    double usCPUNormais = 0.0; // por quadro, só o cálculo das matrizes das normais
+};
+
+Medida medir(ProgramaShader& shader, bool matrizNaCPU, bool uniforme, const vector<Instancia>& objetos,
+             GLuint vao, GLsizei nIndices, GLenum tipoIndice, int quadros) {
+    UniformShader uModel = shader.uniform("model");
+    UniformShader uNormalMatrix = shader.uniform("normalMatrix");
+    shader.usar();
+    shader.definir("viewProjection", glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f) *
+                                     glm::lookAt(glm::vec3(0, 0, 12), glm::vec3(0.0f), glm::vec3(0, 1, 0)));
+    glBindVertexArray(vao);
+
+    GLuint query;
+    glGenQueries(1, &query);
+    Medida m;
+    for (int q = -1; q < quadros; ++q) { // o quadro -1 só aquece
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        double usCPU = 0.0;
+        for (const Instancia& obj : objetos) {
+            glm::vec3 escala = uniforme ? glm::vec3(obj.escala.x) : obj.escala;
+            glm::mat4 model = matrizModelo(obj.pos, obj.rot, escala);
+            shader.definir(uModel, model);
+            if (matrizNaCPU) {
+                auto inicio = chrono::steady_clock::now();
+                glm::mat3 normal = matrizNormal(model, uniforme);
+                usCPU += chrono::duration<double, micro>(chrono::steady_clock::now() - inicio).count();
+                shader.definir(uNormalMatrix, normal);
+            }
+            glDrawElements(GL_TRIANGLES, nIndices, tipoIndice, 0);
+        }
+        glEndQuery(GL_TIME_ELAPSED);
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+        if (q >= 0) {
+            m.msGPU += ns / 1e6;
+            m.usCPUNormais += usCPU;
+        }
+    }
+    glDeleteQueries(1, &query);
+    m.msGPU /= quadros;
+    m.usCPUNormais /= quadros;
+    return m;
+}
+
+int main(int argc, char** argv) {
+    string modelo = argc > 1 ? argv[1] : "../assets/Modelos3D/SuzanneSubdiv1.obj";
+    int nObjetos = argc > 2 ? atoi(argv[2]) : 200;
+    int quadros = argc > 3 ? atoi(argv[3]) : 20;
+
+    if (!glfwInit()) {
+        cerr << "Erro ao inicializar GLFW" << endl;
+        return -1;
+    }
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(32, 32, "BenchNormais", nullptr, nullptr);
+    if (!window) {
+        cerr << "Erro ao criar janela" << endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        cerr << "Erro ao inicializar GLAD" << endl;
+        return -1;
+    }
+    glViewport(0, 0, 32, 32);
+    glEnable(GL_DEPTH_TEST);
+
+    MalhaCacheada malha;
+    if (!carregarMalhaCacheada(modelo, malha)) {
+        cerr << "Arquivo não encontrado: " << modelo << endl;
+        return 1;
+    }
+    GLuint vbo, ebo, vao;
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, malha.bytesVertices(), malha.vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, malha.bytesIndices(), malha.indices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (void*)(6 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(2);
+    GLenum tipoIndice = malha.indices16Bits() ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+    // Grade de objetos com rotações e escala não uniforme variadas
+    vector<Instancia> objetos;
+    srand(42);
+    auto aleatorio = [] { return rand() / (float)RAND_MAX; };
+    for (int i = 0; i < nObjetos; ++i) {
+        objetos.push_back({ glm::vec3(aleatorio() * 8 - 4, aleatorio() * 8 - 4, aleatorio() * -8),
+                            glm::vec3(aleatorio(), aleatorio(), aleatorio()) * 6.28f,
+                            glm::vec3(0.5f + aleatorio(), 0.5f + aleatorio(), 0.5f + aleatorio()) });
+    }
+
+    ProgramaShader inversa(compilarPrograma(vsInversa, fsNormal));
+    ProgramaShader naCPU(compilarPrograma(vsMatrizNormal, fsNormal));
+
+    double verticesPorQuadro = (double)malha.nVertices() * nObjetos;
+    cout << modelo << ": " << malha.nVertices() << " vértices, " << malha.nIndices() / 3 << " triângulos, "
+         << nObjetos << " objetos por quadro, " << quadros << " quadros" << endl;
+    cout << left << setw(34) << "caminho" << right << setw(12) << "GPU ms" << setw(14) << "Mvértices/s"
+         << setw(18) << "CPU normais us" << endl;
+
+    auto linha = [&](const char* nome, const Medida& m) {
+        cout << left << setw(34) << nome << right << fixed
+             << setw(12) << setprecision(3) << m.msGPU
+             << setw(14) << setprecision(1) << verticesPorQuadro / (m.msGPU * 1e3)
+             << setw(18) << setprecision(1) << m.usCPUNormais << endl;
+    };
+    Medida a = medir(inversa, false, false, objetos, vao, malha.nIndices(), tipoIndice, quadros);
+    Medida b = medir(naCPU, true, false, objetos, vao, malha.nIndices(), tipoIndice, quadros);
+    Medida c = medir(naCPU, true, true, objetos, vao, malha.nIndices(), tipoIndice, quadros);
+    linha("inverse() por vértice", a);
+    linha("mat3 na CPU, escala qualquer", b);
+    linha("mat3 na CPU, escala uniforme", c);
+    cout << "speedup de GPU: " << setprecision(2) << a.msGPU / b.msGPU << "x" << endl;
+
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,166 @@
+/*	Benchmark do carregador de OBJ
+    Compara o laço antigo de carregarOBJ (getline + istringstream + sscanf)
+    com o leitor mapeado em memória de Common/CarregadorOBJ.h.
+    Não abre janela nem cria contexto OpenGL: mede apenas o trabalho de CPU
+    até o buffer intercalado de 11 floats que vai para o VBO, e o tamanho
+    do VBO/EBO quando a malha é indexada (indexarMalha). Por fim compara a
+    carga a frio (texto + gravação do .malha) com a carga pelo cache.
+
+    Uso: BenchOBJ [pasta_dos_modelos] [repeticoes]
+    Retorna 1 se os leitores divergirem (tamanho ou diferença acima de
+    TOLERANCIA) ou se o .malha recém-gravado não for usado.
+*/
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "CacheMalha.h"
+
+using namespace std;
+
+// Cópia do laço original de carregarOBJ (M4-M6), sem a parte de OpenGL
+bool carregarOBJAntigo(const string& objPath, vector<float>& buffer) {
+    vector<glm::vec3> pos;
+    vector<glm::vec3> norm;
+    vector<glm::vec2> tex;
+    buffer.clear();
+    ifstream arq(objPath);
+    if (!arq.is_open()) return false;
+    string line;
+    while (getline(arq, line)) {
+        istringstream iss(line);
+        string t; iss >> t;
+        if (t == "v") {
+            glm::vec3 v; iss >> v.x >> v.y >> v.z; pos.push_back(v);
+        } else if (t == "vn") {
+            glm::vec3 n; iss >> n.x >> n.y >> n.z; norm.push_back(n);
+        } else if (t == "vt") {
+            glm::vec2 vt; iss >> vt.x >> vt.y; tex.push_back(vt);
+        } else if (t == "f") {
+            for (int i = 0; i < 3; ++i) {
+                string f; iss >> f;
+                int vi, ti, ni;
+                sscanf(f.c_str(), "%d/%d/%d", &vi, &ti, &ni);
+                vi--; ti--; ni--;
+                glm::vec3 v = pos[vi];
+                glm::vec3 n = norm[ni];
+                glm::vec2 t = tex[ti];
+                t.y = 1.0f - t.y;
+                buffer.push_back(v.x); buffer.push_back(v.y); buffer.push_back(v.z);
+                buffer.push_back(1.0f); buffer.push_back(1.0f); buffer.push_back(1.0f);
+                buffer.push_back(n.x); buffer.push_back(n.y); buffer.push_back(n.z);
+                buffer.push_back(t.x); buffer.push_back(t.y);
+            }
+        }
+    }
+    return true;
+}
+
+bool carregarOBJNovo(const string& objPath, vector<float>& buffer) {
+    MalhaOBJ malha;
+    if (!lerOBJ(objPath, malha)) return false;
+    expandirMalha(malha, buffer);
+    return true;
+}
+
+template <typename F>
+double medirSegundos(int repeticoes, F&& f) {
+    auto inicio = chrono::steady_clock::now();
+    for (int i = 0; i < repeticoes; ++i) f();
+    chrono::duration<double> d = chrono::steady_clock::now() - inicio;
+    return d.count() / repeticoes;
+}
+
+// Os dois leitores convertem o mesmo texto: só arredondamento de float
+const float TOLERANCIA = 1e-5f;
+
+int main(int argc, char** argv) {
+    string pasta = argc > 1 ? argv[1] : "../assets/Modelos3D/";
+    int repeticoes = argc > 2 ? atoi(argv[2]) : 20;
+    if (!pasta.empty() && pasta.back() != '/' && pasta.back() != '\\') pasta += '/';
+    bool falhou = false;
+
+    const char* modelos[] = { "Cube.obj", "Suzanne.obj", "SuzanneSubdiv1.obj" };
+
+    cout << left << setw(20) << "modelo" << setw(10) << "leitor"
+         << right << setw(12) << "ms" << setw(12) << "MB/s" << setw(16) << "vertices/s" << endl;
+
+    for (const char* nome : modelos) {
+        string caminho = pasta + nome;
+        ArquivoMapeado arq(caminho);
+        if (!arq.aberto()) {
+            cout << "Arquivo não encontrado: " << caminho << endl;
+            continue;
+        }
+        double mb = arq.tamanho() / (1024.0 * 1024.0);
+        arq.fechar();
+
+        vector<float> antigo, novo;
+        double tAntigo = medirSegundos(repeticoes, [&] { carregarOBJAntigo(caminho, antigo); });
+        double tNovo = medirSegundos(repeticoes, [&] { carregarOBJNovo(caminho, novo); });
+        double nVertices = novo.size() / FLOATS_POR_VERTICE;
+
+        auto linha = [&](const char* leitor, double t) {
+            cout << left << setw(20) << nome << setw(10) << leitor << right << fixed
+                 << setw(12) << setprecision(3) << t * 1000.0
+                 << setw(12) << setprecision(1) << mb / t
+                 << setw(16) << setprecision(0) << nVertices / t << endl;
+        };
+        linha("antigo", tAntigo);
+        linha("mapeado", tNovo);
+
+        // Confere se os dois leitores produzem o mesmo buffer
+        float difMax = 0.0f;
+        bool mesmoTamanho = antigo.size() == novo.size();
+        for (size_t i = 0; mesmoTamanho && i < novo.size(); ++i)
+            difMax = max(difMax, fabs(antigo[i] - novo[i]));
+        bool equivalentes = mesmoTamanho && difMax <= TOLERANCIA;
+        falhou |= !equivalentes;
+        cout << "  " << (equivalentes ? "buffers equivalentes"
+                                      : mesmoTamanho ? "FALHA: BUFFERS DIFERENTES" : "FALHA: TAMANHOS DIFERENTES")
+             << ", diferença máxima " << scientific << difMax
+             << ", speedup " << fixed << setprecision(1) << tAntigo / tNovo << "x" << endl;
+
+        // Saída indexada: VBO com vértices únicos + EBO
+        MalhaOBJ malha;
+        lerOBJ(caminho, malha);
+        MalhaIndexada indexada;
+        double tIndexar = medirSegundos(repeticoes, [&] { indexarMalha(malha, indexada); });
+        size_t bytesAntes = novo.size() * sizeof(float);
+        size_t bytesVBO = indexada.vertices.size() * sizeof(float);
+        size_t bytesEBO = indexada.indices.size() * (indexada.indices16Bits() ? 2 : 4);
+        cout << "  indexado: " << indexada.nVertices() << " vértices únicos de " << indexada.indices.size()
+             << " (" << setprecision(1) << 100.0 * indexada.nVertices() / indexada.indices.size() << "%), "
+             << "VBO " << bytesAntes << " -> " << bytesVBO << " bytes + EBO " << bytesEBO
+             << " bytes (" << (indexada.indices16Bits() ? 16 : 32) << " bits), "
+             << setprecision(3) << tIndexar * 1000.0 << " ms" << endl;
+
+        // Cache binário: a frio (apaga o .malha antes) e a quente (só mmap)
+        string cache = cacheMalha::caminhoCache(caminho, true);
+        double tFrio = medirSegundos(repeticoes, [&] {
+            remove(cache.c_str());
+            MalhaCacheada m;
+            carregarMalhaCacheada(caminho, m);
+        });
+        bool doCache = false;
+        double tQuente = medirSegundos(repeticoes, [&] {
+            MalhaCacheada m;
+            carregarMalhaCacheada(caminho, m);
+            doCache = m.doCache;
+        });
+        cout << "  cache .malha: frio " << setprecision(3) << tFrio * 1000.0 << " ms, quente "
+             << tQuente * 1000.0 << " ms" << (doCache ? "" : " (FALHA: CACHE NÃO USADO)")
+             << ", speedup " << setprecision(1) << tFrio / tQuente << "x" << endl;
+        falhou |= !doCache;
+    }
+    cout << (falhou ? "FALHA" : "OK") << endl;
+    return falhou ? 1 : 0;
+}
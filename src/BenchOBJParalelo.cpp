@@ -0,0 +1,173 @@
+/*	Benchmark da leitura de OBJ em paralelo (lerOBJParalelo)
+    1) Confere que lerOBJParalelo gera exatamente os mesmos bytes que lerOBJ
+       em SuzanneSubdiv1.obj, dividindo o arquivo em 2..16 blocos, e num OBJ
+       pequeno com índices relativos que apontam antes do primeiro vértice.
+    2) Gera um OBJ sintético com nFaces triângulos (10 milhões por padrão),
+       metade deles com índices negativos (relativos), e compara leitura
+       serial e paralela com 1..N threads, conferindo o resultado.
+
+    Uso: BenchOBJParalelo [pasta_dos_modelos] [nFaces] [arquivo_sintetico]
+    Retorna 1 se alguma leitura paralela divergir da serial.
+*/
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "CarregadorOBJ.h"
+
+using namespace std;
+
+bool malhasIguais(const MalhaOBJ& a, const MalhaOBJ& b) {
+    auto iguais = [](const auto& x, const auto& y) {
+        return x.size() == y.size() && (x.empty() || memcmp(x.data(), y.data(), x.size() * sizeof(x[0])) == 0);
+    };
+    if (!iguais(a.posicoes, b.posicoes) || !iguais(a.texCoords, b.texCoords) ||
+        !iguais(a.normais, b.normais) || !iguais(a.cantos, b.cantos) || a.mtllib != b.mtllib) return false;
+    vector<float> bufA, bufB;
+    expandirMalha(a, bufA);
+    expandirMalha(b, bufB);
+    return iguais(bufA, bufB);
+}
+
+// Grade de (largura x altura) vértices, escrita linha a linha: cada faixa de
+// faces vem logo depois dos vértices que usa, e as faixas ímpares usam
+// índices negativos, que portanto cruzam as fronteiras dos blocos.
+bool gerarOBJSintetico(const string& caminho, size_t nFaces) {
+    const int largura = 1001;
+    const size_t facesPorFaixa = 2 * (largura - 1);
+    size_t faixas = (nFaces + facesPorFaixa - 1) / facesPorFaixa;
+
+    FILE* f = fopen(caminho.c_str(), "wb");
+    if (!f) return false;
+    vector<char> buf(1 << 20);
+    setvbuf(f, buf.data(), _IOFBF, buf.size());
+
+    fprintf(f, "# OBJ sintético: %zu faces\n", faixas * facesPorFaixa);
+    for (int c = 0; c < largura; ++c) fprintf(f, "vt %.6f 0.5\n", c / (float)(largura - 1));
+    size_t escritas = 0;
+    for (size_t linha = 0; linha <= faixas; ++linha) {
+        for (int c = 0; c < largura; ++c)
+            fprintf(f, "v %.6f %.6f %.6f\n", c * 0.01f, linha * 0.01f, 0.001f * ((c * 7 + linha * 13) % 17));
+        fprintf(f, "vn 0.000000 0.000000 1.000000\n");
+        if (linha == 0) continue;
+
+        bool relativa = linha % 2 == 1;
+        long long nV = (long long)(linha + 1) * largura;  // vértices lidos até aqui
+        long long nN = (long long)(linha + 1);             // normais lidas até aqui
+        for (int c = 0; c + 1 < largura && escritas < nFaces; ++c) {
+            long long a = (long long)(linha - 1) * largura + c + 1; // base 1
+            long long b = a + 1, d = a + largura, e = d + 1;
+            long long ta = c + 1, tb = c + 2;
+            long long n = (long long)linha + 1;
+            if (relativa) {
+                a -= nV + 1; b -= nV + 1; d -= nV + 1; e -= nV + 1;
+                ta -= largura + 1; tb -= largura + 1;
+                n -= nN + 1;
+            }
+            fprintf(f, "f %lld/%lld/%lld %lld/%lld/%lld %lld/%lld/%lld\n", a, ta, n, b, tb, n, e, tb, n);
+            fprintf(f, "f %lld/%lld/%lld %lld/%lld/%lld %lld/%lld/%lld\n", a, ta, n, e, tb, n, d, ta, n);
+            escritas += 2;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+// Faces com índices relativos válidos e fora do intervalo (antes do primeiro
+// v/vt/vn), espalhadas pelo arquivo para caírem em blocos diferentes
+bool gerarOBJRelativosInvalidos(const string& caminho) {
+    FILE* f = fopen(caminho.c_str(), "wb");
+    if (!f) return false;
+    for (int i = 0; i < 64; ++i) {
+        fprintf(f, "v %d.0 %d.5 0.0\nvt 0.%d 0.5\nvn 0.0 0.0 1.0\n", i, i, i % 10);
+        fprintf(f, "f -1/-1/-1 -2/-2/-2 -%d/-%d/-%d\n", 3 + i * 7, 2 + i * 5, 1 + i * 3);
+    }
+    fclose(f);
+    return true;
+}
+
+template <typename F>
+double medirSegundos(F&& f) {
+    auto inicio = chrono::steady_clock::now();
+    f();
+    chrono::duration<double> d = chrono::steady_clock::now() - inicio;
+    return d.count();
+}
+
+int main(int argc, char** argv) {
+    string pasta = argc > 1 ? argv[1] : "../assets/Modelos3D/";
+    size_t nFaces = argc > 2 ? strtoull(argv[2], nullptr, 10) : 10000000;
+    string sintetico = argc > 3 ? argv[3] : "obj_sintetico.obj";
+    if (!pasta.empty() && pasta.back() != '/' && pasta.back() != '\\') pasta += '/';
+    unsigned nucleos = max(1u, thread::hardware_concurrency());
+    bool falhou = false;
+
+    // 1) Modelo real
+    string subdiv = pasta + "SuzanneSubdiv1.obj";
+    MalhaOBJ serial;
+    if (!lerOBJ(subdiv, serial)) {
+        cout << "Arquivo não encontrado: " << subdiv << endl;
+        return 1;
+    }
+    for (unsigned n : { 2u, 3u, 4u, 7u, 8u, 16u }) {
+        MalhaOBJ paralela;
+        lerOBJParalelo(subdiv, paralela, n);
+        bool ok = malhasIguais(serial, paralela);
+        falhou |= !ok;
+        cout << "SuzanneSubdiv1.obj, " << setw(2) << n << " blocos: " << (ok ? "idêntico" : "DIFERENTE") << endl;
+    }
+
+    string invalidos = sintetico + ".relativos.obj";
+    if (gerarOBJRelativosInvalidos(invalidos)) {
+        MalhaOBJ serialInvalidos;
+        lerOBJ(invalidos, serialInvalidos);
+        for (unsigned n : { 2u, 3u, 4u, 7u }) {
+            MalhaOBJ paralela;
+            lerOBJParalelo(invalidos, paralela, n);
+            bool ok = malhasIguais(serialInvalidos, paralela);
+            // Fora do intervalo vira -1 (ausente), nunca um índice negativo qualquer
+            for (const CantoOBJ& c : paralela.cantos)
+                ok &= c.v >= -1 && c.v < (int)paralela.posicoes.size() && c.vt >= -1 && c.vn >= -1;
+            falhou |= !ok;
+            cout << "relativos fora do intervalo, " << n << " blocos: " << (ok ? "idêntico" : "DIFERENTE") << endl;
+        }
+        remove(invalidos.c_str());
+    }
+
+    // 2) Arquivo sintético grande
+    cout << "Gerando " << sintetico << " com " << nFaces << " faces..." << endl;
+    if (!gerarOBJSintetico(sintetico, nFaces)) {
+        cout << "Não foi possível gravar " << sintetico << endl;
+        return 1;
+    }
+    ArquivoMapeado arq(sintetico);
+    double mb = arq.tamanho() / (1024.0 * 1024.0);
+    arq.fechar();
+
+    MalhaOBJ referencia;
+    double tSerial = medirSegundos([&] { lerOBJ(sintetico, referencia); });
+    cout << fixed << setprecision(1) << mb << " MB, " << referencia.cantos.size() / 3 << " triângulos" << endl;
+    cout << "  serial      " << setprecision(3) << setw(8) << tSerial << " s  "
+         << setprecision(1) << setw(8) << mb / tSerial << " MB/s" << endl;
+
+    for (unsigned n = 1; n <= max(nucleos, 2u); n *= 2) {
+        MalhaOBJ paralela;
+        double t = medirSegundos([&] { lerOBJParalelo(sintetico, paralela, n); });
+        bool ok = malhasIguais(referencia, paralela);
+        falhou |= !ok;
+        cout << "  " << setw(2) << n << " threads  " << setprecision(3) << setw(8) << t << " s  "
+             << setprecision(1) << setw(8) << mb / t << " MB/s  speedup " << setprecision(2) << tSerial / t << "x  "
+             << (ok ? "idêntico" : "DIFERENTE") << endl;
+    }
+    remove(sintetico.c_str());
+
+    cout << (falhou ? "FALHA: leitura paralela divergiu da serial" : "OK: leitura paralela idêntica à serial") << endl;
+    return falhou ? 1 : 0;
+}
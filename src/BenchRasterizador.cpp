@@ -0,0 +1,174 @@
+/*	Benchmark do RasterizadorSoftware
+    Desenha Suzanne (com a textura do .mtl, ou um xadrez se ela não for
+    encontrada) numa grade de cópias que enche a tela, com a luz e a câmera
+    do M6, e mede o quadro completo (vértices, montagem e tiles) com 1, 2,
+    4... até todos os núcleos, no caminho AVX2 e no escalar.
+
+    Mpixels/s conta os pixels da imagem por segundo (quadros/s * largura *
+    altura); os pixels sombreados e os blocos rejeitados pelo Z hierárquico
+    aparecem à parte. Confere também que a imagem não muda com o número de
+    threads e que o caminho AVX2 fica a no máximo 2 unidades por canal do
+    escalar.
+
+    Uso: BenchRasterizador [modelo.obj] [largura altura] [quadros] [saida.ppm]
+    Retorna 1 se alguma imagem divergir.
+*/
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include <thread>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "CacheMalha.h"
+#include "RasterizadorSoftware.h"
+
+using namespace std;
+
+template <typename F>
+double medirSegundos(F&& f) {
+    auto inicio = chrono::steady_clock::now();
+    f();
+    chrono::duration<double> d = chrono::steady_clock::now() - inicio;
+    return d.count();
+}
+
+// Maior diferença por canal e quantos pixels diferem em mais que limite
+void comparar(const vector<uint32_t>& a, const vector<uint32_t>& b, int& maior, size_t& acima, int limite) {
+    maior = 0;
+    acima = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        int d = 0;
+        for (int c = 0; c < 3; ++c) d = max(d, abs((int)((a[i] >> (8 * c)) & 0xFF) - (int)((b[i] >> (8 * c)) & 0xFF)));
+        maior = max(maior, d);
+        acima += d > limite;
+    }
+}
+
+int main(int argc, char** argv) {
+    string modelo = argc > 1 ? argv[1] : "../assets/Modelos3D/Suzanne.obj";
+    int largura = argc > 3 ? atoi(argv[2]) : 1920;
+    int altura = argc > 3 ? atoi(argv[3]) : 1080;
+    int quadros = argc > 4 ? atoi(argv[4]) : 10;
+    string saida = argc > 5 ? argv[5] : "";
+    unsigned nucleos = max(1u, thread::hardware_concurrency());
+    bool temAVX2 = false;
+#ifdef TRANSFORMACOES_AVX2
+    temAVX2 = transformacoesSoA::temAVX2();
+#endif
+
+    MalhaCacheada malha;
+    if (!carregarMalhaCacheada(modelo, malha)) {
+        cerr << "Arquivo não encontrado: " << modelo << endl;
+        return 1;
+    }
+    TexturaSoftware textura;
+    int w = 0, h = 0, c = 0;
+    unsigned char* pixels = malha.material.mapKd.empty()
+                                ? nullptr
+                                : stbi_load((malha.diretorio + malha.material.mapKd).c_str(), &w, &h, &c, 0);
+    if (pixels) {
+        textura.criar(pixels, w, h, c);
+        stbi_image_free(pixels);
+    } else {
+        w = h = 256;
+        vector<unsigned char> xadrez((size_t)w * h * 3);
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                for (int k = 0; k < 3; ++k) xadrez[((size_t)y * w + x) * 3 + k] = ((x / 32 + y / 32) % 2) ? 230 : 40 + 60 * k;
+        textura.criar(xadrez.data(), w, h, 3);
+    }
+
+    // Grade 5x3 de cópias, de frente para a câmera, com as de trás parcialmente escondidas
+    vector<glm::mat4> modelos;
+    for (int linha = 0; linha < 3; ++linha)
+        for (int coluna = 0; coluna < 5; ++coluna)
+            modelos.push_back(matrizModelo(glm::vec3((coluna - 2) * 1.6f, (linha - 1) * 1.5f, -(float)((coluna + linha) % 3)),
+                                           glm::vec3(0.0f, 0.3f * (coluna - 2), 0.0f), glm::vec3(1.0f)));
+    glm::vec3 camPos(0.0f, 0.0f, 6.0f), lightPos(2.0f, 2.0f, 2.0f);
+    glm::mat4 view = glm::lookAt(camPos, glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0, 1, 0));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)largura / altura, 0.1f, 100.0f);
+    size_t triangulosQuadro = malha.nIndices() / 3 * modelos.size();
+
+    RasterizadorSoftware raster;
+    raster.redimensionar(largura, altura);
+    auto desenharQuadro = [&](unsigned threads) {
+        raster.definirQuadro(view, projection, lightPos, camPos);
+        raster.limpar(glm::vec3(0.1f));
+        for (const glm::mat4& model : modelos)
+            raster.desenhar(malha.vertices, malha.nVertices(), malha.indices, malha.nIndices(), malha.indices16Bits(), model,
+                            &textura, malha.material);
+        raster.executar(threads);
+    };
+    auto copiar = [&] {
+        vector<uint32_t> imagem((size_t)largura * altura);
+        for (int y = 0; y < altura; ++y)
+            for (int x = 0; x < largura; ++x) imagem[(size_t)y * largura + x] = raster.pixel(x, y);
+        return imagem;
+    };
+
+    cout << modelo << " (" << malha.nIndices() / 3 << " triângulos) x " << modelos.size() << " em " << largura << "x"
+         << altura << ", textura " << textura.largura() << "x" << textura.altura() << " (" << textura.niveis()
+         << " níveis), " << nucleos << " núcleos, AVX2 " << (temAVX2 ? "disponível" : "indisponível") << endl;
+    cout << left << setw(10) << "caminho" << right << setw(9) << "threads" << setw(11) << "ms/quadro" << setw(12)
+         << "Mpixels/s" << setw(15) << "Mtriângulos/s" << setw(10) << "speedup" << endl;
+
+    vector<unsigned> contagens;
+    for (unsigned n = 1; n < max(2u, nucleos); n *= 2) contagens.push_back(n);
+    contagens.push_back(max(2u, nucleos));
+
+    bool falhou = false;
+    vector<uint32_t> referencia[2];
+    for (int simd = temAVX2 ? 1 : 0; simd >= 0; --simd) {
+        raster.usarAVX2 = simd == 1;
+        double t1 = 0.0;
+        for (unsigned threads : contagens) {
+            desenharQuadro(threads); // aquece
+            double t = medirSegundos([&] {
+                for (int q = 0; q < quadros; ++q) desenharQuadro(threads);
+            }) / quadros;
+            if (threads == 1) t1 = t;
+            cout << left << setw(10) << (simd ? "AVX2" : "escalar") << right << setw(9) << threads << fixed
+                 << setprecision(2) << setw(11) << t * 1e3 << setprecision(1) << setw(12)
+                 << (double)largura * altura / t / 1e6 << setprecision(2) << setw(14) << triangulosQuadro / t / 1e6
+                 << setprecision(2) << setw(9) << t1 / t << "x" << endl;
+
+            vector<uint32_t> imagem = copiar();
+            if (referencia[simd].empty()) {
+                referencia[simd] = imagem;
+            } else if (imagem != referencia[simd]) {
+                cout << "FALHA: a imagem com " << threads << " threads difere da de 1 thread" << endl;
+                falhou = true;
+            }
+        }
+    }
+
+    const EstatisticasRaster& e = raster.estatisticas;
+    cout << e.triangulos << " triângulos, " << e.descartados << " descartados, " << e.recortados << " recortados; "
+         << e.pixelsSombreados << " pixels sombreados (" << fixed << setprecision(2)
+         << (double)e.pixelsSombreados / ((double)largura * altura) << " por pixel), " << e.rejeitadosHiZ
+         << " blocos 8x8 rejeitados pelo Z hierárquico" << endl;
+
+    if (temAVX2) {
+        int maior;
+        size_t acima;
+        comparar(referencia[0], referencia[1], maior, acima, 2);
+        cout << "AVX2 x escalar: maior diferença " << maior << " por canal, " << acima << " pixels acima de 2" << endl;
+        falhou |= acima != 0;
+    }
+    if (!saida.empty()) {
+        raster.usarAVX2 = temAVX2;
+        desenharQuadro(0);
+        cout << (raster.gravarPPM(saida) ? "imagem gravada em " : "não foi possível gravar ") << saida << endl;
+    }
+    cout << (falhou ? "FALHA" : "OK") << endl;
+    return falhou ? 1 : 0;
+}
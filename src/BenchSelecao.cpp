@@ -0,0 +1,159 @@
+/*	Benchmark do picking (Selecao.h)
+    Instancia um modelo (SuzanneSubdiv1 por padrão) nInstancias vezes numa
+    grade como a do modo de estresse do M5, monta a BVHCena e dispara
+    raios por pixels aleatórios de uma câmera que olha a grade. Mede o
+    tempo médio e o pior tempo por seleção (a meta é ficar abaixo de 1 ms)
+    e confere alguns raios contra força bruta: todos os triângulos de todas
+    as instâncias cuja AABB o raio cruza, com Möller-Trumbore escalar.
+
+    Uso: BenchSelecao [modelo.obj] [nInstancias] [nRaios]
+    Retorna 1 se alguma seleção divergir da força bruta.
+*/
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+
+#include "CacheMalha.h"
+#include "Selecao.h"
+#include "Transformacoes.h"
+
+using namespace std;
+
+template <typename F>
+double medirSegundos(F&& f) {
+    auto inicio = chrono::steady_clock::now();
+    f();
+    chrono::duration<double> d = chrono::steady_clock::now() - inicio;
+    return d.count();
+}
+
+// Möller-Trumbore escalar de referência
+bool raioTriangulo(const glm::vec3& o, const glm::vec3& d, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, float& t) {
+    glm::vec3 e1 = b - a, e2 = c - a;
+    glm::vec3 p = glm::cross(d, e2);
+    float det = glm::dot(e1, p);
+    if (fabs(det) <= 1e-12f) return false;
+    float inv = 1.0f / det;
+    glm::vec3 tv = o - a;
+    float u = glm::dot(tv, p) * inv;
+    if (u < 0.0f || u > 1.0f) return false;
+    glm::vec3 q = glm::cross(tv, e1);
+    float v = glm::dot(d, q) * inv;
+    if (v < 0.0f || u + v > 1.0f) return false;
+    t = glm::dot(e2, q) * inv;
+    return t > 0.0f;
+}
+
+int main(int argc, char** argv) {
+    string modelo = argc > 1 ? argv[1] : "../assets/Modelos3D/SuzanneSubdiv1.obj";
+    int nInstancias = argc > 2 ? atoi(argv[2]) : 10000;
+    int nRaios = argc > 3 ? atoi(argv[3]) : 1000;
+    const int nConferidos = 20;
+    const int largura = 800, altura = 800;
+    bool falhou = false;
+
+    MalhaCacheada malha;
+    if (!carregarMalhaCacheada(modelo, malha)) {
+        cerr << "Arquivo não encontrado: " << modelo << endl;
+        return 1;
+    }
+    size_t nTriangulos = malha.nIndices() / 3;
+    BVHTriangulos bvhMalha;
+    malha.copiarBVH(bvhMalha);
+    BVHTriangulos reconstruida;
+    vector<uint32_t> indices(malha.nIndices());
+    for (size_t i = 0; i < indices.size(); ++i)
+        indices[i] = malha.indices16Bits() ? ((const uint16_t*)malha.indices)[i] : ((const uint32_t*)malha.indices)[i];
+    size_t floatsPorVertice = malha.cabecalho->floatsPorVertice;
+    double tMalha = medirSegundos([&] { reconstruida.construir(malha.vertices, floatsPorVertice, indices.data(), nTriangulos); });
+    cout << modelo << ": " << nTriangulos << " triângulos, BVH com " << bvhMalha.nosArvore().size() << " nós ("
+         << (malha.doCache ? "lida do cache" : "gerada agora") << "; construir leva " << fixed << setprecision(2)
+         << tMalha * 1e3 << " ms)" << endl;
+
+    // Grade igual à do modo de estresse do M5
+    int lado = (int)ceil(cbrt((double)nInstancias));
+    vector<glm::mat4> modelos(nInstancias);
+    vector<CaixaAlinhada> caixas(nInstancias);
+    for (int i = 0; i < nInstancias; ++i) {
+        glm::vec3 pos = glm::vec3(i % lado - lado / 2, (i / lado) % lado - lado / 2, -(i / (lado * lado))) * 2.0f;
+        modelos[i] = matrizModelo(pos, glm::vec3(0.0f, i * 0.1f, 0.0f), glm::vec3(1.0f));
+        caixas[i] = caixaMundo(modelos[i], malha.limites());
+    }
+    BVHCena bvh;
+    double tCena = medirSegundos([&] { bvh.construir(caixas); });
+    cout << nInstancias << " instâncias (" << (double)nInstancias * nTriangulos / 1e6 << " M triângulos), BVH da cena em "
+         << tCena * 1e3 << " ms" << endl;
+
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)largura / altura, 0.1f, 100.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f + lado), glm::vec3(0.0f, 0.0f, -lado), glm::vec3(0, 1, 0));
+    mt19937 gerador(7);
+    uniform_real_distribution<double> px(0.0, largura), py(0.0, altura);
+    vector<RaioSelecao> raios(nRaios);
+    for (RaioSelecao& r : raios) r = raioDaTela(px(gerador), py(gerador), largura, altura, projection, view);
+
+    auto modelDe = [&](uint32_t i) { return modelos[i]; };
+    auto malhaDe = [&](uint32_t) { return &bvhMalha; };
+    vector<Selecao> selecoes(nRaios);
+    double pior = 0.0, total = 0.0;
+    int acertos = 0;
+    for (int r = 0; r < nRaios; ++r) {
+        double t = medirSegundos([&] { selecoes[r] = selecionar(bvh, raios[r], modelDe, malhaDe); });
+        total += t;
+        pior = max(pior, t);
+        acertos += selecoes[r].acertou();
+    }
+    cout << nRaios << " seleções, " << acertos << " acertos: média " << setprecision(1) << total / nRaios * 1e6
+         << " us, pior " << pior * 1e6 << " us" << (pior < 1e-3 ? " (abaixo de 1 ms)" : " (ACIMA de 1 ms)") << endl;
+
+    // Força bruta nos primeiros raios
+    double tBruta = 0.0;
+    int iguais = 0;
+    for (int r = 0; r < min(nConferidos, nRaios); ++r) {
+        const RaioSelecao& raio = raios[r];
+        uint32_t melhorObjeto = BVHCena::NENHUM, melhorTriangulo = TRIANGULO_NENHUM;
+        float melhorT = FLT_MAX;
+        tBruta += medirSegundos([&] {
+            glm::vec3 inverso(1.0f / raio.direcao.x, 1.0f / raio.direcao.y, 1.0f / raio.direcao.z);
+            for (int i = 0; i < nInstancias; ++i) {
+                float tCaixa;
+                if (!raioNaCaixa(caixas[i], raio.origem, inverso, FLT_MAX, tCaixa)) continue;
+                for (size_t k = 0; k < nTriangulos; ++k) {
+                    glm::vec3 v[3];
+                    for (int c = 0; c < 3; ++c) {
+                        const float* p = malha.vertices + (size_t)indices[k * 3 + c] * floatsPorVertice;
+                        v[c] = glm::vec3(modelos[i] * glm::vec4(p[0], p[1], p[2], 1.0f));
+                    }
+                    float t;
+                    if (raioTriangulo(raio.origem, raio.direcao, v[0], v[1], v[2], t) && t < melhorT) {
+                        melhorT = t;
+                        melhorObjeto = i;
+                        melhorTriangulo = (uint32_t)k;
+                    }
+                }
+            }
+        });
+        const Selecao& s = selecoes[r];
+        bool ok = s.objeto == melhorObjeto &&
+                  (melhorObjeto == BVHCena::NENHUM || fabs(s.t - melhorT) <= 1e-3f * max(1.0f, melhorT));
+        if (ok && s.triangulo != melhorTriangulo) ok = fabs(s.t - melhorT) <= 1e-4f; // aresta compartilhada
+        iguais += ok;
+        if (!ok) {
+            cout << "  raio " << r << ": BVH objeto " << s.objeto << " tri " << s.triangulo << " t " << s.t
+                 << " / força bruta objeto " << melhorObjeto << " tri " << melhorTriangulo << " t " << melhorT << endl;
+        }
+    }
+    int conferidos = min(nConferidos, nRaios);
+    falhou = iguais != conferidos;
+    cout << "força bruta: " << setprecision(1) << tBruta / max(conferidos, 1) * 1e3 << " ms por raio, "
+         << iguais << "/" << conferidos << " iguais" << endl;
+    cout << (falhou ? "FALHA: seleção divergiu da força bruta" : "OK: seleção igual à força bruta") << endl;
+    return falhou ? 1 : 0;
+}
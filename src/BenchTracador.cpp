@@ -0,0 +1,142 @@
+/*	Benchmark do TracadorCaminhos
+    Uma grade 3x3 de Suzannes (cada uma faz sombra e rebate luz nas
+    vizinhas) com a luz e a câmera do M6, algumas amostras por pixel com
+    1, 2, 4... até todos os núcleos, traçando em pacotes de 8 raios (AVX2)
+    e um raio por vez. Mraios/s conta raios primários, de sombra e
+    indiretos.
+
+    Confere que a imagem não muda com o número de threads e que os dois
+    caminhos dão a mesma imagem: os acertos só diferem no arredondamento,
+    então bastam alguns pixels fora de 2 unidades por canal (um caminho
+    que desvia para outro triângulo) para falhar.
+
+    Uso: BenchTracador [modelo.obj] [largura altura] [amostras]
+    Retorna 1 se alguma imagem divergir.
+*/
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include <thread>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "CacheMalha.h"
+#include "Transformacoes.h"
+#include "TracadorCaminhos.h"
+
+using namespace std;
+
+template <typename F>
+double medirSegundos(F&& f) {
+    auto inicio = chrono::steady_clock::now();
+    f();
+    chrono::duration<double> d = chrono::steady_clock::now() - inicio;
+    return d.count();
+}
+
+int main(int argc, char** argv) {
+    string modelo = argc > 1 ? argv[1] : "../assets/Modelos3D/Suzanne.obj";
+    int largura = argc > 3 ? atoi(argv[2]) : 640;
+    int altura = argc > 3 ? atoi(argv[3]) : 360;
+    int amostras = argc > 4 ? atoi(argv[4]) : 4;
+    unsigned nucleos = max(1u, thread::hardware_concurrency());
+    bool temAVX2 = false;
+#ifdef TRANSFORMACOES_AVX2
+    temAVX2 = transformacoesSoA::temAVX2();
+#endif
+
+    MalhaCacheada malha;
+    if (!carregarMalhaCacheada(modelo, malha)) {
+        cerr << "Arquivo não encontrado: " << modelo << endl;
+        return 1;
+    }
+    TexturaSoftware textura;
+    int w = 0, h = 0, c = 0;
+    unsigned char* pixels = stbi_load("../assets/tex/pixelWall.png", &w, &h, &c, 0);
+    if (pixels) {
+        textura.criar(pixels, w, h, c);
+        stbi_image_free(pixels);
+    } else {
+        const unsigned char branco[4] = { 255, 255, 255, 255 };
+        textura.criar(branco, 1, 1, 4);
+    }
+
+    TracadorCaminhos tracador;
+    for (int linha = 0; linha < 3; ++linha)
+        for (int coluna = 0; coluna < 3; ++coluna)
+            tracador.adicionar(malha.vertices, malha.nVertices(), malha.indices, malha.nIndices(), malha.indices16Bits(),
+                               matrizModelo(glm::vec3((coluna - 1) * 1.8f, (linha - 1) * 1.6f, -(float)((coluna + linha) % 2)),
+                                            glm::vec3(0.0f, 0.4f * (coluna - 1), 0.0f), glm::vec3(1.0f)),
+                               &textura, malha.material);
+    double tBVH = medirSegundos([&] { tracador.construir(); });
+    glm::vec3 camPos(0.0f, 0.0f, 6.0f), lightPos(2.0f, 2.0f, 2.0f);
+    glm::mat4 view = glm::lookAt(camPos, glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0, 1, 0));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)largura / altura, 0.1f, 100.0f);
+    tracador.redimensionar(largura, altura);
+
+    cout << modelo << " x 9: " << tracador.triangulos() << " triângulos (BVH em " << fixed << setprecision(1)
+         << tBVH * 1e3 << " ms), " << largura << "x" << altura << ", " << amostras << " amostras, " << nucleos
+         << " núcleos, AVX2 " << (temAVX2 ? "disponível" : "indisponível") << endl;
+    cout << left << setw(16) << "caminho" << right << setw(9) << "threads" << setw(13) << "ms/amostra" << setw(12)
+         << "Mraios/s" << setw(10) << "speedup" << setw(10) << "roubos" << endl;
+
+    vector<unsigned> contagens;
+    for (unsigned n = 1; n < max(2u, nucleos); n *= 2) contagens.push_back(n);
+    contagens.push_back(max(2u, nucleos));
+
+    bool falhou = false;
+    vector<uint32_t> referencia[2];
+    for (int simd = temAVX2 ? 1 : 0; simd >= 0; --simd) {
+        tracador.usarAVX2 = simd == 1;
+        double t1 = 0.0;
+        for (unsigned threads : contagens) {
+            tracador.definirCamera(view, projection, lightPos);
+            EstatisticasTracado total;
+            double t = medirSegundos([&] {
+                for (int a = 0; a < amostras; ++a) {
+                    tracador.amostrar(threads);
+                    total.somar(tracador.estatisticas);
+                }
+            });
+            if (threads == 1) t1 = t;
+            cout << left << setw(16) << (simd ? "pacotes AVX2" : "um raio por vez") << right << setw(9) << threads
+                 << setprecision(2) << setw(13) << t / amostras * 1e3 << setw(12) << total.raios() / t / 1e6 << setw(9)
+                 << t1 / t << "x" << setw(10) << total.roubos << endl;
+
+            vector<uint32_t> imagem((size_t)largura * altura);
+            for (int y = 0; y < altura; ++y)
+                for (int x = 0; x < largura; ++x) imagem[(size_t)y * largura + x] = tracador.pixel(x, y);
+            if (referencia[simd].empty()) {
+                referencia[simd] = imagem;
+            } else if (imagem != referencia[simd]) {
+                cout << "FALHA: a imagem com " << threads << " threads difere da de 1 thread" << endl;
+                falhou = true;
+            }
+        }
+    }
+
+    if (temAVX2) {
+        int maior = 0;
+        size_t acima = 0;
+        for (size_t i = 0; i < referencia[0].size(); ++i) {
+            int d = 0;
+            for (int k = 0; k < 3; ++k)
+                d = max(d, abs((int)((referencia[0][i] >> (8 * k)) & 0xFF) - (int)((referencia[1][i] >> (8 * k)) & 0xFF)));
+            maior = max(maior, d);
+            acima += d > 2;
+        }
+        cout << "pacotes x um raio por vez: maior diferença " << maior << " por canal, " << acima << " pixels acima de 2"
+             << endl;
+        falhou |= acima * 1000 > referencia[0].size();
+    }
+    cout << (falhou ? "FALHA" : "OK") << endl;
+    return falhou ? 1 : 0;
+}
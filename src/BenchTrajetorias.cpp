@@ -0,0 +1,205 @@
+/*	Benchmark do SistemaTrajetorias
+    Para 1k, 10k e 100k objetos, cada um com sua curva fechada (4 ou 5
+    pontos aleatórios, centrípeta), mede um passo de animação:
+      A) por objeto: vector de pontos + Trajetoria próprios, posicao() e
+         definirPosicao() (o que o M6 fazia)
+      B) SistemaTrajetorias escalar
+      C) SistemaTrajetorias com AVX2, 1 thread
+      D) SistemaTrajetorias com AVX2, todos os núcleos (ao menos 2)
+    e confere as posições gravadas em B, C e D contra Trajetoria::posicao.
+
+    Depois, em passo fixo (PassoFixo.h, 120 Hz) com 100k objetos: quantos
+    passos só de simulação (avancar) cabem num segundo e quanto custa gravar
+    as posições interpoladas de um quadro. Com quadros de durações
+    aleatórias confere que o relógio dá floor(tempo total / passo) passos e
+    que cada quadro gravado fica na curva recuo segundos antes da distância
+    simulada, como Trajetoria::posicao(s - v * recuo).
+
+    Uso: BenchTrajetorias [repeticoes]
+    Retorna 1 se alguma posição divergir da referência.
+*/
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <algorithm>
+#include <thread>
+
+#include "SistemaTrajetorias.h"
+#include "PassoFixo.h"
+
+using namespace std;
+
+template <typename F>
+double medirSegundos(F&& f) {
+    auto inicio = chrono::steady_clock::now();
+    f();
+    chrono::duration<double> d = chrono::steady_clock::now() - inicio;
+    return d.count();
+}
+
+struct ObjetoAnimado {
+    vector<glm::vec3> pontosControle;
+    Trajetoria curva;
+    float distancia = 0.0f, velocidade = 0.0f;
+};
+
+// Cada objeto com sua curva fechada de 4 ou 5 pontos ao redor de um centro aleatório
+void montar(size_t nObjetos, vector<ObjetoAnimado>& objetos, TransformacoesSoA& transformacoes, SistemaTrajetorias& sistema) {
+    mt19937 gerador(7);
+    uniform_real_distribution<float> unitario(-1.0f, 1.0f);
+    objetos.assign(nObjetos, ObjetoAnimado());
+    transformacoes.reservar(nObjetos);
+    sistema.reservar(nObjetos);
+    for (size_t i = 0; i < nObjetos; ++i) {
+        ObjetoAnimado& o = objetos[i];
+        glm::vec3 centro = glm::vec3(unitario(gerador), unitario(gerador), unitario(gerador)) * 100.0f;
+        int nPontos = 4 + (int)(i % 2);
+        for (int p = 0; p < nPontos; ++p)
+            o.pontosControle.push_back(centro + glm::vec3(unitario(gerador), unitario(gerador), unitario(gerador)) * 5.0f);
+        o.curva.definir(o.pontosControle, TRAJETORIA_CENTRIPETA);
+        o.velocidade = 1.0f + 2.0f * (unitario(gerador) + 1.0f);
+        o.distancia = (unitario(gerador) + 1.0f) * 0.5f * o.curva.comprimento();
+
+        uint32_t id = transformacoes.adicionar(centro);
+        uint32_t t = sistema.adicionar(id, sistema.adicionarCurva(o.pontosControle, TRAJETORIA_CENTRIPETA), o.velocidade,
+                                       o.distancia);
+        sistema.definirAtiva(t, true);
+    }
+    transformacoes.atualizarCache();
+}
+
+int main(int argc, char** argv) {
+    int repeticoes = argc > 1 ? atoi(argv[1]) : 50;
+    unsigned nucleos = max(1u, thread::hardware_concurrency());
+    const float dt = 1.0f / 60.0f;
+    const float tolerancia = 1e-3f;
+    bool falhou = false;
+    bool temAVX2 = false;
+#ifdef TRANSFORMACOES_AVX2
+    temAVX2 = transformacoesSoA::temAVX2();
+#endif
+
+    cout << nucleos << " núcleos, " << repeticoes << " passos, AVX2 " << (temAVX2 ? "disponível" : "indisponível") << endl;
+    cout << left << setw(12) << "objetos" << setw(30) << "caminho" << right << setw(10) << "ms/passo" << setw(14)
+         << "Mobjetos/s" << setw(10) << "speedup" << setw(12) << "erro" << endl;
+
+    for (size_t nObjetos : { (size_t)1000, (size_t)10000, (size_t)100000 }) {
+        vector<ObjetoAnimado> objetos;
+        TransformacoesSoA transformacoes;
+        SistemaTrajetorias sistema;
+        montar(nObjetos, objetos, transformacoes, sistema);
+
+        double tA = medirSegundos([&] {
+            for (int r = 0; r < repeticoes; ++r)
+                for (size_t i = 0; i < nObjetos; ++i) {
+                    ObjetoAnimado& o = objetos[i];
+                    o.distancia = fmod(o.distancia + o.velocidade * dt, o.curva.comprimento());
+                    transformacoes.definirPosicao((uint32_t)i, o.curva.posicao(o.distancia));
+                }
+        }) / repeticoes;
+
+        auto linha = [&](const char* nome, double t, float erro) {
+            cout << left << setw(12) << nObjetos << setw(30) << nome << right << fixed << setprecision(3) << setw(10)
+                 << t * 1e3 << setprecision(1) << setw(14) << nObjetos / t / 1e6 << setw(9) << tA / t << "x" << setw(12)
+                 << scientific << setprecision(1) << erro << fixed << endl;
+        };
+        linha("por objeto (Trajetoria)", tA, 0.0f);
+
+        // Cada caminho parte do mesmo estado e anda os mesmos passos; a
+        // referência é Trajetoria::posicao na distância que o sistema guardou
+        auto medir = [&](const char* nome, bool avx2, unsigned threads) {
+            SistemaTrajetorias copia = sistema;
+            copia.usarAVX2 = avx2;
+            double t = medirSegundos([&] {
+                for (int r = 0; r < repeticoes; ++r) copia.atualizar(dt, transformacoes, threads);
+            }) / repeticoes;
+            float erro = 0.0f;
+            for (size_t i = 0; i < nObjetos; ++i) {
+                glm::vec3 esperada = objetos[i].curva.posicao(copia.distancia((uint32_t)i));
+                glm::vec3 obtida = transformacoes.posicao((uint32_t)i);
+                erro = max(erro, glm::length(obtida - esperada));
+                // O sistema acumula a distância como A: só diverge por arredondamento (ou uma volta)
+                float diferenca = fabs(copia.distancia((uint32_t)i) - objetos[i].distancia);
+                diferenca = min(diferenca, copia.comprimento((uint32_t)i) - diferenca);
+                if (diferenca > 1e-2f) erro = max(erro, diferenca);
+            }
+            linha(nome, t, erro);
+            falhou |= erro > tolerancia;
+        };
+        medir("sistema, escalar", false, 1);
+        if (temAVX2) {
+            medir("sistema, AVX2, 1 thread", true, 1);
+            string nome = "sistema, AVX2, " + to_string(max(2u, nucleos)) + " threads";
+            medir(nome.c_str(), true, max(2u, nucleos));
+        }
+    }
+
+    {
+        size_t nObjetos = 100000;
+        vector<ObjetoAnimado> objetos;
+        TransformacoesSoA transformacoes;
+        SistemaTrajetorias sistema;
+        montar(nObjetos, objetos, transformacoes, sistema);
+        PassoFixo referencia(120.0);
+        int passos = 1200; // 10 s simulados
+
+        SistemaTrajetorias simulado = sistema;
+        double tSimulacao = medirSegundos([&] {
+            for (int p = 0; p < passos; ++p) simulado.avancar(referencia.dt());
+        });
+        double tGravar = medirSegundos([&] {
+            for (int r = 0; r < repeticoes; ++r) simulado.gravarPosicoes(transformacoes, 0.5f * referencia.dt());
+        }) / repeticoes;
+
+        cout << "passo fixo, " << nObjetos << " objetos: " << fixed << setprecision(0) << passos / tSimulacao
+             << " passos de simulação/s, " << setprecision(3) << tGravar * 1e3 << " ms para gravar um quadro interpolado"
+             << endl;
+
+        // Quadros de durações aleatórias, sem limite de passos: o relógio tem
+        // que dar floor(total / passo) passos, e as posições gravadas em cada
+        // quadro ficam recuo = (1 - alfa) * dt antes da distância simulada,
+        // sem recuar para antes do ponto de partida (o primeiro quadro é mais
+        // curto que um passo, então nenhum objeto andou ainda)
+        mt19937 gerador(11);
+        uniform_real_distribution<double> duracao(0.001, 0.05);
+        PassoFixo relogio(120.0, 1000000);
+        SistemaTrajetorias animado = sistema;
+        const int QUADROS = 400;
+        double total = 0.0;
+        uint64_t passosDados = 0;
+        float erroInterpolado = 0.0f;
+        for (int q = 0; q < QUADROS; ++q) {
+            double d = q == 0 ? 0.25 / 120.0 : duracao(gerador);
+            total += d;
+            int n = relogio.avancar(d);
+            for (int p = 0; p < n; ++p) animado.avancar(relogio.dt());
+            passosDados += (uint64_t)n;
+            float recuo = (1.0f - relogio.alfa()) * relogio.dt();
+            animado.gravarPosicoes(transformacoes, recuo);
+            float recuado = min(recuo, (float)passosDados * relogio.dt());
+            // Todos os objetos no primeiro e no último quadro; um em cada 97 nos outros
+            size_t salto = q == 0 || q == QUADROS - 1 ? 1 : 97;
+            for (size_t i = 0; i < nObjetos; i += salto) {
+                float s = animado.distancia((uint32_t)i) - objetos[i].velocidade * recuado;
+                glm::vec3 esperada = objetos[i].curva.posicao(s);
+                erroInterpolado = max(erroInterpolado, glm::length(transformacoes.posicao((uint32_t)i) - esperada));
+            }
+        }
+        uint64_t esperados = (uint64_t)floor(total / (1.0 / 120.0));
+        cout << "quadros irregulares: " << passosDados << " passos em " << setprecision(3) << total << " s (esperados "
+             << esperados << ", " << relogio.passosDescartados() << " descartados), erro interpolado " << scientific
+             << setprecision(1) << erroInterpolado << fixed << endl;
+        falhou |= passosDados != esperados || relogio.passosSimulados() != passosDados;
+        falhou |= erroInterpolado > tolerancia;
+    }
+
+    cout << (falhou ? "FALHA: posições divergem de Trajetoria::posicao" : "OK: posições iguais a Trajetoria::posicao") << endl;
+    return falhou ? 1 : 0;
+}
@@ -0,0 +1,119 @@
+/*	Benchmark das matrizes model: matrizModelo (glm) x TransformacoesSoA
+    Para nObjetos objetos com posição, rotação e escala aleatórias mede
+    quantas matrizes por segundo saem de:
+      A) array de structs + matrizModelo (translate, 3 rotate e scale do glm)
+      B) TransformacoesSoA com a forma fechada, escalar
+      C) TransformacoesSoA com AVX2, 8 objetos por iteração
+      D) como C, mas só para metade dos objetos, lidos por gather de índices
+    e confere o maior erro de B, C e D em relação a A.
+
+    Uso: BenchTransformacoes [nObjetos] [repeticoes]
+    Retorna 1 se algum caminho divergir de matrizModelo.
+*/
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <algorithm>
+
+#include "Transformacoes.h"
+#include "TransformacoesSoA.h"
+
+using namespace std;
+
+struct ObjetoAoS {
+    glm::vec3 pos, rot, escala;
+};
+
+template <typename F>
+double medirSegundos(F&& f) {
+    auto inicio = chrono::steady_clock::now();
+    f();
+    chrono::duration<double> d = chrono::steady_clock::now() - inicio;
+    return d.count();
+}
+
+float maiorErro(const glm::mat4& a, const glm::mat4& b) {
+    float erro = 0.0f;
+    for (int c = 0; c < 4; ++c)
+        for (int l = 0; l < 4; ++l) erro = max(erro, fabs(a[c][l] - b[c][l]));
+    return erro;
+}
+
+int main(int argc, char** argv) {
+    size_t nObjetos = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    int repeticoes = argc > 2 ? atoi(argv[2]) : 10;
+    const float tolerancia = 1e-4f;
+
+    mt19937 gerador(3);
+    uniform_real_distribution<float> unitario(0.0f, 1.0f);
+    vector<ObjetoAoS> aos(nObjetos);
+    TransformacoesSoA soa;
+    soa.reservar(nObjetos);
+    for (ObjetoAoS& o : aos) {
+        o.pos = glm::vec3(unitario(gerador), unitario(gerador), unitario(gerador)) * 200.0f - 100.0f;
+        o.rot = glm::vec3(unitario(gerador), unitario(gerador), unitario(gerador)) * 12.56f - 6.28f;
+        o.escala = glm::vec3(0.2f + unitario(gerador) * 2.0f, 0.2f + unitario(gerador) * 2.0f, 0.2f + unitario(gerador) * 2.0f);
+        soa.adicionar(o.pos, o.rot, o.escala);
+    }
+    vector<uint32_t> metade;
+    for (uint32_t i = 0; i < nObjetos; ++i)
+        if (unitario(gerador) < 0.5f) metade.push_back(i);
+
+    vector<glm::mat4> referencia(nObjetos), saida(nObjetos);
+    bool temAVX2 = false;
+#ifdef TRANSFORMACOES_AVX2
+    temAVX2 = transformacoesSoA::temAVX2();
+#endif
+    cout << nObjetos << " objetos, " << repeticoes << " repetições, AVX2 " << (temAVX2 ? "disponível" : "indisponível") << endl;
+    cout << left << setw(34) << "caminho" << right << setw(10) << "ms" << setw(16) << "Mmatrizes/s"
+         << setw(10) << "speedup" << setw(12) << "erro" << endl;
+
+    double tA = medirSegundos([&] {
+        for (int r = 0; r < repeticoes; ++r)
+            for (size_t i = 0; i < nObjetos; ++i) referencia[i] = matrizModelo(aos[i].pos, aos[i].rot, aos[i].escala);
+    }) / repeticoes;
+
+    bool falhou = false;
+    auto linha = [&](const char* nome, double t, size_t n, float erro) {
+        cout << left << setw(34) << nome << right << fixed << setprecision(2) << setw(10) << t * 1e3
+             << setw(16) << n / t / 1e6 << setw(9) << (n / t) / (nObjetos / tA) << "x"
+             << setw(12) << scientific << setprecision(1) << erro << fixed << endl;
+        falhou |= erro > tolerancia;
+    };
+    linha("AoS + matrizModelo", tA, nObjetos, 0.0f);
+
+    soa.usarAVX2 = false;
+    double tB = medirSegundos([&] {
+        for (int r = 0; r < repeticoes; ++r) soa.calcularModelos(saida.data());
+    }) / repeticoes;
+    float erro = 0.0f;
+    for (size_t i = 0; i < nObjetos; ++i) erro = max(erro, maiorErro(saida[i], referencia[i]));
+    linha("SoA, forma fechada escalar", tB, nObjetos, erro);
+
+    if (temAVX2) {
+        soa.usarAVX2 = true;
+        double tC = medirSegundos([&] {
+            for (int r = 0; r < repeticoes; ++r) soa.calcularModelos(saida.data());
+        }) / repeticoes;
+        erro = 0.0f;
+        for (size_t i = 0; i < nObjetos; ++i) erro = max(erro, maiorErro(saida[i], referencia[i]));
+        linha("SoA, AVX2", tC, nObjetos, erro);
+
+        double tD = medirSegundos([&] {
+            for (int r = 0; r < repeticoes; ++r) soa.calcularModelos(metade.data(), metade.size(), saida.data());
+        }) / repeticoes;
+        erro = 0.0f;
+        for (size_t k = 0; k < metade.size(); ++k) erro = max(erro, maiorErro(saida[k], referencia[metade[k]]));
+        linha("SoA, AVX2, metade (gather)", tD, metade.size(), erro);
+    }
+
+    cout << (falhou ? "FALHA: matrizes divergem de matrizModelo" : "OK: matrizes iguais a matrizModelo (dentro da tolerância)") << endl;
+    return falhou ? 1 : 0;
+}
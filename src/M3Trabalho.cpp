@@ -12,56 +12,61 @@
 #include <vector>
 #include <string>
 #include <iostream>
-#include <sstream>
 #include <fstream>
 #include <map>
 #include <algorithm>
+#include <chrono>
+#include <memory>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#include "CacheTexturas.h"
+#include "CarregadorAssincrono.h"
+#include "GrafoCena.h"
+
 using namespace std;
 
 // Classe para representar um objeto 3D
 class Objeto3D {
 private:
-    GLuint vaoHandle;
-    GLuint textureHandle;
-    int vertexCount;
-    glm::vec3 position;
-    glm::vec3 rotation;
-    glm::vec3 scale;
+    GLuint vaoHandle, vboHandle, eboHandle; // buffers kept so they can be deleted with the VAO
+    RefTextura texture; // shared through the CacheTexturas; the last reference deletes it
+    int indexCount;
+    GLenum indexType;
 
 public:
-    Objeto3D() : vaoHandle(0), textureHandle(0), vertexCount(0), 
-                 position(0.0f), rotation(0.0f), scale(1.0f) {}
+    Objeto3D() : vaoHandle(0), vboHandle(0), eboHandle(0), indexCount(0), indexType(GL_UNSIGNED_INT) {}
     
-    void setVAO(GLuint vao) { vaoHandle = vao; }
-    void setTexture(GLuint tex) { textureHandle = tex; }
-    void setVertexCount(int count) { vertexCount = count; }
-    void setPosition(const glm::vec3& pos) { position = pos; }
-    void setRotation(const glm::vec3& rot) { rotation = rot; }
-    void setScale(const glm::vec3& scl) { scale = scl; }
+    void setVAO(GLuint vao, GLuint vbo, GLuint ebo) {
+        vaoHandle = vao;
+        vboHandle = vbo;
+        eboHandle = ebo;
+    }
+    void deleteVAO() {
+        glDeleteVertexArrays(1, &vaoHandle);
+        glDeleteBuffers(1, &vboHandle);
+        glDeleteBuffers(1, &eboHandle);
+        vaoHandle = vboHandle = eboHandle = 0;
+    }
+    void setTexture(RefTextura tex) { texture = tex; }
+    void setIndexCount(int count) { indexCount = count; }
+    void setIndexType(GLenum type) { indexType = type; }
     
     GLuint getVAO() const { return vaoHandle; }
-    GLuint getTexture() const { return textureHandle; }
-    int getVertexCount() const { return vertexCount; }
-    const glm::vec3& getPosition() const { return position; }
-    const glm::vec3& getRotation() const { return rotation; }
-    const glm::vec3& getScale() const { return scale; }
-    
-    void rotateX(float angle) { rotation.x += angle; }
-    void rotateY(float angle) { rotation.y += angle; }
-    void rotateZ(float angle) { rotation.z += angle; }
-    void moveX(float delta) { position.x += delta; }
-    void moveY(float delta) { position.y += delta; }
-    void moveZ(float delta) { position.z += delta; }
-    void scaleBy(float factor) { scale *= factor; }
+    GLuint getTexture() const { return texture ? texture->id : 0; }
+    int getIndexCount() const { return indexCount; }
+    GLenum getIndexType() const { return indexType; }
 };
 
 // Configurações
 const GLuint WINDOW_WIDTH = 500, WINDOW_HEIGHT = 500;
+// Max time per frame spent uploading loaded assets to the GPU (seconds)
+const double UPLOAD_BUDGET = 0.004;
 vector<Objeto3D> sceneObjects;
+// Posição, rotação e escala de cada objeto (relativas ao pai) ficam no grafo
+// de cena, com o mesmo índice de sceneObjects; o grafo guarda as matrizes de mundo
+GrafoCena sceneGraph;
 int currentObjectIndex = 0;
 
 // Shaders com abordagem diferente
@@ -101,10 +106,15 @@ void main() {
 // Protótipos
 void handleInput(GLFWwindow* window, int key, int scancode, int action, int mods);
 GLuint createShaderProgram();
-GLuint loadTextureFile(const char* filename);
-int loadOBJModel(string filename, int& vertexCount, GLuint& textureID);
+GLuint createVAO(const void* vertices, size_t vertexBytes, const void* indices, size_t indexBytes, GLuint& vbo,
+                 GLuint& ebo);
+GLuint createTexture(const unsigned char* pixels, int width, int height, int channels);
+void createPlaceholder(Objeto3D& obj, CacheTexturas& textures);
+void uploadReadyAssets(CarregadorAssincrono& loader, CacheTexturas& textures, double budget);
 
 int main() {
+    auto programStart = chrono::steady_clock::now();
+
     // Inicialização
     if (glfwInit() != GLFW_TRUE) {
         cerr << "GLFW initialization failed" << endl;
@@ -150,20 +160,21 @@ int main() {
         "../assets/Modelos3D/Suzanne.obj"
     };
 
-    // Carregamento dos objetos
-    for (const string& file : modelFiles) {
+    // Carregamento dos objetos (em segundo plano)
+    // Each object shows a white cube until its mesh and texture arrive
+    // Models sharing an image decode and upload it once
+    CacheTexturas textures(createTexture, [](unsigned id) { glDeleteTextures(1, &id); });
+    CarregadorAssincrono loader(textures);
+    for (size_t i = 0; i < modelFiles.size(); ++i) {
         Objeto3D obj;
-        GLuint textureID;
-        int vertices;
-        
-        obj.setVAO(loadOBJModel(file, vertices, textureID));
-        obj.setTexture(textureID);
-        obj.setVertexCount(vertices);
-        
+        createPlaceholder(obj, textures);
         sceneObjects.push_back(obj);
+        sceneGraph.adicionar(GrafoCena::NENHUM, glm::vec3(0.0f));
+        loader.pedirModelo((int)i, modelFiles[i], "../assets/tex/pixelWall.png", false);
     }
 
     // Loop principal
+    bool firstFrame = true;
     while (!glfwWindowShouldClose(window)) {
         glfwPollEvents();
 
@@ -171,29 +182,37 @@ int main() {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         glUseProgram(shaderProgram);
+        uploadReadyAssets(loader, textures, UPLOAD_BUDGET);
         glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(viewMatrix));
         glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
 
-        // Renderização dos objetos
-        for (const Objeto3D& obj : sceneObjects) {
-            glm::mat4 modelMatrix = glm::mat4(1.0f);
-            modelMatrix = glm::translate(modelMatrix, obj.getPosition());
-            modelMatrix = glm::rotate(modelMatrix, obj.getRotation().x, glm::vec3(1.0f, 0.0f, 0.0f));
-            modelMatrix = glm::rotate(modelMatrix, obj.getRotation().y, glm::vec3(0.0f, 1.0f, 0.0f));
-            modelMatrix = glm::rotate(modelMatrix, obj.getRotation().z, glm::vec3(0.0f, 0.0f, 1.0f));
-            modelMatrix = glm::scale(modelMatrix, obj.getScale());
+        // Só os objetos que mudaram (e os filhos deles) têm a matriz de mundo refeita
+        sceneGraph.atualizar();
 
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(modelMatrix));
+        // Renderização dos objetos
+        for (size_t i = 0; i < sceneObjects.size(); ++i) {
+            const Objeto3D& obj = sceneObjects[i];
+            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(sceneGraph.mundo((uint32_t)i)));
 
             glActiveTexture(GL_TEXTURE0);
             glBindTexture(GL_TEXTURE_2D, obj.getTexture());
             glBindVertexArray(obj.getVAO());
-            glDrawArrays(GL_TRIANGLES, 0, obj.getVertexCount());
+            glDrawElements(GL_TRIANGLES, obj.getIndexCount(), obj.getIndexType(), 0);
         }
 
         glfwSwapBuffers(window);
+        if (firstFrame) {
+            firstFrame = false;
+            chrono::duration<double, milli> t = chrono::steady_clock::now() - programStart;
+            cout << "Time to first frame: " << t.count() << " ms" << endl;
+        }
     }
 
+    EstatisticasTexturas stats = textures.estatisticas();
+    cout << stats.decodificacoes << " textures decoded, " << stats.envios << " uploaded, " << stats.reusos
+         << " reused; " << stats.residentes << " resident (" << stats.bytesGPU / 1024 << " KB)" << endl;
+    for (Objeto3D& obj : sceneObjects) obj.deleteVAO();
+    sceneObjects.clear(); // textures are deleted while the context still exists
     glfwTerminate();
     return 0;
 }
@@ -201,49 +220,61 @@ int main() {
 void handleInput(GLFWwindow* window, int key, int scancode, int action, int mods) {
     if (action != GLFW_PRESS) return;
     
-    Objeto3D& currentObj = sceneObjects[currentObjectIndex];
+    uint32_t current = (uint32_t)currentObjectIndex;
+    glm::vec3 position = sceneGraph.locais().posicao(current);
+    glm::vec3 rotation = sceneGraph.locais().rotacao(current);
+    glm::vec3 scale = sceneGraph.locais().escala(current);
 
     switch (key) {
         case GLFW_KEY_TAB: 
             currentObjectIndex = (currentObjectIndex + 1) % sceneObjects.size(); 
             break;
         case GLFW_KEY_X: 
-            currentObj.rotateX(glm::radians(10.0f)); 
+            rotation.x += glm::radians(10.0f); 
             break;
         case GLFW_KEY_Y: 
-            currentObj.rotateY(glm::radians(10.0f)); 
+            rotation.y += glm::radians(10.0f); 
             break;
         case GLFW_KEY_Z: 
-            currentObj.rotateZ(glm::radians(10.0f)); 
+            rotation.z += glm::radians(10.0f); 
             break;
         case GLFW_KEY_W: 
-            currentObj.moveZ(-0.1f); 
+            position.z -= 0.1f; 
             break;
         case GLFW_KEY_S: 
-            currentObj.moveZ(0.1f); 
+            position.z += 0.1f; 
             break;
         case GLFW_KEY_A: 
-            currentObj.moveX(-0.1f); 
+            position.x -= 0.1f; 
             break;
         case GLFW_KEY_D: 
-            currentObj.moveX(0.1f); 
+            position.x += 0.1f; 
             break;
         case GLFW_KEY_Q: 
-            currentObj.moveY(0.1f); 
+            position.y += 0.1f; 
             break;
         case GLFW_KEY_E: 
-            currentObj.moveY(-0.1f); 
+            position.y -= 0.1f; 
             break;
         case GLFW_KEY_KP_ADD: 
-            currentObj.scaleBy(1.1f); 
+            scale *= 1.1f; 
             break;
         case GLFW_KEY_KP_SUBTRACT: 
-            currentObj.scaleBy(0.9f); 
+            scale *= 0.9f; 
+            break;
+        case GLFW_KEY_H:
+            // Prende ao primeiro objeto (que passa a levá-lo junto) ou solta
+            if (current != 0) {
+                bool attach = sceneGraph.pai(current) == GrafoCena::NENHUM;
+                sceneGraph.definirPai(current, attach ? 0 : GrafoCena::NENHUM);
+                cout << "Object " << current << (attach ? " attached to object 0" : " detached") << endl;
+            }
             break;
         case GLFW_KEY_ESCAPE: 
             glfwSetWindowShouldClose(window, true); 
             break;
     }
+    sceneGraph.locais().definir(current, position, rotation, scale);
 }
 
 GLuint createShaderProgram() {
@@ -270,120 +301,20 @@ GLuint createShaderProgram() {
     return program;
 }
 
-GLuint loadTextureFile(const char* filename) {
-    GLuint textureID;
-    glGenTextures(1, &textureID);
-    
-    int width, height, channels;
-    unsigned char* data = stbi_load(filename, &width, &height, &channels, 0);
-
-    if (data) {
-        GLenum format = (channels == 4) ? GL_RGBA : GL_RGB;
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    } else {
-        cout << "Failed to load texture: " << filename << endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
-
-int loadOBJModel(string filename, int& vertexCount, GLuint& textureID) {
-    vector<glm::vec3> vertexPositions;
-    vector<glm::vec2> textureCoordinates;
-    vector<glm::vec3> normalVectors;
-    vector<GLfloat> vertexBuffer;
-    string mtlFilename;
-    string textureFilename;
-
-    ifstream file(filename);
-    if (!file.is_open()) {
-        cout << "Error opening file: " << filename << endl;
-        return -1;
-    }
-
-    string line;
-    while (getline(file, line)) {
-        istringstream iss(line);
-        string token;
-        iss >> token;
-
-        if (token == "mtllib") {
-            iss >> mtlFilename;
-            
-            // Parse MTL file
-            ifstream mtlFile("../assets/Modelos3D/" + mtlFilename);
-            if (mtlFile.is_open()) {
-                string mtlLine;
-                while (getline(mtlFile, mtlLine)) {
-                    istringstream mtlIss(mtlLine);
-                    string mtlToken;
-                    mtlIss >> mtlToken;
-
-                    if (mtlToken == "map_Kd") {
-                        mtlIss >> textureFilename;
-                    }
-                }
-            }
-        }
-
-        if (token == "v") {
-            glm::vec3 vertex;
-            iss >> vertex.x >> vertex.y >> vertex.z;
-            vertexPositions.push_back(vertex);
-        } else if (token == "vt") {
-            glm::vec2 texCoord;
-            iss >> texCoord.x >> texCoord.y;
-            textureCoordinates.push_back(texCoord);
-        } else if (token == "vn") {
-            glm::vec3 normal;
-            iss >> normal.x >> normal.y >> normal.z;
-            normalVectors.push_back(normal);
-        } else if (token == "f") {
-            while (iss >> token) {
-                int vIdx, tIdx, nIdx;
-                sscanf(token.c_str(), "%d/%d/%d", &vIdx, &tIdx, &nIdx);
-                vIdx--; tIdx--; nIdx--;
-
-                glm::vec3 vertex = vertexPositions[vIdx];
-                glm::vec2 texCoord = textureCoordinates[tIdx];
-                texCoord.y = 1.0f - texCoord.y; // Flip Y coordinate
-
-                // Position
-                vertexBuffer.push_back(vertex.x);
-                vertexBuffer.push_back(vertex.y);
-                vertexBuffer.push_back(vertex.z);
-
-                // Color (white)
-                vertexBuffer.push_back(1.0f);
-                vertexBuffer.push_back(1.0f);
-                vertexBuffer.push_back(1.0f);
-
-                // Texture coordinates
-                vertexBuffer.push_back(texCoord.x);
-                vertexBuffer.push_back(texCoord.y);
-            }
-        }
-    }
-
-    // Create VBO and VAO
-    GLuint VBO, VAO;
+// VAO/VBO/EBO with the 8-float layout (position, color, uv)
+GLuint createVAO(const void* vertices, size_t vertexBytes, const void* indices, size_t indexBytes, GLuint& VBO,
+                 GLuint& EBO) {
+    GLuint VAO;
     glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
     glGenVertexArrays(1, &VAO);
 
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertexBuffer.size() * sizeof(GLfloat), vertexBuffer.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertices, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indices, GL_STATIC_DRAW);
 
     // Vertex attributes
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (void*)0);
@@ -395,14 +326,88 @@ int loadOBJModel(string filename, int& vertexCount, GLuint& textureID) {
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (void*)(6 * sizeof(GLfloat)));
     glEnableVertexAttribArray(2);
 
-    vertexCount = vertexBuffer.size() / 8;
+    glBindVertexArray(0);
+    return VAO;
+}
+
+GLuint createTexture(const unsigned char* pixels, int width, int height, int channels) {
+    GLuint textureID;
+    glGenTextures(1, &textureID);
+
+    GLenum format = (channels == 4) ? GL_RGBA : GL_RGB;
+    glBindTexture(GL_TEXTURE_2D, textureID);
 
-    // Load texture
-    if (!textureFilename.empty()) {
-        textureID = loadTextureFile(("../assets/Modelos3D/" + textureFilename).c_str());
-    } else {
-        textureID = loadTextureFile("../assets/tex/pixelWall.png");
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    return textureID;
+}
+
+// Unit cube with a 1x1 white texture, drawn while the real model is loading
+void createPlaceholder(Objeto3D& obj, CacheTexturas& textures) {
+    vector<GLfloat> vertices;
+    vector<GLushort> indices;
+    const int order[2][6] = { {0, 2, 1, 0, 3, 2}, {0, 1, 2, 0, 2, 3} };
+    for (int axis = 0; axis < 3; ++axis) {
+        for (int side = -1; side <= 1; side += 2) {
+            glm::vec3 n(0.0f), u(0.0f), w(0.0f);
+            n[axis] = (float)side;
+            u[(axis + 1) % 3] = 0.5f;
+            w[(axis + 2) % 3] = 0.5f;
+            size_t base = vertices.size() / 8;
+            for (int k = 0; k < 4; ++k) {
+                float s = (k == 1 || k == 2) ? 1.0f : -1.0f;
+                float t = (k >= 2) ? 1.0f : -1.0f;
+                glm::vec3 p = n * 0.5f + u * s + w * t;
+                vertices.insert(vertices.end(), { p.x, p.y, p.z, 1.0f, 1.0f, 1.0f, (s + 1.0f) * 0.5f, (t + 1.0f) * 0.5f });
+            }
+            for (int i : order[side > 0]) indices.push_back((GLushort)(base + i));
+        }
     }
+    GLuint vbo, ebo;
+    GLuint vao = createVAO(vertices.data(), vertices.size() * sizeof(GLfloat), indices.data(),
+                           indices.size() * sizeof(GLushort), vbo, ebo);
+    obj.setVAO(vao, vbo, ebo);
+    obj.setIndexCount(indices.size());
+    obj.setIndexType(GL_UNSIGNED_SHORT);
+    obj.setTexture(textures.branca());
+}
 
-    return VAO;
+// Uploads whatever the loader threads have finished. At least one item goes
+// up per call; after that it stops once the frame budget (seconds) runs out.
+void uploadReadyAssets(CarregadorAssincrono& loader, CacheTexturas& textures, double budget) {
+    double deadline = glfwGetTime() + budget;
+    do {
+        unique_ptr<AssetPronto> asset = loader.proximo();
+        if (!asset) break;
+        if (!asset->ok) {
+            cout << "Failed to load: " << asset->caminho << endl;
+            continue;
+        }
+        Objeto3D& obj = sceneObjects[asset->id];
+        if (asset->tipo == ASSET_MALHA) {
+            // Unique (v, vt) pairs only: this shader has no normal attribute
+            const MalhaCacheada& mesh = asset->malha;
+            cout << asset->caminho
+                 << (mesh.doCache        ? ": binary cache"
+                     : mesh.cacheGravado ? ": parsed .obj, cache written"
+                                         : ": parsed .obj, failed to write the cache (kept in memory)")
+                 << endl;
+            // Index buffer is stored as 16-bit in the cache when every index fits
+            obj.deleteVAO(); // the placeholder's
+            GLuint vbo, ebo;
+            GLuint vao = createVAO(mesh.vertices, mesh.bytesVertices(), mesh.indices, mesh.bytesIndices(), vbo, ebo);
+            obj.setVAO(vao, vbo, ebo);
+            obj.setIndexCount(mesh.nIndices());
+            obj.setIndexType(mesh.indices16Bits() ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT);
+        } else {
+            // A null image means the texture is already resident and is only referenced again
+            if (RefTextura texture = textures.textura(asset->chave, asset->imagem.get())) obj.setTexture(texture);
+        }
+    } while (glfwGetTime() < deadline);
 }
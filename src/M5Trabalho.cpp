@@ -12,30 +12,49 @@
 #include <vector>
 #include <string>
 #include <iostream>
-#include <sstream>
 #include <fstream>
 #include <map>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <unordered_set>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#include "CacheTexturas.h"
+#include "CarregadorAssincrono.h"
+#include "ProgramaShader.h"
+#include "BlocosUniformes.h"
+#include "Transformacoes.h"
+#include "RenderizadorInstanciado.h"
+#include "Selecao.h"
+#include "GrafoCena.h"
+
 using namespace std;
 
 // Estrutura para objeto 3D
 struct Objeto3D {
-    GLuint vao;
-    GLuint textura;
-    int nVertices;
-    glm::vec3 pos{0.0f};
-    glm::vec3 rot{0.0f};
-    glm::vec3 escala{1.0f};
+    GLuint vao = 0, vbo = 0, ebo = 0; // os buffers ficam aqui para serem apagados junto com o VAO
+    RefTextura textura; // compartilhada pelo CacheTexturas; a última referência apaga da GPU
+    int nIndices;
+    GLenum tipoIndice; // GL_UNSIGNED_SHORT ou GL_UNSIGNED_INT
+    int material = 0;  // índice na TabelaMateriais
+    LimitesMalha limites{}; // AABB e esfera no espaço do objeto, para o culling
+    shared_ptr<const BVHTriangulos> bvhMalha; // triângulos da malha, para a seleção (nulo no placeholder)
 };
 
+// Posição, rotação e escala (relativas ao pai) ficam fora do Objeto3D, no
+// grafo de cena, com o mesmo índice de cena; o grafo guarda as matrizes de mundo
 vector<Objeto3D> cena;
+GrafoCena grafo;
 int objetoAtual = 0;
 
 const GLuint WIDTH = 800, HEIGHT = 800;
+// Tempo máximo por quadro gasto enviando assets carregados para a GPU (s)
+const double ORCAMENTO_UPLOAD = 0.004;
+const float PLANO_DISTANTE = 100.0f;
 
 // Vertex Shader com Phong
 const char* vertexShaderSource = R"(
@@ -45,9 +64,16 @@ layout(location = 1) in vec3 cor;
 layout(location = 2) in vec3 normal;
 layout(location = 3) in vec2 texCoord;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Por instância (RenderizadorInstanciado)
+layout(location = 4) in mat4 model;
+layout(location = 8) in mat3 normalMatrix; // transposta da inversa de mat3(model), calculada na CPU
+
+layout(std140) uniform Quadro {
+    mat4 view;
+    mat4 projection;
+    vec4 lightPos;
+    vec4 camPos;
+};
 
 out vec3 vNormal;
 out vec3 vFragPos;
@@ -56,7 +82,7 @@ out vec2 vTexCoord;
 
 void main() {
     vFragPos = vec3(model * vec4(pos, 1.0));
-    vNormal = mat3(transpose(inverse(model))) * normal;
+    vNormal = normalMatrix * normal;
     vColor = cor;
     vTexCoord = texCoord;
     gl_Position = projection * view * model * vec4(pos, 1.0);
@@ -74,23 +100,31 @@ in vec2 vTexCoord;
 out vec4 FragColor;
 
 uniform sampler2D tex;
-uniform vec3 lightPos;
-uniform vec3 camPos;
-uniform float ka;
-uniform float kd;
-uniform float ks;
-uniform float ns;
+
+layout(std140) uniform Quadro {
+    mat4 view;
+    mat4 projection;
+    vec4 lightPos;
+    vec4 camPos;
+};
+
+layout(std140) uniform Material {
+    float ka;
+    float kd;
+    float ks;
+    float ns;
+};
 
 void main() {
     vec3 lightColor = vec3(1.0);
     vec3 ambient = ka * lightColor;
 
     vec3 norm = normalize(vNormal);
-    vec3 lightDir = normalize(lightPos - vFragPos);
+    vec3 lightDir = normalize(lightPos.xyz - vFragPos);
     float diff = max(dot(norm, lightDir), 0.0);
     vec3 diffuse = kd * diff * lightColor;
 
-    vec3 viewDir = normalize(camPos - vFragPos);
+    vec3 viewDir = normalize(camPos.xyz - vFragPos);
     vec3 reflectDir = reflect(-lightDir, norm);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), ns);
     vec3 specular = ks * spec * lightColor;
@@ -162,15 +196,29 @@ float lastY = HEIGHT / 2.0f;
 bool firstMouse = true;
 float deltaTime = 0.016f;
 float lastFrame = 0.0f;
+bool pedidoSelecao = false; // clique atendido no quadro seguinte, com as caixas em dia
 
 // Protótipos
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+void selecionarObjeto(GLFWwindow* window, const BVHCena& bvh, const BlocoQuadro& quadro);
 GLuint criarShader();
-GLuint carregarTextura(const char* caminho);
-int carregarOBJ(const string& objPath, int& nVertices, GLuint& texID, float& ka, float& kd, float& ks, float& ns);
-
-int main() {
+GLuint criarVAO(const void* vertices, size_t bytesVertices, const void* indices, size_t bytesIndices, GLuint& vbo,
+                GLuint& ebo);
+void apagarVAO(Objeto3D& obj);
+GLuint criarTextura(const unsigned char* pixels, int w, int h, int c);
+void criarPlaceholder(Objeto3D& obj, CacheTexturas& texturas);
+void enviarAssetsProntos(CarregadorAssincrono& carregador, CacheTexturas& texturas, TabelaMateriais& materiais,
+                         double orcamento);
+
+// Modo de estresse: M5Trabalho --estresse [n] espalha n cópias da Suzanne
+// (100 mil por padrão) depois que ela carrega e mostra o tempo de quadro
+int main(int argc, char** argv) {
+    int nEstresse = 0;
+    if (argc > 1 && string(argv[1]) == "--estresse") nEstresse = argc > 2 ? atoi(argv[2]) : 100000;
+    bool modoEstresse = nEstresse > 0;
+    auto inicioPrograma = chrono::steady_clock::now();
     if (!glfwInit()) {
         cerr << "Erro ao inicializar GLFW" << endl;
         return -1;
@@ -184,6 +232,7 @@ int main() {
     glfwMakeContextCurrent(window);
     glfwSetKeyCallback(window, key_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
         cerr << "Erro ao inicializar GLAD" << endl;
@@ -192,27 +241,42 @@ int main() {
     glViewport(0, 0, WIDTH, HEIGHT);
     glEnable(GL_DEPTH_TEST);
 
-    GLuint shader = criarShader();
-    glUseProgram(shader);
-
-    // Carregar apenas Suzanne
-    int nVertices; GLuint texID;
-    float ka, kd, ks, ns;
-    GLuint vao = carregarOBJ("../assets/Modelos3D/Suzanne.obj", nVertices, texID, ka, kd, ks, ns);
-    cena.push_back({vao, texID, nVertices});
-
-    // Uniforms fixos
-    glm::vec3 lightPos(2.0f, 2.0f, 2.0f);
-    glUniform3fv(glGetUniformLocation(shader, "lightPos"), 1, &lightPos[0]);
-    glUniform1f(glGetUniformLocation(shader, "ka"), ka);
-    glUniform1f(glGetUniformLocation(shader, "kd"), kd);
-    glUniform1f(glGetUniformLocation(shader, "ks"), ks);
-    glUniform1f(glGetUniformLocation(shader, "ns"), ns);
-    glUniform1i(glGetUniformLocation(shader, "tex"), 0);
-
-    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)WIDTH/HEIGHT, 0.1f, 100.0f);
-    glUniformMatrix4fv(glGetUniformLocation(shader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-
+    ProgramaShader shader(criarShader());
+    shader.usar();
+    ligarBlocosUniformes(shader.programa());
+    RenderizadorInstanciado renderizador;
+    renderizador.criar();
+    FilaRenderizacao fila;
+    BVHCena bvh;
+    vector<CaixaAlinhada> caixas; // AABB no mundo de cada objeto da cena
+    vector<uint32_t> visiveis;
+
+    // Suzanne é lida em segundo plano; até lá aparece um cubo branco no lugar
+    // Uma decodificação e um envio por imagem, por mais objetos que a usem
+    CacheTexturas texturas(criarTextura, [](unsigned id) { glDeleteTextures(1, &id); });
+    CarregadorAssincrono carregador(texturas);
+    cena.push_back(Objeto3D());
+    grafo.adicionar(GrafoCena::NENHUM, glm::vec3(0.0f));
+    criarPlaceholder(cena[0], texturas);
+    carregador.pedirModelo(0, "../assets/Modelos3D/Suzanne.obj", "../assets/tex/pixelWall.png");
+
+    // Blocos de uniforms: câmera e luz (por quadro) e materiais (por objeto)
+    BufferUniforme<BlocoQuadro> blocoQuadro;
+    blocoQuadro.criar(PONTO_BLOCO_QUADRO);
+    TabelaMateriais materiais;
+    materiais.criar(PONTO_BLOCO_MATERIAL);
+    materiais.adicionar(BlocoMaterial()); // 0: material padrão, usado pelo placeholder
+    shader.definir("tex", 0);
+
+    BlocoQuadro quadro;
+    quadro.lightPos = glm::vec4(2.0f, 2.0f, 2.0f, 1.0f);
+    quadro.projection = glm::perspective(glm::radians(45.0f), (float)WIDTH/HEIGHT, 0.1f, PLANO_DISTANTE);
+
+    bool primeiroQuadro = true;
+    double inicioMedida = glfwGetTime();
+    int quadrosMedidos = 0;
+    size_t matrizesRefeitas = 0, instanciasEnviadas = 0;
+    size_t quadros = 0, quadrosSemRecalculo = 0, quadrosSemRecalculoMedidos = 0;
     while (!glfwWindowShouldClose(window)) {
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
@@ -220,31 +284,107 @@ int main() {
         glfwPollEvents();
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glUseProgram(shader);
-        glm::mat4 view = camera.getViewMatrix();
-        glUniformMatrix4fv(glGetUniformLocation(shader, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        for (const auto& obj : cena) {
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, obj.pos);
-            model = glm::rotate(model, obj.rot.x, glm::vec3(1,0,0));
-            model = glm::rotate(model, obj.rot.y, glm::vec3(0,1,0));
-            model = glm::rotate(model, obj.rot.z, glm::vec3(0,0,1));
-            model = glm::scale(model, obj.escala);
-            glUniformMatrix4fv(glGetUniformLocation(shader, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, obj.textura);
-            glBindVertexArray(obj.vao);
-            glDrawArrays(GL_TRIANGLES, 0, obj.nVertices);
+        shader.usar();
+        enviarAssetsProntos(carregador, texturas, materiais, ORCAMENTO_UPLOAD);
+        materiais.enviar();
+        quadro.view = camera.getViewMatrix();
+        quadro.camPos = glm::vec4(camera.position, 1.0f);
+        blocoQuadro.atualizar(quadro);
+        if (nEstresse > 0 && carregador.emAndamento() == 0) {
+            // Grade cúbica à frente da câmera, todas com o VAO/textura da Suzanne
+            int lado = (int)ceil(cbrt((double)nEstresse));
+            cena.reserve(cena.size() + nEstresse);
+            grafo.reservar(cena.size() + nEstresse);
+            for (int i = 1; i < nEstresse; ++i) {
+                cena.push_back(cena[0]);
+                grafo.adicionar(GrafoCena::NENHUM, glm::vec3(i % lado - lado / 2, (i / lado) % lado - lado / 2, -(i / (lado * lado))) * 2.0f,
+                                glm::vec3(0.0f, i * 0.1f, 0.0f));
+            }
+            cout << "Modo de estresse: " << cena.size() << " objetos" << endl;
+            nEstresse = 0;
         }
+        // Só os objetos que mudaram desde o quadro anterior têm as matrizes refeitas
+        size_t refeitas = grafo.atualizar();
+        matrizesRefeitas += refeitas;
+        if (refeitas == 0) {
+            ++quadrosSemRecalculo;
+            ++quadrosSemRecalculoMedidos;
+        }
+        ++quadros;
+        // BVH das caixas da cena: reconstruída quando a cena muda de tamanho;
+        // fora isso só as caixas dos objetos refeitos são trocadas
+        if (bvh.tamanho() != cena.size()) {
+            caixas.resize(cena.size());
+            for (uint32_t i = 0; i < cena.size(); ++i) caixas[i] = caixaMundo(grafo.mundo(i), cena[i].limites);
+            bvh.construir(caixas);
+        } else if (refeitas > 0) {
+            for (uint32_t i : grafo.recalculados()) {
+                caixas[i] = caixaMundo(grafo.mundo(i), cena[i].limites);
+                bvh.atualizar(i, caixas[i]);
+            }
+            if (bvh.reajustar()) bvh.construir(caixas);
+        }
+        if (pedidoSelecao) {
+            pedidoSelecao = false;
+            selecionarObjeto(window, bvh, quadro);
+        }
+        // Só o que está no frustum entra na fila
+        bvh.consultarFrustum(Frustum::extrair(quadro.projection * quadro.view), visiveis);
+        // Ordena por programa/textura/material/VAO e, dentro disso, da frente para trás
+        fila.limpar();
+        for (uint32_t i : visiveis) {
+            const Objeto3D& obj = cena[i];
+            float distancia = -(quadro.view * grafo.mundo(i)[3]).z;
+            fila.adicionar(shader.programa(), obj.textura->id, obj.material, obj.vao, distancia / PLANO_DISTANTE, i);
+        }
+        fila.ordenar();
+        renderizador.comecar();
+        for (const ItemFila& item : fila.ordenados()) {
+            const Objeto3D& obj = cena[item.indice];
+            renderizador.adicionar(shader.programa(), obj.vao, obj.textura->id, obj.material, obj.nIndices,
+                                   obj.tipoIndice, grafo.mundo(item.indice), grafo.normalMundo(item.indice),
+                                   item.indice, grafo.recalculado(item.indice));
+        }
+        renderizador.desenhar(materiais);
+        instanciasEnviadas += renderizador.estatisticas().instanciasEnviadas;
         glfwSwapBuffers(window);
+        ++quadrosMedidos;
+        if (modoEstresse && glfwGetTime() - inicioMedida >= 1.0) {
+            double ms = (glfwGetTime() - inicioMedida) * 1000.0 / quadrosMedidos;
+            const EstatisticasRenderizacao& stats = renderizador.estatisticas();
+            cout << cena.size() << " objetos (" << visiveis.size() << " visíveis, "
+                 << cena.size() - visiveis.size() << " descartados), " << stats.desenhos << " chamadas de desenho, "
+                 << stats.trocas() << " trocas de estado (" << stats.evitadas() << " evitadas), "
+                 << ms << " ms/quadro (" << 1000.0 / ms << " fps)" << endl;
+            cout << "  " << matrizesRefeitas << " matrizes refeitas, " << quadrosSemRecalculoMedidos << " de "
+                 << quadrosMedidos << " quadros sem nenhuma, " << instanciasEnviadas << " instâncias enviadas à GPU" << endl;
+            inicioMedida = glfwGetTime();
+            quadrosMedidos = 0;
+            matrizesRefeitas = instanciasEnviadas = quadrosSemRecalculoMedidos = 0;
+        }
+        if (primeiroQuadro) {
+            primeiroQuadro = false;
+            chrono::duration<double, milli> t = chrono::steady_clock::now() - inicioPrograma;
+            cout << "Tempo até o primeiro quadro: " << t.count() << " ms" << endl;
+        }
     }
+    cout << quadrosSemRecalculo << " de " << quadros << " quadros sem nenhuma matriz refeita" << endl;
+    EstatisticasTexturas stats = texturas.estatisticas();
+    cout << stats.decodificacoes << " texturas decodificadas, " << stats.envios << " enviadas à GPU, " << stats.reusos
+         << " reaproveitadas; " << stats.residentes << " residentes (" << stats.bytesGPU / 1024 << " KB)" << endl;
+    // As cópias do modo de estresse usam o VAO da Suzanne: cada um é apagado uma vez só
+    unordered_set<GLuint> apagados;
+    for (Objeto3D& obj : cena)
+        if (apagados.insert(obj.vao).second) apagarVAO(obj);
+    cena.clear(); // as texturas são apagadas enquanto o contexto existe
     glfwTerminate();
     return 0;
 }
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
     if (action != GLFW_PRESS && action != GLFW_REPEAT) return;
-    Objeto3D& obj = cena[objetoAtual];
+    glm::vec3 rot = grafo.locais().rotacao(objetoAtual);
+    glm::vec3 escala = grafo.locais().escala(objetoAtual);
     switch (key) {
         case GLFW_KEY_W: camera.processKeyboard('W', deltaTime); break;
         case GLFW_KEY_S: camera.processKeyboard('S', deltaTime); break;
@@ -252,13 +392,23 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
         case GLFW_KEY_D: camera.processKeyboard('D', deltaTime); break;
         case GLFW_KEY_Q: camera.processKeyboard('Q', deltaTime); break;
         case GLFW_KEY_E: camera.processKeyboard('E', deltaTime); break;
-        case GLFW_KEY_X: obj.rot.x += glm::radians(10.0f); break;
-        case GLFW_KEY_Y: obj.rot.y += glm::radians(10.0f); break;
-        case GLFW_KEY_Z: obj.rot.z += glm::radians(10.0f); break;
-        case GLFW_KEY_KP_ADD: obj.escala *= 1.1f; break;
-        case GLFW_KEY_KP_SUBTRACT: obj.escala *= 0.9f; break;
+        case GLFW_KEY_X: rot.x += glm::radians(10.0f); break;
+        case GLFW_KEY_Y: rot.y += glm::radians(10.0f); break;
+        case GLFW_KEY_Z: rot.z += glm::radians(10.0f); break;
+        case GLFW_KEY_KP_ADD: escala *= 1.1f; break;
+        case GLFW_KEY_KP_SUBTRACT: escala *= 0.9f; break;
+        // Hierarquia: o objeto atual passa a acompanhar o objeto 0 (H de novo solta)
+        case GLFW_KEY_H:
+            if (objetoAtual != 0) {
+                bool preso = grafo.pai(objetoAtual) == GrafoCena::NENHUM;
+                grafo.definirPai(objetoAtual, preso ? 0 : GrafoCena::NENHUM);
+                cout << "Objeto " << objetoAtual << (preso ? " preso ao objeto 0" : " solto") << endl;
+            }
+            break;
         case GLFW_KEY_ESCAPE: glfwSetWindowShouldClose(window, true); break;
     }
+    grafo.locais().definirRotacao(objetoAtual, rot);
+    grafo.locais().definirEscala(objetoAtual, escala);
 }
 
 GLuint criarShader() {
@@ -277,85 +427,18 @@ GLuint criarShader() {
     return prog;
 }
 
-GLuint carregarTextura(const char* caminho) {
-    GLuint texID;
-    glGenTextures(1, &texID);
-    int w, h, c;
-    unsigned char* data = stbi_load(caminho, &w, &h, &c, 0);
-    if (data) {
-        GLenum format = (c == 4) ? GL_RGBA : GL_RGB;
-        glBindTexture(GL_TEXTURE_2D, texID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, w, h, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        stbi_image_free(data);
-    } else {
-        cout << "Falha ao carregar textura: " << caminho << endl;
-        stbi_image_free(data);
-    }
-    return texID;
-}
-
-int carregarOBJ(const string& objPath, int& nVertices, GLuint& texID, float& ka, float& kd, float& ks, float& ns) {
-    vector<glm::vec3> pos;
-    vector<glm::vec3> norm;
-    vector<glm::vec2> tex;
-    vector<GLfloat> buffer;
-    string mtlFile, texFile;
-    ka = 0.1f; kd = 0.7f; ks = 0.5f; ns = 32.0f;
-    ifstream arq(objPath);
-    if (!arq.is_open()) return -1;
-    string line;
-    while (getline(arq, line)) {
-        istringstream iss(line);
-        string t; iss >> t;
-        if (t == "mtllib") {
-            iss >> mtlFile;
-            ifstream mtl("../assets/Modelos3D/" + mtlFile);
-            if (mtl.is_open()) {
-                string l;
-                while (getline(mtl, l)) {
-                    istringstream mtliss(l);
-                    string tk; mtliss >> tk;
-                    if (tk == "map_Kd") mtliss >> texFile;
-                    else if (tk == "Ka") mtliss >> ka;
-                    else if (tk == "Kd") mtliss >> kd;
-                    else if (tk == "Ks") mtliss >> ks;
-                    else if (tk == "Ns") mtliss >> ns;
-                }
-            }
-        } else if (t == "v") {
-            glm::vec3 v; iss >> v.x >> v.y >> v.z; pos.push_back(v);
-        } else if (t == "vn") {
-            glm::vec3 n; iss >> n.x >> n.y >> n.z; norm.push_back(n);
-        } else if (t == "vt") {
-            glm::vec2 vt; iss >> vt.x >> vt.y; tex.push_back(vt);
-        } else if (t == "f") {
-            for (int i = 0; i < 3; ++i) {
-                string f; iss >> f;
-                int vi, ti, ni;
-                sscanf(f.c_str(), "%d/%d/%d", &vi, &ti, &ni);
-                vi--; ti--; ni--;
-                glm::vec3 v = pos[vi];
-                glm::vec3 n = norm[ni];
-                glm::vec2 t = tex[ti];
-                t.y = 1.0f - t.y;
-                buffer.push_back(v.x); buffer.push_back(v.y); buffer.push_back(v.z);
-                buffer.push_back(1.0f); buffer.push_back(1.0f); buffer.push_back(1.0f);
-                buffer.push_back(n.x); buffer.push_back(n.y); buffer.push_back(n.z);
-                buffer.push_back(t.x); buffer.push_back(t.y);
-            }
-        }
-    }
-    GLuint VBO, VAO;
+// Cria VAO/VBO/EBO no layout de 11 floats (pos, cor, normal, uv)
+GLuint criarVAO(const void* vertices, size_t bytesVertices, const void* indices, size_t bytesIndices, GLuint& VBO,
+                GLuint& EBO) {
+    GLuint VAO;
     glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
     glGenVertexArrays(1, &VAO);
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, buffer.size() * sizeof(GLfloat), buffer.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, bytesVertices, vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, bytesIndices, indices, GL_STATIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (void*)0);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
@@ -365,12 +448,104 @@ int carregarOBJ(const string& objPath, int& nVertices, GLuint& texID, float& ka,
     glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (void*)(9 * sizeof(GLfloat)));
     glEnableVertexAttribArray(3);
     glBindVertexArray(0);
-    nVertices = buffer.size() / 11;
-    if (!texFile.empty()) texID = carregarTextura(("../assets/Modelos3D/" + texFile).c_str());
-    else texID = carregarTextura("../assets/tex/pixelWall.png");
     return VAO;
 }
 
+// Apaga o VAO e os buffers do objeto (nomes 0 são ignorados pelo OpenGL)
+void apagarVAO(Objeto3D& obj) {
+    glDeleteVertexArrays(1, &obj.vao);
+    glDeleteBuffers(1, &obj.vbo);
+    glDeleteBuffers(1, &obj.ebo);
+    obj.vao = obj.vbo = obj.ebo = 0;
+}
+
+GLuint criarTextura(const unsigned char* pixels, int w, int h, int c) {
+    GLuint texID;
+    glGenTextures(1, &texID);
+    GLenum format = (c == 4) ? GL_RGBA : GL_RGB;
+    glBindTexture(GL_TEXTURE_2D, texID);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, w, h, 0, format, GL_UNSIGNED_BYTE, pixels);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return texID;
+}
+
+// Cubo unitário e textura branca 1x1, usados no lugar dos modelos enquanto carregam
+void criarPlaceholder(Objeto3D& obj, CacheTexturas& texturas) {
+    vector<GLfloat> vertices;
+    vector<GLushort> indices;
+    const int ordem[2][6] = { {0, 2, 1, 0, 3, 2}, {0, 1, 2, 0, 2, 3} };
+    for (int eixo = 0; eixo < 3; ++eixo) {
+        for (int lado = -1; lado <= 1; lado += 2) {
+            glm::vec3 n(0.0f), u(0.0f), w(0.0f);
+            n[eixo] = (float)lado;
+            u[(eixo + 1) % 3] = 0.5f;
+            w[(eixo + 2) % 3] = 0.5f;
+            size_t base = vertices.size() / 11;
+            for (int k = 0; k < 4; ++k) {
+                float s = (k == 1 || k == 2) ? 1.0f : -1.0f;
+                float t = (k >= 2) ? 1.0f : -1.0f;
+                glm::vec3 p = n * 0.5f + u * s + w * t;
+                vertices.insert(vertices.end(), { p.x, p.y, p.z, 1.0f, 1.0f, 1.0f, n.x, n.y, n.z, (s + 1.0f) * 0.5f, (t + 1.0f) * 0.5f });
+            }
+            for (int i : ordem[lado > 0]) indices.push_back((GLushort)(base + i));
+        }
+    }
+    obj.vao = criarVAO(vertices.data(), vertices.size() * sizeof(GLfloat), indices.data(), indices.size() * sizeof(GLushort),
+                       obj.vbo, obj.ebo);
+    obj.nIndices = indices.size();
+    obj.tipoIndice = GL_UNSIGNED_SHORT;
+    obj.limites = calcularLimites(vertices.data(), vertices.size() / 11, 11);
+    obj.textura = texturas.branca();
+}
+
+// Envia para a GPU o que as threads do carregador deixaram pronto. Sempre
+// envia ao menos um item e para quando o orçamento do quadro (em segundos) acaba.
+void enviarAssetsProntos(CarregadorAssincrono& carregador, CacheTexturas& texturas, TabelaMateriais& materiais,
+                         double orcamento) {
+    double limite = glfwGetTime() + orcamento;
+    do {
+        unique_ptr<AssetPronto> asset = carregador.proximo();
+        if (!asset) break;
+        if (!asset->ok) {
+            cout << "Falha ao carregar: " << asset->caminho << endl;
+            continue;
+        }
+        Objeto3D& obj = cena[asset->id];
+        if (asset->tipo == ASSET_MALHA) {
+            const MalhaCacheada& malha = asset->malha;
+            cout << asset->caminho
+                 << (malha.doCache        ? ": cache binário"
+                     : malha.cacheGravado ? ": lido do .obj, cache gravado"
+                                          : ": lido do .obj, falha ao gravar o cache (mantido na memória)")
+                 << endl;
+            // Índices já estão no tamanho certo (16 ou 32 bits) dentro do cache
+            apagarVAO(obj); // o do placeholder
+            obj.vao = criarVAO(malha.vertices, malha.bytesVertices(), malha.indices, malha.bytesIndices(), obj.vbo,
+                               obj.ebo);
+            obj.nIndices = malha.nIndices();
+            obj.tipoIndice = malha.indices16Bits() ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+            obj.limites = malha.limites();
+            grafo.locais().marcarAlterado(asset->id); // a caixa na BVH muda com a malha
+            auto bvhMalha = make_shared<BVHTriangulos>();
+            malha.copiarBVH(*bvhMalha);
+            obj.bvhMalha = bvhMalha;
+            BlocoMaterial material;
+            material.ka = malha.material.ka;
+            material.kd = malha.material.kd;
+            material.ks = malha.material.ks;
+            material.ns = malha.material.ns;
+            obj.material = materiais.adicionar(material);
+        } else {
+            // Imagem nula: a textura já está na GPU e o cache só devolve a referência
+            if (RefTextura textura = texturas.textura(asset->chave, asset->imagem.get())) obj.textura = textura;
+        }
+    } while (glfwGetTime() < limite);
+}
+
 // Novo callback de mouse
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
     if (firstMouse) {
@@ -384,3 +559,23 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
     lastY = ypos;
     camera.processMouse(xoffset, yoffset);
 }
+
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) pedidoSelecao = true;
+}
+
+// Seleciona o objeto sob o cursor; com o cursor preso pela câmera, sob a mira no centro da tela
+void selecionarObjeto(GLFWwindow* window, const BVHCena& bvh, const BlocoQuadro& quadro) {
+    double x = WIDTH / 2.0, y = HEIGHT / 2.0;
+    if (glfwGetInputMode(window, GLFW_CURSOR) != GLFW_CURSOR_DISABLED) glfwGetCursorPos(window, &x, &y);
+    RaioSelecao raio = raioDaTela(x, y, WIDTH, HEIGHT, quadro.projection, quadro.view);
+    Selecao s = selecionar(bvh, raio,
+                           [](uint32_t i) { return grafo.mundo(i); },
+                           [](uint32_t i) { return cena[i].bvhMalha.get(); });
+    if (!s.acertou()) return;
+    objetoAtual = s.objeto;
+    cout << "Objeto selecionado: " << objetoAtual;
+    if (s.triangulo != TRIANGULO_NENHUM)
+        cout << " (triângulo " << s.triangulo << ", baricêntricas " << 1.0f - s.u - s.v << " " << s.u << " " << s.v << ")";
+    cout << endl;
+}
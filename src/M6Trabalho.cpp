@@ -10,10 +10,13 @@ CONTROLES DE TRAJETÓRIA:
 - ESPAÇO: Adicionar ponto de controle na posição atual da câmera (apenas no modo edição)
 - P: Ativar/Desativar trajetória do objeto selecionado
 - C: Limpar todos os pontos de controle do objeto selecionado
-- V: Mostrar/Ocultar pontos de controle visuais
+- V: Mostrar/Ocultar a curva e os pontos de controle (modo edição)
+- M: Alternar o tipo de curva (linear, Catmull-Rom, Catmull-Rom centrípeta, Bézier cúbica)
 - TAB: Alternar entre objetos da cena
-- F5: Salvar trajetória do objeto atual em arquivo
-- F9: Carregar trajetória do objeto atual de arquivo
+- H: Prender/soltar o objeto atual ao objeto 0 (ele passa a acompanhá-lo)
+- Clique esquerdo: Selecionar o objeto sob a mira (centro da tela)
+- F5: Salvar trajetória do objeto atual em arquivo (binário, trajetoria_N.trj, com o tipo de curva)
+- F9: Carregar trajetória do objeto atual de arquivo (trajetoria_N.trj ou, se não houver, o texto trajetoria_N.txt)
 
 CONTROLES DE CÂMERA:
 - WASD: Mover câmera horizontalmente
@@ -33,36 +36,60 @@ CONTROLES DE OBJETO:
 #include <vector>
 #include <string>
 #include <iostream>
-#include <sstream>
 #include <fstream>
 #include <map>
 #include <algorithm>
+#include <chrono>
+#include <memory>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#include "CacheTexturas.h"
+#include "CarregadorAssincrono.h"
+#include "ProgramaShader.h"
+#include "BlocosUniformes.h"
+#include "Transformacoes.h"
+#include "RenderizadorInstanciado.h"
+#include "Frustum.h"
+#include "Selecao.h"
+#include "GrafoCena.h"
+#include "SistemaTrajetorias.h"
+#include "ArquivoTrajetoria.h"
+#include "DesenhoDepuracao.h"
+#include "PassoFixo.h"
+
 using namespace std;
 
 // Estrutura para objeto 3D
 struct Objeto3D {
-    GLuint vao;
-    GLuint textura;
-    int nVertices;
-    glm::vec3 pos{0.0f};
-    glm::vec3 rot{0.0f};
-    glm::vec3 escala{1.0f};
+    GLuint vao = 0, vbo = 0, ebo = 0; // os buffers ficam aqui para serem apagados junto com o VAO
+    RefTextura textura; // compartilhada pelo CacheTexturas; a última referência apaga da GPU
+    int nIndices;
+    GLenum tipoIndice; // GL_UNSIGNED_SHORT ou GL_UNSIGNED_INT
+    int material = 0;  // índice na TabelaMateriais
+    LimitesMalha limites{}; // AABB e esfera no espaço do objeto, para o culling
+    shared_ptr<const BVHTriangulos> bvhMalha; // triângulos da malha, para a seleção (nulo no placeholder)
     
-    // Sistema de trajetória
+    // Trajetória: pontos e modo para edição; a curva fica no SistemaTrajetorias
     vector<glm::vec3> pontosControle;
-    int pontoAtual;
-    float tempoTrajetoria;
-    bool trajetoriaAtiva;
+    ModoTrajetoria modoTrajetoria = TRAJETORIA_CENTRIPETA;
+    PoligonalTrajetoria poligonal; // curva e pontos para o modo edição, refeitos quando mudam
 };
 
+// Posição, rotação e escala (relativas ao pai) ficam fora do Objeto3D, no
+// grafo de cena, com o mesmo índice de cena; o grafo guarda as matrizes de mundo
 vector<Objeto3D> cena;
+GrafoCena grafo;
+// Uma trajetória por objeto, com o mesmo índice de cena; grava as posições no grafo
+SistemaTrajetorias trajetorias;
+const float VELOCIDADE_TRAJETORIA = 2.0f; // unidades por segundo, medidas ao longo da curva
 int objetoAtual = 0;
 
 const GLuint WIDTH = 800, HEIGHT = 800;
+// Tempo máximo por quadro gasto enviando assets carregados para a GPU (s)
+const double ORCAMENTO_UPLOAD = 0.004;
+const float PLANO_DISTANTE = 100.0f;
 
 // Vertex Shader com Phong
 const char* vertexShaderSource = R"(
@@ -72,9 +99,16 @@ layout(location = 1) in vec3 cor;
 layout(location = 2) in vec3 normal;
 layout(location = 3) in vec2 texCoord;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Por instância (RenderizadorInstanciado)
+layout(location = 4) in mat4 model;
+layout(location = 8) in mat3 normalMatrix; // transposta da inversa de mat3(model), calculada na CPU
+
+layout(std140) uniform Quadro {
+    mat4 view;
+    mat4 projection;
+    vec4 lightPos;
+    vec4 camPos;
+};
 
 out vec3 vNormal;
 out vec3 vFragPos;
@@ -83,7 +117,7 @@ out vec2 vTexCoord;
 
 void main() {
     vFragPos = vec3(model * vec4(pos, 1.0));
-    vNormal = mat3(transpose(inverse(model))) * normal;
+    vNormal = normalMatrix * normal;
     vColor = cor;
     vTexCoord = texCoord;
     gl_Position = projection * view * model * vec4(pos, 1.0);
@@ -101,23 +135,31 @@ in vec2 vTexCoord;
 out vec4 FragColor;
 
 uniform sampler2D tex;
-uniform vec3 lightPos;
-uniform vec3 camPos;
-uniform float ka;
-uniform float kd;
-uniform float ks;
-uniform float ns;
+
+layout(std140) uniform Quadro {
+    mat4 view;
+    mat4 projection;
+    vec4 lightPos;
+    vec4 camPos;
+};
+
+layout(std140) uniform Material {
+    float ka;
+    float kd;
+    float ks;
+    float ns;
+};
 
 void main() {
     vec3 lightColor = vec3(1.0);
     vec3 ambient = ka * lightColor;
 
     vec3 norm = normalize(vNormal);
-    vec3 lightDir = normalize(lightPos - vFragPos);
+    vec3 lightDir = normalize(lightPos.xyz - vFragPos);
     float diff = max(dot(norm, lightDir), 0.0);
     vec3 diffuse = kd * diff * lightColor;
 
-    vec3 viewDir = normalize(camPos - vFragPos);
+    vec3 viewDir = normalize(camPos.xyz - vFragPos);
     vec3 reflectDir = reflect(-lightDir, norm);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), ns);
     vec3 specular = ks * spec * lightColor;
@@ -147,7 +189,12 @@ public:
     }
 
     glm::mat4 getViewMatrix() {
-        return glm::lookAt(position, position + front, up);
+        return getViewMatrix(position);
+    }
+
+    // View a partir de outra posição do olho (a interpolada), com a mesma orientação
+    glm::mat4 getViewMatrix(const glm::vec3& eye) {
+        return glm::lookAt(eye, eye + front, up);
     }
 
     void processKeyboard(char direction, float deltaTime) {
@@ -189,6 +236,9 @@ float lastY = HEIGHT / 2.0f;
 bool firstMouse = true;
 float deltaTime = 0.016f;
 float lastFrame = 0.0f;
+// Câmera e trajetórias andam em passos fixos de 1/120 s, independentes dos quadros
+PassoFixo relogio(120.0);
+bool pedidoSelecao = false; // clique atendido no quadro seguinte, com as caixas em dia
 
 // Modo de edição de trajetória
 bool modoEdicaoTrajetoria = false;
@@ -196,23 +246,36 @@ bool mostrarPontosControle = true;
 
 // Protótipos
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+void moverCamera(GLFWwindow* window, float dt);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+void selecionarObjeto(GLFWwindow* window, const BVHCena& bvh, const BlocoQuadro& quadro);
 GLuint criarShader();
-GLuint carregarTextura(const char* caminho);
-int carregarOBJ(const string& objPath, int& nVertices, GLuint& texID, float& ka, float& kd, float& ks, float& ns);
+GLuint criarVAO(const void* vertices, size_t bytesVertices, const void* indices, size_t bytesIndices, GLuint& vbo,
+                GLuint& ebo);
+void apagarVAO(Objeto3D& obj);
+GLuint criarTextura(const unsigned char* pixels, int w, int h, int c);
+void criarPlaceholder(Objeto3D& obj, CacheTexturas& texturas);
+void enviarAssetsProntos(CarregadorAssincrono& carregador, CacheTexturas& texturas, TabelaMateriais& materiais,
+                         double orcamento);
 
 // Funções de trajetória
-void adicionarPontoControle(Objeto3D& obj, const glm::vec3& ponto);
-void atualizarTrajetoria(Objeto3D& obj, float deltaTime);
-void salvarTrajetoria(const Objeto3D& obj, const string& nomeArquivo);
-void carregarTrajetoria(Objeto3D& obj, const string& nomeArquivo);
-void desenharPontosControle(const vector<glm::vec3>& pontos);
+void adicionarPontoControle(uint32_t indice, const glm::vec3& ponto);
+void refazerTrajetoria(uint32_t indice);
+void salvarTrajetoria(const Objeto3D& obj, const string& nomeBase);
+void carregarTrajetoria(uint32_t indice, const string& nomeBase);
 
 int main() {
+    auto inicioPrograma = chrono::steady_clock::now();
     if (!glfwInit()) {
         cerr << "Erro ao inicializar GLFW" << endl;
         return -1;
     }
+    // Nada aqui usa o pipeline fixo (o desenho de depuração tem shader próprio): core profile
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "M6 - Rodrigo Pires", nullptr, nullptr);
     if (!window) {
         cerr << "Erro ao criar janela" << endl;
@@ -222,6 +285,7 @@ int main() {
     glfwMakeContextCurrent(window);
     glfwSetKeyCallback(window, key_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
         cerr << "Erro ao inicializar GLAD" << endl;
@@ -230,93 +294,156 @@ int main() {
     glViewport(0, 0, WIDTH, HEIGHT);
     glEnable(GL_DEPTH_TEST);
 
-    GLuint shader = criarShader();
-    glUseProgram(shader);
-
-    // Carregar Suzanne
-    int nVertices; GLuint texID;
-    float ka, kd, ks, ns;
-    GLuint vao = carregarOBJ("../assets/Modelos3D/Suzanne.obj", nVertices, texID, ka, kd, ks, ns);
-    cena.push_back({vao, texID, nVertices});
+    ProgramaShader shader(criarShader());
+    shader.usar();
+    ligarBlocosUniformes(shader.programa());
+    RenderizadorInstanciado renderizador;
+    renderizador.criar();
+    DesenhoDepuracao depuracao;
+    depuracao.criar();
+    FilaRenderizacao fila;
+    BVHCena bvh;
+    vector<CaixaAlinhada> caixas; // AABB no mundo de cada objeto da cena
+    vector<uint32_t> visiveis;
+
+    // Suzanne é lida em segundo plano; até lá aparece um cubo branco no lugar
+    // Uma decodificação e um envio por imagem, por mais objetos que a usem
+    CacheTexturas texturas(criarTextura, [](unsigned id) { glDeleteTextures(1, &id); });
+    CarregadorAssincrono carregador(texturas);
+    cena.push_back(Objeto3D());
+    grafo.adicionar(GrafoCena::NENHUM, glm::vec3(0.0f));
+    criarPlaceholder(cena[0], texturas);
+    carregador.pedirModelo(0, "../assets/Modelos3D/Suzanne.obj", "../assets/tex/pixelWall.png");
     
-    // Inicializar variáveis de trajetória
-    cena[0].pontoAtual = 0;
-    cena[0].tempoTrajetoria = 0.0f;
-    cena[0].trajetoriaAtiva = false;
-
-    // Uniforms fixos
-    glm::vec3 lightPos(2.0f, 2.0f, 2.0f);
-    glUniform3fv(glGetUniformLocation(shader, "lightPos"), 1, &lightPos[0]);
-    glUniform1f(glGetUniformLocation(shader, "ka"), ka);
-    glUniform1f(glGetUniformLocation(shader, "kd"), kd);
-    glUniform1f(glGetUniformLocation(shader, "ks"), ks);
-    glUniform1f(glGetUniformLocation(shader, "ns"), ns);
-    glUniform1i(glGetUniformLocation(shader, "tex"), 0);
-
-    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)WIDTH/HEIGHT, 0.1f, 100.0f);
-    glUniformMatrix4fv(glGetUniformLocation(shader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-
+    // Trajetória sem pontos e desativada até o P
+    trajetorias.adicionar(0, trajetorias.adicionarCurva(cena[0].pontosControle, cena[0].modoTrajetoria),
+                          VELOCIDADE_TRAJETORIA);
+
+    // Blocos de uniforms: câmera e luz (por quadro) e materiais (por objeto)
+    BufferUniforme<BlocoQuadro> blocoQuadro;
+    blocoQuadro.criar(PONTO_BLOCO_QUADRO);
+    TabelaMateriais materiais;
+    materiais.criar(PONTO_BLOCO_MATERIAL);
+    materiais.adicionar(BlocoMaterial()); // 0: material padrão, usado pelo placeholder
+    shader.definir("tex", 0);
+
+    BlocoQuadro quadro;
+    quadro.lightPos = glm::vec4(2.0f, 2.0f, 2.0f, 1.0f);
+    quadro.projection = glm::perspective(glm::radians(45.0f), (float)WIDTH/HEIGHT, 0.1f, PLANO_DISTANTE);
+
+    bool primeiroQuadro = true;
+    size_t quadros = 0, quadrosSemRecalculo = 0;
+    glm::vec3 posicaoCameraAnterior = camera.position; // estado da câmera no penúltimo passo
     while (!glfwWindowShouldClose(window)) {
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
         glfwPollEvents();
+
+        // Simulação: quantos passos fixos couberem no tempo do quadro, com o
+        // teclado consultado a cada passo; as trajetórias só andam as distâncias
+        int passos = relogio.avancar(deltaTime);
+        for (int p = 0; p < passos; ++p) {
+            posicaoCameraAnterior = camera.position;
+            moverCamera(window, relogio.dt());
+            trajetorias.avancar(relogio.dt());
+        }
+        // O desenho fica entre os dois últimos passos, alfa do caminho
+        float alfa = relogio.alfa();
+        glm::vec3 posicaoCamera = glm::mix(posicaoCameraAnterior, camera.position, alfa);
+        trajetorias.gravarPosicoes(grafo.locais(), (1.0f - alfa) * relogio.dt());
+
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glUseProgram(shader);
-        glm::mat4 view = camera.getViewMatrix();
-        glUniformMatrix4fv(glGetUniformLocation(shader, "view"), 1, GL_FALSE, glm::value_ptr(view));
+        shader.usar();
+        enviarAssetsProntos(carregador, texturas, materiais, ORCAMENTO_UPLOAD);
+        materiais.enviar();
+        quadro.view = camera.getViewMatrix(posicaoCamera);
+        quadro.camPos = glm::vec4(posicaoCamera, 1.0f);
+        blocoQuadro.atualizar(quadro);
         
-        // Atualizar trajetórias
-        for (auto& obj : cena) {
-            if (obj.trajetoriaAtiva && !obj.pontosControle.empty()) {
-                atualizarTrajetoria(obj, deltaTime);
+        // Só os objetos que mudaram desde o quadro anterior têm as matrizes refeitas
+        size_t refeitas = grafo.atualizar();
+        if (refeitas == 0) ++quadrosSemRecalculo;
+        ++quadros;
+        // BVH das caixas da cena: reconstruída quando a cena muda de tamanho;
+        // fora isso as caixas dos objetos refeitos (os que andam nas
+        // trajetórias, a cada quadro) são trocadas e a árvore reajustada
+        if (bvh.tamanho() != cena.size()) {
+            caixas.resize(cena.size());
+            for (uint32_t i = 0; i < cena.size(); ++i) caixas[i] = caixaMundo(grafo.mundo(i), cena[i].limites);
+            bvh.construir(caixas);
+        } else if (refeitas > 0) {
+            for (uint32_t i : grafo.recalculados()) {
+                caixas[i] = caixaMundo(grafo.mundo(i), cena[i].limites);
+                bvh.atualizar(i, caixas[i]);
             }
+            if (bvh.reajustar()) bvh.construir(caixas);
         }
-        
-        for (const auto& obj : cena) {
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, obj.pos);
-            model = glm::rotate(model, obj.rot.x, glm::vec3(1,0,0));
-            model = glm::rotate(model, obj.rot.y, glm::vec3(0,1,0));
-            model = glm::rotate(model, obj.rot.z, glm::vec3(0,0,1));
-            model = glm::scale(model, obj.escala);
-            glUniformMatrix4fv(glGetUniformLocation(shader, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, obj.textura);
-            glBindVertexArray(obj.vao);
-            glDrawArrays(GL_TRIANGLES, 0, obj.nVertices);
+        if (pedidoSelecao) {
+            pedidoSelecao = false;
+            selecionarObjeto(window, bvh, quadro);
+        }
+        // Só o que está no frustum entra na fila
+        bvh.consultarFrustum(Frustum::extrair(quadro.projection * quadro.view), visiveis);
+        // Ordena por programa/textura/material/VAO e, dentro disso, da frente para trás
+        fila.limpar();
+        for (uint32_t i : visiveis) {
+            const Objeto3D& obj = cena[i];
+            float distancia = -(quadro.view * grafo.mundo(i)[3]).z;
+            fila.adicionar(shader.programa(), obj.textura->id, obj.material, obj.vao, distancia / PLANO_DISTANTE, i);
         }
+        fila.ordenar();
+        renderizador.comecar();
+        for (const ItemFila& item : fila.ordenados()) {
+            const Objeto3D& obj = cena[item.indice];
+            renderizador.adicionar(shader.programa(), obj.vao, obj.textura->id, obj.material, obj.nIndices,
+                                   obj.tipoIndice, grafo.mundo(item.indice), grafo.normalMundo(item.indice),
+                                   item.indice, grafo.recalculado(item.indice));
+        }
+        renderizador.desenhar(materiais);
         
-        // Desenhar pontos de controle se estiver no modo de edição
-        if (modoEdicaoTrajetoria && mostrarPontosControle && !cena[objetoAtual].pontosControle.empty()) {
-            desenharPontosControle(cena[objetoAtual].pontosControle);
+        // Curva e pontos de controle do objeto atual no modo de edição
+        if (modoEdicaoTrajetoria && mostrarPontosControle) {
+            Objeto3D& obj = cena[objetoAtual];
+            obj.poligonal.atualizar(obj.pontosControle, obj.modoTrajetoria);
+            depuracao.adicionar(obj.poligonal);
         }
+        depuracao.desenhar();
         
         glfwSwapBuffers(window);
+        if (primeiroQuadro) {
+            primeiroQuadro = false;
+            chrono::duration<double, milli> t = chrono::steady_clock::now() - inicioPrograma;
+            cout << "Tempo até o primeiro quadro: " << t.count() << " ms" << endl;
+        }
     }
+    cout << quadrosSemRecalculo << " de " << quadros << " quadros sem nenhuma matriz refeita" << endl;
+    cout << relogio.passosSimulados() << " passos de simulação (" << relogio.passosDescartados()
+         << " descartados em quadros lentos)" << endl;
+    EstatisticasTexturas stats = texturas.estatisticas();
+    cout << stats.decodificacoes << " texturas decodificadas, " << stats.envios << " enviadas à GPU, " << stats.reusos
+         << " reaproveitadas; " << stats.residentes << " residentes (" << stats.bytesGPU / 1024 << " KB)" << endl;
+    for (Objeto3D& obj : cena) apagarVAO(obj);
+    cena.clear(); // as texturas são apagadas enquanto o contexto existe
     glfwTerminate();
     return 0;
 }
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
     if (action != GLFW_PRESS && action != GLFW_REPEAT) return;
-    Objeto3D& obj = cena[objetoAtual];
+    uint32_t indice = objetoAtual; // TAB troca objetoAtual no meio do switch
+    Objeto3D& obj = cena[indice];
+    glm::vec3 rot = grafo.locais().rotacao(indice);
+    glm::vec3 escala = grafo.locais().escala(indice);
     switch (key) {
-        // Controles de câmera
-        case GLFW_KEY_W: camera.processKeyboard('W', deltaTime); break;
-        case GLFW_KEY_S: camera.processKeyboard('S', deltaTime); break;
-        case GLFW_KEY_A: camera.processKeyboard('A', deltaTime); break;
-        case GLFW_KEY_D: camera.processKeyboard('D', deltaTime); break;
-        case GLFW_KEY_Q: camera.processKeyboard('Q', deltaTime); break;
-        case GLFW_KEY_E: camera.processKeyboard('E', deltaTime); break;
         
         // Controles de objeto (rotação e escala)
-        case GLFW_KEY_X: obj.rot.x += glm::radians(10.0f); break;
-        case GLFW_KEY_Y: obj.rot.y += glm::radians(10.0f); break;
-        case GLFW_KEY_Z: obj.rot.z += glm::radians(10.0f); break;
-        case GLFW_KEY_KP_ADD: obj.escala *= 1.1f; break;
-        case GLFW_KEY_KP_SUBTRACT: obj.escala *= 0.9f; break;
+        case GLFW_KEY_X: rot.x += glm::radians(10.0f); break;
+        case GLFW_KEY_Y: rot.y += glm::radians(10.0f); break;
+        case GLFW_KEY_Z: rot.z += glm::radians(10.0f); break;
+        case GLFW_KEY_KP_ADD: escala *= 1.1f; break;
+        case GLFW_KEY_KP_SUBTRACT: escala *= 0.9f; break;
         
         // Controles de trajetória
         case GLFW_KEY_T: 
@@ -325,23 +452,28 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
             break;
         case GLFW_KEY_SPACE:
             if (modoEdicaoTrajetoria) {
-                adicionarPontoControle(obj, camera.position);
+                adicionarPontoControle(indice, camera.position);
                 cout << "Ponto adicionado na posição: (" << camera.position.x << ", " << camera.position.y << ", " << camera.position.z << ")" << endl;
             }
             break;
         case GLFW_KEY_P:
-            obj.trajetoriaAtiva = !obj.trajetoriaAtiva;
-            cout << "Trajetória: " << (obj.trajetoriaAtiva ? "ATIVADA" : "DESATIVADA") << endl;
+            trajetorias.definirAtiva(indice, !trajetorias.ativa(indice));
+            cout << "Trajetória: " << (trajetorias.ativa(indice) ? "ATIVADA" : "DESATIVADA") << endl;
             break;
         case GLFW_KEY_C:
             obj.pontosControle.clear();
-            obj.pontoAtual = 0;
-            obj.tempoTrajetoria = 0.0f;
+            refazerTrajetoria(indice);
+            trajetorias.definirDistancia(indice, 0.0f);
             cout << "Pontos de controle limpos" << endl;
             break;
         case GLFW_KEY_V:
             mostrarPontosControle = !mostrarPontosControle;
             break;
+        case GLFW_KEY_M:
+            obj.modoTrajetoria = (ModoTrajetoria)((obj.modoTrajetoria + 1) % N_MODOS_TRAJETORIA);
+            refazerTrajetoria(indice);
+            cout << "Curva: " << nomeModoTrajetoria(obj.modoTrajetoria) << endl;
+            break;
         
         // Navegação entre objetos
         case GLFW_KEY_TAB:
@@ -349,16 +481,27 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
             cout << "Objeto selecionado: " << objetoAtual << endl;
             break;
         
+        // Hierarquia: o objeto atual passa a acompanhar o objeto 0 (H de novo solta)
+        case GLFW_KEY_H:
+            if (indice != 0) {
+                bool preso = grafo.pai(indice) == GrafoCena::NENHUM;
+                grafo.definirPai(indice, preso ? 0 : GrafoCena::NENHUM);
+                cout << "Objeto " << indice << (preso ? " preso ao objeto 0" : " solto") << endl;
+            }
+            break;
+        
         // Salvar e Carregar trajetória
         case GLFW_KEY_F5:
-            salvarTrajetoria(obj, "trajetoria_" + to_string(objetoAtual) + ".txt");
+            salvarTrajetoria(obj, "trajetoria_" + to_string(objetoAtual));
             break;
         case GLFW_KEY_F9:
-            carregarTrajetoria(obj, "trajetoria_" + to_string(objetoAtual) + ".txt");
+            carregarTrajetoria(indice, "trajetoria_" + to_string(objetoAtual));
             break;
         
         case GLFW_KEY_ESCAPE: glfwSetWindowShouldClose(window, true); break;
     }
+    grafo.locais().definirRotacao(indice, rot);
+    grafo.locais().definirEscala(indice, escala);
 }
 
 GLuint criarShader() {
@@ -377,85 +520,18 @@ GLuint criarShader() {
     return prog;
 }
 
-GLuint carregarTextura(const char* caminho) {
-    GLuint texID;
-    glGenTextures(1, &texID);
-    int w, h, c;
-    unsigned char* data = stbi_load(caminho, &w, &h, &c, 0);
-    if (data) {
-        GLenum format = (c == 4) ? GL_RGBA : GL_RGB;
-        glBindTexture(GL_TEXTURE_2D, texID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, w, h, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        stbi_image_free(data);
-    } else {
-        cout << "Falha ao carregar textura: " << caminho << endl;
-        stbi_image_free(data);
-    }
-    return texID;
-}
-
-int carregarOBJ(const string& objPath, int& nVertices, GLuint& texID, float& ka, float& kd, float& ks, float& ns) {
-    vector<glm::vec3> pos;
-    vector<glm::vec3> norm;
-    vector<glm::vec2> tex;
-    vector<GLfloat> buffer;
-    string mtlFile, texFile;
-    ka = 0.1f; kd = 0.7f; ks = 0.5f; ns = 32.0f;
-    ifstream arq(objPath);
-    if (!arq.is_open()) return -1;
-    string line;
-    while (getline(arq, line)) {
-        istringstream iss(line);
-        string t; iss >> t;
-        if (t == "mtllib") {
-            iss >> mtlFile;
-            ifstream mtl("../assets/Modelos3D/" + mtlFile);
-            if (mtl.is_open()) {
-                string l;
-                while (getline(mtl, l)) {
-                    istringstream mtliss(l);
-                    string tk; mtliss >> tk;
-                    if (tk == "map_Kd") mtliss >> texFile;
-                    else if (tk == "Ka") mtliss >> ka;
-                    else if (tk == "Kd") mtliss >> kd;
-                    else if (tk == "Ks") mtliss >> ks;
-                    else if (tk == "Ns") mtliss >> ns;
-                }
-            }
-        } else if (t == "v") {
-            glm::vec3 v; iss >> v.x >> v.y >> v.z; pos.push_back(v);
-        } else if (t == "vn") {
-            glm::vec3 n; iss >> n.x >> n.y >> n.z; norm.push_back(n);
-        } else if (t == "vt") {
-            glm::vec2 vt; iss >> vt.x >> vt.y; tex.push_back(vt);
-        } else if (t == "f") {
-            for (int i = 0; i < 3; ++i) {
-                string f; iss >> f;
-                int vi, ti, ni;
-                sscanf(f.c_str(), "%d/%d/%d", &vi, &ti, &ni);
-                vi--; ti--; ni--;
-                glm::vec3 v = pos[vi];
-                glm::vec3 n = norm[ni];
-                glm::vec2 t = tex[ti];
-                t.y = 1.0f - t.y;
-                buffer.push_back(v.x); buffer.push_back(v.y); buffer.push_back(v.z);
-                buffer.push_back(1.0f); buffer.push_back(1.0f); buffer.push_back(1.0f);
-                buffer.push_back(n.x); buffer.push_back(n.y); buffer.push_back(n.z);
-                buffer.push_back(t.x); buffer.push_back(t.y);
-            }
-        }
-    }
-    GLuint VBO, VAO;
+// Cria VAO/VBO/EBO no layout de 11 floats (pos, cor, normal, uv)
+GLuint criarVAO(const void* vertices, size_t bytesVertices, const void* indices, size_t bytesIndices, GLuint& VBO,
+                GLuint& EBO) {
+    GLuint VAO;
     glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
     glGenVertexArrays(1, &VAO);
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, buffer.size() * sizeof(GLfloat), buffer.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, bytesVertices, vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, bytesIndices, indices, GL_STATIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (void*)0);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
@@ -465,12 +541,114 @@ int carregarOBJ(const string& objPath, int& nVertices, GLuint& texID, float& ka,
     glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (void*)(9 * sizeof(GLfloat)));
     glEnableVertexAttribArray(3);
     glBindVertexArray(0);
-    nVertices = buffer.size() / 11;
-    if (!texFile.empty()) texID = carregarTextura(("../assets/Modelos3D/" + texFile).c_str());
-    else texID = carregarTextura("../assets/tex/pixelWall.png");
     return VAO;
 }
 
+// Apaga o VAO e os buffers do objeto (nomes 0 são ignorados pelo OpenGL)
+void apagarVAO(Objeto3D& obj) {
+    glDeleteVertexArrays(1, &obj.vao);
+    glDeleteBuffers(1, &obj.vbo);
+    glDeleteBuffers(1, &obj.ebo);
+    obj.vao = obj.vbo = obj.ebo = 0;
+}
+
+GLuint criarTextura(const unsigned char* pixels, int w, int h, int c) {
+    GLuint texID;
+    glGenTextures(1, &texID);
+    GLenum format = (c == 4) ? GL_RGBA : GL_RGB;
+    glBindTexture(GL_TEXTURE_2D, texID);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, w, h, 0, format, GL_UNSIGNED_BYTE, pixels);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return texID;
+}
+
+// Cubo unitário e textura branca 1x1, usados no lugar dos modelos enquanto carregam
+void criarPlaceholder(Objeto3D& obj, CacheTexturas& texturas) {
+    vector<GLfloat> vertices;
+    vector<GLushort> indices;
+    const int ordem[2][6] = { {0, 2, 1, 0, 3, 2}, {0, 1, 2, 0, 2, 3} };
+    for (int eixo = 0; eixo < 3; ++eixo) {
+        for (int lado = -1; lado <= 1; lado += 2) {
+            glm::vec3 n(0.0f), u(0.0f), w(0.0f);
+            n[eixo] = (float)lado;
+            u[(eixo + 1) % 3] = 0.5f;
+            w[(eixo + 2) % 3] = 0.5f;
+            size_t base = vertices.size() / 11;
+            for (int k = 0; k < 4; ++k) {
+                float s = (k == 1 || k == 2) ? 1.0f : -1.0f;
+                float t = (k >= 2) ? 1.0f : -1.0f;
+                glm::vec3 p = n * 0.5f + u * s + w * t;
+                vertices.insert(vertices.end(), { p.x, p.y, p.z, 1.0f, 1.0f, 1.0f, n.x, n.y, n.z, (s + 1.0f) * 0.5f, (t + 1.0f) * 0.5f });
+            }
+            for (int i : ordem[lado > 0]) indices.push_back((GLushort)(base + i));
+        }
+    }
+    obj.vao = criarVAO(vertices.data(), vertices.size() * sizeof(GLfloat), indices.data(), indices.size() * sizeof(GLushort),
+                       obj.vbo, obj.ebo);
+    obj.nIndices = indices.size();
+    obj.tipoIndice = GL_UNSIGNED_SHORT;
+    obj.limites = calcularLimites(vertices.data(), vertices.size() / 11, 11);
+    obj.textura = texturas.branca();
+}
+
+// Envia para a GPU o que as threads do carregador deixaram pronto. Sempre
+// envia ao menos um item e para quando o orçamento do quadro (em segundos) acaba.
+void enviarAssetsProntos(CarregadorAssincrono& carregador, CacheTexturas& texturas, TabelaMateriais& materiais,
+                         double orcamento) {
+    double limite = glfwGetTime() + orcamento;
+    do {
+        unique_ptr<AssetPronto> asset = carregador.proximo();
+        if (!asset) break;
+        if (!asset->ok) {
+            cout << "Falha ao carregar: " << asset->caminho << endl;
+            continue;
+        }
+        Objeto3D& obj = cena[asset->id];
+        if (asset->tipo == ASSET_MALHA) {
+            const MalhaCacheada& malha = asset->malha;
+            cout << asset->caminho
+                 << (malha.doCache        ? ": cache binário"
+                     : malha.cacheGravado ? ": lido do .obj, cache gravado"
+                                          : ": lido do .obj, falha ao gravar o cache (mantido na memória)")
+                 << endl;
+            // Índices já estão no tamanho certo (16 ou 32 bits) dentro do cache
+            apagarVAO(obj); // o do placeholder
+            obj.vao = criarVAO(malha.vertices, malha.bytesVertices(), malha.indices, malha.bytesIndices(), obj.vbo,
+                               obj.ebo);
+            obj.nIndices = malha.nIndices();
+            obj.tipoIndice = malha.indices16Bits() ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+            obj.limites = malha.limites();
+            auto bvhMalha = make_shared<BVHTriangulos>();
+            malha.copiarBVH(*bvhMalha);
+            obj.bvhMalha = bvhMalha;
+            BlocoMaterial material;
+            material.ka = malha.material.ka;
+            material.kd = malha.material.kd;
+            material.ks = malha.material.ks;
+            material.ns = malha.material.ns;
+            obj.material = materiais.adicionar(material);
+        } else {
+            // Imagem nula: a textura já está na GPU e o cache só devolve a referência
+            if (RefTextura textura = texturas.textura(asset->chave, asset->imagem.get())) obj.textura = textura;
+        }
+    } while (glfwGetTime() < limite);
+}
+
+// WASD/QE consultados a cada passo de simulação: a velocidade não depende
+// da repetição de teclas nem da taxa de quadros
+void moverCamera(GLFWwindow* window, float dt) {
+    const struct { int tecla; char direcao; } teclas[] = {
+        { GLFW_KEY_W, 'W' }, { GLFW_KEY_S, 'S' }, { GLFW_KEY_A, 'A' },
+        { GLFW_KEY_D, 'D' }, { GLFW_KEY_Q, 'Q' }, { GLFW_KEY_E, 'E' }
+    };
+    for (const auto& t : teclas)
+        if (glfwGetKey(window, t.tecla) == GLFW_PRESS) camera.processKeyboard(t.direcao, dt);
+}
+
 // Callback de mouse
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
     if (firstMouse) {
@@ -486,123 +664,66 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
 }
 
 // Funções de trajetória
-void adicionarPontoControle(Objeto3D& obj, const glm::vec3& ponto) {
+void adicionarPontoControle(uint32_t indice, const glm::vec3& ponto) {
+    Objeto3D& obj = cena[indice];
     obj.pontosControle.push_back(ponto);
+    refazerTrajetoria(indice);
     cout << "Ponto " << obj.pontosControle.size() << " adicionado" << endl;
 }
 
-void atualizarTrajetoria(Objeto3D& obj, float deltaTime) {
-    if (obj.pontosControle.size() < 2) return;
-    
-    const float velocidade = 2.0f; // unidades por segundo
-    obj.tempoTrajetoria += deltaTime * velocidade;
-    
-    // Calcular posição atual na trajetória
-    float tempoTotal = obj.pontosControle.size();
-    float tempoNormalizado = fmod(obj.tempoTrajetoria, tempoTotal);
-    
-    int indiceAtual = static_cast<int>(tempoNormalizado);
-    int indiceProximo = (indiceAtual + 1) % obj.pontosControle.size();
-    
-    float t = tempoNormalizado - indiceAtual;
-    
-    // Interpolação linear entre pontos
-    glm::vec3 posAtual = obj.pontosControle[indiceAtual];
-    glm::vec3 posProximo = obj.pontosControle[indiceProximo];
-    obj.pos = glm::mix(posAtual, posProximo, t);
+// Curva nova para os pontos e o modo atuais (a antiga fica no pool do sistema)
+void refazerTrajetoria(uint32_t indice) {
+    Objeto3D& obj = cena[indice];
+    obj.poligonal.invalidar();
+    trajetorias.trocarCurva(indice, trajetorias.adicionarCurva(obj.pontosControle, obj.modoTrajetoria));
 }
 
-void salvarTrajetoria(const Objeto3D& obj, const string& nomeArquivo) {
-    ofstream arquivo(nomeArquivo);
-    if (arquivo.is_open()) {
-        for (const auto& ponto : obj.pontosControle) {
-            arquivo << ponto.x << " " << ponto.y << " " << ponto.z << endl;
-        }
-        arquivo.close();
+void salvarTrajetoria(const Objeto3D& obj, const string& nomeBase) {
+    string nomeArquivo = nomeBase + ".trj";
+    if (gravarTrajetoria(nomeArquivo, obj.pontosControle, obj.modoTrajetoria)) {
         cout << "Trajetória salva em: " << nomeArquivo << endl;
     } else {
         cout << "Erro ao salvar trajetória" << endl;
     }
 }
 
-void carregarTrajetoria(Objeto3D& obj, const string& nomeArquivo) {
-    ifstream arquivo(nomeArquivo);
-    if (arquivo.is_open()) {
-        obj.pontosControle.clear();
-        float x, y, z;
-        while (arquivo >> x >> y >> z) {
-            obj.pontosControle.push_back(glm::vec3(x, y, z));
-        }
-        arquivo.close();
-        obj.pontoAtual = 0;
-        obj.tempoTrajetoria = 0.0f;
-        cout << "Trajetória carregada de: " << nomeArquivo << " (" << obj.pontosControle.size() << " pontos)" << endl;
+// O binário tem preferência; o texto antigo ainda é importado
+void carregarTrajetoria(uint32_t indice, const string& nomeBase) {
+    Objeto3D& obj = cena[indice];
+    string nomeArquivo = nomeBase + ".trj";
+    TrajetoriaMapeada mapeada;
+    if (abrirTrajetoria(nomeArquivo, mapeada)) {
+        mapeada.copiarPontos(obj.pontosControle);
+        obj.modoTrajetoria = mapeada.modo();
     } else {
-        cout << "Erro ao carregar trajetória: " << nomeArquivo << endl;
+        nomeArquivo = nomeBase + ".txt";
+        if (!importarTrajetoriaTexto(nomeArquivo, obj.pontosControle)) {
+            cout << "Erro ao carregar trajetória: " << nomeBase << ".trj / .txt" << endl;
+            return;
+        }
     }
+    refazerTrajetoria(indice);
+    trajetorias.definirDistancia(indice, 0.0f);
+    cout << "Trajetória carregada de: " << nomeArquivo << " (" << obj.pontosControle.size() << " pontos, "
+         << nomeModoTrajetoria(obj.modoTrajetoria) << ")" << endl;
 }
 
-void desenharPontosControle(const vector<glm::vec3>& pontos) {
-    // Desabilitar textura para desenhar pontos
-    glBindTexture(GL_TEXTURE_2D, 0);
-    
-    // Desenhar linhas conectando os pontos
-    if (pontos.size() > 1) {
-        glBegin(GL_LINE_STRIP);
-        glColor3f(0.0f, 1.0f, 0.0f); // Verde para linhas
-        for (const auto& ponto : pontos) {
-            glVertex3f(ponto.x, ponto.y, ponto.z);
-        }
-        // Fechar o loop conectando o último ponto ao primeiro
-        if (pontos.size() > 2) {
-            glVertex3f(pontos.front().x, pontos.front().y, pontos.front().z);
-        }
-        glEnd();
-    }
-    
-    // Desenhar cada ponto como um pequeno cubo
-    for (const auto& ponto : pontos) {
-        glPushMatrix();
-        glTranslatef(ponto.x, ponto.y, ponto.z);
-        glColor3f(1.0f, 0.0f, 0.0f); // Vermelho para pontos
-        
-        // Desenhar um pequeno cubo
-        float size = 0.05f;
-        glBegin(GL_QUADS);
-        // Frente
-        glVertex3f(-size, -size, size);
-        glVertex3f(size, -size, size);
-        glVertex3f(size, size, size);
-        glVertex3f(-size, size, size);
-        // Traseira
-        glVertex3f(-size, -size, -size);
-        glVertex3f(-size, size, -size);
-        glVertex3f(size, size, -size);
-        glVertex3f(size, -size, -size);
-        // Topo
-        glVertex3f(-size, size, -size);
-        glVertex3f(-size, size, size);
-        glVertex3f(size, size, size);
-        glVertex3f(size, size, -size);
-        // Base
-        glVertex3f(-size, -size, -size);
-        glVertex3f(size, -size, -size);
-        glVertex3f(size, -size, size);
-        glVertex3f(-size, -size, size);
-        // Direita
-        glVertex3f(size, -size, -size);
-        glVertex3f(size, size, -size);
-        glVertex3f(size, size, size);
-        glVertex3f(size, -size, size);
-        // Esquerda
-        glVertex3f(-size, -size, -size);
-        glVertex3f(-size, -size, size);
-        glVertex3f(-size, size, size);
-        glVertex3f(-size, size, -size);
-        glEnd();
-        
-        glPopMatrix();
-    }
-    
-    glColor3f(1.0f, 1.0f, 1.0f); // Restaurar cor branca
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) pedidoSelecao = true;
+}
+
+// Seleciona o objeto sob o cursor; com o cursor preso pela câmera, sob a mira no centro da tela
+void selecionarObjeto(GLFWwindow* window, const BVHCena& bvh, const BlocoQuadro& quadro) {
+    double x = WIDTH / 2.0, y = HEIGHT / 2.0;
+    if (glfwGetInputMode(window, GLFW_CURSOR) != GLFW_CURSOR_DISABLED) glfwGetCursorPos(window, &x, &y);
+    RaioSelecao raio = raioDaTela(x, y, WIDTH, HEIGHT, quadro.projection, quadro.view);
+    Selecao s = selecionar(bvh, raio,
+                           [](uint32_t i) { return grafo.mundo(i); },
+                           [](uint32_t i) { return cena[i].bvhMalha.get(); });
+    if (!s.acertou()) return;
+    objetoAtual = s.objeto;
+    cout << "Objeto selecionado: " << objetoAtual;
+    if (s.triangulo != TRIANGULO_NENHUM)
+        cout << " (triângulo " << s.triangulo << ", baricêntricas " << 1.0f - s.u - s.v << " " << s.u << " " << s.v << ")";
+    cout << endl;
 }
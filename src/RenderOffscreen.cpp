@@ -0,0 +1,371 @@
+/*	Renderização sem janela: gera uma sequência de imagens de um modelo
+    Desenha o modelo (Phong, com a textura do .mtl) num FBO do tamanho
+    pedido e grava cada quadro em PNG ou PPM (RenderizacaoOffscreen.h),
+    com a câmera seguindo uma trajetória gravada ou orbitando o modelo.
+
+    Sem DISPLAY/WAYLAND_DISPLAY (ou com --sem-display) a GLFW é iniciada
+    na plataforma nula e o contexto vem do OSMesa ou, se ele não estiver
+    disponível, do EGL: roda num servidor sem X, inclusive com o Mesa
+    llvmpipe (LIBGL_ALWAYS_SOFTWARE=1). Com display, usa uma janela oculta.
+
+    A câmera olha sempre para o centro do modelo. Com --camera:
+      .trj  - abrirTrajetoria; .txt - importarTrajetoriaTexto ("x y z [t]")
+    Se os pontos têm tempos, a posição no quadro q é interpolada no tempo
+    q / fps; sem tempos, a câmera percorre a curva (no modo gravado, ou
+    Catmull-Rom no texto) a --velocidade unidades por segundo.
+
+    Uso: RenderOffscreen modelo.obj [--camera caminho.trj|.txt]
+         [--quadros inicio:fim] [--fps 30] [--tamanho 1280x720]
+         [--formato png|ppm] [--saida quadros/q] [--pbos 3]
+         [--velocidade 2] [--sem-display]
+    Grava <saida>_<quadro>.png, com o número do quadro em 5 dígitos.
+*/
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+#include "CacheMalha.h"
+#include "ProgramaShader.h"
+#include "Transformacoes.h"
+#include "ArquivoTrajetoria.h"
+#include "RenderizacaoOffscreen.h"
+
+using namespace std;
+
+const char* vertexShaderSource = R"(
+#version 330 core
+layout(location = 0) in vec3 pos;
+layout(location = 2) in vec3 normal;
+layout(location = 3) in vec2 texCoord;
+uniform mat4 model;
+uniform mat3 normalMatrix;
+uniform mat4 view;
+uniform mat4 projection;
+out vec3 vNormal;
+out vec3 vFragPos;
+out vec2 vTexCoord;
+void main() {
+    vFragPos = vec3(model * vec4(pos, 1.0));
+    vNormal = normalMatrix * normal;
+    vTexCoord = texCoord;
+    gl_Position = projection * view * model * vec4(pos, 1.0);
+}
+)";
+
+const char* fragmentShaderSource = R"(
+#version 330 core
+in vec3 vNormal;
+in vec3 vFragPos;
+in vec2 vTexCoord;
+out vec4 FragColor;
+uniform sampler2D tex;
+uniform vec3 lightPos;
+uniform vec3 camPos;
+uniform float ka;
+uniform float kd;
+uniform float ks;
+uniform float ns;
+void main() {
+    vec3 norm = normalize(vNormal);
+    vec3 lightDir = normalize(lightPos - vFragPos);
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 viewDir = normalize(camPos - vFragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), ns);
+    vec3 texColor = texture(tex, vTexCoord).rgb;
+    FragColor = vec4((ka + kd * diff + ks * spec) * texColor, 1.0);
+}
+)";
+
+struct Opcoes {
+    string modelo;
+    string camera;
+    int inicio = 0, fim = 119;     // quadros, inclusive
+    double fps = 30.0;
+    int largura = 1280, altura = 720;
+    FormatoImagem formato = FORMATO_PNG;
+    string saida = "quadro";
+    int pbos = 3;
+    float velocidade = 2.0f;
+    bool semDisplay = false;
+};
+
+// Caminho da câmera: pontos com tempos (interpolados no tempo) ou uma curva percorrida a velocidade constante
+struct CaminhoCamera {
+    vector<glm::vec3> pontos;
+    vector<float> tempos;
+    Trajetoria curva;
+    float velocidade = 2.0f;
+
+    bool vazio() const { return pontos.empty(); }
+
+    glm::vec3 posicao(double t) const {
+        if (!tempos.empty()) {
+            if (t <= tempos.front()) return pontos.front();
+            if (t >= tempos.back()) return pontos.back();
+            size_t i = upper_bound(tempos.begin(), tempos.end(), (float)t) - tempos.begin();
+            float intervalo = tempos[i] - tempos[i - 1];
+            float s = intervalo > 0.0f ? ((float)t - tempos[i - 1]) / intervalo : 1.0f;
+            return glm::mix(pontos[i - 1], pontos[i], s);
+        }
+        float comprimento = curva.comprimento();
+        if (comprimento <= 0.0f) return pontos.front();
+        return curva.posicao(fmod((float)t * velocidade, comprimento));
+    }
+};
+
+bool terminaCom(const string& s, const char* sufixo) {
+    size_t n = strlen(sufixo);
+    return s.size() >= n && s.compare(s.size() - n, n, sufixo) == 0;
+}
+
+bool carregarCaminho(const string& arquivo, float velocidade, CaminhoCamera& caminho) {
+    ModoTrajetoria modo = TRAJETORIA_CATMULL_ROM;
+    if (terminaCom(arquivo, ".trj")) {
+        TrajetoriaMapeada t;
+        if (!abrirTrajetoria(arquivo, t)) return false;
+        t.copiarPontos(caminho.pontos);
+        t.copiarTempos(caminho.tempos);
+        modo = t.modo();
+    } else if (!importarTrajetoriaTexto(arquivo, caminho.pontos, &caminho.tempos)) {
+        return false;
+    }
+    if (caminho.pontos.empty()) return false;
+    caminho.curva.definir(caminho.pontos, modo);
+    caminho.velocidade = velocidade;
+    return true;
+}
+
+bool lerOpcoes(int argc, char** argv, Opcoes& op) {
+    for (int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        bool temValor = i + 1 < argc;
+        if (a == "--sem-display") op.semDisplay = true;
+        else if (a == "--camera" && temValor) op.camera = argv[++i];
+        else if (a == "--quadros" && temValor) {
+            if (sscanf(argv[++i], "%d:%d", &op.inicio, &op.fim) != 2) return false;
+        } else if (a == "--fps" && temValor) op.fps = atof(argv[++i]);
+        else if (a == "--tamanho" && temValor) {
+            if (sscanf(argv[++i], "%dx%d", &op.largura, &op.altura) != 2) return false;
+        } else if (a == "--formato" && temValor) {
+            string f = argv[++i];
+            if (f != "png" && f != "ppm") return false;
+            op.formato = f == "png" ? FORMATO_PNG : FORMATO_PPM;
+        } else if (a == "--saida" && temValor) op.saida = argv[++i];
+        else if (a == "--pbos" && temValor) op.pbos = atoi(argv[++i]);
+        else if (a == "--velocidade" && temValor) op.velocidade = (float)atof(argv[++i]);
+        else if (a.compare(0, 2, "--") != 0 && op.modelo.empty()) op.modelo = a;
+        else return false;
+    }
+    return !op.modelo.empty() && op.fim >= op.inicio && op.fps > 0.0 && op.largura > 0 && op.altura > 0;
+}
+
+void erroGLFW(int codigo, const char* descricao) {
+    cerr << "GLFW (" << codigo << "): " << descricao << endl;
+}
+
+// Janela oculta com display; sem display, plataforma nula com OSMesa ou EGL
+GLFWwindow* criarContexto(bool semDisplay) {
+    glfwSetErrorCallback(erroGLFW);
+    if (!semDisplay) semDisplay = !getenv("DISPLAY") && !getenv("WAYLAND_DISPLAY");
+    if (semDisplay) glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    if (!glfwInit()) return nullptr;
+
+    const int apis[] = { GLFW_OSMESA_CONTEXT_API, GLFW_EGL_CONTEXT_API };
+    for (int api : apis) {
+        glfwDefaultWindowHints();
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        if (semDisplay) glfwWindowHint(GLFW_CONTEXT_CREATION_API, api);
+        // O desenho vai para o FBO: a janela (ou superfície) só segura o contexto
+        GLFWwindow* window = glfwCreateWindow(16, 16, "RenderOffscreen", nullptr, nullptr);
+        if (window || !semDisplay) return window;
+    }
+    return nullptr;
+}
+
+GLuint compilarPrograma() {
+    GLuint v = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(v, 1, &vertexShaderSource, nullptr);
+    glCompileShader(v);
+    GLuint f = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(f, 1, &fragmentShaderSource, nullptr);
+    glCompileShader(f);
+    GLuint prog = glCreateProgram();
+    glAttachShader(prog, v);
+    glAttachShader(prog, f);
+    glLinkProgram(prog);
+    GLint ok;
+    glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[512];
+        glGetProgramInfoLog(prog, 512, nullptr, log);
+        cerr << "Erro ao linkar shader: " << log << endl;
+    }
+    glDeleteShader(v);
+    glDeleteShader(f);
+    return prog;
+}
+
+// Textura do map_Kd, ou branca 1x1 se não houver
+GLuint carregarTextura(const MalhaCacheada& malha) {
+    int w = 1, h = 1, c = 4;
+    unsigned char branco[4] = { 255, 255, 255, 255 };
+    unsigned char* pixels = nullptr;
+    if (!malha.material.mapKd.empty()) {
+        pixels = stbi_load((malha.diretorio + malha.material.mapKd).c_str(), &w, &h, &c, 0);
+        if (!pixels) cerr << "Textura não encontrada: " << malha.diretorio + malha.material.mapKd << endl;
+    }
+    if (!pixels) w = h = 1, c = 4;
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    GLenum format = c == 4 ? GL_RGBA : c == 3 ? GL_RGB : GL_RED;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, w, h, 0, format, GL_UNSIGNED_BYTE, pixels ? pixels : branco);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    if (pixels) stbi_image_free(pixels);
+    return tex;
+}
+
+int main(int argc, char** argv) {
+    Opcoes op;
+    if (!lerOpcoes(argc, argv, op)) {
+        cerr << "Uso: " << argv[0] << " modelo.obj [--camera caminho.trj|.txt] [--quadros inicio:fim] [--fps 30]\n"
+             << "       [--tamanho 1280x720] [--formato png|ppm] [--saida quadros/q] [--pbos 3]\n"
+             << "       [--velocidade 2] [--sem-display]" << endl;
+        return 2;
+    }
+
+    GLFWwindow* window = criarContexto(op.semDisplay);
+    if (!window) {
+        cerr << "Erro ao criar contexto OpenGL 3.3" << endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        cerr << "Erro ao inicializar GLAD" << endl;
+        return -1;
+    }
+    cout << "OpenGL " << glGetString(GL_VERSION) << ", " << glGetString(GL_RENDERER) << endl;
+
+    MalhaCacheada malha;
+    if (!carregarMalhaCacheada(op.modelo, malha)) {
+        cerr << "Arquivo não encontrado: " << op.modelo << endl;
+        return 1;
+    }
+    GLuint vbo, ebo, vao;
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, malha.bytesVertices(), malha.vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, malha.bytesIndices(), malha.indices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (void*)(6 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (void*)(9 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(3);
+    GLenum tipoIndice = malha.indices16Bits() ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    GLuint textura = carregarTextura(malha);
+
+    const LimitesMalha& limites = malha.limites();
+    glm::vec3 centro(limites.centro[0], limites.centro[1], limites.centro[2]);
+    float raio = max(limites.raio, 1e-3f);
+
+    CaminhoCamera caminho;
+    if (!op.camera.empty() && !carregarCaminho(op.camera, op.velocidade, caminho)) {
+        cerr << "Trajetória da câmera não encontrada: " << op.camera << endl;
+        return 1;
+    }
+
+    ProgramaShader shader(compilarPrograma());
+    shader.usar();
+    shader.definir("tex", 0);
+    shader.definir("model", glm::mat4(1.0f));
+    shader.definir("normalMatrix", glm::mat3(1.0f));
+    shader.definir("projection", glm::perspective(glm::radians(45.0f), (float)op.largura / op.altura, raio * 0.01f,
+                                                  raio * 100.0f));
+    shader.definir("ka", malha.material.ka);
+    shader.definir("kd", malha.material.kd);
+    shader.definir("ks", malha.material.ks);
+    shader.definir("ns", malha.material.ns);
+    UniformShader uView = shader.uniform("view");
+    UniformShader uCamPos = shader.uniform("camPos");
+    UniformShader uLightPos = shader.uniform("lightPos");
+
+    FramebufferOffscreen fbo;
+    if (!fbo.criar(op.largura, op.altura)) {
+        cerr << "FBO " << op.largura << "x" << op.altura << " incompleto" << endl;
+        return 1;
+    }
+    LeituraQuadros leitura;
+    leitura.criar(op.largura, op.altura, op.pbos, op.formato, op.saida);
+    glEnable(GL_DEPTH_TEST);
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+
+    int nQuadros = op.fim - op.inicio + 1;
+    cout << op.modelo << ": " << malha.nIndices() / 3 << " triângulos, quadros " << op.inicio << " a " << op.fim
+         << " em " << op.largura << "x" << op.altura << ", " << op.pbos << " PBOs -> "
+         << leitura.nomeArquivo(op.inicio) << "..." << endl;
+
+    auto inicio = chrono::steady_clock::now();
+    for (int q = op.inicio; q <= op.fim; ++q) {
+        double t = q / op.fps;
+        glm::vec3 olho = caminho.vazio()
+                             ? centro + raio * 3.0f * glm::vec3(sin(t * 0.5), 0.3f, cos(t * 0.5))
+                             : caminho.posicao(t);
+        shader.definir(uView, glm::lookAt(olho, centro, glm::vec3(0, 1, 0)));
+        shader.definir(uCamPos, olho);
+        shader.definir(uLightPos, olho + glm::vec3(0.0f, raio, 0.0f));
+
+        fbo.usar();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, textura);
+        glBindVertexArray(vao);
+        glDrawElements(GL_TRIANGLES, (GLsizei)malha.nIndices(), tipoIndice, 0);
+        leitura.ler(q);
+    }
+    double tDesenho = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+    leitura.terminar();
+    double tTotal = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+
+    EstatisticasLeitura e = leitura.estatisticas();
+    cout << fixed << setprecision(1) << nQuadros / tTotal << " quadros/s (" << nQuadros / tDesenho
+         << " até o último ler(), " << setprecision(3) << tTotal - tDesenho << " s esperando o disco no fim)" << endl;
+    cout << e.gravados << " imagens gravadas, " << e.falhas << " falhas, " << e.esperasFence
+         << " esperas por PBO ainda em uso, " << e.esperasFila << " esperas pela fila de escrita" << endl;
+
+    fbo.destruir();
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return e.falhas == 0 && e.gravados == (size_t)nQuadros ? 0 : 1;
+}
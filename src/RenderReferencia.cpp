@@ -0,0 +1,194 @@
+/*	Imagem de referência por traçado de caminhos (TracadorCaminhos.h)
+    Monta a cena do M6 na CPU (Suzanne com a textura do map_Kd, câmera em
+    (0, 0, 3) olhando para -z, fov de 45 graus, luz em (2, 2, 2)) ou os
+    modelos dados, lado a lado, e acumula amostras por pixel até chegar
+    a --amostras ou estourar --tempo, o que vier antes. Sombras, oclusão
+    do ambiente e luz entre superfícies ficam de verdade; sem elas, a
+    imagem converge para a do shader Phong da GPU.
+
+    Cada modelo pode levar a textura depois de uma vírgula; sem ela, vale
+    o map_Kd do .mtl e, sem map_Kd, a pixelWall.png, como no M6. Com --progresso k a imagem parcial é regravada a
+    cada k amostras.
+
+    Uso: RenderReferencia [modelo.obj[,textura.png] ...] [--amostras 256]
+         [--tempo segundos] [--tamanho 800x800] [--saida referencia.png]
+         [--threads 0] [--saltos 4] [--progresso k] [--escalar]
+    Grava PNG ou, se o nome terminar em .ppm, PPM.
+*/
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+#include <thread>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+#include "CacheMalha.h"
+#include "Transformacoes.h"
+#include "TracadorCaminhos.h"
+
+using namespace std;
+
+const char* TEXTURA_PADRAO = "../assets/tex/pixelWall.png";
+
+struct Opcoes {
+    vector<string> modelos, texturas;
+    int amostras = 256;
+    double tempo = 0.0;          // 0: sem limite de tempo
+    int largura = 800, altura = 800;
+    string saida = "referencia.png";
+    unsigned threads = 0;
+    int saltos = 4;
+    int progresso = 0;
+    bool escalar = false;
+};
+
+bool terminaCom(const string& s, const char* sufixo) {
+    size_t n = strlen(sufixo);
+    return s.size() >= n && s.compare(s.size() - n, n, sufixo) == 0;
+}
+
+bool lerOpcoes(int argc, char** argv, Opcoes& op) {
+    for (int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        bool temValor = i + 1 < argc;
+        if (a == "--escalar") op.escalar = true;
+        else if (a == "--amostras" && temValor) op.amostras = atoi(argv[++i]);
+        else if (a == "--tempo" && temValor) op.tempo = atof(argv[++i]);
+        else if (a == "--tamanho" && temValor) {
+            if (sscanf(argv[++i], "%dx%d", &op.largura, &op.altura) != 2) return false;
+        } else if (a == "--saida" && temValor) op.saida = argv[++i];
+        else if (a == "--threads" && temValor) op.threads = (unsigned)atoi(argv[++i]);
+        else if (a == "--saltos" && temValor) op.saltos = atoi(argv[++i]);
+        else if (a == "--progresso" && temValor) op.progresso = atoi(argv[++i]);
+        else if (a.compare(0, 2, "--") != 0) {
+            size_t virgula = a.find(',');
+            op.modelos.push_back(a.substr(0, virgula));
+            op.texturas.push_back(virgula == string::npos ? "" : a.substr(virgula + 1));
+        } else return false;
+    }
+    if (op.modelos.empty()) {
+        op.modelos.push_back("../assets/Modelos3D/Suzanne.obj");
+        op.texturas.push_back("");
+    }
+    return op.amostras > 0 && op.tempo >= 0.0 && op.largura > 0 && op.altura > 0 && op.saltos >= 0;
+}
+
+// Textura do arquivo, ou nula (branca) se ele não abrir
+unique_ptr<TexturaSoftware> carregarTextura(const string& caminho) {
+    int w, h, c;
+    unsigned char* pixels = caminho.empty() ? nullptr : stbi_load(caminho.c_str(), &w, &h, &c, 0);
+    if (!pixels) {
+        if (!caminho.empty()) cerr << "Textura não encontrada: " << caminho << endl;
+        return nullptr;
+    }
+    unique_ptr<TexturaSoftware> textura(new TexturaSoftware());
+    textura->criar(pixels, w, h, c);
+    stbi_image_free(pixels);
+    return textura;
+}
+
+bool gravar(const TracadorCaminhos& tracador, const string& nome) {
+    if (terminaCom(nome, ".ppm")) return tracador.gravarPPM(nome);
+    vector<unsigned char> rgb;
+    tracador.copiarRGB(rgb);
+    return stbi_write_png(nome.c_str(), tracador.larguraImagem(), tracador.alturaImagem(), 3, rgb.data(),
+                          tracador.larguraImagem() * 3) != 0;
+}
+
+int main(int argc, char** argv) {
+    Opcoes op;
+    if (!lerOpcoes(argc, argv, op)) {
+        cerr << "Uso: " << argv[0] << " [modelo.obj[,textura.png] ...] [--amostras 256] [--tempo segundos]\n"
+             << "       [--tamanho 800x800] [--saida referencia.png] [--threads 0] [--saltos 4]\n"
+             << "       [--progresso k] [--escalar]" << endl;
+        return 2;
+    }
+
+    // As malhas e texturas precisam existir até construir(); a cena copia o que usa
+    vector<unique_ptr<MalhaCacheada>> malhas;
+    vector<unique_ptr<TexturaSoftware>> texturas;
+    float larguraCena = 0.0f;
+    for (size_t i = 0; i < op.modelos.size(); ++i) {
+        malhas.emplace_back(new MalhaCacheada());
+        MalhaCacheada& malha = *malhas.back();
+        if (!carregarMalhaCacheada(op.modelos[i], malha)) {
+            cerr << "Arquivo não encontrado: " << op.modelos[i] << endl;
+            return 1;
+        }
+        string textura = op.texturas[i];
+        // Mesma ordem do CarregadorAssincrono no M6: map_Kd, senão a textura padrão
+        if (textura.empty())
+            textura = malha.material.mapKd.empty() ? string(TEXTURA_PADRAO) : malha.diretorio + malha.material.mapKd;
+        texturas.push_back(carregarTextura(textura));
+        larguraCena += 2.2f * max(malha.limites().raio, 1e-3f);
+    }
+
+    // Um modelo fica onde está, como no M6; vários, lado a lado no eixo x e centrados na origem
+    TracadorCaminhos tracador;
+    float x = -0.5f * larguraCena;
+    for (size_t i = 0; i < malhas.size(); ++i) {
+        const MalhaCacheada& malha = *malhas[i];
+        const LimitesMalha& limites = malha.limites();
+        float raio = 1.1f * max(limites.raio, 1e-3f);
+        glm::vec3 centro(limites.centro[0], limites.centro[1], limites.centro[2]);
+        glm::mat4 model = malhas.size() == 1 ? glm::mat4(1.0f)
+                                             : glm::translate(glm::mat4(1.0f), glm::vec3(x + raio, 0.0f, 0.0f) - centro);
+        x += 2.0f * raio;
+        tracador.adicionar(malha.vertices, malha.nVertices(), malha.indices, malha.nIndices(), malha.indices16Bits(),
+                           model, texturas[i].get(), malha.material);
+    }
+    auto inicio = chrono::steady_clock::now();
+    tracador.construir();
+    double tBVH = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+
+    // A câmera inicial do M6; com vários modelos, recua até caberem todos
+    glm::vec3 camPos(0.0f, 0.0f, 3.0f), lightPos(2.0f, 2.0f, 2.0f);
+    float aspecto = (float)op.largura / op.altura, tangente = tan(glm::radians(22.5f));
+    if (malhas.size() > 1) camPos.z = max(3.0f, 0.55f * larguraCena / (tangente * aspecto));
+    glm::mat4 view = glm::lookAt(camPos, camPos + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0, 1, 0));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), aspecto, 0.1f, 100.0f);
+    tracador.usarAVX2 = !op.escalar;
+    tracador.saltos = op.saltos;
+    tracador.redimensionar(op.largura, op.altura);
+    tracador.definirCamera(view, projection, lightPos);
+
+    unsigned threads = op.threads ? op.threads : max(1u, thread::hardware_concurrency());
+    cout << tracador.triangulos() << " triângulos (BVH em " << fixed << setprecision(1) << tBVH * 1e3 << " ms), "
+         << op.largura << "x" << op.altura << ", " << threads << " threads, " << op.saltos << " rebotes, "
+         << (op.escalar ? "um raio por vez" : "pacotes de 8 raios") << endl;
+
+    EstatisticasTracado total;
+    inicio = chrono::steady_clock::now();
+    double decorrido = 0.0;
+    while ((int)tracador.amostras() < op.amostras && (op.tempo == 0.0 || decorrido < op.tempo)) {
+        tracador.amostrar(threads);
+        total.somar(tracador.estatisticas);
+        decorrido = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+        if (op.progresso > 0 && tracador.amostras() % op.progresso == 0) {
+            gravar(tracador, op.saida);
+            cout << tracador.amostras() << " amostras, " << setprecision(1) << decorrido << " s, "
+                 << total.raios() / decorrido / 1e6 << " Mraios/s" << endl;
+        }
+    }
+
+    cout << tracador.amostras() << " amostras por pixel em " << setprecision(2) << decorrido << " s: " << setprecision(2)
+         << total.raios() / decorrido / 1e6 << " Mraios/s (" << total.primarios << " primários, " << total.sombra
+         << " de sombra, " << total.indiretos << " indiretos), " << total.roubos << " faixas de tiles roubadas" << endl;
+    bool ok = gravar(tracador, op.saida);
+    cout << (ok ? "imagem gravada em " : "não foi possível gravar ") << op.saida << endl;
+    return ok ? 0 : 1;
+}